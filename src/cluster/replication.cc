@@ -42,6 +42,8 @@
 #include "server/server.h"
 #include "status.h"
 #include "storage/batch_debugger.h"
+#include "storage/batch_extractor.h"
+#include "string_util.h"
 #include "thread_util.h"
 #include "time_util.h"
 #include "unique_fd.h"
@@ -54,6 +56,7 @@
 
 Status FeedSlaveThread::Start() {
   auto s = util::CreateThread("feed-replica", [this] {
+    srv_->SetReplicationThreadAffinity();
     sigset_t mask, omask;
     sigemptyset(&mask);
     sigemptyset(&omask);
@@ -99,6 +102,27 @@ void FeedSlaveThread::checkLivenessIfNeed() {
   }
 }
 
+void FeedSlaveThread::FeedPubSubMessage(const std::string &channel, const std::string &msg) {
+  std::lock_guard<std::mutex> lg(pubsub_mu_);
+  // the replica can't catch up, drop the message like a slow subscriber instead of exhausting the memory
+  if (pending_pubsub_frames_.size() >= kMaxPendingPubSubBytes) return;
+  pending_pubsub_frames_ += redis::ArrayOfBulkStrings({"publish", channel, msg});
+}
+
+void FeedSlaveThread::sendPubSubMessagesIfNeed() {
+  std::string frames;
+  {
+    std::lock_guard<std::mutex> lg(pubsub_mu_);
+    if (pending_pubsub_frames_.empty()) return;
+    frames.swap(pending_pubsub_frames_);
+  }
+  auto s = util::SockSend(conn_->GetFD(), frames, conn_->GetBufferEvent());
+  if (!s.IsOK()) {
+    LOG(ERROR) << "Write error while sending published messages to slave: " << s.Msg();
+    Stop();
+  }
+}
+
 void FeedSlaveThread::loop() {
   // is_first_repl_batch was used to fix that replication may be stuck in a dead loop
   // when some seqs might be lost in the middle of the WAL log, so forced to replicate
@@ -116,6 +140,7 @@ void FeedSlaveThread::loop() {
         iter_ = nullptr;
         usleep(yield_microseconds);
         checkLivenessIfNeed();
+        sendPubSubMessagesIfNeed();
         continue;
       }
     }
@@ -124,6 +149,8 @@ void FeedSlaveThread::loop() {
     if (batch.sequence != curr_seq) {
       LOG(ERROR) << "Fatal error encountered, WAL iterator is discrete, some seq might be lost"
                  << ", sequence " << curr_seq << " expected, but got " << batch.sequence;
+      // the next sync from before the gap would stop here again, so it must be a full sync
+      srv_->storage->RecordWALGap(batch.sequence - 1);
       Stop();
       return;
     }
@@ -155,9 +182,136 @@ void FeedSlaveThread::loop() {
     }
     curr_seq = batch.sequence + batch.writeBatchPtr->Count();
     next_repl_seq_.store(curr_seq);
+    sendPubSubMessagesIfNeed();
     while (!IsStopped() && !srv_->storage->WALHasNewData(curr_seq)) {
       usleep(yield_microseconds);
       checkLivenessIfNeed();
+      sendPubSubMessagesIfNeed();
+    }
+    iter_->Next();
+  }
+}
+
+Status CDCFeedThread::Start() {
+  auto s = util::CreateThread("feed-cdc", [this] {
+    srv_->SetReplicationThreadAffinity();
+    sigset_t mask, omask;
+    sigemptyset(&mask);
+    sigemptyset(&omask);
+    sigaddset(&mask, SIGCHLD);
+    sigaddset(&mask, SIGHUP);
+    sigaddset(&mask, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &mask, &omask);
+    auto s = util::SockSend(conn_->GetFD(), redis::SimpleString("OK"), conn_->GetBufferEvent());
+    if (!s.IsOK()) {
+      LOG(ERROR) << "failed to send OK response to the CDC consumer: " << s.Msg();
+      return;
+    }
+    this->loop();
+  });
+
+  if (s) {
+    t_ = std::move(*s);
+  } else {
+    conn_ = nullptr;  // prevent connection was freed when failed to start the thread
+  }
+
+  return std::move(s);
+}
+
+void CDCFeedThread::Stop() {
+  stop_ = true;
+  LOG(WARNING) << "CDC thread was terminated, would stop feeding the consumer: " << conn_->GetAddr();
+}
+
+void CDCFeedThread::Join() {
+  if (auto s = util::ThreadJoin(t_); !s) {
+    LOG(WARNING) << "CDC thread operation failed: " << s.Msg();
+  }
+}
+
+Status CDCFeedThread::sendFrame(const std::vector<std::string> &events) {
+  std::string frame = redis::MultiLen(3) + redis::BulkString("cdc") + redis::Integer(next_seq_.load()) +
+                      redis::MultiLen(events.size());
+  for (const auto &event : events) {
+    frame += event;
+  }
+  last_send_ms_ = util::GetTimeStampMS();
+  return util::SockSend(conn_->GetFD(), frame, conn_->GetBufferEvent());
+}
+
+void CDCFeedThread::heartbeatIfNeed() {
+  if (util::GetTimeStampMS() - last_send_ms_ < kHeartbeatIntervalMs) return;
+  auto s = sendFrame({});
+  if (!s.IsOK()) {
+    LOG(ERROR) << "Heartbeat CDC consumer[" << conn_->GetAddr() << "] err: " << s.Msg() << ", would stop the thread";
+    Stop();
+  }
+}
+
+void CDCFeedThread::loop() {
+  uint32_t yield_microseconds = 2 * 1000;
+  std::vector<std::string> events;
+  size_t events_bytes = 0;
+  while (!IsStopped()) {
+    auto curr_seq = next_seq_.load();
+
+    if (!iter_ || !iter_->Valid()) {
+      if (iter_) LOG(INFO) << "WAL was rotated, would reopen again";
+      if (!srv_->storage->WALHasNewData(curr_seq) || !srv_->storage->GetWALIter(curr_seq, &iter_).IsOK()) {
+        iter_ = nullptr;
+        heartbeatIfNeed();
+        usleep(yield_microseconds);
+        continue;
+      }
+    }
+    // iter_ would be always valid here
+    auto batch = iter_->GetBatch();
+    if (batch.sequence != curr_seq) {
+      LOG(ERROR) << "Fatal error encountered, WAL iterator is discrete, some seq might be lost"
+                 << ", sequence " << curr_seq << " expected, but got " << batch.sequence;
+      // the next sync from before the gap would stop here again, so it must be a full sync
+      srv_->storage->RecordWALGap(batch.sequence - 1);
+      Stop();
+      return;
+    }
+
+    WriteBatchExtractor extractor(srv_->storage->IsSlotIdEncoded(), -1, true);
+    if (!options_.ns.empty()) extractor.SetNamespace(srv_->storage->EncodeNamespace(options_.ns));
+    extractor.SetKeyPattern(options_.key_pattern);
+    if (options_.types) extractor.SetRedisTypes(*options_.types);
+    if (auto s = batch.writeBatchPtr->Iterate(&extractor); !s.ok()) {
+      LOG(ERROR) << "Failed to extract the write batch with sequence " << batch.sequence << ": " << s.ToString();
+      Stop();
+      return;
+    }
+    for (const auto &[ns, commands] : *extractor.GetRESPCommands()) {
+      auto ns_name = srv_->storage->DecodeNamespace(ns);
+      for (const auto &command : commands) {
+        events.emplace_back(redis::MultiLen(2) + redis::BulkString(ns_name) + command);
+        events_bytes += events.back().size();
+      }
+    }
+
+    curr_seq = batch.sequence + batch.writeBatchPtr->Count();
+    next_seq_.store(curr_seq);
+    // Events are only sent at the batch boundary, so that the sequence in the frame is always
+    // a valid point to resume from. Like the replication, we pack multiple batches into one frame
+    // if possible, but still send it once the consumer has caught up with the latest sequence.
+    if (!events.empty() && (events.size() >= options_.batch_size || events_bytes >= kMaxDelayBytes ||
+                            !srv_->storage->WALHasNewData(curr_seq))) {
+      if (auto s = sendFrame(events); !s.IsOK()) {
+        LOG(ERROR) << "Write error while sending events to the CDC consumer: " << s.Msg();
+        Stop();
+        return;
+      }
+      events.clear();
+      events_bytes = 0;
+    }
+
+    while (!IsStopped() && !srv_->storage->WALHasNewData(curr_seq)) {
+      heartbeatIfNeed();
+      usleep(yield_microseconds);
     }
     iter_->Next();
   }
@@ -223,6 +377,12 @@ LOOP_LABEL:
       bev_ = nullptr;
       repl_->repl_state_.store(kReplError, std::memory_order_relaxed);
       break;
+    case CBState::RECONNECT:  // reconnect at once, e.g. to negotiate the capabilities again
+      Stop();
+      if (repl_->stop_flag_) break;
+      repl_->repl_state_.store(kReplConnecting, std::memory_order_relaxed);
+      Start();
+      break;
     case CBState::RESTART:  // state that can be retried some time later
       Stop();
       if (repl_->stop_flag_) {
@@ -300,6 +460,8 @@ void ReplicationThread::CallbacksStateMachine::Start() {
 
   handler_idx_ = 0;
   repl_->incr_state_ = Incr_batch_size;
+  repl_->incr_frame_len_ = 0;
+  repl_->incr_frame_.clear();
   if (getHandlerEventType(0) == WRITE) {
     SetWriteCB(bev, EventCallbackFunc<&CallbacksStateMachine::ReadWriteCB>);
   } else {
@@ -352,6 +514,7 @@ Status ReplicationThread::Start(std::function<void()> &&pre_fullsync_cb, std::fu
   storage_->PurgeOldBackups(0, 0);
 
   t_ = GET_OR_RET(util::CreateThread("master-repl", [this] {
+    srv_->SetReplicationThreadAffinity();
     this->run();
     assert(stop_flag_);
   }));
@@ -456,6 +619,18 @@ ReplicationThread::CBState ReplicationThread::replConfWriteCB(bufferevent *bev)
     data_to_send.emplace_back("ip-address");
     data_to_send.emplace_back(config->replica_announce_ip);
   }
+  // the published messages could be received in the replication stream, unless they couldn't be relayed
+  // to all the sub-replicas in the same way, which only receive them via the WAL then
+  pubsub_capa_ = !next_try_without_capa_ && srv_->CanRelayPubSubMessages();
+  if (pubsub_capa_) {
+    data_to_send.emplace_back("capa");
+    data_to_send.emplace_back("pubsub");
+  }
+  if (!next_try_without_capa_) {
+    // the master refuses to sync if it encodes the sub keys in another version
+    data_to_send.emplace_back("subkey-encoding-version");
+    data_to_send.emplace_back(std::to_string(SUBKEY_ENCODING_VERSION_DEFAULT));
+  }
   SendString(bev, redis::ArrayOfBulkStrings(data_to_send));
   repl_state_.store(kReplReplConf, std::memory_order_relaxed);
   LOG(INFO) << "[replication] replconf request was sent, waiting for response";
@@ -467,7 +642,21 @@ ReplicationThread::CBState ReplicationThread::replConfReadCB(bufferevent *bev) {
   UniqueEvbufReadln line(input, EVBUFFER_EOL_CRLF_STRICT);
   if (!line) return CBState::AGAIN;
 
-  // on unknown option: first try without announce ip, if it fails again - do nothing (to prevent infinite loop)
+  // on unknown option: first try without capa, then without announce ip,
+  // if it fails again - do nothing (to prevent infinite loop)
+  if (isUnknownOption(line.get()) && !next_try_without_capa_) {
+    // the old version master only encodes the sub keys in version 0
+    if (SUBKEY_ENCODING_VERSION_DEFAULT != 0) {
+      LOG(ERROR) << "[replication] The old version master only supports the sub key encoding version 0, "
+                 << "while version " << static_cast<int>(SUBKEY_ENCODING_VERSION_DEFAULT) << " is used";
+      return CBState::RESTART;
+    }
+    next_try_without_capa_ = true;
+    pubsub_capa_ = false;
+    LOG(WARNING) << "The old version master, can't handle capa, "
+                 << "try without it again";
+    return CBState::PREV;
+  }
   if (isUnknownOption(line.get()) && !next_try_without_announce_ip_address_) {
     next_try_without_announce_ip_address_ = true;
     LOG(WARNING) << "The old version master, can't handle ip-address, "
@@ -565,9 +754,29 @@ ReplicationThread::CBState ReplicationThread::incrementBatchLoopCB(bufferevent *
       case Incr_batch_size: {
         // Read bulk length
         UniqueEvbufReadln line(input, EVBUFFER_EOL_CRLF_STRICT);
-        if (!line) return CBState::AGAIN;
+        if (!line) {
+          // A sub-replica which can't receive the published messages in the replication stream is attached,
+          // or starts the full sync. Reconnect to ask the master to replicate them via the WAL instead.
+          if (pubsub_capa_ && !srv_->CanRelayPubSubMessages()) {
+            LOG(INFO) << "[replication] Reconnect to the master to receive the published messages via the WAL";
+            return CBState::RECONNECT;
+          }
+          return CBState::AGAIN;
+        }
+        // the frames besides the write batches, e.g. the published messages, are sent as arrays of bulk strings
+        if (line.length > 0 && line[0] == '*' && incr_frame_len_ == 0) {
+          incr_frame_len_ = std::strtoull(line.get() + 1, nullptr, 10);
+          incr_frame_.clear();
+          if (incr_frame_len_ == 0) {
+            LOG(ERROR) << "[replication] Invalid increment frame size";
+            return CBState::RESTART;
+          }
+          break;
+        }
         incr_bulk_len_ = line.length > 0 ? std::strtoull(line.get() + 1, nullptr, 10) : 0;
-        if (incr_bulk_len_ == 0) {
+        // an empty bulk string is valid inside a frame, e.g. a published empty message,
+        // but a write batch is never empty
+        if (line.length == 0 || (incr_bulk_len_ == 0 && incr_frame_len_ == 0)) {
           LOG(ERROR) << "[replication] Invalid increment data size";
           return CBState::RESTART;
         }
@@ -579,9 +788,18 @@ ReplicationThread::CBState ReplicationThread::incrementBatchLoopCB(bufferevent *
         if (incr_bulk_len_ + 2 <= evbuffer_get_length(input)) {  // We got enough data
           bulk_data = reinterpret_cast<char *>(evbuffer_pullup(input, static_cast<ssize_t>(incr_bulk_len_ + 2)));
           std::string bulk_string = std::string(bulk_data, incr_bulk_len_);
-          // master would send the ping heartbeat packet to check whether the slave was alive or not,
-          // don't write ping to db here.
-          if (bulk_string != "ping") {
+          if (incr_frame_len_ > 0) {
+            incr_frame_.emplace_back(std::move(bulk_string));
+            if (--incr_frame_len_ == 0) {
+              auto s = handleFrame(incr_frame_);
+              if (!s.IsOK()) {
+                LOG(ERROR) << "[replication] Failed to handle the frame: " << s.Msg();
+                return CBState::RESTART;
+              }
+            }
+          } else if (bulk_string != "ping") {
+            // master would send the ping heartbeat packet to check whether the slave was alive or not,
+            // don't write ping to db here.
             auto s = storage_->ReplicaApplyWriteBatch(std::string(bulk_data, incr_bulk_len_));
             if (!s.IsOK()) {
               LOG(ERROR) << "[replication] CRITICAL - Failed to write batch to local, " << s.Msg() << ". batch: 0x"
@@ -957,11 +1175,21 @@ void ReplicationThread::TimerCB(int, int16_t) {
 
 Status ReplicationThread::parseWriteBatch(const std::string &batch_string) {
   rocksdb::WriteBatch write_batch(batch_string);
-  WriteBatchHandler write_batch_handler;
+  WriteBatchHandler write_batch_handler(storage_->IsSlotIdEncoded(), srv_->HasTrackingClients());
 
   auto db_status = write_batch.Iterate(&write_batch_handler);
   if (!db_status.ok()) return {Status::NotOK, "failed to iterate over write batch: " + db_status.ToString()};
 
+  // The replicated writes invalidate the keys cached by the tracking clients of this replica,
+  // the keys deleted by ranges, e.g. FLUSHDB, are unknown so all the cached keys are invalidated
+  if (write_batch_handler.HasRangeDeletion()) {
+    srv_->InvalidateAllTrackedKeys();
+  } else {
+    for (const auto &[ns, keys] : write_batch_handler.ModifiedKeys()) {
+      srv_->InvalidateTrackedKeys(storage_->DecodeNamespace(ns), std::vector<std::string>(keys.begin(), keys.end()));
+    }
+  }
+
   switch (write_batch_handler.Type()) {
     case kBatchTypePublish:
       srv_->PublishMessage(write_batch_handler.Key(), write_batch_handler.Value());
@@ -980,6 +1208,11 @@ Status ReplicationThread::parseWriteBatch(const std::string &batch_string) {
         if (!s.IsOK()) {
           return s.Prefixed("failed to load namespaces");
         }
+      } else if (util::HasPrefix(write_batch_handler.Key(), engine::kNamespaceIDPrefix)) {
+        auto s = storage_->ReloadNamespaceIDs();
+        if (!s.IsOK()) {
+          return s.Prefixed("failed to load namespace ids");
+        }
       }
       break;
     case kBatchTypeStream: {
@@ -998,6 +1231,18 @@ Status ReplicationThread::parseWriteBatch(const std::string &batch_string) {
   return Status::OK();
 }
 
+Status ReplicationThread::handleFrame(const std::vector<std::string> &frame) {
+  if (util::ToLower(frame[0]) == "publish" && frame.size() == 3) {
+    srv_->PublishMessage(frame[1], frame[2]);
+    // pass the message to the sub-replicas in the same way, it can't be written into the WAL of a replica
+    srv_->FeedPubSubMessageToSlaves(frame[1], frame[2], true);
+    return Status::OK();
+  }
+  // the frames unknown to this version are ignored, so the master could send new kinds of frames
+  LOG(WARNING) << "[replication] Ignore the unknown frame: " << frame[0];
+  return Status::OK();
+}
+
 bool ReplicationThread::isRestoringError(const char *err) {
   return std::string(err) == "-ERR restoring the db from backup";
 }
@@ -1008,8 +1253,24 @@ bool ReplicationThread::isWrongPsyncNum(const char *err) {
 
 bool ReplicationThread::isUnknownOption(const char *err) { return std::string(err) == "-ERR unknown option"; }
 
+void WriteBatchHandler::collectKey(uint32_t column_family_id, const rocksdb::Slice &key) {
+  if (!collect_keys_) return;
+
+  if (column_family_id == static_cast<uint32_t>(ColumnFamilyID::Metadata)) {
+    auto [ns, user_key] = ExtractNamespaceKey<std::string>(key, slot_id_encoded_);
+    modified_keys_[ns].emplace(std::move(user_key));
+  } else if (column_family_id == static_cast<uint32_t>(ColumnFamilyID::PrimarySubkey) ||
+             column_family_id == static_cast<uint32_t>(ColumnFamilyID::SecondarySubkey) ||
+             column_family_id == static_cast<uint32_t>(ColumnFamilyID::Stream)) {
+    // e.g. overwriting a hash field only writes the sub key
+    InternalKey ikey(key, slot_id_encoded_);
+    modified_keys_[ikey.GetNamespace().ToString()].emplace(ikey.GetKey().ToString());
+  }
+}
+
 rocksdb::Status WriteBatchHandler::PutCF(uint32_t column_family_id, const rocksdb::Slice &key,
                                          const rocksdb::Slice &value) {
+  collectKey(column_family_id, key);
   type_ = kBatchTypeNone;
   if (column_family_id == static_cast<uint32_t>(ColumnFamilyID::PubSub)) {
     type_ = kBatchTypePublish;
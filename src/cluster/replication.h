@@ -24,7 +24,11 @@
 
 #include <atomic>
 #include <deque>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
+#include <set>
 #include <string>
 #include <thread>
 #include <tuple>
@@ -35,6 +39,7 @@
 #include "io_util.h"
 #include "server/redis_connection.h"
 #include "status.h"
+#include "storage/redis_metadata.h"
 #include "storage/storage.h"
 
 class Server;
@@ -75,6 +80,10 @@ class FeedSlaveThread {
     auto seq = next_repl_seq_.load();
     return seq == 0 ? 0 : seq - 1;
   }
+  bool HasPubSubCapa() { return conn_->HasReplicaPubSubCapa(); }
+  // Queue the published message to be sent to the replica as a ["publish", channel, message] frame
+  // between the write batches, the message is dropped if too many messages are pending.
+  void FeedPubSubMessage(const std::string &channel, const std::string &msg);
 
  private:
   uint64_t interval_ = 0;
@@ -84,12 +93,62 @@ class FeedSlaveThread {
   std::atomic<rocksdb::SequenceNumber> next_repl_seq_ = 0;
   std::thread t_;
   std::unique_ptr<rocksdb::TransactionLogIterator> iter_ = nullptr;
+  std::mutex pubsub_mu_;
+  std::string pending_pubsub_frames_;
 
   static const size_t kMaxDelayUpdates = 16;
   static const size_t kMaxDelayBytes = 16 * 1024;
+  static const size_t kMaxPendingPubSubBytes = 64 * 1024 * 1024;
 
   void loop();
   void checkLivenessIfNeed();
+  void sendPubSubMessagesIfNeed();
+};
+
+struct CDCFeedOptions {
+  // Only deliver updates of the namespace, empty means all namespaces
+  std::string ns;
+  // Only deliver updates of keys matching the glob-style pattern, empty means all keys
+  std::string key_pattern;
+  std::optional<RedisTypes> types;
+  // The max number of events packed into one frame
+  size_t batch_size = 128;
+};
+
+// CDCFeedThread tails the WAL and streams the decoded updates to a change data capture
+// consumer. Each frame is a RESP array: ["cdc", <next sequence>, [[<namespace>, <command>], ...]],
+// the next sequence can be used to resume the stream via CDCSYNC after a disconnection.
+// A frame without events is sent as the heartbeat when there is no new update.
+class CDCFeedThread {
+ public:
+  explicit CDCFeedThread(Server *srv, redis::Connection *conn, rocksdb::SequenceNumber next_seq,
+                         CDCFeedOptions options)
+      : srv_(srv), conn_(conn), next_seq_(next_seq), options_(std::move(options)) {}
+  ~CDCFeedThread() = default;
+
+  Status Start();
+  void Stop();
+  void Join();
+  bool IsStopped() { return stop_; }
+  redis::Connection *GetConn() { return conn_.get(); }
+  rocksdb::SequenceNumber GetNextSeq() { return next_seq_.load(); }
+
+ private:
+  std::atomic<bool> stop_ = false;
+  Server *srv_ = nullptr;
+  std::unique_ptr<redis::Connection> conn_ = nullptr;
+  std::atomic<rocksdb::SequenceNumber> next_seq_ = 0;
+  CDCFeedOptions options_;
+  uint64_t last_send_ms_ = 0;
+  std::thread t_;
+  std::unique_ptr<rocksdb::TransactionLogIterator> iter_ = nullptr;
+
+  static const size_t kMaxDelayBytes = 16 * 1024;
+  static const uint64_t kHeartbeatIntervalMs = 1000;
+
+  void loop();
+  void heartbeatIfNeed();
+  Status sendFrame(const std::vector<std::string> &events);
 };
 
 class ReplicationThread : private EventCallbackBase<ReplicationThread> {
@@ -114,6 +173,7 @@ class ReplicationThread : private EventCallbackBase<ReplicationThread> {
       AGAIN,
       QUIT,
       RESTART,
+      RECONNECT,
     };
     enum EventType {
       READ,
@@ -158,6 +218,9 @@ class ReplicationThread : private EventCallbackBase<ReplicationThread> {
   std::atomic<int64_t> last_io_time_secs_ = 0;
   bool next_try_old_psync_ = false;
   bool next_try_without_announce_ip_address_ = false;
+  bool next_try_without_capa_ = false;
+  // whether the master was asked to send the published messages in the replication stream
+  bool pubsub_capa_ = false;
 
   std::function<void()> pre_fullsync_cb_;
   std::function<void()> post_fullsync_cb_;
@@ -176,6 +239,9 @@ class ReplicationThread : private EventCallbackBase<ReplicationThread> {
     Incr_batch_size,
     Incr_batch_data,
   } incr_state_ = Incr_batch_size;
+  // the bulk strings left to read of the current frame, and the ones already read
+  size_t incr_frame_len_ = 0;
+  std::vector<std::string> incr_frame_;
 
   size_t incr_bulk_len_ = 0;
 
@@ -209,6 +275,7 @@ class ReplicationThread : private EventCallbackBase<ReplicationThread> {
   static bool isUnknownOption(const char *err);
 
   Status parseWriteBatch(const std::string &batch_string);
+  Status handleFrame(const std::vector<std::string> &frame);
 };
 
 /*
@@ -216,19 +283,36 @@ class ReplicationThread : private EventCallbackBase<ReplicationThread> {
  */
 class WriteBatchHandler : public rocksdb::WriteBatch::Handler {
  public:
+  WriteBatchHandler() = default;
+  // The modified user keys are collected if `collect_keys` is true, which invalidates the keys
+  // cached by the tracking clients of the replica
+  WriteBatchHandler(bool slot_id_encoded, bool collect_keys)
+      : slot_id_encoded_(slot_id_encoded), collect_keys_(collect_keys) {}
+
   rocksdb::Status PutCF(uint32_t column_family_id, const rocksdb::Slice &key, const rocksdb::Slice &value) override;
   rocksdb::Status DeleteCF(uint32_t column_family_id, const rocksdb::Slice &key) override {
+    collectKey(column_family_id, key);
     return rocksdb::Status::OK();
   }
   rocksdb::Status DeleteRangeCF(uint32_t column_family_id, const rocksdb::Slice &begin_key,
                                 const rocksdb::Slice &end_key) override {
+    if (collect_keys_) has_range_deletion_ = true;
     return rocksdb::Status::OK();
   }
   WriteBatchType Type() { return type_; }
   std::string Key() const { return kv_.first; }
   std::string Value() const { return kv_.second; }
+  // namespace in keys -> the modified user keys
+  const std::map<std::string, std::set<std::string>> &ModifiedKeys() const { return modified_keys_; }
+  bool HasRangeDeletion() const { return has_range_deletion_; }
 
  private:
   std::pair<std::string, std::string> kv_;
   WriteBatchType type_ = kBatchTypeNone;
+  bool slot_id_encoded_ = false;
+  bool collect_keys_ = false;
+  std::map<std::string, std::set<std::string>> modified_keys_;
+  bool has_range_deletion_ = false;
+
+  void collectKey(uint32_t column_family_id, const rocksdb::Slice &key);
 };
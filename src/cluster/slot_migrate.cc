@@ -32,6 +32,7 @@
 #include "sync_migrate_context.h"
 #include "thread_util.h"
 #include "time_util.h"
+#include "types/redis_hash.h"
 #include "types/redis_stream_base.h"
 
 const char *errFailedToSendCommands = "failed to send commands to restore a key";
@@ -684,10 +685,21 @@ StatusOr<KeyMigrationResult> SlotMigrator::migrateOneKey(const rocksdb::Slice &k
       }
       break;
     }
+    case kRedisHash: {
+      HashMetadata hash_md(false);
+      if (auto s = hash_md.Decode(bytes); !s.ok()) {
+        return {Status::NotOK, s.ToString()};
+      }
+
+      auto s = migrateComplexKey(key, hash_md, restore_cmds);
+      if (!s.IsOK()) {
+        return s.Prefixed("failed to migrate complex key");
+      }
+      break;
+    }
     case kRedisList:
     case kRedisZSet:
     case kRedisBitmap:
-    case kRedisHash:
     case kRedisSet:
     case kRedisSortedint: {
       auto s = migrateComplexKey(key, metadata, restore_cmds);
@@ -751,6 +763,8 @@ Status SlotMigrator::migrateComplexKey(const rocksdb::Slice &key, const Metadata
   auto iter = util::UniqueIterator(storage_->GetDB()->NewIterator(read_options));
 
   int item_count = 0;
+  // the fields with TTL of a hash key, which should be restored after all fields are migrated
+  std::vector<std::pair<std::string, uint64_t>> field_expires;
 
   for (iter->Seek(prefix_subkey); iter->Valid(); iter->Next()) {
     if (stop_migration_) {
@@ -788,8 +802,21 @@ Status SlotMigrator::migrateComplexKey(const rocksdb::Slice &key, const Metadata
         break;
       }
       case kRedisHash: {
+        // the metadata of hashes is always decoded as HashMetadata in migrateOneKey
+        const auto &hash_metadata = static_cast<const HashMetadata &>(metadata);
+        Slice field_value;
+        uint64_t field_expire = 0;
+        if (!hash_metadata.DecodeFieldValue(iter->value(), &field_value, &field_expire)) {
+          return {Status::NotOK, "the value of hash field is too short"};
+        }
+        // the expired field will be ignored
+        if (redis::Hash::IsFieldExpired(field_expire)) continue;
+
         user_cmd.emplace_back(inkey.GetSubKey().ToString());
-        user_cmd.emplace_back(iter->value().ToString());
+        user_cmd.emplace_back(field_value.ToString());
+        if (field_expire > 0) {
+          field_expires.emplace_back(inkey.GetSubKey().ToString(), field_expire);
+        }
         break;
       }
       case kRedisList: {
@@ -826,6 +853,12 @@ Status SlotMigrator::migrateComplexKey(const rocksdb::Slice &key, const Metadata
     current_pipeline_size_++;
   }
 
+  for (const auto &[field, field_expire] : field_expires) {
+    *restore_cmds += redis::ArrayOfBulkStrings(
+        {"HPEXPIREAT", key.ToString(), std::to_string(field_expire), "FIELDS", "1", field});
+    current_pipeline_size_++;
+  }
+
   // Add TTL for complex key
   if (metadata.expire > 0) {
     *restore_cmds += redis::ArrayOfBulkStrings({"PEXPIREAT", key.ToString(), std::to_string(metadata.expire)});
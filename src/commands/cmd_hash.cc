@@ -434,6 +434,163 @@ class CommandHRandField : public Commander {
   bool no_parameters_ = true;
 };
 
+// parse the `FIELDS numfields field [field ...]` part of hash field expiration commands,
+// and return the index of the first field in arguments
+static StatusOr<size_t> ParseFieldsArgument(const std::vector<std::string> &args, size_t index) {
+  if (index >= args.size() || !util::EqualICase(args[index], "fields")) {
+    return {Status::RedisParseErr, "mandatory argument FIELDS is missing or not at the right position"};
+  }
+  if (index + 1 >= args.size()) {
+    return {Status::RedisParseErr, errWrongNumOfArguments};
+  }
+  auto num_fields = ParseInt<int64_t>(args[index + 1], 10);
+  if (!num_fields || *num_fields <= 0) {
+    return {Status::RedisParseErr, "parameter `numfields` should be greater than 0"};
+  }
+  if (static_cast<size_t>(*num_fields) != args.size() - index - 2) {
+    return {Status::RedisParseErr, "the `numfields` parameter must match the number of arguments"};
+  }
+  return index + 2;
+}
+
+template <bool is_milliseconds, bool is_absolute>
+class CommandHExpireImpl : public Commander {
+ public:
+  Status Parse(const std::vector<std::string> &args) override {
+    constexpr int64_t max_value = is_milliseconds ? std::numeric_limits<int64_t>::max() / 2
+                                                  : std::numeric_limits<int64_t>::max() / 2 / 1000;
+    auto value = ParseInt<int64_t>(args[2], {0, max_value}, 10);
+    if (!value) {
+      return {Status::RedisParseErr, "invalid expire time"};
+    }
+    expire_ = is_milliseconds ? *value : *value * 1000;
+    if (!is_absolute) expire_ += util::GetTimeStampMS();
+
+    size_t index = 3;
+    if (index < args.size()) {
+      if (util::EqualICase(args[index], "nx")) {
+        flag_ = HashFieldExpireFlag::kNX;
+      } else if (util::EqualICase(args[index], "xx")) {
+        flag_ = HashFieldExpireFlag::kXX;
+      } else if (util::EqualICase(args[index], "gt")) {
+        flag_ = HashFieldExpireFlag::kGT;
+      } else if (util::EqualICase(args[index], "lt")) {
+        flag_ = HashFieldExpireFlag::kLT;
+      }
+      if (flag_ != HashFieldExpireFlag::kNone) index++;
+    }
+    fields_index_ = GET_OR_RET(ParseFieldsArgument(args, index));
+    return Commander::Parse(args);
+  }
+
+  Status Execute(Server *srv, Connection *conn, std::string *output) override {
+    std::vector<Slice> fields(args_.begin() + static_cast<int64_t>(fields_index_), args_.end());
+    std::vector<int64_t> results;
+    redis::Hash hash_db(srv->storage, conn->GetNamespace());
+    auto s = hash_db.ExpireFields(args_[1], expire_, fields, flag_, &results);
+    if (!s.ok() && !s.IsNotFound()) {
+      return {Status::RedisExecErr, s.ToString()};
+    }
+    if (s.IsNotFound()) {
+      results.assign(fields.size(), kHashFieldNotExist);
+    }
+
+    output->append(redis::MultiLen(results.size()));
+    for (const auto &result : results) {
+      output->append(redis::Integer(result));
+    }
+    return Status::OK();
+  }
+
+ private:
+  uint64_t expire_ = 0;
+  HashFieldExpireFlag flag_ = HashFieldExpireFlag::kNone;
+  size_t fields_index_ = 0;
+};
+
+class CommandHExpire : public CommandHExpireImpl<false, false> {};
+
+class CommandHPExpire : public CommandHExpireImpl<true, false> {};
+
+class CommandHExpireAt : public CommandHExpireImpl<false, true> {};
+
+class CommandHPExpireAt : public CommandHExpireImpl<true, true> {};
+
+template <bool is_milliseconds, bool is_absolute>
+class CommandHTTLImpl : public Commander {
+ public:
+  Status Parse(const std::vector<std::string> &args) override {
+    fields_index_ = GET_OR_RET(ParseFieldsArgument(args, 2));
+    return Commander::Parse(args);
+  }
+
+  Status Execute(Server *srv, Connection *conn, std::string *output) override {
+    std::vector<Slice> fields(args_.begin() + static_cast<int64_t>(fields_index_), args_.end());
+    std::vector<int64_t> expire_times;
+    redis::Hash hash_db(srv->storage, conn->GetNamespace());
+    auto s = hash_db.GetFieldsExpireTime(args_[1], fields, &expire_times);
+    if (!s.ok() && !s.IsNotFound()) {
+      return {Status::RedisExecErr, s.ToString()};
+    }
+    if (s.IsNotFound()) {
+      expire_times.assign(fields.size(), kHashFieldNotExist);
+    }
+
+    auto now = static_cast<int64_t>(util::GetTimeStampMS());
+    output->append(redis::MultiLen(expire_times.size()));
+    for (auto expire : expire_times) {
+      if (expire >= 0) {
+        int64_t value = is_absolute ? expire : std::max<int64_t>(expire - now, 0);
+        if (!is_milliseconds) value = is_absolute ? value / 1000 : (value + 500) / 1000;
+        expire = value;
+      }
+      output->append(redis::Integer(expire));
+    }
+    return Status::OK();
+  }
+
+ private:
+  size_t fields_index_ = 0;
+};
+
+class CommandHTTL : public CommandHTTLImpl<false, false> {};
+
+class CommandHPTTL : public CommandHTTLImpl<true, false> {};
+
+class CommandHExpireTime : public CommandHTTLImpl<false, true> {};
+
+class CommandHPExpireTime : public CommandHTTLImpl<true, true> {};
+
+class CommandHPersist : public Commander {
+ public:
+  Status Parse(const std::vector<std::string> &args) override {
+    fields_index_ = GET_OR_RET(ParseFieldsArgument(args, 2));
+    return Commander::Parse(args);
+  }
+
+  Status Execute(Server *srv, Connection *conn, std::string *output) override {
+    std::vector<Slice> fields(args_.begin() + static_cast<int64_t>(fields_index_), args_.end());
+    std::vector<int64_t> results;
+    redis::Hash hash_db(srv->storage, conn->GetNamespace());
+    auto s = hash_db.PersistFields(args_[1], fields, &results);
+    if (!s.ok() && !s.IsNotFound()) {
+      return {Status::RedisExecErr, s.ToString()};
+    }
+    if (s.IsNotFound()) {
+      results.assign(fields.size(), kHashFieldNotExist);
+    }
+
+    output->append(redis::MultiLen(results.size()));
+    for (const auto &result : results) {
+      output->append(redis::Integer(result));
+    }
+    return Status::OK();
+  }
+
+ private:
+  size_t fields_index_ = 0;
+};
+
 REDIS_REGISTER_COMMANDS(MakeCmdAttr<CommandHGet>("hget", 3, "read-only", 1, 1, 1),
                         MakeCmdAttr<CommandHIncrBy>("hincrby", 4, "write", 1, 1, 1),
                         MakeCmdAttr<CommandHIncrByFloat>("hincrbyfloat", 4, "write", 1, 1, 1),
@@ -450,6 +607,15 @@ REDIS_REGISTER_COMMANDS(MakeCmdAttr<CommandHGet>("hget", 3, "read-only", 1, 1, 1
                         MakeCmdAttr<CommandHGetAll>("hgetall", 2, "read-only", 1, 1, 1),
                         MakeCmdAttr<CommandHScan>("hscan", -3, "read-only", 1, 1, 1),
                         MakeCmdAttr<CommandHRangeByLex>("hrangebylex", -4, "read-only", 1, 1, 1),
-                        MakeCmdAttr<CommandHRandField>("hrandfield", -2, "read-only", 1, 1, 1), )
+                        MakeCmdAttr<CommandHRandField>("hrandfield", -2, "read-only", 1, 1, 1),
+                        MakeCmdAttr<CommandHExpire>("hexpire", -6, "write", 1, 1, 1),
+                        MakeCmdAttr<CommandHPExpire>("hpexpire", -6, "write", 1, 1, 1),
+                        MakeCmdAttr<CommandHExpireAt>("hexpireat", -6, "write", 1, 1, 1),
+                        MakeCmdAttr<CommandHPExpireAt>("hpexpireat", -6, "write", 1, 1, 1),
+                        MakeCmdAttr<CommandHTTL>("httl", -5, "read-only", 1, 1, 1),
+                        MakeCmdAttr<CommandHPTTL>("hpttl", -5, "read-only", 1, 1, 1),
+                        MakeCmdAttr<CommandHExpireTime>("hexpiretime", -5, "read-only", 1, 1, 1),
+                        MakeCmdAttr<CommandHPExpireTime>("hpexpiretime", -5, "read-only", 1, 1, 1),
+                        MakeCmdAttr<CommandHPersist>("hpersist", -5, "write", 1, 1, 1), )
 
 }  // namespace redis
@@ -85,7 +85,8 @@ class CommandMoveX : public Commander {
 
     Database::CopyResult res = Database::CopyResult::DONE;
     std::string ns_key = redis.AppendNamespacePrefix(key);
-    std::string new_ns_key = ComposeNamespaceKey(ns, key, srv->storage->IsSlotIdEncoded());
+    std::string new_ns_key =
+        ComposeNamespaceKey(srv->storage->EncodeNamespace(ns), key, srv->storage->IsSlotIdEncoded());
     auto s = redis.Copy(ns_key, new_ns_key, true, true, &res);
     if (!s.ok()) return {Status::RedisExecErr, s.ToString()};
 
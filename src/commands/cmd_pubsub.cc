@@ -25,6 +25,21 @@
 
 namespace redis {
 
+// The published message is replicated via the WAL by writing it into the pubsub column family,
+// unless it could be fed to all the replicas in the replication stream directly.
+Status ReplicatePublishedMessage(Server *srv, const std::string &channel, const std::string &msg) {
+  if (srv->GetConfig()->repl_pubsub_side_channel && srv->FeedPubSubMessageToSlaves(channel, msg)) {
+    return Status::OK();
+  }
+
+  redis::PubSub pubsub_db(srv->storage);
+  auto s = pubsub_db.Publish(channel, msg);
+  if (!s.ok()) {
+    return {Status::RedisExecErr, s.ToString()};
+  }
+  return Status::OK();
+}
+
 class CommandPublish : public Commander {
  public:
   Status Execute(Server *srv, Connection *conn, std::string *output) override {
@@ -32,12 +47,7 @@ class CommandPublish : public Commander {
       // Compromise: can't replicate a message to sub-replicas in a cascading-like structure.
       // Replication relies on WAL seq; increasing the seq on a replica will break the replication process,
       // hence the compromise solution
-      redis::PubSub pubsub_db(srv->storage);
-
-      auto s = pubsub_db.Publish(args_[1], args_[2]);
-      if (!s.ok()) {
-        return {Status::RedisExecErr, s.ToString()};
-      }
+      if (auto s = ReplicatePublishedMessage(srv, args_[1], args_[2]); !s) return s;
     }
 
     int receivers = srv->PublishMessage(args_[1], args_[2]);
@@ -55,12 +65,7 @@ class CommandMPublish : public Commander {
 
     for (size_t i = 2; i < args_.size(); i++) {
       if (!srv->IsSlave()) {
-        redis::PubSub pubsub_db(srv->storage);
-
-        auto s = pubsub_db.Publish(args_[1], args_[i]);
-        if (!s.ok()) {
-          return {Status::RedisExecErr, s.ToString()};
-        }
+        if (auto s = ReplicatePublishedMessage(srv, args_[1], args_[i]); !s) return s;
       }
 
       int receivers = srv->PublishMessage(args_[1], args_[i]);
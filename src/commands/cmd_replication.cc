@@ -18,6 +18,10 @@
  *
  */
 
+#include <algorithm>
+#include <optional>
+
+#include "command_parser.h"
 #include "commander.h"
 #include "error_constants.h"
 #include "io_util.h"
@@ -29,6 +33,48 @@
 
 namespace redis {
 
+// Return OK if the seq is in the range of the current WAL
+static Status CheckWALBoundary(engine::Storage *storage, rocksdb::SequenceNumber seq) {
+  if (seq == storage->LatestSeqNumber() + 1) {
+    return Status::OK();
+  }
+
+  // Upper bound
+  if (seq > storage->LatestSeqNumber() + 1) {
+    return {Status::NotOK};
+  }
+
+  // The WAL isn't continuous before the gap left by the writes without the WAL
+  if (seq <= storage->GetWALGapSeq()) {
+    return {Status::NotOK};
+  }
+
+  // Lower bound
+  std::unique_ptr<rocksdb::TransactionLogIterator> iter;
+  auto s = storage->GetWALIter(seq, &iter);
+  if (s.IsOK() && iter->Valid()) {
+    auto batch = iter->GetBatch();
+    if (seq != batch.sequence) {
+      if (seq > batch.sequence) {
+        LOG(ERROR) << "CheckWALBoundary with sequence: " << seq
+                   << ", but GetWALIter return older sequence: " << batch.sequence;
+      }
+      return {Status::NotOK};
+    }
+    return Status::OK();
+  }
+  return {Status::NotOK};
+}
+
+// The WAL batches and the checkpoint files carry the sub keys as they are encoded on the master,
+// so they would be misparsed by a replica using another sub key encoding version.
+static Status CheckReplicaSubkeyEncoding(Connection *conn) {
+  if (conn->GetReplicaSubkeyEncodingVersion() == SUBKEY_ENCODING_VERSION_DEFAULT) return Status::OK();
+  return {Status::RedisExecErr, "mismatched sub key encoding version, the replica uses " +
+                                    std::to_string(conn->GetReplicaSubkeyEncodingVersion()) +
+                                    " while the master uses " + std::to_string(SUBKEY_ENCODING_VERSION_DEFAULT)};
+}
+
 class CommandPSync : public Commander {
  public:
   Status Parse(const std::vector<std::string> &args) override {
@@ -62,6 +108,11 @@ class CommandPSync : public Commander {
               << " replication id: " << (replica_replid_.length() ? replica_replid_ : "not supported")
               << ", and local sequence: " << srv->storage->LatestSeqNumber();
 
+    if (auto s = CheckReplicaSubkeyEncoding(conn); !s) {
+      srv->stats.IncrPSyncErrCount();
+      return s;
+    }
+
     bool need_full_sync = false;
 
     // Check replication id of the last sequence log
@@ -78,7 +129,7 @@ class CommandPSync : public Commander {
     }
 
     // Check Log sequence
-    if (!need_full_sync && !checkWALBoundary(srv->storage, next_repl_seq_).IsOK()) {
+    if (!need_full_sync && !CheckWALBoundary(srv->storage, next_repl_seq_).IsOK()) {
       *output = "sequence out of range, please use fullsync";
       need_full_sync = true;
     }
@@ -118,34 +169,81 @@ class CommandPSync : public Commander {
   rocksdb::SequenceNumber next_repl_seq_ = 0;
   bool new_psync_ = false;
   std::string replica_replid_;
+};
 
-  // Return OK if the seq is in the range of the current WAL
-  static Status checkWALBoundary(engine::Storage *storage, rocksdb::SequenceNumber seq) {
-    if (seq == storage->LatestSeqNumber() + 1) {
-      return Status::OK();
+class CommandCDCSync : public Commander {
+ public:
+  Status Parse(const std::vector<std::string> &args) override {
+    CommandParser parser(args, 1);
+    next_seq_ = GET_OR_RET(parser.TakeInt<uint64_t>());
+
+    while (parser.Good()) {
+      if (parser.EatEqICase("namespace")) {
+        options_.ns = GET_OR_RET(parser.TakeStr());
+      } else if (parser.EatEqICase("match")) {
+        options_.key_pattern = GET_OR_RET(parser.TakeStr());
+      } else if (parser.EatEqICase("type")) {
+        auto type_str = util::ToLower(GET_OR_RET(parser.TakeStr()));
+        auto iter = std::find(RedisTypeNames.begin(), RedisTypeNames.end(), type_str);
+        if (iter == RedisTypeNames.end() || iter == RedisTypeNames.begin()) {
+          return {Status::RedisParseErr, "Invalid type"};
+        }
+        if (!options_.types) options_.types = RedisTypes{};
+        options_.types->Add(static_cast<RedisType>(iter - RedisTypeNames.begin()));
+      } else if (parser.EatEqICase("batch")) {
+        options_.batch_size = GET_OR_RET(parser.TakeInt<size_t>(NumericRange<size_t>{1, 65536}));
+      } else {
+        return parser.InvalidSyntax();
+      }
     }
 
-    // Upper bound
-    if (seq > storage->LatestSeqNumber() + 1) {
-      return {Status::NotOK};
+    return Status::OK();
+  }
+
+  Status Execute(Server *srv, Connection *conn, std::string *output) override {
+    // Only the admin could subscribe to the updates of other namespaces
+    if (!conn->IsAdmin()) {
+      if (!options_.ns.empty() && options_.ns != conn->GetNamespace()) {
+        return {Status::RedisExecErr, errAdminPermissionRequired};
+      }
+      options_.ns = conn->GetNamespace();
     }
 
-    // Lower bound
-    std::unique_ptr<rocksdb::TransactionLogIterator> iter;
-    auto s = storage->GetWALIter(seq, &iter);
-    if (s.IsOK() && iter->Valid()) {
-      auto batch = iter->GetBatch();
-      if (seq != batch.sequence) {
-        if (seq > batch.sequence) {
-          LOG(ERROR) << "checkWALBoundary with sequence: " << seq
-                     << ", but GetWALIter return older sequence: " << batch.sequence;
-        }
-        return {Status::NotOK};
+    if (!CheckWALBoundary(srv->storage, next_seq_).IsOK()) {
+      return {Status::RedisExecErr, "sequence out of range"};
+    }
+
+    LOG(INFO) << "CDC consumer " << conn->GetAddr() << " asks for the updates with next sequence: " << next_seq_
+              << ", and local sequence: " << srv->storage->LatestSeqNumber();
+
+    // Server would spawn a new thread to feed the updates, and connection would
+    // be taken over, so should never trigger any event in worker thread.
+    conn->Detach();
+    conn->EnableFlag(redis::Connection::kSlave);
+    auto s = util::SockSetBlocking(conn->GetFD(), 1);
+    if (!s.IsOK()) {
+      conn->EnableFlag(redis::Connection::kCloseAsync);
+      return s.Prefixed("failed to set blocking mode on socket");
+    }
+
+    s = srv->AddCDCConsumer(conn, next_seq_, std::move(options_));
+    if (!s.IsOK()) {
+      std::string err = "-ERR " + s.Msg() + "\r\n";
+      s = util::SockSend(conn->GetFD(), err, conn->GetBufferEvent());
+      if (!s.IsOK()) {
+        LOG(WARNING) << "failed to send error message to the CDC consumer: " << s.Msg();
       }
-      return Status::OK();
+      conn->EnableFlag(redis::Connection::kCloseAsync);
+      LOG(WARNING) << "Failed to add CDC consumer: " << conn->GetAddr();
+    } else {
+      LOG(INFO) << "New CDC consumer: " << conn->GetAddr() << " was added";
     }
-    return {Status::NotOK};
+    return s;
   }
+
+ private:
+  rocksdb::SequenceNumber next_seq_ = 0;
+  CDCFeedOptions options_;
 };
 
 class CommandReplConf : public Commander {
@@ -178,6 +276,15 @@ class CommandReplConf : public Commander {
         return {Status::RedisParseErr, "ip-address should not be empty"};
       }
       ip_address_ = value;
+    } else if (option == "subkey-encoding-version") {
+      auto parse_result = ParseInt<uint8_t>(value, 10);
+      if (!parse_result) {
+        return {Status::RedisParseErr, "subkey-encoding-version should be number or out of range"};
+      }
+      subkey_encoding_version_ = *parse_result;
+    } else if (option == "capa") {
+      // ignore the unknown capabilities like Redis, they may be supported by the newer versions
+      if (util::ToLower(value) == "pubsub") capa_pubsub_ = true;
     } else {
       return {Status::RedisParseErr, errUnknownOption};
     }
@@ -192,6 +299,12 @@ class CommandReplConf : public Commander {
     if (!ip_address_.empty()) {
       conn->SetAnnounceIP(ip_address_);
     }
+    if (capa_pubsub_) {
+      conn->SetReplicaPubSubCapa(true);
+    }
+    if (subkey_encoding_version_) {
+      conn->SetReplicaSubkeyEncodingVersion(*subkey_encoding_version_);
+    }
     *output = redis::SimpleString("OK");
     return Status::OK();
   }
@@ -199,6 +312,8 @@ class CommandReplConf : public Commander {
  private:
   int port_ = 0;
   std::string ip_address_;
+  bool capa_pubsub_ = false;
+  std::optional<uint8_t> subkey_encoding_version_;
 };
 
 class CommandFetchMeta : public Commander {
@@ -206,6 +321,12 @@ class CommandFetchMeta : public Commander {
   Status Parse(const std::vector<std::string> &args) override { return Status::OK(); }
 
   Status Execute(Server *srv, Connection *conn, std::string *output) override {
+    if (auto s = CheckReplicaSubkeyEncoding(conn); !s) return s;
+    // the replica couldn't continue with PSYNC after the full sync
+    if (srv->storage->HasWALDisabledNamespaces()) {
+      return {Status::RedisExecErr, "can't sync with a replica while wal-disabled-namespaces is set"};
+    }
+
     int repl_fd = conn->GetFD();
     std::string ip = conn->GetAnnounceIP();
 
@@ -217,9 +338,12 @@ class CommandFetchMeta : public Commander {
     conn->NeedNotFreeBufferEvent();
     conn->EnableFlag(redis::Connection::kCloseAsync);
     srv->stats.IncrFullSyncCount();
+    // the published messages are replicated via the WAL until the replica PSYNC from the checkpoint
+    srv->AddFullSyncReplica(conn);
 
     // Feed-replica-meta thread
     auto t = GET_OR_RET(util::CreateThread("feed-repl-info", [srv, repl_fd, ip, bev = conn->GetBufferEvent()] {
+      srv->SetReplicationThreadAffinity();
       srv->IncrFetchFileThread();
       auto exit = MakeScopeExit([srv, bev] {
         bufferevent_free(bev);
@@ -276,6 +400,7 @@ class CommandFetchFile : public Commander {
     conn->EnableFlag(redis::Connection::kCloseAsync);
 
     auto t = GET_OR_RET(util::CreateThread("feed-repl-file", [srv, repl_fd, ip, files, bev = conn->GetBufferEvent()]() {
+      srv->SetReplicationThreadAffinity();
       auto exit = MakeScopeExit([bev] { bufferevent_free(bev); });
       srv->IncrFetchFileThread();
 
@@ -341,6 +466,8 @@ class CommandDBName : public Commander {
 
 REDIS_REGISTER_COMMANDS(MakeCmdAttr<CommandReplConf>("replconf", -3, "read-only replication no-script", 0, 0, 0),
                         MakeCmdAttr<CommandPSync>("psync", -2, "read-only replication no-multi no-script", 0, 0, 0),
+                        MakeCmdAttr<CommandCDCSync>("cdcsync", -2, "read-only replication no-multi no-script", 0, 0,
+                                                    0),
                         MakeCmdAttr<CommandFetchMeta>("_fetch_meta", 1, "read-only replication no-multi no-script", 0,
                                                       0, 0),
                         MakeCmdAttr<CommandFetchFile>("_fetch_file", 2, "read-only replication no-multi no-script", 0,
@@ -21,6 +21,8 @@
 #include <rocksdb/iostats_context.h>
 #include <rocksdb/perf_context.h>
 
+#include <future>
+
 #include "command_parser.h"
 #include "commander.h"
 #include "commands/scan_base.h"
@@ -30,6 +32,7 @@
 #include "error_constants.h"
 #include "server/redis_connection.h"
 #include "server/server.h"
+#include "stats/cpu_profiler.h"
 #include "stats/disk_stats.h"
 #include "storage/rdb.h"
 #include "string_util.h"
@@ -138,7 +141,55 @@ class CommandKeys : public Commander {
   }
 };
 
-class CommandFlushDB : public Commander {
+// The flushed keys are removed by range deletions, the space is reclaimed by compacting the flushed range
+// of the data column families in the task runner, and the SYNC flag waits for the compaction before replying.
+// The keys were flushed anyway, so a failed compaction is only logged.
+static void CompactFlushedRange(Server *srv, const std::string &begin_key, const std::string &end_key, bool sync) {
+  std::future<rocksdb::Status> compacted;
+  std::function<void(const rocksdb::Status &)> done;
+  if (sync) {
+    auto promise = std::make_shared<std::promise<rocksdb::Status>>();
+    compacted = promise->get_future();
+    done = [promise](const rocksdb::Status &s) { promise->set_value(s); };
+  }
+
+  auto s = srv->AsyncCompactFlushedRange(begin_key, end_key, std::move(done));
+  if (!s.IsOK()) {
+    LOG(WARNING) << "The keys were flushed, but failed to schedule the compaction: " << s.Msg();
+    return;
+  }
+  if (!sync) return;
+
+  try {
+    if (auto compact_s = compacted.get(); !compact_s.ok()) {
+      LOG(WARNING) << "The keys were flushed, but failed to compact them: " << compact_s.ToString();
+    }
+  } catch (const std::future_error &e) {
+    // the queued compaction is dropped if the task runner is stopped
+    LOG(WARNING) << "The keys were flushed, but the compaction was cancelled: " << e.what();
+  }
+}
+
+class CommandFlushBase : public Commander {
+ public:
+  Status Parse(const std::vector<std::string> &args) override {
+    CommandParser parser(args, 1);
+    if (parser.Good()) {
+      if (parser.EatEqICase("sync")) {
+        sync_ = true;
+      } else if (!parser.EatEqICase("async")) {
+        return parser.InvalidSyntax();
+      }
+    }
+    if (parser.Good()) return parser.InvalidSyntax();
+    return Status::OK();
+  }
+
+ protected:
+  bool sync_ = false;
+};
+
+class CommandFlushDB : public CommandFlushBase {
  public:
   Status Execute(Server *srv, Connection *conn, std::string *output) override {
     if (srv->GetConfig()->cluster_enabled) {
@@ -151,6 +202,9 @@ class CommandFlushDB : public Commander {
     auto s = redis.FlushDB();
     LOG(WARNING) << "DB keys in namespace: " << conn->GetNamespace() << " was flushed, addr: " << conn->GetAddr();
     if (s.ok()) {
+      std::string begin_key, end_key;
+      redis.GetNamespaceKeyRange(&begin_key, &end_key);
+      CompactFlushedRange(srv, begin_key, end_key, sync_);
       *output = redis::SimpleString("OK");
       return Status::OK();
     }
@@ -159,7 +213,7 @@ class CommandFlushDB : public Commander {
   }
 };
 
-class CommandFlushAll : public Commander {
+class CommandFlushAll : public CommandFlushBase {
  public:
   Status Execute(Server *srv, Connection *conn, std::string *output) override {
     if (!conn->IsAdmin()) {
@@ -177,6 +231,7 @@ class CommandFlushAll : public Commander {
     auto s = redis.FlushAll();
     if (s.ok()) {
       LOG(WARNING) << "All DB keys was flushed, addr: " << conn->GetAddr();
+      CompactFlushedRange(srv, "", "", sync_);
       *output = redis::SimpleString("OK");
       return Status::OK();
     }
@@ -424,6 +479,34 @@ class CommandClient : public Commander {
       return Status::OK();
     }
 
+    if (subcommand_ == "tracking" && args.size() >= 3) {
+      if (util::EqualICase(args[2], "on")) {
+        tracking_on_ = true;
+      } else if (!util::EqualICase(args[2], "off")) {
+        return {Status::RedisParseErr, errInvalidSyntax};
+      }
+
+      for (size_t i = 3; i < args.size(); i++) {
+        if (util::EqualICase(args[i], "bcast")) {
+          tracking_bcast_ = true;
+        } else if (util::EqualICase(args[i], "noloop")) {
+          tracking_noloop_ = true;
+        } else if (util::EqualICase(args[i], "prefix") && i + 1 < args.size()) {
+          tracking_prefixes_.emplace_back(args[++i]);
+        } else if (util::EqualICase(args[i], "redirect") || util::EqualICase(args[i], "optin") ||
+                   util::EqualICase(args[i], "optout")) {
+          return {Status::RedisParseErr, "the " + args[i] + " option of CLIENT TRACKING isn't supported"};
+        } else {
+          return {Status::RedisParseErr, errInvalidSyntax};
+        }
+      }
+
+      if (!tracking_prefixes_.empty() && !tracking_bcast_) {
+        return {Status::RedisParseErr, "PREFIX option requires BCAST mode to be enabled"};
+      }
+      return Status::OK();
+    }
+
     if ((subcommand_ == "kill")) {
       if (args.size() == 2) {
         return {Status::RedisParseErr, errInvalidSyntax};
@@ -476,7 +559,7 @@ class CommandClient : public Commander {
       }
       return Status::OK();
     }
-    return {Status::RedisInvalidCmd, "Syntax error, try CLIENT LIST|INFO|KILL ip:port|GETNAME|SETNAME"};
+    return {Status::RedisInvalidCmd, "Syntax error, try CLIENT LIST|INFO|KILL ip:port|GETNAME|SETNAME|TRACKING"};
   }
 
   Status Execute(Server *srv, Connection *conn, std::string *output) override {
@@ -497,6 +580,19 @@ class CommandClient : public Commander {
     } else if (subcommand_ == "id") {
       *output = redis::Integer(conn->GetID());
       return Status::OK();
+    } else if (subcommand_ == "tracking") {
+      if (!tracking_on_) {
+        conn->DisableTracking();
+      } else {
+        // the invalidation messages are pushed to the connection itself, which requires RESP3
+        if (conn->GetProtocolVersion() != RESP::v3) {
+          return {Status::RedisExecErr, "client tracking requires RESP3, switch the protocol by HELLO 3 first"};
+        }
+        auto s = conn->EnableTracking(tracking_bcast_, tracking_noloop_, tracking_prefixes_);
+        if (!s.IsOK()) return {Status::RedisExecErr, s.Msg()};
+      }
+      *output = redis::SimpleString("OK");
+      return Status::OK();
     } else if (subcommand_ == "kill") {
       int64_t killed = 0;
       srv->KillClient(&killed, addr_, id_, kill_type_, skipme_, conn);
@@ -511,7 +607,7 @@ class CommandClient : public Commander {
       return Status::OK();
     }
 
-    return {Status::RedisInvalidCmd, "Syntax error, try CLIENT LIST|INFO|KILL ip:port|GETNAME|SETNAME"};
+    return {Status::RedisInvalidCmd, "Syntax error, try CLIENT LIST|INFO|KILL ip:port|GETNAME|SETNAME|TRACKING"};
   }
 
  private:
@@ -522,6 +618,10 @@ class CommandClient : public Commander {
   int64_t kill_type_ = 0;
   uint64_t id_ = 0;
   bool new_format_ = true;
+  bool tracking_on_ = false;
+  bool tracking_bcast_ = false;
+  bool tracking_noloop_ = false;
+  std::vector<std::string> tracking_prefixes_;
 };
 
 class CommandMonitor : public Commander {
@@ -580,8 +680,24 @@ class CommandDebug : public Commander {
 
       dbsize_limit_ = static_cast<bool>(val);
       return Status::OK();
+    } else if (subcommand_ == "profile" && args.size() >= 3) {
+      profile_action_ = util::ToLower(args[2]);
+      if (profile_action_ == "start" && args.size() <= 4) {
+        if (args.size() == 4) {
+          auto frequency = ParseInt<int>(args[3], {1, CpuProfiler::kMaxFrequency}, 10);
+          if (!frequency) {
+            return {Status::RedisParseErr, "invalid debug profile sampling frequency"};
+          }
+          profile_frequency_ = *frequency;
+        }
+        return Status::OK();
+      } else if (profile_action_ == "stop" && args.size() == 3) {
+        return Status::OK();
+      }
     }
-    return {Status::RedisInvalidCmd, "Syntax error, DEBUG SLEEP <seconds>|PROTOCOL <type>|DBSIZE-LIMIT <0|1>"};
+    return {Status::RedisInvalidCmd,
+            "Syntax error, DEBUG SLEEP <seconds>|PROTOCOL <type>|DBSIZE-LIMIT <0|1>|PROFILE START [frequency]|PROFILE "
+            "STOP"};
   }
 
   Status Execute(Server *srv, Connection *conn, std::string *output) override {
@@ -636,8 +752,19 @@ class CommandDebug : public Commander {
     } else if (subcommand_ == "dbsize-limit") {
       srv->storage->SetDBSizeLimit(dbsize_limit_);
       *output = redis::SimpleString("OK");
+    } else if (subcommand_ == "profile") {
+      if (profile_action_ == "start") {
+        auto s = CpuProfiler::Start(profile_frequency_);
+        if (!s.IsOK()) return {Status::RedisExecErr, s.Msg()};
+        *output = redis::SimpleString("OK");
+      } else {
+        // the stacks are returned in the collapsed-stack format, which could be rendered by flamegraph.pl
+        auto stacks = CpuProfiler::Stop();
+        if (!stacks) return {Status::RedisExecErr, stacks.Msg()};
+        *output = redis::BulkString(*stacks);
+      }
     } else {
-      return {Status::RedisInvalidCmd, "Unknown subcommand, should be SLEEP, PROTOCOL or DBSIZE-LIMIT"};
+      return {Status::RedisInvalidCmd, "Unknown subcommand, should be SLEEP, PROTOCOL, DBSIZE-LIMIT or PROFILE"};
     }
     return Status::OK();
   }
@@ -647,6 +774,8 @@ class CommandDebug : public Commander {
   std::string protocol_type_;
   uint64_t microsecond_ = 0;
   bool dbsize_limit_ = false;
+  std::string profile_action_;
+  int profile_frequency_ = CpuProfiler::kDefaultFrequency;
 };
 
 class CommandCommand : public Commander {
@@ -872,7 +1001,7 @@ class CommandCompact : public Commander {
     auto ns = conn->GetNamespace();
 
     if (ns != kDefaultNamespace) {
-      std::string prefix = ComposeNamespaceKey(ns, "", false);
+      std::string prefix = ComposeNamespaceKey(srv->storage->EncodeNamespace(ns), "", false);
 
       redis::Database redis_db(srv->storage, conn->GetNamespace());
       auto s = redis_db.FindKeyRangeWithPrefix(prefix, std::string(), &begin_key, &end_key);
@@ -1285,8 +1414,8 @@ REDIS_REGISTER_COMMANDS(MakeCmdAttr<CommandAuth>("auth", 2, "read-only ok-loadin
                         MakeCmdAttr<CommandConfig>("config", -2, "read-only", 0, 0, 0, GenerateConfigFlag),
                         MakeCmdAttr<CommandNamespace>("namespace", -3, "read-only exclusive", 0, 0, 0),
                         MakeCmdAttr<CommandKeys>("keys", 2, "read-only", 0, 0, 0),
-                        MakeCmdAttr<CommandFlushDB>("flushdb", 1, "write no-dbsize-check", 0, 0, 0),
-                        MakeCmdAttr<CommandFlushAll>("flushall", 1, "write no-dbsize-check", 0, 0, 0),
+                        MakeCmdAttr<CommandFlushDB>("flushdb", -1, "write no-dbsize-check", 0, 0, 0),
+                        MakeCmdAttr<CommandFlushAll>("flushall", -1, "write no-dbsize-check", 0, 0, 0),
                         MakeCmdAttr<CommandDBSize>("dbsize", -1, "read-only", 0, 0, 0),
                         MakeCmdAttr<CommandSlowlog>("slowlog", -2, "read-only", 0, 0, 0),
                         MakeCmdAttr<CommandPerfLog>("perflog", -2, "read-only", 0, 0, 0),
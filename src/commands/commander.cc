@@ -20,6 +20,8 @@
 
 #include "commander.h"
 
+#include <cctype>
+
 #include "cluster/cluster_defs.h"
 
 namespace redis {
@@ -27,9 +29,44 @@ namespace redis {
 RegisterToCommandTable::RegisterToCommandTable(std::initializer_list<CommandAttributes> list) {
   for (const auto &attr : list) {
     CommandTable::redis_command_table.emplace_back(attr);
+    CommandTable::redis_command_table.back().id = CommandTable::redis_command_table.size() - 1;
     CommandTable::original_commands[attr.name] = &CommandTable::redis_command_table.back();
     CommandTable::commands[attr.name] = &CommandTable::redis_command_table.back();
   }
+  CommandTable::UpdateLookupIndex();
+}
+
+void CommandLookupIndex::Build(const CommandMap &commands) {
+  // keep the load factor under 0.5 to make probe sequences short
+  size_t capacity = 16;
+  while (capacity < commands.size() * 2) capacity <<= 1;
+
+  slots_.assign(capacity, {});
+  mask_ = capacity - 1;
+  for (const auto &[name, attributes] : commands) {
+    size_t i = hash(name) & mask_;
+    while (slots_[i].second) i = (i + 1) & mask_;
+    slots_[i] = {name, attributes};
+  }
+}
+
+const CommandAttributes *CommandLookupIndex::Find(std::string_view name) const {
+  if (slots_.empty()) return nullptr;
+
+  for (size_t i = hash(name) & mask_; slots_[i].second; i = (i + 1) & mask_) {
+    if (util::EqualICase(slots_[i].first, name)) return slots_[i].second;
+  }
+  return nullptr;
+}
+
+uint64_t CommandLookupIndex::hash(std::string_view name) {
+  // FNV-1a over the lowercase bytes
+  uint64_t h = 14695981039346656037ULL;
+  for (char c : name) {
+    h ^= static_cast<uint8_t>(std::tolower(static_cast<unsigned char>(c)));
+    h *= 1099511628211ULL;
+  }
+  return h;
 }
 
 size_t CommandTable::Size() { return redis_command_table.size(); }
@@ -38,7 +75,10 @@ const CommandMap *CommandTable::GetOriginal() { return &original_commands; }
 
 CommandMap *CommandTable::Get() { return &commands; }
 
-void CommandTable::Reset() { commands = original_commands; }
+void CommandTable::Reset() {
+  commands = original_commands;
+  UpdateLookupIndex();
+}
 
 std::string CommandTable::GetCommandInfo(const CommandAttributes *command_attributes) {
   std::string command, command_flags;
@@ -33,6 +33,7 @@
 #include <map>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <utility>
 #include <vector>
@@ -65,6 +66,7 @@ enum CommandFlags : uint64_t {
   kCmdROScript = 1ULL << 10,       // "ro-script" flag for read-only script commands
   kCmdCluster = 1ULL << 11,        // "cluster" flag
   kCmdNoDBSizeCheck = 1ULL << 12,  // "no-dbsize-check" flag
+  kCmdBlocking = 1ULL << 13,       // "blocking" flag
 };
 
 class Commander {
@@ -93,6 +95,17 @@ class CommanderWithParseMove : Commander {
 
 using CommanderFactory = std::function<std::unique_ptr<Commander>()>;
 
+using CommanderResetter = void (*)(Commander *);
+
+/// ResetCommander brings a used commander back to the state of a newly created one,
+/// so that it could be reused by the next command without allocating a new one.
+template <typename T>
+void ResetCommander(Commander *cmd) {
+  auto *derived = static_cast<T *>(cmd);
+  derived->~T();
+  new (derived) T();
+}
+
 struct CommandKeyRange {
   // index of the first key in command tokens
   // 0 stands for no key, since the first index of command arguments is command name
@@ -144,6 +157,12 @@ struct CommandAttributes {
   // commander object generator
   CommanderFactory factory;
 
+  // reset a commander object created by `factory` for reuse
+  CommanderResetter reset = nullptr;
+
+  // index in the command table, assigned on registration
+  size_t id = 0;
+
   auto GenerateFlags(const std::vector<std::string> &args) const {
     uint64_t res = flags;
     if (flag_gen) res = flag_gen(res, args);
@@ -157,6 +176,20 @@ struct CommandAttributes {
 
 using CommandMap = std::map<std::string, const CommandAttributes *>;
 
+/// CommandLookupIndex is a case-insensitive open addressing hash index of a command map,
+/// so that a command could be found by the name in the request without lowercasing it first.
+class CommandLookupIndex {
+ public:
+  void Build(const CommandMap &commands);
+  const CommandAttributes *Find(std::string_view name) const;
+
+ private:
+  static uint64_t hash(std::string_view name);
+
+  std::vector<std::pair<std::string, const CommandAttributes *>> slots_;
+  size_t mask_ = 0;
+};
+
 inline uint64_t ParseCommandFlags(const std::string &description, const std::string &cmd_name) {
   uint64_t flags = 0;
 
@@ -185,6 +218,8 @@ inline uint64_t ParseCommandFlags(const std::string &description, const std::str
       flags |= kCmdCluster;
     else if (flag == "no-dbsize-check")
       flags |= kCmdNoDBSizeCheck;
+    else if (flag == "blocking")
+      flags |= kCmdBlocking;
     else {
       std::cout << fmt::format("Encountered non-existent flag '{}' in command {} in command attribute parsing", flag,
                                cmd_name)
@@ -207,7 +242,8 @@ auto MakeCmdAttr(const std::string &name, int arity, const std::string &descript
                          {first_key, last_key, key_step},
                          {},
                          {},
-                         []() -> std::unique_ptr<Commander> { return std::unique_ptr<Commander>(new T()); }};
+                         []() -> std::unique_ptr<Commander> { return std::unique_ptr<Commander>(new T()); },
+                         &ResetCommander<T>};
 
   if ((first_key > 0 && key_step <= 0) || (first_key > 0 && last_key >= 0 && last_key < first_key)) {
     std::cout << fmt::format("Encountered invalid key range in command {}", name) << std::endl;
@@ -228,7 +264,8 @@ auto MakeCmdAttr(const std::string &name, int arity, const std::string &descript
                          {-1, 0, 0},
                          gen,
                          {},
-                         []() -> std::unique_ptr<Commander> { return std::unique_ptr<Commander>(new T()); }};
+                         []() -> std::unique_ptr<Commander> { return std::unique_ptr<Commander>(new T()); },
+                         &ResetCommander<T>};
 
   return attr;
 }
@@ -244,7 +281,8 @@ auto MakeCmdAttr(const std::string &name, int arity, const std::string &descript
                          {-2, 0, 0},
                          {},
                          vec_gen,
-                         []() -> std::unique_ptr<Commander> { return std::unique_ptr<Commander>(new T()); }};
+                         []() -> std::unique_ptr<Commander> { return std::unique_ptr<Commander>(new T()); },
+                         &ResetCommander<T>};
 
   return attr;
 }
@@ -261,6 +299,11 @@ struct CommandTable {
   static const CommandMap *GetOriginal();
   static void Reset();
 
+  // Find a command of the current command table by case-insensitive name, return nullptr if not found
+  static const CommandAttributes *Lookup(std::string_view name) { return lookup_index.Find(name); }
+  // Must be called after the command table returned by `Get` is modified
+  static void UpdateLookupIndex() { lookup_index.Build(commands); }
+
   static void GetAllCommandsInfo(std::string *info);
   static void GetCommandsInfo(std::string *info, const std::vector<std::string> &cmd_names);
   static std::string GetCommandInfo(const CommandAttributes *command_attributes);
@@ -281,6 +324,9 @@ struct CommandTable {
   // Command table after rename-command directive
   static inline CommandMap commands;
 
+  // Lookup index of `commands`
+  static inline CommandLookupIndex lookup_index;
+
   friend struct RegisterToCommandTable;
 };
 
@@ -275,10 +275,12 @@ Status SockSendFile(int out_fd, int in_fd, size_t size, ssl_st *ssl) {
 #ifdef ENABLE_OPENSSL
   if (ssl) {
 #if OPENSSL_VERSION_NUMBER >= 0x30000000L
-    return SockSendFileImpl<SSL_sendfile>(ssl, in_fd, size, 0);
-#else
-    return SockSendFileImpl<SendFileSSLImpl>(ssl, in_fd, size);
+    // SSL_sendfile only works when the records are encrypted by the kernel
+    if (IsKTLSSendEnabled(ssl)) {
+      return SockSendFileImpl<SSL_sendfile>(ssl, in_fd, size, 0);
+    }
 #endif
+    return SockSendFileImpl<SendFileSSLImpl>(ssl, in_fd, size);
   }
 #endif
   return SockSendFile(out_fd, in_fd, size);
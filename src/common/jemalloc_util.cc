@@ -0,0 +1,106 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "jemalloc_util.h"
+
+#include <fmt/format.h>
+
+#include <mutex>
+#include <vector>
+
+#ifndef DISABLE_JEMALLOC
+#include <jemalloc/jemalloc.h>
+#endif
+
+namespace util {
+
+#ifndef DISABLE_JEMALLOC
+
+static std::mutex released_arenas_mu;
+static std::vector<unsigned> released_arenas;
+
+StatusOr<unsigned> BindThreadToNewArena() {
+  unsigned arena = 0;
+  {
+    std::lock_guard<std::mutex> guard(released_arenas_mu);
+    if (!released_arenas.empty()) {
+      arena = released_arenas.back();
+      released_arenas.pop_back();
+    }
+  }
+  if (arena == 0) {
+    size_t len = sizeof(arena);
+    if (int ret = mallctl("arenas.create", &arena, &len, nullptr, 0); ret != 0) {
+      return {Status::NotOK, fmt::format("failed to create the arena, errno: {}", ret)};
+    }
+  }
+
+  // the thread cache may hold the memory freed from other arenas, flush it before binding
+  mallctl("thread.tcache.flush", nullptr, nullptr, nullptr, 0);
+  if (int ret = mallctl("thread.arena", nullptr, nullptr, &arena, sizeof(arena)); ret != 0) {
+    ReleaseArena(arena);
+    return {Status::NotOK, fmt::format("failed to bind the arena {}, errno: {}", arena, ret)};
+  }
+  return arena;
+}
+
+void ReleaseArena(unsigned arena) {
+  std::lock_guard<std::mutex> guard(released_arenas_mu);
+  released_arenas.push_back(arena);
+}
+
+void RefreshAllocatorStats() {
+  uint64_t epoch = 1;
+  size_t len = sizeof(epoch);
+  mallctl("epoch", &epoch, &len, &epoch, len);
+}
+
+StatusOr<ArenaStats> GetArenaStats(unsigned arena) {
+  auto read_stat = [arena](const char *name, size_t *value) {
+    size_t len = sizeof(*value);
+    return mallctl(fmt::format("stats.arenas.{}.{}", arena, name).c_str(), value, &len, nullptr, 0);
+  };
+
+  size_t small_allocated = 0, large_allocated = 0, pactive = 0, page_size = 0;
+  size_t len = sizeof(page_size);
+  if (read_stat("small.allocated", &small_allocated) != 0 || read_stat("large.allocated", &large_allocated) != 0 ||
+      read_stat("pactive", &pactive) != 0 || mallctl("arenas.page", &page_size, &len, nullptr, 0) != 0) {
+    return {Status::NotOK, fmt::format("failed to get the stats of the arena {}", arena)};
+  }
+
+  ArenaStats stats;
+  stats.allocated = small_allocated + large_allocated;
+  stats.active = pactive * page_size;
+  return stats;
+}
+
+#else
+
+StatusOr<unsigned> BindThreadToNewArena() { return {Status::NotSupported, "kvrocks is built without jemalloc"}; }
+
+void ReleaseArena(unsigned) {}
+
+void RefreshAllocatorStats() {}
+
+StatusOr<ArenaStats> GetArenaStats(unsigned) { return {Status::NotSupported, "kvrocks is built without jemalloc"}; }
+
+#endif
+
+}  // namespace util
@@ -0,0 +1,48 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+
+#include "status.h"
+
+namespace util {
+
+struct ArenaStats {
+  // bytes allocated by the application from the arena
+  uint64_t allocated = 0;
+  // bytes of the pages which are in active use by the arena
+  uint64_t active = 0;
+};
+
+// Create an arena (or reuse one released by ReleaseArena) and bind it to the calling thread,
+// so that all the allocations of the thread would be served by the arena.
+// The arenas of jemalloc can't be destroyed while some allocations are still alive,
+// so they are recycled instead.
+StatusOr<unsigned> BindThreadToNewArena();
+// Put back the arena to be reused by the following BindThreadToNewArena calls.
+// The arena should no longer be bound to any thread.
+void ReleaseArena(unsigned arena);
+// Refresh the statistics of jemalloc, which are cached until the next refresh.
+void RefreshAllocatorStats();
+StatusOr<ArenaStats> GetArenaStats(unsigned arena);
+
+}  // namespace util
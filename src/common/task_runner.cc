@@ -38,6 +38,14 @@ Status TaskRunner::Start() {
   return Status::OK();
 }
 
+Status TaskRunner::SetAffinity(const std::vector<int> &cpus) {
+  for (auto &thread : threads_) {
+    if (auto s = util::ThreadSetAffinity(thread, cpus); !s) return s;
+  }
+
+  return Status::OK();
+}
+
 Status TaskRunner::Join() {
   if (state_ == Stopped) {
     return {Status::NotOK, "Task runner is expected to start before joining"};
@@ -24,6 +24,7 @@
 #include <cstdint>
 #include <functional>
 #include <thread>
+#include <vector>
 
 #include "oneapi/tbb/concurrent_queue.h"
 #include "status.h"
@@ -72,6 +73,8 @@ class TaskRunner {
 
   Status Start();
   Status Join();
+  // Pin all the threads of the runner to the CPUs, it should be called after starting
+  Status SetAffinity(const std::vector<int>& cpus);
 
  private:
   void run();
@@ -20,8 +20,18 @@
 
 #include "thread_util.h"
 
+#include <dirent.h>
 #include <fmt/std.h>
 #include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <fstream>
+
+#include "parse_util.h"
+#include "string_util.h"
 
 namespace util {
 
@@ -48,4 +58,164 @@ Status ThreadJoin(std::thread &t) { return ThreadOperationImpl<&std::thread::joi
 
 Status ThreadDetach(std::thread &t) { return ThreadOperationImpl<&std::thread::detach>(t, "detach"); }
 
+StatusOr<std::vector<int>> ParseCPUList(std::string_view list) {
+  // the same limit of the CPU ids as the kernel, which is much larger than CPU_SETSIZE
+  constexpr int max_cpu = 8192;
+
+  std::vector<int> cpus;
+  for (const auto &range : Split(list, ",")) {
+    auto pos = range.find('-');
+    auto first = GET_OR_RET(ParseInt<int>(Trim(range.substr(0, pos), " "), {0, max_cpu - 1}, 10)
+                                .Prefixed(fmt::format("invalid CPU list '{}'", list)));
+    auto last = first;
+    if (pos != std::string::npos) {
+      last = GET_OR_RET(ParseInt<int>(Trim(range.substr(pos + 1), " "), {0, max_cpu - 1}, 10)
+                            .Prefixed(fmt::format("invalid CPU list '{}'", list)));
+    }
+    if (first > last) {
+      return {Status::NotOK, fmt::format("invalid CPU range '{}', the first CPU should not be larger", range)};
+    }
+    for (int cpu = first; cpu <= last; cpu++) {
+      cpus.push_back(cpu);
+    }
+  }
+
+  std::sort(cpus.begin(), cpus.end());
+  cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+  return cpus;
+}
+
+std::string FormatCPUList(const std::vector<int> &cpus) {
+  std::string result;
+  for (size_t i = 0; i < cpus.size(); i++) {
+    size_t j = i;
+    while (j + 1 < cpus.size() && cpus[j + 1] == cpus[j] + 1) j++;
+
+    if (!result.empty()) result += ",";
+    result += std::to_string(cpus[i]);
+    if (j > i) result += "-" + std::to_string(cpus[j]);
+    i = j;
+  }
+  return result;
+}
+
+#ifdef __linux__
+
+struct DirCloser {
+  void operator()(DIR *dir) const { closedir(dir); }
+};
+
+static StatusOr<cpu_set_t> makeCPUSet(const std::vector<int> &cpus) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : cpus) {
+    if (cpu >= CPU_SETSIZE) {
+      return {Status::NotOK, fmt::format("CPU {} is out of the supported range", cpu)};
+    }
+    CPU_SET(cpu, &set);
+  }
+  return set;
+}
+
+Status ThreadSetAffinity(std::thread &t, const std::vector<int> &cpus) {
+  if (cpus.empty()) return Status::OK();
+
+  auto set = GET_OR_RET(makeCPUSet(cpus));
+  if (int err = pthread_setaffinity_np(t.native_handle(), sizeof(set), &set); err != 0) {
+    return {Status::NotOK, fmt::format("failed to set the CPU affinity to {}: {}", FormatCPUList(cpus), strerror(err))};
+  }
+  return Status::OK();
+}
+
+Status ThreadSetAffinity(const std::vector<int> &cpus) {
+  if (cpus.empty()) return Status::OK();
+
+  auto set = GET_OR_RET(makeCPUSet(cpus));
+  if (int err = pthread_setaffinity_np(pthread_self(), sizeof(set), &set); err != 0) {
+    return {Status::NotOK, fmt::format("failed to set the CPU affinity to {}: {}", FormatCPUList(cpus), strerror(err))};
+  }
+  return Status::OK();
+}
+
+StatusOr<int> ThreadSetAffinityByName(const std::string &prefix, const std::vector<int> &cpus) {
+  if (cpus.empty()) return 0;
+
+  auto set = GET_OR_RET(makeCPUSet(cpus));
+  std::unique_ptr<DIR, DirCloser> dir(opendir("/proc/self/task"));
+  if (!dir) {
+    return {Status::NotOK, fmt::format("failed to list the threads: {}", strerror(errno))};
+  }
+
+  int count = 0;
+  while (auto entry = readdir(dir.get())) {
+    if (entry->d_name[0] == '.') continue;
+
+    std::ifstream comm(fmt::format("/proc/self/task/{}/comm", entry->d_name));
+    std::string name;
+    // the thread may have exited
+    if (!std::getline(comm, name) || !HasPrefix(name, prefix)) continue;
+
+    auto tid = ParseInt<int>(entry->d_name, 10);
+    if (!tid) continue;
+    if (sched_setaffinity(*tid, sizeof(set), &set) != 0) {
+      if (errno == ESRCH) continue;
+      return {Status::NotOK, fmt::format("failed to set the CPU affinity of thread '{}': {}", name, strerror(errno))};
+    }
+    count++;
+  }
+  return count;
+}
+
+int GetCPUNumaNode(int cpu) {
+  std::unique_ptr<DIR, DirCloser> dir(opendir(fmt::format("/sys/devices/system/cpu/cpu{}", cpu).c_str()));
+  if (!dir) return -1;
+
+  // the CPU directory contains a link named by its node, e.g. node0
+  while (auto entry = readdir(dir.get())) {
+    std::string name = entry->d_name;
+    if (!HasPrefix(name, "node")) continue;
+    if (auto node = ParseInt<int>(name.substr(4), 10)) return *node;
+  }
+  return -1;
+}
+
+Status ThreadBindNumaNode(int node) {
+  // use the syscall directly to avoid depending on libnuma
+  constexpr int mpol_preferred = 1;
+  constexpr int max_nodes = 1024;
+  if (node < 0 || node >= max_nodes) {
+    return {Status::NotOK, fmt::format("NUMA node {} is out of the supported range", node)};
+  }
+
+  unsigned long mask[max_nodes / (8 * sizeof(unsigned long))] = {};  // NOLINT
+  mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+  if (syscall(SYS_set_mempolicy, mpol_preferred, mask, max_nodes + 1) != 0) {
+    return {Status::NotOK, fmt::format("failed to bind the memory to NUMA node {}: {}", node, strerror(errno))};
+  }
+  return Status::OK();
+}
+
+#else
+
+Status ThreadSetAffinity(std::thread &t, const std::vector<int> &cpus) {
+  if (cpus.empty()) return Status::OK();
+  return {Status::NotSupported, "CPU affinity is only supported on Linux"};
+}
+
+Status ThreadSetAffinity(const std::vector<int> &cpus) {
+  if (cpus.empty()) return Status::OK();
+  return {Status::NotSupported, "CPU affinity is only supported on Linux"};
+}
+
+StatusOr<int> ThreadSetAffinityByName(const std::string &prefix, const std::vector<int> &cpus) {
+  if (cpus.empty()) return 0;
+  return {Status::NotSupported, "CPU affinity is only supported on Linux"};
+}
+
+int GetCPUNumaNode(int cpu) { return -1; }
+
+Status ThreadBindNumaNode(int node) { return {Status::NotSupported, "NUMA binding is only supported on Linux"}; }
+
+#endif
+
 }  // namespace util
@@ -20,8 +20,11 @@
 
 #pragma once
 
+#include <string>
+#include <string_view>
 #include <system_error>
 #include <thread>
+#include <vector>
 
 #include "fmt/core.h"
 #include "status.h"
@@ -45,4 +48,20 @@ StatusOr<std::thread> CreateThread(const char *name, F f) {
 Status ThreadJoin(std::thread &t);
 Status ThreadDetach(std::thread &t);
 
+// Parse a CPU list like "0-3,8,10-11", the result is sorted and deduplicated
+StatusOr<std::vector<int>> ParseCPUList(std::string_view list);
+std::string FormatCPUList(const std::vector<int> &cpus);
+
+// Restrict the thread to run on the given CPUs, nothing is done if the list is empty
+Status ThreadSetAffinity(std::thread &t, const std::vector<int> &cpus);
+Status ThreadSetAffinity(const std::vector<int> &cpus);
+// Restrict all the threads of the process whose names start with the prefix,
+// and return the number of the threads found
+StatusOr<int> ThreadSetAffinityByName(const std::string &prefix, const std::vector<int> &cpus);
+
+// Return the NUMA node of the CPU, or -1 if it's unknown
+int GetCPUNumaNode(int cpu);
+// Make the memory pages touched by the calling thread be allocated from the NUMA node if possible
+Status ThreadBindNumaNode(int node);
+
 }  // namespace util
@@ -41,6 +41,7 @@
 #include "server/server.h"
 #include "status.h"
 #include "storage/redis_metadata.h"
+#include "thread_util.h"
 
 constexpr const char *kDefaultDir = "/tmp/kvrocks";
 constexpr const char *kDefaultBackupDir = "/tmp/kvrocks/backup";
@@ -123,12 +124,22 @@ Config::Config() {
       {"tls-session-caching", false, new YesNoField(&tls_session_caching, true)},
       {"tls-session-cache-size", false, new IntField(&tls_session_cache_size, 1024 * 20, 0, INT_MAX)},
       {"tls-session-cache-timeout", false, new IntField(&tls_session_cache_timeout, 300, 0, INT_MAX)},
+      {"tls-ktls", false, new YesNoField(&tls_ktls, false)},
       {"tls-replication", true, new YesNoField(&tls_replication, false)},
 #endif
       {"workers", false, new IntField(&workers, 8, 1, 256)},
+      {"worker-dedicated-arena", true, new YesNoField(&worker_dedicated_arena, true)},
+      {"worker-cpulist", true, new StringField(&worker_cpulist_str_, "")},
+      {"worker-numa-bind", true, new YesNoField(&worker_numa_bind, false)},
+      {"rocksdb-cpulist", true, new StringField(&rocksdb_cpulist_str_, "")},
+      {"replication-cpulist", true, new StringField(&replication_cpulist_str_, "")},
+      {"task-runner-cpulist", true, new StringField(&task_runner_cpulist_str_, "")},
       {"timeout", false, new IntField(&timeout, 0, 0, INT_MAX)},
       {"tcp-backlog", true, new IntField(&backlog, 511, 0, INT_MAX)},
       {"maxclients", false, new IntField(&maxclients, 10240, 0, INT_MAX)},
+      {"tracking-table-max-keys", false, new IntField(&tracking_table_max_keys, 1000000, 0, INT_MAX)},
+      {"wal-disabled-namespaces", false, new StringField(&wal_disabled_namespaces_str_, "")},
+      {"wal-disabled-flush-interval", false, new IntField(&wal_disabled_flush_interval, 60, 0, 86400)},
       {"max-backup-to-keep", false, new IntField(&max_backup_to_keep, 1, 0, 1)},
       {"max-backup-keep-hours", false, new IntField(&max_backup_keep_hours, 0, 0, INT_MAX)},
       {"master-use-repl-port", false, new YesNoField(&master_use_repl_port, false)},
@@ -144,6 +155,13 @@ Config::Config() {
       {"force-compact-file-age", false, new Int64Field(&force_compact_file_age, 2 * 24 * 3600, 60, INT64_MAX)},
       {"force-compact-file-min-deleted-percentage", false,
        new IntField(&force_compact_file_min_deleted_percentage, 10, 1, 100)},
+      {"compaction-auto-tune", false, new YesNoField(&compaction_auto_tune, false)},
+      {"compaction-auto-tune-latency-target-us", false,
+       new IntField(&compaction_auto_tune_latency_target_us, 10000, 1, INT_MAX)},
+      {"compaction-auto-tune-min-io-mb", false, new IntField(&compaction_auto_tune_min_io_mb, 32, 1, INT_MAX)},
+      {"compaction-auto-tune-max-io-mb", false, new IntField(&compaction_auto_tune_max_io_mb, 512, 1, INT_MAX)},
+      {"compaction-auto-tune-min-background-jobs", false,
+       new IntField(&compaction_auto_tune_min_background_jobs, 2, 1, 32)},
       {"db-name", true, new StringField(&db_name, "change.me.db")},
       {"dir", true, new StringField(&dir, kDefaultDir)},
       {"backup-dir", false, new StringField(&backup_dir, kDefaultBackupDir)},
@@ -160,6 +178,7 @@ Config::Config() {
       {"slave-priority", false, new IntField(&slave_priority, 100, 0, INT_MAX)},
       {"slave-read-only", false, new YesNoField(&slave_readonly, true)},
       {"use-rsid-psync", true, new YesNoField(&use_rsid_psync, false)},
+      {"repl-pubsub-side-channel", false, new YesNoField(&repl_pubsub_side_channel, false)},
       {"profiling-sample-ratio", false, new IntField(&profiling_sample_ratio, 0, 0, 100)},
       {"profiling-sample-record-max-len", false, new IntField(&profiling_sample_record_max_len, 256, 0, INT_MAX)},
       {"profiling-sample-record-threshold-ms", false,
@@ -189,12 +208,20 @@ Config::Config() {
       {"json-max-nesting-depth", false, new IntField(&json_max_nesting_depth, 1024, 0, INT_MAX)},
       {"json-storage-format", false,
        new EnumField<JsonStorageFormat>(&json_storage_format, json_storage_formats, JsonStorageFormat::JSON)},
+      {"convert-subkey-encoding", true, new YesNoField(&convert_subkey_encoding, false)},
+      {"namespace-id-encoding", true, new YesNoField(&namespace_id_encoding, false)},
 
       /* rocksdb options */
       {"rocksdb.compression", false,
        new EnumField<rocksdb::CompressionType>(&rocks_db.compression, compression_types,
                                                rocksdb::CompressionType::kNoCompression)},
       {"rocksdb.compression_level", true, new IntField(&rocks_db.compression_level, 32767, INT_MIN, INT_MAX)},
+      {"rocksdb.compression_max_dict_bytes", true, new IntField(&rocks_db.compression_max_dict_bytes, 0, 0, INT_MAX)},
+      {"rocksdb.compression_zstd_max_train_bytes", true,
+       new IntField(&rocks_db.compression_zstd_max_train_bytes, 0, 0, INT_MAX)},
+      {"rocksdb.compression_parallel_threads", true, new IntField(&rocks_db.compression_parallel_threads, 1, 1, 64)},
+      {"rocksdb.compression_dict_column_families", true,
+       new StringField(&compression_dict_column_families_str_, "default metadata")},
       {"rocksdb.block_size", true, new IntField(&rocks_db.block_size, 16384, 0, INT_MAX)},
       {"rocksdb.max_open_files", false, new IntField(&rocks_db.max_open_files, 8096, -1, INT_MAX)},
       {"rocksdb.write_buffer_size", false, new IntField(&rocks_db.write_buffer_size, 64, 0, 4096)},
@@ -208,6 +235,8 @@ Config::Config() {
       {"rocksdb.wal_size_limit_mb", true, new IntField(&rocks_db.wal_size_limit_mb, 16384, 0, INT_MAX)},
       {"rocksdb.max_total_wal_size", false, new IntField(&rocks_db.max_total_wal_size, 64 * 4 * 2, 0, INT_MAX)},
       {"rocksdb.disable_auto_compactions", false, new YesNoField(&rocks_db.disable_auto_compactions, false)},
+      {"rocksdb.pubsub_fifo_compaction", true, new YesNoField(&rocks_db.pubsub_fifo_compaction, false)},
+      {"rocksdb.pubsub_fifo_ttl", true, new IntField(&rocks_db.pubsub_fifo_ttl, 3600, 1, INT_MAX)},
       {"rocksdb.enable_pipelined_write", true, new YesNoField(&rocks_db.enable_pipelined_write, false)},
       {"rocksdb.stats_dump_period_sec", false, new IntField(&rocks_db.stats_dump_period_sec, 0, 0, INT_MAX)},
       {"rocksdb.cache_index_and_filter_blocks", true, new YesNoField(&rocks_db.cache_index_and_filter_blocks, true)},
@@ -218,6 +247,9 @@ Config::Config() {
       {"rocksdb.metadata_block_cache_size", true, new IntField(&rocks_db.metadata_block_cache_size, 2048, 0, INT_MAX)},
       {"rocksdb.share_metadata_and_subkey_block_cache", true,
        new YesNoField(&rocks_db.share_metadata_and_subkey_block_cache, true)},
+      {"rocksdb.block_cache_dump", true, new YesNoField(&rocks_db.block_cache_dump, false)},
+      {"rocksdb.block_cache_dump_interval", false, new IntField(&rocks_db.block_cache_dump_interval, 60, 0, INT_MAX)},
+      {"rocksdb.block_cache_prewarm_rate", true, new IntField(&rocks_db.block_cache_prewarm_rate, 64, 0, INT_MAX)},
       {"rocksdb.row_cache_size", true, new IntField(&rocks_db.row_cache_size, 0, 0, INT_MAX)},
       {"rocksdb.compaction_readahead_size", false,
        new IntField(&rocks_db.compaction_readahead_size, 2 * MiB, 0, 64 * MiB)},
@@ -252,6 +284,8 @@ Config::Config() {
 
       /* rocksdb read options */
       {"rocksdb.read_options.async_io", false, new YesNoField(&rocks_db.read_options.async_io, false)},
+      {"rocksdb.read_options.iterator_refresh_interval", false,
+       new IntField(&rocks_db.read_options.iterator_refresh_interval, 10000, 0, INT_MAX)},
   };
   for (auto &wrapper : fields) {
     auto &field = wrapper.field;
@@ -298,6 +332,56 @@ void Config::initFieldValidator() {
          std::vector<std::string> args = util::Split(v, " \t");
          return dbsize_scan_cron.SetScheduleTime(args);
        }},
+      {"worker-cpulist",
+       [this](const std::string &k, const std::string &v) -> Status {
+         worker_cpulist = GET_OR_RET(util::ParseCPUList(v));
+         return Status::OK();
+       }},
+      {"rocksdb-cpulist",
+       [this](const std::string &k, const std::string &v) -> Status {
+         rocksdb_cpulist = GET_OR_RET(util::ParseCPUList(v));
+         return Status::OK();
+       }},
+      {"replication-cpulist",
+       [this](const std::string &k, const std::string &v) -> Status {
+         replication_cpulist = GET_OR_RET(util::ParseCPUList(v));
+         return Status::OK();
+       }},
+      {"task-runner-cpulist",
+       [this](const std::string &k, const std::string &v) -> Status {
+         task_runner_cpulist = GET_OR_RET(util::ParseCPUList(v));
+         return Status::OK();
+       }},
+      {"tls-ktls",
+       [this](const std::string &k, const std::string &v) -> Status {
+         // only the sessions accepted on tls-port can be handed to the kernel
+         if (util::EqualICase(v, "yes") && tls_port == 0) {
+           return {Status::NotOK, "tls-ktls requires TLS to be enabled by tls-port"};
+         }
+         return Status::OK();
+       }},
+      {"rocksdb.compression",
+       [this](const std::string &k, const std::string &v) -> Status {
+         // the dictionary options are read-only, so the compression can't be changed to a type ignoring them
+         if (rocks_db.compression_max_dict_bytes > 0 && !util::EqualICase(v, "zstd") &&
+             (rocks_db.compression_zstd_max_train_bytes > 0 || !util::EqualICase(v, "lz4"))) {
+           return {Status::NotOK, "the compression dictionary is only supported by zstd, or lz4 without training"};
+         }
+         return Status::OK();
+       }},
+      {"rocksdb.compression_dict_column_families",
+       [this](const std::string &k, const std::string &v) -> Status {
+         std::vector<std::string> names = util::Split(v, " \t");
+         const auto &column_families = engine::ColumnFamilyConfigs::ListAllColumnFamilies();
+         for (const auto &name : names) {
+           if (std::none_of(column_families.begin(), column_families.end(),
+                            [&name](const auto &cf) { return cf.Name() == name; })) {
+             return {Status::NotOK, fmt::format("unknown column family '{}'", name)};
+           }
+         }
+         rocks_db.compression_dict_column_families = std::move(names);
+         return Status::OK();
+       }},
       {"compaction-checker-range",
        [this](const std::string &k, const std::string &v) -> Status {
          if (v.empty()) {
@@ -338,6 +422,7 @@ void Config::initFieldValidator() {
            }
            commands->erase(cmd_iter);
          }
+         redis::CommandTable::UpdateLookupIndex();
          return Status::OK();
        }},
   };
@@ -405,6 +490,12 @@ void Config::initFieldCallback() {
              srv->AdjustWorkerThreads();
              return Status::OK();
            }},
+          {"tracking-table-max-keys",
+           [this](Server *srv, const std::string &k, const std::string &v) -> Status {
+             if (!srv) return Status::OK();
+             srv->SetTrackingTableMaxKeys(tracking_table_max_keys);
+             return Status::OK();
+           }},
           {"dir",
            [this](Server *srv, const std::string &k, const std::string &v) -> Status {
              db_dir = dir + "/db";
@@ -443,6 +534,20 @@ void Config::initFieldCallback() {
              binds = std::move(args);
              return Status::OK();
            }},
+          {"wal-disabled-namespaces",
+           [this](Server *srv, const std::string &k, const std::string &v) -> Status {
+             auto namespaces = util::Split(v, " \t");
+             if (srv) {
+               if (auto s = srv->SetWALDisabledNamespaces(namespaces); !s) {
+                 // keep showing the namespaces in effect
+                 wal_disabled_namespaces_str_ =
+                     util::StringJoin(wal_disabled_namespaces, [](const auto &ns) { return ns; }, " ");
+                 return s;
+               }
+             }
+             wal_disabled_namespaces = std::move(namespaces);
+             return Status::OK();
+           }},
           {"maxclients",
            [](Server *srv, const std::string &k, const std::string &v) -> Status {
              if (!srv) return Status::OK();
@@ -700,6 +805,7 @@ void Config::initFieldCallback() {
           {"tls-session-caching", set_tls_option},
           {"tls-session-cache-size", set_tls_option},
           {"tls-session-cache-timeout", set_tls_option},
+          {"tls-ktls", set_tls_option},
 #endif
       };
   for (const auto &iter : callbacks) {
@@ -789,6 +895,24 @@ Status Config::finish() {
   if (master_port != 0 && binds.size() == 0) {
     return {Status::NotOK, "replication doesn't support unix socket"};
   }
+  if (rocks_db.compression_zstd_max_train_bytes > 0 && rocks_db.compression_max_dict_bytes == 0) {
+    return {Status::NotOK, "rocksdb.compression_zstd_max_train_bytes requires rocksdb.compression_max_dict_bytes"};
+  }
+  // the other compression types ignore the dictionary silently
+  if (rocks_db.compression_max_dict_bytes > 0 && rocks_db.compression != rocksdb::kZSTD &&
+      rocks_db.compression != rocksdb::kLZ4Compression) {
+    return {Status::NotOK, "rocksdb.compression_max_dict_bytes requires rocksdb.compression to be zstd or lz4"};
+  }
+  if (rocks_db.compression_zstd_max_train_bytes > 0 && rocks_db.compression != rocksdb::kZSTD) {
+    return {Status::NotOK, "rocksdb.compression_zstd_max_train_bytes requires rocksdb.compression to be zstd"};
+  }
+  if (cluster_enabled && !wal_disabled_namespaces.empty()) {
+    // the slot migration is fed by the WAL, which has gaps left by the writes without the WAL
+    return {Status::NotOK, "wal-disabled-namespaces isn't allowed in cluster mode"};
+  }
+  if (worker_numa_bind && worker_cpulist.empty()) {
+    return {Status::NotOK, "worker-numa-bind requires the workers to be pinned by worker-cpulist"};
+  }
   if (db_dir.empty()) db_dir = dir + "/db";
   if (log_dir.empty()) log_dir = dir;
   std::vector<std::string> create_dirs = {dir};
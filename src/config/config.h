@@ -93,6 +93,7 @@ struct Config {
   bool tls_session_caching = true;
   int tls_session_cache_size = 1024 * 20;
   int tls_session_cache_timeout = 300;
+  bool tls_ktls = false;
   bool tls_replication = false;
 
   int workers = 0;
@@ -100,10 +101,19 @@ struct Config {
   int log_level = 0;
   int backlog = 511;
   int maxclients = 10000;
+  int tracking_table_max_keys = 1000000;
+  std::vector<std::string> wal_disabled_namespaces;
+  int wal_disabled_flush_interval = 60;
   int max_backup_to_keep = 1;
   int max_backup_keep_hours = 24;
   int slowlog_log_slower_than = 100000;
   int slowlog_max_len = 128;
+  bool worker_dedicated_arena = true;
+  std::vector<int> worker_cpulist;
+  bool worker_numa_bind = false;
+  std::vector<int> rocksdb_cpulist;
+  std::vector<int> replication_cpulist;
+  std::vector<int> task_runner_cpulist;
   bool daemonize = false;
   SupervisedMode supervised_mode = kSupervisedNone;
   bool slave_readonly = true;
@@ -119,6 +129,7 @@ struct Config {
   bool auto_resize_block_and_sst = true;
   int fullsync_recv_file_delay = 0;
   bool use_rsid_psync = false;
+  bool repl_pubsub_side_channel = false;
   std::vector<std::string> binds;
   std::string dir;
   std::string db_dir;
@@ -140,6 +151,11 @@ struct Config {
   Cron dbsize_scan_cron;
   CompactionCheckerRange compaction_checker_range{-1, -1};
   int64_t force_compact_file_age;
+  bool compaction_auto_tune = false;
+  int compaction_auto_tune_latency_target_us = 10000;
+  int compaction_auto_tune_min_io_mb = 32;
+  int compaction_auto_tune_max_io_mb = 512;
+  int compaction_auto_tune_min_background_jobs = 2;
   int force_compact_file_min_deleted_percentage;
   bool repl_namespace_enabled = false;
   std::string replica_announce_ip;
@@ -174,6 +190,8 @@ struct Config {
   // json
   int json_max_nesting_depth = 1024;
   JsonStorageFormat json_storage_format = JsonStorageFormat::JSON;
+  bool convert_subkey_encoding = false;
+  bool namespace_id_encoding = false;
 
   struct RocksDB {
     int block_size;
@@ -183,6 +201,9 @@ struct Config {
     int metadata_block_cache_size;
     int subkey_block_cache_size;
     bool share_metadata_and_subkey_block_cache;
+    bool block_cache_dump;
+    int block_cache_dump_interval;
+    int block_cache_prewarm_rate;
     int row_cache_size;
     int max_open_files;
     int write_buffer_size;
@@ -203,7 +224,13 @@ struct Config {
     int level0_file_num_compaction_trigger;
     rocksdb::CompressionType compression;
     int compression_level;
+    int compression_max_dict_bytes;
+    int compression_zstd_max_train_bytes;
+    int compression_parallel_threads;
+    std::vector<std::string> compression_dict_column_families;
     bool disable_auto_compactions;
+    bool pubsub_fifo_compaction;
+    int pubsub_fifo_ttl;
     bool enable_blob_files;
     int min_blob_size;
     int blob_file_size;
@@ -226,6 +253,7 @@ struct Config {
 
     struct ReadOptions {
       bool async_io;
+      int iterator_refresh_interval;
     } read_options;
   } rocks_db;
 
@@ -250,6 +278,12 @@ struct Config {
   std::string dbsize_scan_cron_str_;
   std::string compaction_checker_range_str_;
   std::string profiling_sample_commands_str_;
+  std::string worker_cpulist_str_;
+  std::string wal_disabled_namespaces_str_;
+  std::string compression_dict_column_families_str_;
+  std::string rocksdb_cpulist_str_;
+  std::string replication_cpulist_str_;
+  std::string task_runner_cpulist_str_;
   std::map<std::string, std::unique_ptr<ConfigField>> fields_;
   std::vector<std::string> rename_command_;
 
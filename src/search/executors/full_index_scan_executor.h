@@ -38,7 +38,8 @@ struct FullIndexScanExecutor : ExecutorNode {
       : ExecutorNode(ctx), scan(scan), ss(ctx->storage), prefix_iter(scan->index->info->prefixes.begin()) {}
 
   std::string NSKey(const std::string &user_key) {
-    return ComposeNamespaceKey(scan->index->info->ns, user_key, ctx->storage->IsSlotIdEncoded());
+    return ComposeNamespaceKey(ctx->storage->EncodeNamespace(scan->index->info->ns), user_key,
+                               ctx->storage->IsSlotIdEncoded());
   }
 
   StatusOr<Result> Next() override {
@@ -42,7 +42,8 @@ struct NumericFieldScanExecutor : ExecutorNode {
 
   NumericFieldScanExecutor(ExecutorContext *ctx, NumericFieldScan *scan)
       : ExecutorNode(ctx), scan(scan), ss(ctx->storage), index(scan->field->info->index) {
-    ns_key = ComposeNamespaceKey(index->ns, index->name, ctx->storage->IsSlotIdEncoded());
+    ns_key =
+        ComposeNamespaceKey(ctx->storage->EncodeNamespace(index->ns), index->name, ctx->storage->IsSlotIdEncoded());
   }
 
   std::string IndexKey(double num) {
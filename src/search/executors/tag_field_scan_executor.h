@@ -43,7 +43,8 @@ struct TagFieldScanExecutor : ExecutorNode {
 
   TagFieldScanExecutor(ExecutorContext *ctx, TagFieldScan *scan)
       : ExecutorNode(ctx), scan(scan), ss(ctx->storage), index(scan->field->info->index) {
-    ns_key = ComposeNamespaceKey(index->ns, index->name, ctx->storage->IsSlotIdEncoded());
+    ns_key =
+        ComposeNamespaceKey(ctx->storage->EncodeNamespace(index->ns), index->name, ctx->storage->IsSlotIdEncoded());
     index_key = InternalKey(ns_key, redis::ConstructTagFieldSubkey(scan->field->name, scan->tag, {}),
                             index->metadata.version, ctx->storage->IsSlotIdEncoded())
                     .Encode();
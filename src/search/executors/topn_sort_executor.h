@@ -43,8 +43,17 @@ struct TopNSortExecutor : ExecutorNode {
   std::vector<ComparedRow> rows;
   decltype(rows)::iterator rows_iter;
   bool initialized = false;
+  int64_t buffered_bytes = 0;
 
   TopNSortExecutor(ExecutorContext *ctx, TopNSort *sort) : ExecutorNode(ctx), sort(sort) {}
+  ~TopNSortExecutor() override { executors_buffered_bytes -= buffered_bytes; }
+  TopNSortExecutor(const TopNSortExecutor &) = delete;
+  TopNSortExecutor &operator=(const TopNSortExecutor &) = delete;
+
+  void AddBufferedBytes(int64_t delta) {
+    buffered_bytes += delta;
+    executors_buffered_bytes += delta;
+  }
 
   StatusOr<Result> Next() override {
     if (!initialized) {
@@ -68,12 +77,15 @@ struct TopNSortExecutor : ExecutorNode {
 
         if (rows.size() < total) {
           auto order = GET_OR_RET(get_order(row));
+          AddBufferedBytes(static_cast<int64_t>(row.MemoryUsage()));
           rows.emplace_back(row, order);
         } else {
           auto order = GET_OR_RET(get_order(row));
 
           if (order < rows[0].val) {
             std::pop_heap(rows.begin(), rows.end());
+            AddBufferedBytes(static_cast<int64_t>(row.MemoryUsage()) -
+                             static_cast<int64_t>(rows.back().row.MemoryUsage()));
             rows.back() = ComparedRow{row, order};
             std::push_heap(rows.begin(), rows.end());
           }
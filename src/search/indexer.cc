@@ -63,7 +63,10 @@ rocksdb::Status FieldValueRetriever::Retrieve(std::string_view field, std::strin
     rocksdb::ReadOptions read_options;
     read_options.snapshot = ss.GetSnapShot();
     std::string sub_key = InternalKey(ns_key, field, metadata.version, hash.storage_->IsSlotIdEncoded()).Encode();
-    return hash.storage_->Get(read_options, sub_key, output);
+    std::string raw_value;
+    auto s = hash.storage_->Get(read_options, sub_key, &raw_value);
+    if (!s.ok()) return s;
+    return Hash::DecodeFieldValue(metadata, raw_value, output);
   } else if (std::holds_alternative<JsonData>(db)) {
     auto &value = std::get<JsonData>(db);
     auto s = value.Get(field.front() == '$' ? field : fmt::format("$.{}", field));
@@ -125,7 +128,7 @@ Status IndexUpdater::UpdateIndex(const std::string &field, std::string_view key,
 
   auto *metadata = iter->second.metadata.get();
   auto *storage = indexer->storage;
-  auto ns_key = ComposeNamespaceKey(ns, info->name, storage->IsSlotIdEncoded());
+  auto ns_key = ComposeNamespaceKey(storage->EncodeNamespace(ns), info->name, storage->IsSlotIdEncoded());
   if (auto tag = dynamic_cast<SearchTagFieldMetadata *>(metadata)) {
     const char delim[] = {tag->separator, '\0'};
     auto original_tags = util::Split(original, delim);
@@ -20,6 +20,7 @@
 
 #pragma once
 
+#include <atomic>
 #include <variant>
 
 #include "ir_plan.h"
@@ -29,6 +30,9 @@
 
 namespace kqir {
 
+// bytes of the rows buffered by all the running executors, e.g. the rows kept by TopNSortExecutor
+inline std::atomic<int64_t> executors_buffered_bytes = 0;
+
 struct ExecutorContext;
 
 struct ExecutorNode {
@@ -45,6 +49,13 @@ struct ExecutorNode {
 
     bool operator!=(const RowType &another) const { return !(*this == another); }
 
+    // approximate bytes held by the row
+    size_t MemoryUsage() const {
+      size_t total = sizeof(RowType) + key.capacity();
+      for (const auto &[_, value] : fields) total += value.capacity() + sizeof(value) + sizeof(void *) * 4;
+      return total;
+    }
+
     // for debug purpose
     friend std::ostream &operator<<(std::ostream &os, const RowType &row) {
       if (row.index) {
@@ -0,0 +1,347 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#ifdef ENABLE_IO_URING
+
+#include "io_uring_driver.h"
+
+#include <fmt/format.h>
+#include <glog/logging.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+constexpr unsigned kQueueDepth = 4096;
+constexpr int kBufferGroupID = 0;
+constexpr unsigned kRecvBufferCount = 4096;
+constexpr size_t kRecvBufferSize = 16 * 1024;
+// Limit the bytes of a single send, so that a large reply doesn't hold too much memory twice
+constexpr size_t kMaxSendBytes = 1024 * 1024;
+
+IOUringDriver::~IOUringDriver() {
+  // remove the output callbacks first, since they may be run by other threads until then
+  for (const auto &[bev, sock] : sockets_) {
+    if (sock->output_cb) evbuffer_remove_cb_entry(bufferevent_get_output(bev), sock->output_cb);
+  }
+  completion_ev_.reset();
+  flush_ev_.reset();
+  sockets_.clear();
+  pending_completions_.clear();
+  if (buf_ring_) io_uring_free_buf_ring(&ring_, buf_ring_, kRecvBufferCount, kBufferGroupID);
+  if (ring_inited_) io_uring_queue_exit(&ring_);
+  if (event_fd_ != -1) close(event_fd_);
+}
+
+Status IOUringDriver::Init() {
+  if (int ret = io_uring_queue_init(kQueueDepth, &ring_, 0); ret < 0) {
+    return {Status::NotOK, fmt::format("failed to init io_uring: {}", strerror(-ret))};
+  }
+  ring_inited_ = true;
+
+  int ret = 0;
+  buf_ring_ = io_uring_setup_buf_ring(&ring_, kRecvBufferCount, kBufferGroupID, 0, &ret);
+  if (!buf_ring_) {
+    return {Status::NotOK, fmt::format("failed to setup the provided buffer ring: {}", strerror(-ret))};
+  }
+  recv_buffers_ = std::make_unique<char[]>(kRecvBufferCount * kRecvBufferSize);
+  int mask = io_uring_buf_ring_mask(kRecvBufferCount);
+  for (unsigned i = 0; i < kRecvBufferCount; i++) {
+    io_uring_buf_ring_add(buf_ring_, recv_buffers_.get() + i * kRecvBufferSize, kRecvBufferSize, i, mask,
+                          static_cast<int>(i));
+  }
+  io_uring_buf_ring_advance(buf_ring_, kRecvBufferCount);
+
+  event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (event_fd_ == -1) {
+    return {Status::NotOK, fmt::format("failed to create eventfd: {}", strerror(errno))};
+  }
+  if (ret = io_uring_register_eventfd(&ring_, event_fd_); ret < 0) {
+    return {Status::NotOK, fmt::format("failed to register eventfd: {}", strerror(-ret))};
+  }
+
+  completion_ev_.reset(event_new(base_, event_fd_, EV_READ | EV_PERSIST,
+                                 EventCallbackFunc<&IOUringDriver::onCompletion>, this));
+  flush_ev_.reset(event_new(base_, -1, 0, EventCallbackFunc<&IOUringDriver::onFlush>, this));
+  if (!completion_ev_ || !flush_ev_ || event_add(completion_ev_.get(), nullptr) != 0) {
+    return {Status::NotOK, "failed to create the io_uring events"};
+  }
+  return Status::OK();
+}
+
+void IOUringDriver::Attach(bufferevent *bev, int fd) {
+  auto sock = std::make_unique<Socket>();
+  sock->driver = this;
+  sock->bev = bev;
+  sock->fd = fd;
+  sock->output_cb = evbuffer_add_cb(bufferevent_get_output(bev), outputCB, sock.get());
+  submitRecv(sock.get());
+  sockets_.emplace(bev, std::move(sock));
+  scheduleFlush(nullptr);
+}
+
+void IOUringDriver::Detach(bufferevent *bev) {
+  auto iter = sockets_.find(bev);
+  if (iter == sockets_.end()) return;
+
+  auto sock = iter->second.get();
+  // The output callback is run with the lock of the output buffer held, so it's
+  // neither running nor run again once it's removed.
+  evbuffer_remove_cb_entry(bufferevent_get_output(bev), sock->output_cb);
+  sock->output_cb = nullptr;
+  sock->detaching = true;
+
+  auto owned_by_sock = [sock](const Completion &completion) {
+    return (completion.data & ~kOpMask) == reinterpret_cast<uint64_t>(sock);
+  };
+  for (auto it = pending_completions_.begin(); it != pending_completions_.end();) {
+    if (!owned_by_sock(*it)) {
+      ++it;
+      continue;
+    }
+    handleCompletion(*it);
+    it = pending_completions_.erase(it);
+  }
+
+  // Wait for the operations in flight, the send is canceled as well since it may wait
+  // for the peer forever, and the completions of the other sockets are left pending.
+  if (sock->receiving) submitCancel(sock, kRecv);
+  if (sock->sending) submitCancel(sock, kSend);
+  while (sock->receiving || sock->sending) {
+    if (int ret = io_uring_submit_and_wait(&ring_, 1); ret < 0 && ret != -EINTR) {
+      LOG(ERROR) << "[io_uring] Failed to wait for the operations of the socket " << sock->fd << ": "
+                 << strerror(-ret);
+      // the socket is leaked since the ring may still access it
+      iter->second.release();
+      sockets_.erase(iter);
+      bufferevent_setfd(bev, sock->fd);
+      return;
+    }
+
+    io_uring_cqe *cqe = nullptr;
+    unsigned head = 0, count = 0;
+    io_uring_for_each_cqe(&ring_, head, cqe) {
+      count++;
+      Completion completion{io_uring_cqe_get_data64(cqe), cqe->res, cqe->flags};
+      if (owned_by_sock(completion)) {
+        handleCompletion(completion);
+      } else {
+        pending_completions_.emplace_back(completion);
+      }
+    }
+    io_uring_cq_advance(&ring_, count);
+  }
+  if (!pending_completions_.empty()) event_active(completion_ev_.get(), 0, 0);
+
+  bufferevent_setfd(bev, sock->fd);
+  // the unsent bytes are sent by the bufferevent ahead of the later output
+  if (sock->send_offset < sock->send_buf.size()) {
+    evbuffer_prepend(bufferevent_get_output(bev), sock->send_buf.data() + sock->send_offset,
+                     sock->send_buf.size() - sock->send_offset);
+  }
+  sockets_.erase(iter);
+}
+
+void IOUringDriver::Wakeup(bufferevent *bev) { scheduleFlush(bev); }
+
+void IOUringDriver::outputCB(evbuffer *buffer, const evbuffer_cb_info *info, void *ctx) {
+  if (info->n_added == 0) return;
+
+  // The output may be appended from other threads, e.g. by Worker::Reply. It's safe to access
+  // the socket here, since the callback is run with the lock of the output buffer held,
+  // and the socket is released only after the callback is removed with the same lock.
+  // Only the bufferevent is recorded, and the socket is looked up again in the worker thread.
+  auto sock = static_cast<Socket *>(ctx);
+  if (!sock->flush_scheduled.exchange(true)) {
+    sock->driver->scheduleFlush(sock->bev);
+  }
+}
+
+void IOUringDriver::scheduleFlush(bufferevent *bev) {
+  if (bev) {
+    std::lock_guard<std::mutex> guard(pending_mu_);
+    pending_flushes_.emplace_back(bev);
+  }
+  event_active(flush_ev_.get(), 0, 0);
+}
+
+void IOUringDriver::onFlush(evutil_socket_t, int16_t) {
+  std::vector<bufferevent *> pending;
+  {
+    std::lock_guard<std::mutex> guard(pending_mu_);
+    pending.swap(pending_flushes_);
+  }
+  for (auto bev : pending) {
+    auto iter = sockets_.find(bev);
+    if (iter == sockets_.end()) continue;
+
+    auto sock = iter->second.get();
+    sock->flush_scheduled = false;
+    if (sock->sending) continue;
+    if (evbuffer_get_length(bufferevent_get_output(bev)) > 0) {
+      submitSend(sock);
+    } else if (bufferevent_get_enabled(bev) & EV_WRITE) {
+      bufferevent_trigger(bev, EV_WRITE, 0);
+    }
+  }
+  io_uring_submit(&ring_);
+}
+
+io_uring_sqe *IOUringDriver::getSQE() {
+  auto sqe = io_uring_get_sqe(&ring_);
+  if (!sqe) {
+    // the submission queue is full, submit them to make room
+    io_uring_submit(&ring_);
+    sqe = io_uring_get_sqe(&ring_);
+  }
+  return sqe;
+}
+
+void IOUringDriver::submitRecv(Socket *sock) {
+  auto sqe = getSQE();
+  io_uring_prep_recv_multishot(sqe, sock->fd, nullptr, 0, 0);
+  sqe->flags |= IOSQE_BUFFER_SELECT;
+  sqe->buf_group = kBufferGroupID;
+  io_uring_sqe_set_data64(sqe, reinterpret_cast<uint64_t>(sock) | kRecv);
+  sock->receiving = true;
+}
+
+void IOUringDriver::submitSend(Socket *sock) {
+  if (sock->send_offset == sock->send_buf.size()) {
+    auto output = bufferevent_get_output(sock->bev);
+    size_t len = std::min(evbuffer_get_length(output), kMaxSendBytes);
+    if (len == 0) return;
+
+    sock->send_buf.resize(len);
+    sock->send_offset = 0;
+    evbuffer_remove(output, sock->send_buf.data(), len);
+  }
+
+  auto sqe = getSQE();
+  io_uring_prep_send(sqe, sock->fd, sock->send_buf.data() + sock->send_offset,
+                     sock->send_buf.size() - sock->send_offset, MSG_NOSIGNAL);
+  io_uring_sqe_set_data64(sqe, reinterpret_cast<uint64_t>(sock) | kSend);
+  sock->sending = true;
+}
+
+void IOUringDriver::submitCancel(Socket *sock, Op op) {
+  auto sqe = getSQE();
+  io_uring_prep_cancel64(sqe, reinterpret_cast<uint64_t>(sock) | op, 0);
+  io_uring_sqe_set_data64(sqe, kCancel);
+}
+
+void IOUringDriver::onCompletion(evutil_socket_t, int16_t) {
+  uint64_t value = 0;
+  // reset the eventfd, the completions are counted by the ring itself
+  while (read(event_fd_, &value, sizeof(value)) > 0) {
+  }
+
+  io_uring_cqe *cqe = nullptr;
+  unsigned head = 0, count = 0;
+  io_uring_for_each_cqe(&ring_, head, cqe) {
+    count++;
+    pending_completions_.push_back({io_uring_cqe_get_data64(cqe), cqe->res, cqe->flags});
+  }
+  io_uring_cq_advance(&ring_, count);
+
+  while (!pending_completions_.empty()) {
+    auto completion = pending_completions_.front();
+    pending_completions_.pop_front();
+    handleCompletion(completion);
+  }
+  io_uring_submit(&ring_);
+}
+
+void IOUringDriver::handleCompletion(const Completion &completion) {
+  auto op = completion.data & kOpMask;
+  if (op == kCancel) return;
+
+  auto sock = reinterpret_cast<Socket *>(completion.data & ~kOpMask);
+  if (op == kRecv) {
+    handleRecv(sock, completion.res, completion.flags);
+  } else {
+    handleSend(sock, completion.res);
+  }
+}
+
+void IOUringDriver::handleRecv(Socket *sock, int res, uint32_t flags) {
+  if (flags & IORING_CQE_F_BUFFER) {
+    auto bid = static_cast<uint16_t>(flags >> IORING_CQE_BUFFER_SHIFT);
+    if (res > 0) {
+      evbuffer_add(bufferevent_get_input(sock->bev), recv_buffers_.get() + bid * kRecvBufferSize, res);
+    }
+    recycleBuffer(bid);
+  }
+  if (!(flags & IORING_CQE_F_MORE)) sock->receiving = false;
+  if (sock->detaching) return;
+
+  auto bev = sock->bev;
+  if (res > 0) {
+    if (!sock->receiving) submitRecv(sock);
+    if (bufferevent_get_enabled(bev) & EV_READ) bufferevent_trigger(bev, EV_READ, 0);
+  } else if (res == -ENOBUFS) {
+    // all the buffers are in use, they are recycled once the completions are processed
+    if (!sock->receiving) submitRecv(sock);
+  } else if (res == 0) {
+    runEventCB(bev, BEV_EVENT_EOF | BEV_EVENT_READING);
+  } else if (res != -ECANCELED) {
+    errno = -res;
+    runEventCB(bev, BEV_EVENT_ERROR | BEV_EVENT_READING);
+  }
+}
+
+void IOUringDriver::handleSend(Socket *sock, int res) {
+  sock->sending = false;
+  if (res > 0) sock->send_offset += res;
+  if (sock->detaching) return;
+
+  auto bev = sock->bev;
+  if (res < 0 && res != -EAGAIN && res != -EINTR) {
+    errno = -res;
+    runEventCB(bev, BEV_EVENT_ERROR | BEV_EVENT_WRITING);
+    return;
+  }
+
+  if (sock->send_offset < sock->send_buf.size() || evbuffer_get_length(bufferevent_get_output(bev)) > 0) {
+    submitSend(sock);
+    return;
+  }
+  // Shrink the buffer if a large reply was sent
+  if (sock->send_buf.capacity() > kRecvBufferSize) sock->send_buf = std::string();
+  if (bufferevent_get_enabled(bev) & EV_WRITE) bufferevent_trigger(bev, EV_WRITE, 0);
+}
+
+void IOUringDriver::recycleBuffer(uint16_t bid) {
+  io_uring_buf_ring_add(buf_ring_, recv_buffers_.get() + bid * kRecvBufferSize, kRecvBufferSize, bid,
+                        io_uring_buf_ring_mask(kRecvBufferCount), 0);
+  io_uring_buf_ring_advance(buf_ring_, 1);
+}
+
+void IOUringDriver::runEventCB(bufferevent *bev, int16_t events) {
+  bufferevent_event_cb event_cb = nullptr;
+  void *ctx = nullptr;
+  bufferevent_getcb(bev, nullptr, nullptr, &event_cb, &ctx);
+  // the callback may free the connection, so the socket mustn't be touched after that
+  if (event_cb) event_cb(bev, events, ctx);
+}
+
+#endif
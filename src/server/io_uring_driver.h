@@ -0,0 +1,124 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#pragma once
+
+#ifdef ENABLE_IO_URING
+
+#include <liburing.h>
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "event_util.h"
+#include "status.h"
+
+// IOUringDriver does the socket I/O of the connections in a worker by io_uring instead of libevent.
+//
+// The bufferevent of a driven connection is created without the socket, so it still works as the
+// input/output buffers of the connection and its callbacks are run as usual, but libevent never
+// polls the socket. Requests are received by the multishot recv into the provided buffer ring,
+// and the replies appended in an event loop iteration are sent together, so that all the sends
+// are submitted by one syscall.
+class IOUringDriver {
+ public:
+  explicit IOUringDriver(event_base *base) : base_(base) {}
+  ~IOUringDriver();
+  IOUringDriver(const IOUringDriver &) = delete;
+  IOUringDriver &operator=(const IOUringDriver &) = delete;
+
+  Status Init();
+  // Start to do the I/O of the socket for the bufferevent, which must be created without a socket
+  void Attach(bufferevent *bev, int fd);
+  // Stop doing the I/O of the socket and hand it back to the bufferevent, which would poll the socket
+  // by itself from now on. The operations in flight are canceled and waited for, so the socket is never
+  // touched by the ring afterwards: the received bytes are appended to the input buffer and the unsent
+  // bytes are put back in front of the output buffer. Nothing is done if the bufferevent isn't attached.
+  void Detach(bufferevent *bev);
+  // Send the pending output of the bufferevent, or run its write callback if there is nothing to send.
+  // It's the counterpart of enabling EV_WRITE on a socket bufferevent, and can be called from any thread.
+  void Wakeup(bufferevent *bev);
+
+ private:
+  struct Socket {
+    IOUringDriver *driver = nullptr;
+    bufferevent *bev = nullptr;
+    int fd = -1;
+    evbuffer_cb_entry *output_cb = nullptr;
+    // bytes being sent, which are moved out of the output buffer since the
+    // kernel may read them at any time before the send is completed
+    std::string send_buf;
+    size_t send_offset = 0;
+    bool receiving = false;
+    bool sending = false;
+    // no callback is run while it's being detached
+    bool detaching = false;
+    std::atomic<bool> flush_scheduled = false;
+  };
+
+  // a completion taken from the ring but not handled yet
+  struct Completion {
+    uint64_t data;
+    int32_t res;
+    uint32_t flags;
+  };
+
+  enum Op : uint64_t { kRecv = 0, kSend = 1, kCancel = 2 };
+  static constexpr uint64_t kOpMask = 3;
+
+  static void outputCB(evbuffer *buffer, const evbuffer_cb_info *info, void *ctx);
+  void onCompletion(evutil_socket_t fd, int16_t events);
+  void onFlush(evutil_socket_t fd, int16_t events);
+
+  io_uring_sqe *getSQE();
+  void scheduleFlush(bufferevent *bev);
+  void submitRecv(Socket *sock);
+  void submitSend(Socket *sock);
+  void submitCancel(Socket *sock, Op op);
+  void handleCompletion(const Completion &completion);
+  void handleRecv(Socket *sock, int res, uint32_t flags);
+  void handleSend(Socket *sock, int res);
+  void recycleBuffer(uint16_t bid);
+  static void runEventCB(bufferevent *bev, int16_t events);
+
+  event_base *base_;
+  io_uring ring_ = {};
+  bool ring_inited_ = false;
+  io_uring_buf_ring *buf_ring_ = nullptr;
+  std::unique_ptr<char[]> recv_buffers_;
+  int event_fd_ = -1;
+  UniqueEvent completion_ev_;
+  UniqueEvent flush_ev_;
+
+  std::unordered_map<bufferevent *, std::unique_ptr<Socket>> sockets_;
+  // the completions taken from the ring but not handled yet, they're handled one by one
+  // since a callback may detach a socket, which handles the completions of the socket itself
+  std::deque<Completion> pending_completions_;
+
+  std::mutex pending_mu_;
+  std::vector<bufferevent *> pending_flushes_;
+};
+
+#endif
@@ -21,6 +21,7 @@
 #include "namespace.h"
 
 #include "jsoncons/json.hpp"
+#include "storage/redis_metadata.h"
 
 // Error messages
 constexpr const char* kErrNamespaceExists = "the namespace already exists";
@@ -38,6 +39,9 @@ Status IsNamespaceLegal(const std::string& ns) {
   if (ns.size() > UINT8_MAX) {
     return {Status::NotOK, fmt::format("size exceed limit {}", UINT8_MAX)};
   }
+  if (IsNamespaceID(ns)) {
+    return {Status::NotOK, "namespace contain illegal letter"};
+  }
   char last_char = ns.back();
   if (last_char == std::numeric_limits<char>::max()) {
     return {Status::NotOK, "namespace contain illegal letter"};
@@ -174,6 +178,13 @@ Status Namespace::Del(const std::string& ns) {
   return {Status::NotOK, kErrNamespaceNotFound};
 }
 
+Status Namespace::AssignIDs() {
+  for (const auto& iter : tokens_) {
+    if (auto s = storage_->AssignNamespaceID(iter.second); !s.IsOK()) return s;
+  }
+  return Status::OK();
+}
+
 Status Namespace::Rewrite() {
   auto config = storage_->GetConfig();
   // Rewrite the configuration file only if it's running with the configuration file
@@ -190,6 +201,8 @@ Status Namespace::Rewrite() {
     return Status::OK();
   }
 
+  if (auto s = AssignIDs(); !s.IsOK()) return s;
+
   // Don't need to write to db if repl_namespace_enabled is false
   if (!config->repl_namespace_enabled) {
     return Status::OK();
@@ -41,6 +41,8 @@ class Namespace {
   Status Del(const std::string &ns);
   const std::map<std::string, std::string> &List() const { return tokens_; }
   Status Rewrite();
+  // Assign the ids to the namespaces which have none, see Storage::AssignNamespaceID
+  Status AssignIDs();
   bool IsAllowModify() const;
 
  private:
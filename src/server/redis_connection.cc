@@ -42,8 +42,13 @@
 
 namespace redis {
 
-Connection::Connection(bufferevent *bev, Worker *owner)
-    : need_free_bev_(true), bev_(bev), req_(owner->srv), owner_(owner), srv_(owner->srv) {
+Connection::Connection(bufferevent *bev, Worker *owner, int fd)
+    : need_free_bev_(true),
+      bev_(bev),
+      fd_(fd >= 0 ? fd : bufferevent_getfd(bev)),
+      req_(owner->srv),
+      owner_(owner),
+      srv_(owner->srv) {
   int64_t now = util::GetTimeStamp();
   create_time_ = now;
   last_interaction_ = now;
@@ -61,12 +66,22 @@ Connection::~Connection() {
   // unsubscribe all channels and patterns if exists
   UnsubscribeAll();
   PUnsubscribeAll();
+  DisableTracking();
 }
 
 std::string Connection::ToString() {
-  return fmt::format("id={} addr={} fd={} name={} age={} idle={} flags={} namespace={} qbuf={} obuf={} cmd={}\n", id_,
-                     addr_, bufferevent_getfd(bev_), name_, GetAge(), GetIdleTime(), GetFlags(), ns_,
-                     evbuffer_get_length(Input()), evbuffer_get_length(Output()), last_cmd_);
+  size_t qbuf = evbuffer_get_length(Input());
+  size_t obuf = evbuffer_get_length(Output());
+  size_t argv_mem = argv_mem_;
+  return fmt::format(
+      "id={} addr={} fd={} name={} age={} idle={} flags={} namespace={} qbuf={} argv-mem={} obuf={} tot-mem={} "
+      "cmd={}\n",
+      id_, addr_, GetFD(), name_, GetAge(), GetIdleTime(), GetFlags(), ns_, qbuf, argv_mem, obuf,
+      qbuf + argv_mem + obuf, last_cmd_);
+}
+
+size_t Connection::GetMemoryUsage() {
+  return evbuffer_get_length(Input()) + argv_mem_ + evbuffer_get_length(Output());
 }
 
 void Connection::Close() {
@@ -90,6 +105,7 @@ void Connection::OnRead(struct bufferevent *bev) {
   }
 
   ExecuteCommands(req_.GetCommands());
+  argv_mem_ = req_.GetArgvMemory();
   if (IsFlagEnabled(kCloseAsync)) {
     Close();
   }
@@ -123,6 +139,16 @@ void Connection::OnEvent(bufferevent *bev, int16_t events) {
     DLOG(INFO) << "[connection] The client: " << GetAddr() << "] reached timeout";
     bufferevent_enable(bev, EV_READ | EV_WRITE);
   }
+
+#ifdef ENABLE_OPENSSL
+  // The session is handed to the kernel by OpenSSL once the handshake is done if tls-ktls is enabled
+  if (events & BEV_EVENT_CONNECTED) {
+    if (auto ssl = bufferevent_openssl_get_ssl(bev)) {
+      if (IsKTLSSendEnabled(ssl)) srv_->stats.IncrKTLSSendSessions();
+      if (IsKTLSRecvEnabled(ssl)) srv_->stats.IncrKTLSRecvSessions();
+    }
+  }
+#endif
 }
 
 void Connection::Reply(const std::string &msg) {
@@ -222,6 +248,7 @@ std::string Connection::GetFlags() const {
   if (IsFlagEnabled(kMonitor)) flags.append("M");
   if (IsFlagEnabled(kAsking)) flags.append("A");
   if (!subscribe_channels_.empty() || !subscribe_patterns_.empty()) flags.append("P");
+  if (IsFlagEnabled(kTracking)) flags.append("t");
   if (flags.empty()) flags = "N";
   return flags;
 }
@@ -236,7 +263,36 @@ bool Connection::CanMigrate() const {
   return !is_running_                                                    // reading or writing
          && !IsFlagEnabled(redis::Connection::kCloseAfterReply)          // close after reply
          && saved_current_command_ == nullptr                            // not executing blocking command like BLPOP
-         && subscribe_channels_.empty() && subscribe_patterns_.empty();  // not subscribing any channel
+         && subscribe_channels_.empty() && subscribe_patterns_.empty()   // not subscribing any channel
+         && !IsFlagEnabled(redis::Connection::kTracking);                // tracked keys are kept by the owner
+}
+
+Status Connection::EnableTracking(bool bcast, bool noloop, const std::vector<std::string> &prefixes) {
+  if (IsFlagEnabled(kTracking) && bcast != tracking_bcast_) {
+    return {Status::NotOK, "You can't switch BCAST mode on/off before disabling tracking for this client"};
+  }
+
+  if (!IsFlagEnabled(kTracking)) {
+    EnableFlag(kTracking);
+    srv_->IncrTrackingClientNum();
+  }
+  tracking_bcast_ = bcast;
+  tracking_noloop_ = noloop;
+  if (bcast) {
+    // broadcast all the keys if no prefix is specified
+    owner_->AddTrackingPrefixes(this, prefixes.empty() ? std::vector<std::string>{""} : prefixes);
+  }
+  return Status::OK();
+}
+
+void Connection::DisableTracking() {
+  if (!IsFlagEnabled(kTracking)) return;
+
+  owner_->RemoveTrackingClient(this);
+  DisableFlag(kTracking);
+  tracking_bcast_ = false;
+  tracking_noloop_ = false;
+  srv_->DecrTrackingClientNum();
 }
 
 void Connection::SubscribeChannel(const std::string &channel) {
@@ -405,6 +461,11 @@ Status Connection::ExecuteCommand(const std::string &cmd_name, const std::vector
 
   srv_->SlowlogPushEntryIfNeeded(&cmd_tokens, duration, this);
   srv_->stats.IncrLatency(static_cast<uint64_t>(duration), cmd_name);
+  // the blocking commands wait for the data by design, so they're left out of the latency
+  // which the compaction rate controller watches
+  if (!(current_cmd->GetAttributes()->flags & kCmdBlocking) && !s.Is<Status::BlockingCmd>()) {
+    srv_->stats.IncrLatencyHistogram(static_cast<uint64_t>(duration));
+  }
   srv_->FeedMonitorConns(this, cmd_tokens);
   return s;
 }
@@ -429,9 +490,13 @@ void Connection::ExecuteCommands(std::deque<CommandTokens> *to_process_cmds) {
       continue;
     }
     auto current_cmd = std::move(*cmd_s);
+    // the commander is reused by the following commands unless it's saved by a blocking command
+    auto recycle_cmd = MakeScopeExit([&current_cmd] {
+      if (current_cmd) Server::RecycleCommand(std::move(current_cmd));
+    });
 
     const auto &attributes = current_cmd->GetAttributes();
-    auto cmd_name = attributes->name;
+    const auto &cmd_name = attributes->name;
     auto cmd_flags = attributes->GenerateFlags(cmd_tokens);
 
     if (GetNamespace().empty()) {
@@ -536,6 +601,7 @@ void Connection::ExecuteCommands(std::deque<CommandTokens> *to_process_cmds) {
     }
 
     SetLastCmd(cmd_name);
+    srv_->TrackKeysFromArgs(this, cmd_tokens, *attributes);
     s = ExecuteCommand(cmd_name, cmd_tokens, current_cmd.get(), &reply);
 
     // Break the execution loop when occurring the blocking command like BLPOP or BRPOP,
@@ -556,6 +622,7 @@ void Connection::ExecuteCommands(std::deque<CommandTokens> *to_process_cmds) {
     }
 
     srv_->UpdateWatchedKeysFromArgs(cmd_tokens, *attributes);
+    srv_->UpdateTrackedKeysFromArgs(this, cmd_tokens, *attributes);
 
     if (!reply.empty()) Reply(reply);
     reply.clear();
@@ -47,9 +47,11 @@ class Connection : public EvbufCallbackBase<Connection> {
     kMultiExec = 1 << 8,
     kReadOnly = 1 << 9,
     kAsking = 1 << 10,
+    kTracking = 1 << 11,
   };
 
-  explicit Connection(bufferevent *bev, Worker *owner);
+  // The fd of the socket is taken from the bufferevent if it's not specified
+  explicit Connection(bufferevent *bev, Worker *owner, int fd = -1);
   ~Connection();
 
   Connection(const Connection &) = delete;
@@ -62,6 +64,8 @@ class Connection : public EvbufCallbackBase<Connection> {
   void OnEvent(bufferevent *bev, int16_t events);
   void SendFile(int fd);
   std::string ToString();
+  // Bytes held by the query buffer, the parsed arguments and the reply buffer of the connection
+  size_t GetMemoryUsage();
 
   void Reply(const std::string &msg);
   RESP GetProtocolVersion() const { return protocol_version_; }
@@ -121,6 +125,13 @@ class Connection : public EvbufCallbackBase<Connection> {
   void SUnsubscribeAll(const UnsubscribeCallback &reply = nullptr);
   int SSubscriptionsCount();
 
+  // Client side caching, the keys read by the connection are tracked in the default mode,
+  // while all the keys matching the prefixes are notified in the broadcasting mode
+  Status EnableTracking(bool bcast, bool noloop, const std::vector<std::string> &prefixes);
+  void DisableTracking();
+  bool IsTrackingBCast() const { return tracking_bcast_; }
+  bool IsTrackingNoLoop() const { return tracking_noloop_; }
+
   uint64_t GetAge() const;
   uint64_t GetIdleTime() const;
   void SetLastInteraction();
@@ -141,6 +152,12 @@ class Connection : public EvbufCallbackBase<Connection> {
   void SetListeningPort(int port) { listening_port_ = port; }
   int GetListeningPort() const { return listening_port_; }
   void SetAnnounceIP(std::string ip) { announce_ip_ = std::move(ip); }
+  // The replica could receive the published messages in the replication stream besides the write batches
+  void SetReplicaPubSubCapa(bool capa) { replica_pubsub_capa_ = capa; }
+  bool HasReplicaPubSubCapa() const { return replica_pubsub_capa_; }
+  // The replicas which don't report it predate the compact sub key encoding, so they only use version 0
+  void SetReplicaSubkeyEncodingVersion(uint8_t version) { replica_subkey_encoding_version_ = version; }
+  uint8_t GetReplicaSubkeyEncodingVersion() const { return replica_subkey_encoding_version_; }
   std::string GetAnnounceIP() const { return !announce_ip_.empty() ? announce_ip_ : ip_; }
   uint32_t GetAnnouncePort() const { return listening_port_ != 0 ? listening_port_ : port_; }
   std::string GetAnnounceAddr() const { return GetAnnounceIP() + ":" + std::to_string(GetAnnouncePort()); }
@@ -159,7 +176,7 @@ class Connection : public EvbufCallbackBase<Connection> {
 
   Worker *Owner() { return owner_; }
   void SetOwner(Worker *new_owner) { owner_ = new_owner; };
-  int GetFD() { return bufferevent_getfd(bev_); }
+  int GetFD() const { return fd_; }
   evbuffer *Input() { return bufferevent_get_input(bev_); }
   evbuffer *Output() { return bufferevent_get_output(bev_); }
   bufferevent *GetBufferEvent() { return bev_; }
@@ -194,6 +211,8 @@ class Connection : public EvbufCallbackBase<Connection> {
   uint32_t port_ = 0;
   std::string addr_;
   int listening_port_ = 0;
+  bool replica_pubsub_capa_ = false;
+  uint8_t replica_subkey_encoding_version_ = 0;
   bool is_admin_ = false;
   bool need_free_bev_ = true;
   std::string last_cmd_;
@@ -201,7 +220,10 @@ class Connection : public EvbufCallbackBase<Connection> {
   int64_t last_interaction_;
 
   bufferevent *bev_;
+  int fd_;
   Request req_;
+  // updated after every read, since the arguments are only accessible in the owner worker
+  std::atomic<size_t> argv_mem_ = 0;
   Worker *owner_;
   std::unique_ptr<Commander> saved_current_command_;
 
@@ -217,6 +239,8 @@ class Connection : public EvbufCallbackBase<Connection> {
 
   bool importing_ = false;
   RESP protocol_version_ = RESP::v2;
+  std::atomic<bool> tracking_bcast_ = false;
+  std::atomic<bool> tracking_noloop_ = false;
 };
 
 }  // namespace redis
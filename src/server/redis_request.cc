@@ -135,4 +135,15 @@ Status Request::Tokenize(evbuffer *input) {
   }
 }
 
+size_t Request::GetArgvMemory() const {
+  size_t total = 0;
+  auto add_tokens = [&total](const CommandTokens &tokens) {
+    for (const auto &token : tokens) total += token.capacity();
+  };
+
+  add_tokens(tokens_);
+  for (const auto &tokens : commands_) add_tokens(tokens);
+  return total;
+}
+
 }  // namespace redis
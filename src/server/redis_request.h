@@ -53,6 +53,8 @@ class Request {
   Status Tokenize(evbuffer *input);
 
   std::deque<CommandTokens> *GetCommands() { return &commands_; }
+  // Bytes of the arguments which are parsed but not executed yet
+  size_t GetArgvMemory() const;
 
  private:
   // internal states related to parsing
@@ -23,10 +23,13 @@
 #include <glog/logging.h>
 #include <rocksdb/convenience.h>
 #include <rocksdb/statistics.h>
+#include <rocksdb/table.h>
+#include <rocksdb/utilities/memory_util.h>
 #include <sys/resource.h>
 #include <sys/statvfs.h>
 #include <sys/utsname.h>
 
+#include <algorithm>
 #include <atomic>
 #include <cstdint>
 #include <functional>
@@ -35,13 +38,17 @@
 #include <memory>
 #include <mutex>
 #include <shared_mutex>
+#include <unordered_set>
 #include <utility>
 
 #include "commands/commander.h"
 #include "config.h"
 #include "fmt/format.h"
+#include "jemalloc_util.h"
 #include "redis_connection.h"
+#include "search/plan_executor.h"
 #include "storage/compaction_checker.h"
+#include "storage/iterator.h"
 #include "storage/redis_db.h"
 #include "storage/scripting.h"
 #include "storage/storage.h"
@@ -52,7 +59,11 @@
 #include "worker.h"
 
 Server::Server(engine::Storage *storage, Config *config)
-    : storage(storage), start_time_secs_(util::GetTimeStamp()), config_(config), namespace_(storage) {
+    : storage(storage),
+      start_time_secs_(util::GetTimeStamp()),
+      config_(config),
+      namespace_(storage),
+      compaction_rate_controller_(storage, config) {
   // init commands stats here to prevent concurrent insert, and cause core
   auto commands = redis::CommandTable::GetOriginal();
   for (const auto &iter : *commands) {
@@ -91,6 +102,9 @@ Server::Server(engine::Storage *storage, Config *config)
       }
       LOG(INFO) << "[server] Listening on unix socket: " << config->unixsocket;
     }
+    if (!config->worker_cpulist.empty()) {
+      worker->SetCPU(config->worker_cpulist[i % config->worker_cpulist.size()]);
+    }
     worker_threads_.emplace_back(std::make_unique<WorkerThread>(std::move(worker)));
   }
 
@@ -173,7 +187,10 @@ Status Server::Start() {
 
   if (auto s = task_runner_.Start(); !s) {
     LOG(WARNING) << "Failed to start task runner: " << s.Msg();
+  } else if (auto s = task_runner_.SetAffinity(config_->task_runner_cpulist); !s) {
+    LOG(WARNING) << "[server] Failed to pin the task runner threads: " << s.Msg();
   }
+  setRocksDBThreadsAffinity();
   // setup server cron thread
   cron_thread_ = GET_OR_RET(util::CreateThread("server-cron", [this] { this->cron(); }));
 
@@ -243,6 +260,13 @@ void Server::Join() {
   for (const auto &worker : worker_threads_) {
     worker->Join();
   }
+
+  // all requests are done, so the block cache holds the hottest blocks now
+  if (config_->rocks_db.block_cache_dump) {
+    if (auto s = storage->DumpBlockCache(); !s) {
+      LOG(WARNING) << "[server] Failed to dump the block cache: " << s.Msg();
+    }
+  }
 }
 
 Status Server::AddMaster(const std::string &host, uint32_t port, bool force_reconnect) {
@@ -293,23 +317,103 @@ Status Server::RemoveMaster() {
       replication_thread_->Stop();
       replication_thread_ = nullptr;
     }
-    return storage->ShiftReplId();
+    if (auto s = storage->ShiftReplId(); !s.IsOK()) return s;
+    // The namespaces added while it was a replica have no ids yet
+    return namespace_.AssignIDs();
   }
   return Status::OK();
 }
 
+// The writes without the WAL leave gaps in the WAL which stop the threads fed by it, so the replicas
+// and CDC consumers can't be attached while wal-disabled-namespaces is set, and vice versa.
+// Both sides are checked with the slave_threads_mu_ held.
 Status Server::AddSlave(redis::Connection *conn, rocksdb::SequenceNumber next_repl_seq) {
+  std::lock_guard<std::mutex> lg(slave_threads_mu_);
+  if (storage->HasWALDisabledNamespaces()) {
+    return {Status::NotOK, "can't sync with a replica while wal-disabled-namespaces is set"};
+  }
+
   auto t = std::make_unique<FeedSlaveThread>(this, conn, next_repl_seq);
   auto s = t->Start();
   if (!s.IsOK()) {
     return s;
   }
 
-  std::lock_guard<std::mutex> lg(slave_threads_mu_);
+  full_sync_replicas_.erase(conn->GetAnnounceAddr());
   slave_threads_.emplace_back(std::move(t));
   return Status::OK();
 }
 
+Status Server::AddCDCConsumer(redis::Connection *conn, rocksdb::SequenceNumber next_seq, CDCFeedOptions options) {
+  std::lock_guard<std::mutex> lg(slave_threads_mu_);
+  if (storage->HasWALDisabledNamespaces()) {
+    return {Status::NotOK, "can't feed a CDC consumer while wal-disabled-namespaces is set"};
+  }
+
+  auto t = std::make_unique<CDCFeedThread>(this, conn, next_seq, std::move(options));
+  auto s = t->Start();
+  if (!s.IsOK()) {
+    return s;
+  }
+
+  cdc_threads_.emplace_back(std::move(t));
+  return Status::OK();
+}
+
+Status Server::SetWALDisabledNamespaces(const std::vector<std::string> &namespaces) {
+  if (config_->cluster_enabled && !namespaces.empty()) {
+    return {Status::NotOK, "wal-disabled-namespaces isn't allowed in cluster mode"};
+  }
+
+  std::lock_guard<std::mutex> lg(slave_threads_mu_);
+  if (!namespaces.empty()) {
+    auto has_running = [](const auto &threads) {
+      return std::any_of(threads.begin(), threads.end(), [](const auto &t) { return !t->IsStopped(); });
+    };
+    if (has_running(slave_threads_) || has_running(cdc_threads_)) {
+      return {Status::NotOK, "wal-disabled-namespaces can't be set while replicas or CDC consumers are attached"};
+    }
+  }
+  storage->SetWALDisabledNamespaces(namespaces);
+  return Status::OK();
+}
+
+void Server::AddFullSyncReplica(redis::Connection *conn) {
+  std::lock_guard<std::mutex> lg(slave_threads_mu_);
+  full_sync_replicas_[conn->GetAnnounceAddr()] = util::GetTimeStamp<std::chrono::seconds>();
+}
+
+bool Server::FeedPubSubMessageToSlaves(const std::string &channel, const std::string &msg, bool force) {
+  std::lock_guard<std::mutex> lg(slave_threads_mu_);
+
+  if (!force && !canFeedPubSubMessagesToAllSlaves()) return false;
+  for (const auto &slave_thread : slave_threads_) {
+    if (!slave_thread->IsStopped() && slave_thread->HasPubSubCapa()) {
+      slave_thread->FeedPubSubMessage(channel, msg);
+    }
+  }
+  return true;
+}
+
+bool Server::CanRelayPubSubMessages() {
+  std::lock_guard<std::mutex> lg(slave_threads_mu_);
+  return canFeedPubSubMessagesToAllSlaves();
+}
+
+// Should be called with the slave_threads_mu_ held
+bool Server::canFeedPubSubMessagesToAllSlaves() {
+  // The replicas in the full sync aren't fed by the slave threads until they PSYNC from the checkpoint,
+  // they'd miss the messages published meanwhile unless the messages are in the WAL. The full sync
+  // can't last longer than the checkpoint, so the replicas which never PSYNC are forgotten after that.
+  int64_t now_secs = util::GetTimeStamp<std::chrono::seconds>();
+  for (auto iter = full_sync_replicas_.begin(); iter != full_sync_replicas_.end();) {
+    iter = now_secs - iter->second > kMaxFullSyncSecs ? full_sync_replicas_.erase(iter) : std::next(iter);
+  }
+  if (!full_sync_replicas_.empty()) return false;
+  return std::all_of(slave_threads_.begin(), slave_threads_.end(),
+                     [](const auto &t) { return t->IsStopped() || t->HasPubSubCapa(); });
+}
+
 void Server::DisconnectSlaves() {
   std::lock_guard<std::mutex> lg(slave_threads_mu_);
 
@@ -322,6 +426,16 @@ void Server::DisconnectSlaves() {
     slave_threads_.pop_front();
     slave_thread->Join();
   }
+
+  for (auto &cdc_thread : cdc_threads_) {
+    if (!cdc_thread->IsStopped()) cdc_thread->Stop();
+  }
+
+  while (!cdc_threads_.empty()) {
+    auto cdc_thread = std::move(cdc_threads_.front());
+    cdc_threads_.pop_front();
+    cdc_thread->Join();
+  }
 }
 
 void Server::CleanupExitedSlaves() {
@@ -336,6 +450,16 @@ void Server::CleanupExitedSlaves() {
       ++it;
     }
   }
+
+  for (auto it = cdc_threads_.begin(); it != cdc_threads_.end();) {
+    if ((*it)->IsStopped()) {
+      auto thread = std::move(*it);
+      it = cdc_threads_.erase(it);
+      thread->Join();
+    } else {
+      ++it;
+    }
+  }
 }
 
 void Server::FeedMonitorConns(redis::Connection *conn, const std::vector<std::string> &tokens) {
@@ -688,6 +812,10 @@ int Server::IncrBlockedClientNum() { return blocked_clients_.fetch_add(1, std::m
 
 int Server::DecrBlockedClientNum() { return blocked_clients_.fetch_sub(1, std::memory_order_relaxed); }
 
+int Server::IncrTrackingClientNum() { return tracking_clients_.fetch_add(1, std::memory_order_relaxed); }
+
+int Server::DecrTrackingClientNum() { return tracking_clients_.fetch_sub(1, std::memory_order_relaxed); }
+
 std::shared_lock<std::shared_mutex> Server::WorkConcurrencyGuard() {
   return std::shared_lock(works_concurrency_rw_lock_);
 }
@@ -737,6 +865,34 @@ void Server::cron() {
       continue;
     }
 
+    // RocksDB starts more background threads when its pools are enlarged, so pin them again every minute
+    if (counter != 0 && counter % 600 == 0) {
+      setRocksDBThreadsAffinity();
+    }
+
+    // flush the writes of wal-disabled-namespaces periodically, since they're lost on crash until flushed
+    if (config_->wal_disabled_flush_interval > 0 && counter % (config_->wal_disabled_flush_interval * 10) == 0) {
+      if (auto s = storage->FlushWALDisabledWrites(); !s) {
+        LOG(WARNING) << "[server] Failed to flush the writes without WAL: " << s.Msg();
+      }
+    }
+
+    // dump the block cache periodically besides on shutdown, so the cache could still be prewarmed after a crash
+    if (config_->rocks_db.block_cache_dump && config_->rocks_db.block_cache_dump_interval > 0 && counter != 0 &&
+        counter % (static_cast<uint64_t>(config_->rocks_db.block_cache_dump_interval) * 600) == 0) {
+      auto s = task_runner_.TryPublish([this] {
+        if (auto s = storage->DumpBlockCache(); !s) {
+          LOG(WARNING) << "[task runner] Failed to dump the block cache: " << s.Msg();
+        }
+      });
+      if (!s) LOG(WARNING) << "[server] Failed to schedule the block cache dump: " << s.Msg();
+    }
+
+    // adjust the IO rate limit of flush and compaction every second
+    if (counter != 0 && counter % 10 == 0) {
+      compaction_rate_controller_.Adjust(stats.GetLatencyHistogram());
+    }
+
     // check every 20s (use 20s instead of 60s so that cron will execute in critical condition)
     if (counter != 0 && counter % 200 == 0) {
       auto t = static_cast<time_t>(util::GetTimeStamp());
@@ -834,10 +990,13 @@ void Server::GetRocksDBInfo(std::string *info) {
   uint64_t memtable_sizes = 0, cur_memtable_sizes = 0, num_snapshots = 0, num_running_flushes = 0;
   uint64_t num_immutable_tables = 0, memtable_flush_pending = 0, compaction_pending = 0;
   uint64_t num_running_compaction = 0, num_live_versions = 0, num_super_version = 0, num_background_errors = 0;
+  uint64_t total_sst_files_size = 0, live_sst_files_size = 0, oldest_snapshot_time = 0;
 
   db->GetAggregatedIntProperty("rocksdb.num-snapshots", &num_snapshots);
-  db->GetAggregatedIntProperty("rocksdb.size-all-mem-tables", &memtable_sizes);
+  // the active and unflushed immutable memtables are read before all of them, so the memtables which are flushed
+  // in between are not regarded as the pinned ones
   db->GetAggregatedIntProperty("rocksdb.cur-size-all-mem-tables", &cur_memtable_sizes);
+  db->GetAggregatedIntProperty("rocksdb.size-all-mem-tables", &memtable_sizes);
   db->GetAggregatedIntProperty("rocksdb.num-running-flushes", &num_running_flushes);
   db->GetAggregatedIntProperty("rocksdb.num-immutable-mem-table", &num_immutable_tables);
   db->GetAggregatedIntProperty("rocksdb.mem-table-flush-pending", &memtable_flush_pending);
@@ -846,6 +1005,9 @@ void Server::GetRocksDBInfo(std::string *info) {
   db->GetAggregatedIntProperty("rocksdb.background-errors", &num_background_errors);
   db->GetAggregatedIntProperty("rocksdb.compaction-pending", &compaction_pending);
   db->GetAggregatedIntProperty("rocksdb.num-live-versions", &num_live_versions);
+  db->GetAggregatedIntProperty("rocksdb.total-sst-files-size", &total_sst_files_size);
+  db->GetAggregatedIntProperty("rocksdb.live-sst-files-size", &live_sst_files_size);
+  db->GetIntProperty("rocksdb.oldest-snapshot-time", &oldest_snapshot_time);
 
   string_stream << "# RocksDB\r\n";
 
@@ -887,6 +1049,21 @@ void Server::GetRocksDBInfo(std::string *info) {
                   << "]:" << cf_stats_map["memtable-limit-delays"] << "\r\n";
     string_stream << "memtable_count_limit_stop[" << cf_handle->GetName()
                   << "]:" << cf_stats_map["memtable-limit-stops"] << "\r\n";
+
+    // the ratio of the uncompressed size to the file size on the levels which have files
+    std::string compression_ratios;
+    for (int level = 0; level < db->NumberLevels(cf_handle); level++) {
+      std::string ratio;
+      if (!db->GetProperty(cf_handle, rocksdb::DB::Properties::kCompressionRatioAtLevelPrefix + std::to_string(level),
+                           &ratio)) {
+        continue;
+      }
+      if (auto value = std::strtod(ratio.c_str(), nullptr); value > 0) {
+        if (!compression_ratios.empty()) compression_ratios += ",";
+        compression_ratios += fmt::format("level{}={:.2f}", level, value);
+      }
+    }
+    string_stream << "compression_ratio[" << cf_handle->GetName() << "]:" << compression_ratios << "\r\n";
   }
 
   auto rocksdb_stats = storage->GetDB()->GetDBOptions().statistics;
@@ -917,6 +1094,27 @@ void Server::GetRocksDBInfo(std::string *info) {
   string_stream << "num_live_versions:" << num_live_versions << "\r\n";
   string_stream << "num_super_version:" << num_super_version << "\r\n";
   string_stream << "num_background_errors:" << num_background_errors << "\r\n";
+  // the memtables which were flushed and the SST files which were compacted away, but are still kept alive by
+  // the iterators and the old versions. The immutable memtables waiting to be flushed are not counted.
+  string_stream << "pinned_flushed_mem_tables:" << memtable_sizes - std::min(memtable_sizes, cur_memtable_sizes)
+                << "\r\n";
+  string_stream << "pinned_sst_files:" << total_sst_files_size - std::min(total_sst_files_size, live_sst_files_size)
+                << "\r\n";
+  int64_t oldest_snapshot_age = 0;
+  if (oldest_snapshot_time > 0) {
+    oldest_snapshot_age = std::max<int64_t>(0, util::GetTimeStamp() - static_cast<int64_t>(oldest_snapshot_time));
+  }
+  string_stream << "oldest_snapshot_age:" << oldest_snapshot_age << "\r\n";
+  string_stream << "auto_refresh_iterators:" << engine::AutoRefreshIterator::GetAliveNum() << "\r\n";
+  string_stream << "iterator_refreshes:" << engine::AutoRefreshIterator::GetRefreshNum() << "\r\n";
+  const auto &dump_info = storage->GetBlockCacheDumpInfo();
+  string_stream << "block_cache_last_dump_time:" << dump_info.last_dump_time_secs << "\r\n";
+  string_stream << "block_cache_last_dump_bytes:" << dump_info.last_dump_bytes << "\r\n";
+  string_stream << "block_cache_prewarm_status:" << engine::BlockCacheDumpInfo::PrewarmStateName(dump_info.prewarm_state)
+                << "\r\n";
+  string_stream << "block_cache_prewarm_loaded_bytes:" << dump_info.prewarm_loaded_bytes << "\r\n";
+  string_stream << "block_cache_prewarm_total_bytes:" << dump_info.prewarm_total_bytes << "\r\n";
+  string_stream << "block_cache_prewarm_duration_ms:" << dump_info.prewarm_duration_ms << "\r\n";
   auto db_stats = storage->GetDBStats();
   string_stream << "flush_count:" << db_stats->flush_count << "\r\n";
   string_stream << "compaction_count:" << db_stats->compaction_count << "\r\n";
@@ -931,7 +1129,11 @@ void Server::GetRocksDBInfo(std::string *info) {
   db_job_mu_.lock();
   string_stream << "is_bgsaving:" << (is_bgsave_in_progress_ ? "yes" : "no") << "\r\n";
   string_stream << "is_compacting:" << (db_compacting_ ? "yes" : "no") << "\r\n";
+  if (db_compacting_) {
+    string_stream << "compaction_progress:" << compacted_cfs_ << "/" << cfs_to_compact_ << "\r\n";
+  }
   db_job_mu_.unlock();
+  string_stream << compaction_rate_controller_.GetInfo();
 
   *info = string_stream.str();
 }
@@ -978,6 +1180,12 @@ void Server::GetClientsInfo(std::string *info) {
   string_stream << "connected_clients:" << connected_clients_ << "\r\n";
   string_stream << "monitor_clients:" << monitor_clients_ << "\r\n";
   string_stream << "blocked_clients:" << blocked_clients_ << "\r\n";
+  string_stream << "tracking_clients:" << tracking_clients_ << "\r\n";
+  size_t tracking_total_keys = 0;
+  for (const auto &t : worker_threads_) {
+    tracking_total_keys += t->GetWorker()->GetTrackedKeyNum();
+  }
+  string_stream << "tracking_total_keys:" << tracking_total_keys << "\r\n";
   *info = string_stream.str();
 }
 
@@ -994,9 +1202,121 @@ void Server::GetMemoryInfo(std::string *info) {
   string_stream << "used_memory_lua:" << memory_lua << "\r\n";
   string_stream << "used_memory_lua_human:" << used_memory_lua_human << "\r\n";
   string_stream << "used_memory_startup:" << memory_startup_use_.load(std::memory_order_relaxed) << "\r\n";
+
+  uint64_t memory_clients = 0;
+  for (const auto &t : worker_threads_) {
+    memory_clients += t->GetWorker()->GetClientsMemory();
+  }
+  string_stream << "used_memory_clients:" << memory_clients << "\r\n";
+  string_stream << "used_memory_clients_human:" << util::BytesToHuman(memory_clients) << "\r\n";
+  string_stream << "used_memory_pubsub:" << getPubSubMemory() << "\r\n";
+  string_stream << "used_memory_search_executors:" << kqir::executors_buffered_bytes.load() << "\r\n";
+
+  {
+    rocksdb::DB *db = storage->GetDB();
+    // the caches may be shared among the column families, so they are deduplicated before counting
+    std::unordered_set<const rocksdb::Cache *> caches;
+    if (auto row_cache = db->GetDBOptions().row_cache) caches.emplace(row_cache.get());
+    for (const auto &cf_handle : *storage->GetCFHandles()) {
+      auto table_opts = db->GetOptions(cf_handle).table_factory->GetOptions<rocksdb::BlockBasedTableOptions>();
+      if (table_opts && table_opts->block_cache) caches.emplace(table_opts->block_cache.get());
+    }
+
+    std::map<rocksdb::MemoryUtil::UsageType, uint64_t> usage_by_type;
+    auto s = rocksdb::MemoryUtil::GetApproximateMemoryUsageByType({db}, caches, &usage_by_type);
+    if (s.ok()) {
+      uint64_t pinned_usage = 0;
+      for (const auto *cache : caches) pinned_usage += cache->GetPinnedUsage();
+      string_stream << "used_memory_rocksdb_memtables:" << usage_by_type[rocksdb::MemoryUtil::kMemTableTotal]
+                    << "\r\n";
+      string_stream << "used_memory_rocksdb_memtables_unflushed:"
+                    << usage_by_type[rocksdb::MemoryUtil::kMemTableUnFlushed] << "\r\n";
+      string_stream << "used_memory_rocksdb_table_readers:" << usage_by_type[rocksdb::MemoryUtil::kTableReadersTotal]
+                    << "\r\n";
+      string_stream << "used_memory_rocksdb_caches:" << usage_by_type[rocksdb::MemoryUtil::kCacheTotal] << "\r\n";
+      string_stream << "used_memory_rocksdb_caches_pinned:" << pinned_usage << "\r\n";
+    }
+
+    for (const auto &cf_handle : *storage->GetCFHandles()) {
+      uint64_t memtable_usage = 0, table_readers_usage = 0, block_cache_usage = 0;
+      db->GetIntProperty(cf_handle, rocksdb::DB::Properties::kSizeAllMemTables, &memtable_usage);
+      db->GetIntProperty(cf_handle, rocksdb::DB::Properties::kEstimateTableReadersMem, &table_readers_usage);
+      db->GetIntProperty(cf_handle, rocksdb::DB::Properties::kBlockCacheUsage, &block_cache_usage);
+      string_stream << "used_memory_rocksdb[" << cf_handle->GetName() << "]:memtables=" << memtable_usage
+                    << ",table_readers=" << table_readers_usage << ",block_cache=" << block_cache_usage << "\r\n";
+    }
+  }
+
+  util::RefreshAllocatorStats();
+  for (size_t i = 0; i < worker_threads_.size(); i++) {
+    unsigned arena = worker_threads_[i]->GetWorker()->GetArena();
+    if (arena == 0) continue;
+    auto arena_stats = util::GetArenaStats(arena);
+    if (!arena_stats) continue;
+    string_stream << "worker" << i << "_memory:arena=" << arena << ",allocated=" << arena_stats->allocated
+                  << ",active=" << arena_stats->active << "\r\n";
+  }
   *info = string_stream.str();
 }
 
+void Server::SetReplicationThreadAffinity() {
+  if (auto s = util::ThreadSetAffinity(config_->replication_cpulist); !s) {
+    LOG(WARNING) << "[server] Failed to pin the replication thread: " << s.Msg();
+  }
+}
+
+void Server::setRocksDBThreadsAffinity() {
+  if (config_->rocksdb_cpulist.empty()) return;
+
+  // the threads of the RocksDB pools are named like rocksdb:low and rocksdb:high
+  auto count = util::ThreadSetAffinityByName("rocksdb:", config_->rocksdb_cpulist);
+  if (!count) {
+    LOG(WARNING) << "[server] Failed to pin the RocksDB background threads: " << count.Msg();
+    return;
+  }
+  rocksdb_pinned_threads_ = *count;
+}
+
+std::string Server::getCPUAffinityInfo() {
+  std::ostringstream string_stream;
+  string_stream << "worker_cpulist:" << util::FormatCPUList(config_->worker_cpulist) << "\r\n";
+  string_stream << "rocksdb_cpulist:" << util::FormatCPUList(config_->rocksdb_cpulist) << "\r\n";
+  string_stream << "rocksdb_pinned_threads:" << rocksdb_pinned_threads_ << "\r\n";
+  string_stream << "replication_cpulist:" << util::FormatCPUList(config_->replication_cpulist) << "\r\n";
+  string_stream << "task_runner_cpulist:" << util::FormatCPUList(config_->task_runner_cpulist) << "\r\n";
+  string_stream << "worker_numa_bind:" << (config_->worker_numa_bind ? "yes" : "no") << "\r\n";
+  for (size_t i = 0; i < worker_threads_.size(); i++) {
+    auto worker = worker_threads_[i]->GetWorker();
+    string_stream << "worker" << i << "_affinity:cpu=" << worker->GetCPU() << ",numa_node=" << worker->GetNumaNode()
+                  << ",numa_bound=" << (worker->IsNumaBound() ? 1 : 0) << "\r\n";
+  }
+  return string_stream.str();
+}
+
+uint64_t Server::getPubSubMemory() {
+  // approximate the size of the subscription tables by the sizes of the names and the list nodes
+  auto table_memory = [](const std::map<std::string, std::list<ConnContext>> &table) {
+    uint64_t total = 0;
+    for (const auto &[name, conns] : table) {
+      total += name.capacity() + sizeof(std::list<ConnContext>) + conns.size() * (sizeof(ConnContext) + 16);
+    }
+    return total;
+  };
+
+  uint64_t total = 0;
+  {
+    std::lock_guard<std::mutex> guard(pubsub_channels_mu_);
+    total += table_memory(pubsub_channels_) + table_memory(pubsub_patterns_);
+  }
+  {
+    std::lock_guard<std::mutex> guard(pubsub_shard_channels_mu_);
+    for (const auto &shard_channels : pubsub_shard_channels_) {
+      total += table_memory(shard_channels);
+    }
+  }
+  return total;
+}
+
 void Server::GetReplicationInfo(std::string *info) {
   std::ostringstream string_stream;
   string_stream << "# Replication\r\n";
@@ -1028,6 +1348,16 @@ void Server::GetReplicationInfo(std::string *info) {
                   << "\r\n";
     ++idx;
   }
+  string_stream << "connected_cdc_consumers:" << cdc_threads_.size() << "\r\n";
+  idx = 0;
+  for (const auto &cdc : cdc_threads_) {
+    if (cdc->IsStopped()) continue;
+
+    string_stream << "cdc_consumer" << std::to_string(idx) << ":";
+    string_stream << "addr=" << cdc->GetConn()->GetAddr() << ",offset=" << cdc->GetNextSeq()
+                  << ",lag=" << latest_seq + 1 - cdc->GetNextSeq() << "\r\n";
+    ++idx;
+  }
   slave_threads_mu_.unlock();
 
   string_stream << "master_repl_offset:" << latest_seq << "\r\n";
@@ -1119,6 +1449,10 @@ void Server::GetStatsInfo(std::string *info) {
   string_stream << "sync_full:" << stats.fullsync_count << "\r\n";
   string_stream << "sync_partial_ok:" << stats.psync_ok_count << "\r\n";
   string_stream << "sync_partial_err:" << stats.psync_err_count << "\r\n";
+#ifdef ENABLE_OPENSSL
+  string_stream << "ktls_send_sessions:" << stats.ktls_send_sessions << "\r\n";
+  string_stream << "ktls_recv_sessions:" << stats.ktls_recv_sessions << "\r\n";
+#endif
 
   auto db_stats = storage->GetDBStats();
   string_stream << "keyspace_hits:" << db_stats->keyspace_hits << "\r\n";
@@ -1231,6 +1565,7 @@ void Server::GetInfo(const std::string &ns, const std::string &section, std::str
                   << static_cast<float>(self_ru.ru_utime.tv_sec) +
                          static_cast<float>(self_ru.ru_utime.tv_usec / 1000000)
                   << "\r\n";
+    string_stream << getCPUAffinityInfo();
   }
 
   if (all || section == "commandstats") {
@@ -1371,21 +1706,66 @@ Status Server::AsyncCompactDB(const std::string &begin_key, const std::string &e
     return {Status::NotOK, "compact in-progress"};
   }
 
-  db_compacting_ = true;
+  return startCompaction({begin_key, end_key, *storage->GetCFHandles()});
+}
 
-  return task_runner_.TryPublish([begin_key, end_key, this] {
-    std::unique_ptr<Slice> begin = nullptr, end = nullptr;
-    if (!begin_key.empty()) begin = std::make_unique<Slice>(begin_key);
-    if (!end_key.empty()) end = std::make_unique<Slice>(end_key);
+// The flushed range only needs to be compacted in the data column families, and it's compacted after
+// the running compaction instead of being dropped, so that the space is always reclaimed.
+// `done` is called with the result once the range is compacted, it's never called if the scheduling fails.
+Status Server::AsyncCompactFlushedRange(const std::string &begin_key, const std::string &end_key,
+                                        std::function<void(const rocksdb::Status &)> done) {
+  if (is_loading_) {
+    return {Status::NotOK, "loading in-progress"};
+  }
 
-    auto s = storage->Compact(nullptr, begin.get(), end.get());
-    if (!s.ok()) {
-      LOG(ERROR) << "[task runner] Failed to do compaction: " << s.ToString();
-    }
+  std::lock_guard<std::mutex> lg(db_job_mu_);
+  CompactionRange range{begin_key, end_key, storage->GetDataCFHandles(), std::move(done)};
+  if (db_compacting_) {
+    pending_compactions_.emplace_back(std::move(range));
+    return Status::OK();
+  }
 
-    std::lock_guard<std::mutex> lg(db_job_mu_);
-    db_compacting_ = false;
+  return startCompaction(std::move(range));
+}
+
+// db_job_mu_ should be held by the caller
+Status Server::startCompaction(CompactionRange range) {
+  db_compacting_ = true;
+  compacted_cfs_ = 0;
+  cfs_to_compact_ = range.cf_handles.size();
+
+  auto s = task_runner_.TryPublish([range = std::move(range), this]() mutable {
+    while (true) {
+      std::unique_ptr<Slice> begin = nullptr, end = nullptr;
+      if (!range.begin_key.empty()) begin = std::make_unique<Slice>(range.begin_key);
+      if (!range.end_key.empty()) end = std::make_unique<Slice>(range.end_key);
+
+      // Compact column families one by one to report the progress
+      rocksdb::Status s;
+      for (auto cf_handle : range.cf_handles) {
+        s = storage->Compact(cf_handle, begin.get(), end.get());
+        if (!s.ok()) {
+          LOG(ERROR) << "[task runner] Failed to do compaction: " << s.ToString();
+          break;
+        }
+        std::lock_guard<std::mutex> lg(db_job_mu_);
+        compacted_cfs_++;
+      }
+      if (range.done) range.done(s);
+
+      std::lock_guard<std::mutex> lg(db_job_mu_);
+      if (pending_compactions_.empty()) {
+        db_compacting_ = false;
+        return;
+      }
+      range = std::move(pending_compactions_.front());
+      pending_compactions_.erase(pending_compactions_.begin());
+      compacted_cfs_ = 0;
+      cfs_to_compact_ = range.cf_handles.size();
+    }
   });
+  if (!s.IsOK()) db_compacting_ = false;
+  return s;
 }
 
 Status Server::AsyncBgSaveDB() {
@@ -1627,22 +2007,40 @@ ReplState Server::GetReplicationState() {
   return kReplConnecting;
 }
 
+// Commanders released by RecycleCommand, indexed by the id of their command attributes.
+// It's thread local so that each worker reuses its own commanders without locking.
+static thread_local std::vector<std::unique_ptr<redis::Commander>> recycled_commands;
+
 StatusOr<std::unique_ptr<redis::Commander>> Server::LookupAndCreateCommand(const std::string &cmd_name) {
   if (cmd_name.empty()) return {Status::RedisUnknownCmd};
 
-  auto commands = redis::CommandTable::Get();
-  auto cmd_iter = commands->find(util::ToLower(cmd_name));
-  if (cmd_iter == commands->end()) {
+  auto cmd_attr = redis::CommandTable::Lookup(cmd_name);
+  if (!cmd_attr) {
     return {Status::RedisUnknownCmd};
   }
 
-  auto cmd_attr = cmd_iter->second;
-  auto cmd = cmd_attr->factory();
+  std::unique_ptr<redis::Commander> cmd;
+  if (cmd_attr->id < recycled_commands.size() && recycled_commands[cmd_attr->id]) {
+    cmd = std::move(recycled_commands[cmd_attr->id]);
+  } else {
+    cmd = cmd_attr->factory();
+  }
   cmd->SetAttributes(cmd_attr);
 
   return std::move(cmd);
 }
 
+void Server::RecycleCommand(std::unique_ptr<redis::Commander> cmd) {
+  auto cmd_attr = cmd->GetAttributes();
+  if (!cmd_attr || !cmd_attr->reset) return;
+
+  cmd_attr->reset(cmd.get());
+  if (recycled_commands.size() <= cmd_attr->id) {
+    recycled_commands.resize(redis::CommandTable::Size());
+  }
+  recycled_commands[cmd_attr->id] = std::move(cmd);
+}
+
 Status Server::ScriptExists(const std::string &sha) {
   if (lua::ScriptExists(lua_, sha)) {
     return Status::OK();
@@ -1822,6 +2220,9 @@ void Server::AdjustWorkerThreads() {
 void Server::increaseWorkerThreads(size_t delta) {
   for (size_t i = 0; i < delta; i++) {
     auto worker = std::make_unique<Worker>(this, config_);
+    if (!config_->worker_cpulist.empty()) {
+      worker->SetCPU(config_->worker_cpulist[worker_threads_.size() % config_->worker_cpulist.size()]);
+    }
     auto worker_thread = std::make_unique<WorkerThread>(std::move(worker));
     worker_thread->Start();
     worker_threads_.emplace_back(std::move(worker_thread));
@@ -1951,6 +2352,89 @@ void Server::UpdateWatchedKeysManually(const std::vector<std::string> &keys) {
   }
 }
 
+bool Server::getKeysFromArgs(const std::vector<std::string> &args, const redis::CommandAttributes &attr,
+                             std::vector<std::string> *keys) {
+  auto append_keys = [&args, keys](const redis::CommandKeyRange &range) {
+    if (range.first_key <= 0) return;
+    for (size_t i = range.first_key;
+         range.last_key > 0 ? i <= size_t(range.last_key) : i <= args.size() + range.last_key; i += range.key_step) {
+      keys->emplace_back(args[i]);
+    }
+  };
+
+  if (attr.key_range.first_key > 0) {
+    append_keys(attr.key_range);
+  } else if (attr.key_range.first_key == -1) {
+    append_keys(attr.key_range_gen(args));
+  } else if (attr.key_range.first_key == -2) {
+    for (const auto &range : attr.key_range_vec_gen(args)) {
+      append_keys(range);
+    }
+  } else {
+    // the command has no key argument, e.g. flushdb
+    return false;
+  }
+  return true;
+}
+
+void Server::TrackKeysFromArgs(redis::Connection *conn, const std::vector<std::string> &args,
+                               const redis::CommandAttributes &attr) {
+  if (!conn->IsFlagEnabled(redis::Connection::kTracking) || conn->IsTrackingBCast()) return;
+
+  // The keys are tracked before they're read, so a write racing with the read still invalidates them
+  auto flags = attr.GenerateFlags(args);
+  std::vector<std::string> keys;
+  if ((flags & redis::kCmdReadOnly) && getKeysFromArgs(args, attr, &keys) && !keys.empty()) {
+    conn->Owner()->TrackKeys(conn, keys);
+  }
+}
+
+void Server::UpdateTrackedKeysFromArgs(redis::Connection *conn, const std::vector<std::string> &args,
+                                       const redis::CommandAttributes &attr) {
+  if (tracking_clients_ == 0) return;
+
+  auto flags = attr.GenerateFlags(args);
+  std::vector<std::string> keys;
+  if (flags & redis::kCmdWrite) {
+    if (getKeysFromArgs(args, attr, &keys)) {
+      InvalidateTrackedKeys(conn, keys);
+    } else {
+      // the written keys are unknown, so all the cached keys are invalidated
+      InvalidateAllTrackedKeys();
+    }
+  }
+}
+
+void Server::InvalidateTrackedKeys(redis::Connection *conn, const std::vector<std::string> &keys) {
+  if (tracking_clients_ == 0 || keys.empty()) return;
+
+  for (const auto &t : worker_threads_) {
+    t->GetWorker()->InvalidateTrackedKeys(conn->GetNamespace(), keys, conn);
+  }
+}
+
+void Server::InvalidateTrackedKeys(const std::string &ns, const std::vector<std::string> &keys) {
+  if (tracking_clients_ == 0 || keys.empty()) return;
+
+  for (const auto &t : worker_threads_) {
+    t->GetWorker()->InvalidateTrackedKeys(ns, keys, nullptr);
+  }
+}
+
+void Server::InvalidateAllTrackedKeys() {
+  if (tracking_clients_ == 0) return;
+
+  for (const auto &t : worker_threads_) {
+    t->GetWorker()->InvalidateAllTrackedKeys();
+  }
+}
+
+void Server::SetTrackingTableMaxKeys(size_t max_keys) {
+  for (const auto &t : worker_threads_) {
+    t->GetWorker()->SetTrackingTableMaxKeys(max_keys);
+  }
+}
+
 void Server::WatchKey(redis::Connection *conn, const std::vector<std::string> &keys) {
   std::unique_lock lock(watched_key_mutex_);
 
@@ -27,6 +27,7 @@
 #include <atomic>
 #include <cstddef>
 #include <cstdint>
+#include <functional>
 #include <list>
 #include <map>
 #include <memory>
@@ -47,6 +48,7 @@
 #include "server/redis_connection.h"
 #include "stats/log_collector.h"
 #include "stats/stats.h"
+#include "storage/compaction_rate_controller.h"
 #include "storage/redis_metadata.h"
 #include "storage/storage.h"
 #include "task_runner.h"
@@ -62,6 +64,15 @@ struct DBScanInfo {
   bool is_scanning = false;
 };
 
+struct CompactionRange {
+  // The empty keys mean the beginning and the end of the column families
+  std::string begin_key;
+  std::string end_key;
+  std::vector<rocksdb::ColumnFamilyHandle *> cf_handles;
+  // Called in the task runner once the range is compacted, if set
+  std::function<void(const rocksdb::Status &)> done;
+};
+
 struct ConnContext {
   Worker *owner;
   int fd;
@@ -188,12 +199,17 @@ class Server {
   bool IsLoading() const { return is_loading_; }
   Config *GetConfig() { return config_; }
   static StatusOr<std::unique_ptr<redis::Commander>> LookupAndCreateCommand(const std::string &cmd_name);
+  // Return a commander which has finished its execution to the pool of the current thread,
+  // it must not be referenced anywhere else, e.g. by a suspended blocking command.
+  static void RecycleCommand(std::unique_ptr<redis::Commander> cmd);
   void AdjustOpenFilesLimit();
   void AdjustWorkerThreads();
 
   Status AddMaster(const std::string &host, uint32_t port, bool force_reconnect);
   Status RemoveMaster();
   Status AddSlave(redis::Connection *conn, rocksdb::SequenceNumber next_repl_seq);
+  Status SetWALDisabledNamespaces(const std::vector<std::string> &namespaces);
+  Status AddCDCConsumer(redis::Connection *conn, rocksdb::SequenceNumber next_seq, CDCFeedOptions options);
   void DisconnectSlaves();
   void CleanupExitedSlaves();
   bool IsSlave() const { return !master_host_.empty(); }
@@ -201,8 +217,18 @@ class Server {
   void IncrFetchFileThread() { fetch_file_threads_num_++; }
   void DecrFetchFileThread() { fetch_file_threads_num_--; }
   int GetFetchFileThreadNum() const { return fetch_file_threads_num_; }
+  // Pin the calling thread to the CPUs of replication-cpulist
+  void SetReplicationThreadAffinity();
 
   int PublishMessage(const std::string &channel, const std::string &msg);
+  // Feed the published message to the replicas in the replication stream instead of the WAL. Unless `force`
+  // is true, nothing is fed and false is returned if some replica doesn't support it, then the message
+  // should be replicated via the WAL instead. If `force` is true, it's fed to the replicas supporting it.
+  bool FeedPubSubMessageToSlaves(const std::string &channel, const std::string &msg, bool force = false);
+  // Whether the published messages could be fed to all the replicas in the replication stream,
+  // it's false if any replica doesn't support it or is in the full sync
+  bool CanRelayPubSubMessages();
+  void AddFullSyncReplica(redis::Connection *conn);
   void SubscribeChannel(const std::string &channel, redis::Connection *conn);
   void UnsubscribeChannel(const std::string &channel, redis::Connection *conn);
   void GetChannelsByPattern(const std::string &pattern, std::vector<std::string> *channels);
@@ -246,6 +272,8 @@ class Server {
   void PrepareRestoreDB();
   void WaitNoMigrateProcessing();
   Status AsyncCompactDB(const std::string &begin_key = "", const std::string &end_key = "");
+  Status AsyncCompactFlushedRange(const std::string &begin_key, const std::string &end_key,
+                                  std::function<void(const rocksdb::Status &)> done = nullptr);
   Status AsyncBgSaveDB();
   Status AsyncPurgeOldBackups(uint32_t num_backups_to_keep, uint32_t backup_max_keep_hours);
   Status AsyncScanDBSize(const std::string &ns);
@@ -261,6 +289,8 @@ class Server {
   int DecrMonitorClientNum();
   int IncrBlockedClientNum();
   int DecrBlockedClientNum();
+  int IncrTrackingClientNum();
+  int DecrTrackingClientNum();
   std::string GetClientsStr();
   uint64_t GetClientID();
   void KillClient(int64_t *killed, const std::string &addr, uint64_t id, uint64_t type, bool skipme,
@@ -301,6 +331,15 @@ class Server {
 
   void UpdateWatchedKeysFromArgs(const std::vector<std::string> &args, const redis::CommandAttributes &attr);
   void UpdateWatchedKeysManually(const std::vector<std::string> &keys);
+  void TrackKeysFromArgs(redis::Connection *conn, const std::vector<std::string> &args,
+                         const redis::CommandAttributes &attr);
+  void UpdateTrackedKeysFromArgs(redis::Connection *conn, const std::vector<std::string> &args,
+                                 const redis::CommandAttributes &attr);
+  void InvalidateTrackedKeys(redis::Connection *conn, const std::vector<std::string> &keys);
+  void InvalidateTrackedKeys(const std::string &ns, const std::vector<std::string> &keys);
+  void InvalidateAllTrackedKeys();
+  bool HasTrackingClients() const { return tracking_clients_ > 0; }
+  void SetTrackingTableMaxKeys(size_t max_keys);
   void WatchKey(redis::Connection *conn, const std::vector<std::string> &keys);
   static bool IsWatchedKeysModified(redis::Connection *conn);
   void ResetWatchedKeys(redis::Connection *conn);
@@ -320,9 +359,16 @@ class Server {
   Status autoResizeBlockAndSST();
   void updateWatchedKeysFromRange(const std::vector<std::string> &args, const redis::CommandKeyRange &range);
   void updateAllWatchedKeys();
+  static bool getKeysFromArgs(const std::vector<std::string> &args, const redis::CommandAttributes &attr,
+                              std::vector<std::string> *keys);
   void increaseWorkerThreads(size_t delta);
   void decreaseWorkerThreads(size_t delta);
   void cleanupExitedWorkerThreads(bool force);
+  uint64_t getPubSubMemory();
+  Status startCompaction(CompactionRange range);
+  bool canFeedPubSubMessagesToAllSlaves();
+  void setRocksDBThreadsAffinity();
+  std::string getCPUAffinityInfo();
 
   std::atomic<bool> stop_ = false;
   std::atomic<bool> is_loading_ = false;
@@ -347,6 +393,10 @@ class Server {
   // slave
   std::mutex slave_threads_mu_;
   std::list<std::unique_ptr<FeedSlaveThread>> slave_threads_;
+  // replica address -> the time its full sync started, which is removed once it starts PSYNC
+  std::map<std::string, int64_t> full_sync_replicas_;
+  static constexpr int64_t kMaxFullSyncSecs = 24 * 60 * 60;
+  std::list<std::unique_ptr<CDCFeedThread>> cdc_threads_;
   std::atomic<int> fetch_file_threads_num_ = 0;
 
   // namespace
@@ -355,6 +405,11 @@ class Server {
   // Some jobs to operate DB should be unique
   std::mutex db_job_mu_;
   bool db_compacting_ = false;
+  // The number of column families which were compacted in the running compaction
+  size_t compacted_cfs_ = 0;
+  size_t cfs_to_compact_ = 0;
+  // The flushed ranges which are compacted after the running compaction
+  std::vector<CompactionRange> pending_compactions_;
   bool is_bgsave_in_progress_ = false;
   int64_t last_bgsave_timestamp_secs_ = -1;
   std::string last_bgsave_status_ = "ok";
@@ -374,6 +429,7 @@ class Server {
   std::mutex blocking_keys_mu_;
 
   std::atomic<int> blocked_clients_{0};
+  std::atomic<int> tracking_clients_{0};
 
   std::mutex blocked_stream_consumers_mu_;
   std::map<std::string, std::set<std::shared_ptr<StreamConsumer>>> blocked_stream_consumers_;
@@ -382,7 +438,9 @@ class Server {
   std::shared_mutex works_concurrency_rw_lock_;
   std::thread cron_thread_;
   std::thread compaction_checker_thread_;
+  CompactionRateController compaction_rate_controller_;
   TaskRunner task_runner_;
+  std::atomic<int> rocksdb_pinned_threads_ = 0;
   std::vector<std::unique_ptr<WorkerThread>> worker_threads_;
   std::unique_ptr<ReplicationThread> replication_thread_;
   tbb::concurrent_queue<std::unique_ptr<WorkerThread>> recycle_worker_threads_;
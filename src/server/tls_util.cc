@@ -149,6 +149,15 @@ UniqueSSLContext CreateSSLContext(const Config *config, const SSL_METHOD *method
     ctx_options |= SSL_OP_CIPHER_SERVER_PREFERENCE;
   }
 
+  if (config->tls_ktls) {
+#ifdef SSL_OP_ENABLE_KTLS
+    // OpenSSL falls back to the user space if the kernel doesn't support the negotiated cipher
+    ctx_options |= SSL_OP_ENABLE_KTLS;
+#else
+    LOG(WARNING) << "kTLS isn't supported by the linked OpenSSL, tls-ktls is ignored";
+#endif
+  }
+
   SSL_CTX_set_options(ssl_ctx.get(), ctx_options);
 
   SSL_CTX_set_mode(ssl_ctx.get(), SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
@@ -223,6 +232,22 @@ UniqueSSLContext CreateSSLContext(const Config *config, const SSL_METHOD *method
   return ssl_ctx;
 }
 
+bool IsKTLSSendEnabled(SSL *ssl) {
+#ifdef BIO_get_ktls_send
+  return BIO_get_ktls_send(SSL_get_wbio(ssl)) == 1;
+#else
+  return false;
+#endif
+}
+
+bool IsKTLSRecvEnabled(SSL *ssl) {
+#ifdef BIO_get_ktls_recv
+  return BIO_get_ktls_recv(SSL_get_rbio(ssl)) == 1;
+#else
+  return false;
+#endif
+}
+
 std::ostream &operator<<(std::ostream &os, SSLErrors) {
   ERR_print_errors_cb(
       [](const char *str, size_t len, void *pos) {
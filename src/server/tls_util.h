@@ -43,6 +43,10 @@ struct UniqueSSLContext : std::unique_ptr<SSL_CTX, StaticSSLCTXFree> {
 
 UniqueSSLContext CreateSSLContext(const Config *config, const SSL_METHOD *method = SSLv23_method());
 
+// Whether the records of the session are encrypted (send) or decrypted (recv) by the kernel
+bool IsKTLSSendEnabled(SSL *ssl);
+bool IsKTLSRecvEnabled(SSL *ssl);
+
 using StaticSSLFree = StaticFunction<decltype(SSL_free), SSL_free>;
 
 struct UniqueSSL : std::unique_ptr<SSL, StaticSSLFree> {
@@ -0,0 +1,108 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "tracking_table.h"
+
+#include <algorithm>
+
+// the namespace is prefixed by its size like in the metadata keys, since it's at most 255 bytes
+std::string TrackingTable::encodeKey(const std::string &ns, const std::string &key) {
+  std::string encoded;
+  encoded.reserve(1 + ns.size() + key.size());
+  encoded.push_back(static_cast<char>(ns.size()));
+  encoded.append(ns).append(key);
+  return encoded;
+}
+
+void TrackingTable::SetMaxKeys(size_t max_keys) {
+  std::lock_guard<std::mutex> guard(mu_);
+  max_keys_ = max_keys;
+}
+
+void TrackingTable::TrackKeys(const std::string &ns, const std::vector<std::string> &keys, Client client,
+                              Invalidations *evicted) {
+  std::lock_guard<std::mutex> guard(mu_);
+  for (const auto &key : keys) {
+    auto &clients = keys_[encodeKey(ns, key)];
+    if (std::find(clients.begin(), clients.end(), client) == clients.end()) {
+      clients.emplace_back(client);
+    }
+  }
+  evictKeys(evicted);
+}
+
+void TrackingTable::evictKeys(Invalidations *evicted) {
+  while (max_keys_ > 0 && keys_.size() > max_keys_) {
+    auto iter = keys_.begin();
+    // strip the namespace, since the clients only know the user keys
+    auto ns_size = static_cast<uint8_t>(iter->first[0]);
+    for (const auto &client : iter->second) {
+      (*evicted)[client].emplace_back(iter->first.substr(1 + ns_size));
+    }
+    keys_.erase(iter);
+  }
+}
+
+void TrackingTable::AddPrefixes(const std::string &ns, const std::vector<std::string> &prefixes, Client client) {
+  std::lock_guard<std::mutex> guard(mu_);
+  for (const auto &prefix : prefixes) {
+    prefixes_.emplace_back(Prefix{ns, prefix, client});
+  }
+}
+
+void TrackingTable::RemoveClient(Client client) {
+  std::lock_guard<std::mutex> guard(mu_);
+  // the keys of the client are removed lazily when they're invalidated or evicted
+  auto is_removed = [&client](const Prefix &p) { return p.client == client; };
+  prefixes_.erase(std::remove_if(prefixes_.begin(), prefixes_.end(), is_removed), prefixes_.end());
+}
+
+void TrackingTable::Invalidate(const std::string &ns, const std::vector<std::string> &keys,
+                               Invalidations *invalidations) {
+  std::lock_guard<std::mutex> guard(mu_);
+  for (const auto &key : keys) {
+    if (!keys_.empty()) {
+      if (auto iter = keys_.find(encodeKey(ns, key)); iter != keys_.end()) {
+        for (const auto &client : iter->second) {
+          (*invalidations)[client].emplace_back(key);
+        }
+        keys_.erase(iter);
+      }
+    }
+
+    for (const auto &p : prefixes_) {
+      if (p.ns == ns && key.compare(0, p.prefix.size(), p.prefix) == 0) {
+        auto &client_keys = (*invalidations)[p.client];
+        // a key may match several prefixes of the same client
+        if (client_keys.empty() || client_keys.back() != key) client_keys.emplace_back(key);
+      }
+    }
+  }
+}
+
+void TrackingTable::Clear() {
+  std::lock_guard<std::mutex> guard(mu_);
+  keys_.clear();
+}
+
+size_t TrackingTable::Size() {
+  std::lock_guard<std::mutex> guard(mu_);
+  return keys_.size();
+}
@@ -0,0 +1,73 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// TrackingTable remembers the keys read by the client side caching connections of a worker,
+// and the key prefixes of the broadcasting ones, so that the write commands in any worker
+// could find out which connections should be told to invalidate their cached keys.
+//
+// The connections are identified by their fd and id, since a connection may be freed while it's
+// still in the table, and its fd may be reused by another connection later.
+class TrackingTable {
+ public:
+  using Client = std::pair<int, uint64_t>;
+  // the keys to invalidate of every client
+  using Invalidations = std::map<Client, std::vector<std::string>>;
+
+  explicit TrackingTable(size_t max_keys) : max_keys_(max_keys) {}
+
+  void SetMaxKeys(size_t max_keys);
+  // Remember the keys read by the client, the evicted keys are put into `evicted` since
+  // their clients should also be told to invalidate them when the table is full
+  void TrackKeys(const std::string &ns, const std::vector<std::string> &keys, Client client, Invalidations *evicted);
+  void AddPrefixes(const std::string &ns, const std::vector<std::string> &prefixes, Client client);
+  void RemoveClient(Client client);
+  // Collect the clients which cached the modified keys or subscribed their prefixes.
+  // The keys are no longer tracked after they're invalidated, until they're read again.
+  void Invalidate(const std::string &ns, const std::vector<std::string> &keys, Invalidations *invalidations);
+  // Forget all the tracked keys, e.g. when the whole database is flushed
+  void Clear();
+  size_t Size();
+
+ private:
+  static std::string encodeKey(const std::string &ns, const std::string &key);
+  void evictKeys(Invalidations *evicted);
+
+  struct Prefix {
+    std::string ns;
+    std::string prefix;
+    Client client;
+  };
+
+  std::mutex mu_;
+  size_t max_keys_;
+  // the key is encoded with its namespace, and the clients of a key are usually few, so a vector is enough
+  std::unordered_map<std::string, std::vector<Client>> keys_;
+  std::vector<Prefix> prefixes_;
+};
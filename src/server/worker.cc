@@ -28,6 +28,7 @@
 
 #include "event2/bufferevent.h"
 #include "io_util.h"
+#include "jemalloc_util.h"
 #include "scope_exit.h"
 #include "thread_util.h"
 #include "time_util.h"
@@ -52,13 +53,22 @@
 #include "server.h"
 #include "storage/scripting.h"
 
-Worker::Worker(Server *srv, Config *config) : srv(srv), base_(event_base_new()) {
+Worker::Worker(Server *srv, Config *config)
+    : srv(srv), base_(event_base_new()), tracking_table_(config->tracking_table_max_keys) {
   if (!base_) throw std::runtime_error{"event base failed to be created"};
 
   timer_.reset(NewEvent(base_, -1, EV_PERSIST));
   timeval tm = {10, 0};
   evtimer_add(timer_.get(), &tm);
 
+#ifdef ENABLE_IO_URING
+  io_uring_ = std::make_unique<IOUringDriver>(base_);
+  if (auto s = io_uring_->Init(); !s.IsOK()) {
+    LOG(WARNING) << "[worker] Failed to init io_uring, fallback to libevent. Error: " << s.Msg();
+    io_uring_.reset();
+  }
+#endif
+
   uint32_t ports[3] = {config->port, config->tls_port, 0};
   auto binds = config->binds;
 
@@ -90,6 +100,9 @@ Worker::~Worker() {
   }
 
   timer_.reset();
+#ifdef ENABLE_IO_URING
+  io_uring_.reset();
+#endif
   if (rate_limit_group_) {
     bufferevent_rate_limit_group_free(rate_limit_group_);
   }
@@ -130,6 +143,11 @@ void Worker::newTCPConnection(evconnlistener *listener, evutil_socket_t fd, sock
 
   bufferevent *bev = nullptr;
   ssl_st *ssl = nullptr;
+  // The bufferevent doesn't own the socket if it's driven by io_uring
+  int bev_fd = fd;
+#ifdef ENABLE_IO_URING
+  if (io_uring_ && uint32_t(local_port) != srv->GetConfig()->tls_port) bev_fd = -1;
+#endif
 #ifdef ENABLE_OPENSSL
   if (uint32_t(local_port) == srv->GetConfig()->tls_port) {
     ssl = SSL_new(srv->ssl_ctx.get());
@@ -140,10 +158,10 @@ void Worker::newTCPConnection(evconnlistener *listener, evutil_socket_t fd, sock
     }
     bev = bufferevent_openssl_socket_new(base, fd, ssl, BUFFEREVENT_SSL_ACCEPTING, ev_thread_safe_flags);
   } else {
-    bev = bufferevent_socket_new(base, fd, ev_thread_safe_flags);
+    bev = bufferevent_socket_new(base, bev_fd, ev_thread_safe_flags);
   }
 #else
-  bev = bufferevent_socket_new(base, fd, ev_thread_safe_flags);
+  bev = bufferevent_socket_new(base, bev_fd, ev_thread_safe_flags);
 #endif
   if (!bev) {
     auto socket_err = evutil_socket_error_to_string(EVUTIL_SOCKET_ERROR());
@@ -161,9 +179,12 @@ void Worker::newTCPConnection(evconnlistener *listener, evutil_socket_t fd, sock
     bufferevent_openssl_set_allow_dirty_shutdown(bev, 1);
   }
 #endif
-  auto conn = new redis::Connection(bev, this);
+  auto conn = new redis::Connection(bev, this, fd);
   conn->SetCB(bev);
   bufferevent_enable(bev, EV_READ);
+#ifdef ENABLE_IO_URING
+  if (bev_fd == -1) io_uring_->Attach(bev, fd);
+#endif
 
   s = AddConnection(conn);
   if (!s.IsOK()) {
@@ -290,9 +311,40 @@ Status Worker::ListenUnixSocket(const std::string &path, int perm, int backlog)
 
 void Worker::Run(std::thread::id tid) {
   tid_ = tid;
+  if (cpu_ >= 0) {
+    if (auto s = util::ThreadSetAffinity({cpu_}); s.IsOK()) {
+      numa_node_ = util::GetCPUNumaNode(cpu_);
+    } else {
+      LOG(WARNING) << "[worker] Failed to pin the worker thread to CPU " << cpu_ << ". Error: " << s.Msg();
+      cpu_ = -1;
+    }
+  }
+  // bind the memory policy before creating the arena, so that the arena metadata is local as well
+  if (srv->GetConfig()->worker_numa_bind && numa_node_ >= 0) {
+    if (auto s = util::ThreadBindNumaNode(numa_node_); s.IsOK()) {
+      numa_bound_ = true;
+    } else {
+      LOG(WARNING) << "[worker] Failed to bind the memory to the NUMA node " << numa_node_ << ". Error: " << s.Msg();
+    }
+  }
+  if (srv->GetConfig()->worker_dedicated_arena) {
+    auto arena = util::BindThreadToNewArena();
+    if (arena) {
+      arena_ = *arena;
+    } else {
+      LOG(WARNING) << "[worker] Failed to bind a dedicated memory arena, fallback to the shared arenas. Error: "
+                   << arena.Msg();
+    }
+  }
+
   if (event_base_dispatch(base_) != 0) {
     LOG(ERROR) << "[worker] Failed to run server, err: " << strerror(errno);
   }
+
+  if (arena_ != 0) {
+    util::ReleaseArena(arena_);
+    arena_ = 0;
+  }
   is_terminated_ = true;
 }
 
@@ -362,6 +414,11 @@ void Worker::MigrateConnection(Worker *target, redis::Connection *conn) {
   if (!target || !conn) return;
 
   auto bev = conn->GetBufferEvent();
+#ifdef ENABLE_IO_URING
+  // The socket driven by io_uring is submitted to the ring of the current worker,
+  // so it's closed with the worker like the connections which can't be migrated.
+  if (bufferevent_getfd(bev) == -1) return;
+#endif
   // disable read/write event to prevent the connection from being processed during migration
   bufferevent_disable(bev, EV_READ | EV_WRITE);
   // We cannot migrate the connection if it has a running command
@@ -394,6 +451,21 @@ void Worker::DetachConnection(redis::Connection *conn) {
   }
 
   auto bev = conn->GetBufferEvent();
+#ifdef ENABLE_IO_URING
+  if (io_uring_) {
+    io_uring_->Detach(bev);
+    // The detached connection is taken over by a thread which writes the socket directly,
+    // so the output handed back by io_uring, e.g. the unsent part of a reply, is written first.
+    auto output = bufferevent_get_output(bev);
+    if (evbuffer_get_length(output) > 0) {
+      std::string data(evbuffer_get_length(output), '\0');
+      evbuffer_remove(output, data.data(), data.size());
+      auto s = util::SockSetBlocking(conn->GetFD(), 1);
+      if (s.IsOK()) s = util::SockSend(conn->GetFD(), data);
+      if (!s.IsOK()) LOG(WARNING) << "[worker] Failed to flush the output of the detached connection: " << s.Msg();
+    }
+  }
+#endif
   bufferevent_disable(bev, EV_READ | EV_WRITE);
   bufferevent_setcb(bev, nullptr, nullptr, nullptr, nullptr);
 }
@@ -406,6 +478,10 @@ void Worker::FreeConnection(redis::Connection *conn) {
   if (rate_limit_group_) {
     bufferevent_remove_from_rate_limit_group(conn->GetBufferEvent());
   }
+#ifdef ENABLE_IO_URING
+  // hand the socket back to the bufferevent, so it's closed when the bufferevent is freed
+  if (io_uring_) io_uring_->Detach(conn->GetBufferEvent());
+#endif
   delete conn;
 }
 
@@ -416,6 +492,9 @@ void Worker::FreeConnectionByID(int fd, uint64_t id) {
     if (rate_limit_group_ != nullptr) {
       bufferevent_remove_from_rate_limit_group(iter->second->GetBufferEvent());
     }
+#ifdef ENABLE_IO_URING
+    if (io_uring_) io_uring_->Detach(iter->second->GetBufferEvent());
+#endif
     delete iter->second;
     conns_.erase(iter);
     srv->DecrClientNum();
@@ -423,6 +502,9 @@ void Worker::FreeConnectionByID(int fd, uint64_t id) {
 
   iter = monitor_conns_.find(fd);
   if (iter != monitor_conns_.end() && iter->second->GetID() == id) {
+#ifdef ENABLE_IO_URING
+    if (io_uring_) io_uring_->Detach(iter->second->GetBufferEvent());
+#endif
     delete iter->second;
     monitor_conns_.erase(iter);
     srv->DecrClientNum();
@@ -436,6 +518,9 @@ Status Worker::EnableWriteEvent(int fd) {
   if (iter != conns_.end()) {
     auto bev = iter->second->GetBufferEvent();
     bufferevent_enable(bev, EV_WRITE);
+#ifdef ENABLE_IO_URING
+    if (io_uring_) io_uring_->Wakeup(bev);
+#endif
     return Status::OK();
   }
 
@@ -454,6 +539,52 @@ Status Worker::Reply(int fd, const std::string &reply) {
   return {Status::NotOK, "connection doesn't exist"};
 }
 
+void Worker::TrackKeys(redis::Connection *conn, const std::vector<std::string> &keys) {
+  TrackingTable::Invalidations evicted;
+  tracking_table_.TrackKeys(conn->GetNamespace(), keys, {conn->GetFD(), conn->GetID()}, &evicted);
+  if (!evicted.empty()) sendInvalidations(evicted, nullptr);
+}
+
+void Worker::AddTrackingPrefixes(redis::Connection *conn, const std::vector<std::string> &prefixes) {
+  tracking_table_.AddPrefixes(conn->GetNamespace(), prefixes, {conn->GetFD(), conn->GetID()});
+}
+
+void Worker::RemoveTrackingClient(redis::Connection *conn) {
+  tracking_table_.RemoveClient({conn->GetFD(), conn->GetID()});
+}
+
+void Worker::InvalidateTrackedKeys(const std::string &ns, const std::vector<std::string> &keys,
+                                   const redis::Connection *writer) {
+  TrackingTable::Invalidations invalidations;
+  tracking_table_.Invalidate(ns, keys, &invalidations);
+  if (!invalidations.empty()) sendInvalidations(invalidations, writer);
+}
+
+void Worker::InvalidateAllTrackedKeys() {
+  tracking_table_.Clear();
+
+  std::lock_guard<std::mutex> guard(conns_mu_);
+  for (const auto &[_, conn] : conns_) {
+    if (!conn->IsFlagEnabled(redis::Connection::kTracking)) continue;
+    // the null array tells the client to flush all the cached keys
+    redis::Reply(conn->Output(), conn->HeaderOfPush(2) + redis::BulkString("invalidate") + conn->NilArray());
+  }
+}
+
+void Worker::sendInvalidations(const TrackingTable::Invalidations &invalidations, const redis::Connection *writer) {
+  std::lock_guard<std::mutex> guard(conns_mu_);
+  for (const auto &[client, keys] : invalidations) {
+    auto iter = conns_.find(client.first);
+    // the connection may have been freed after its keys were tracked
+    if (iter == conns_.end() || iter->second->GetID() != client.second) continue;
+
+    auto conn = iter->second;
+    if (!conn->IsFlagEnabled(redis::Connection::kTracking)) continue;
+    if (conn == writer && conn->IsTrackingNoLoop()) continue;
+    redis::Reply(conn->Output(), conn->HeaderOfPush(2) + redis::BulkString("invalidate") + conn->MultiBulkString(keys));
+  }
+}
+
 void Worker::BecomeMonitorConn(redis::Connection *conn) {
   {
     std::lock_guard<std::mutex> guard(conns_mu_);
@@ -498,6 +629,16 @@ std::string Worker::GetClientsStr() {
   return output;
 }
 
+uint64_t Worker::GetClientsMemory() {
+  std::unique_lock<std::mutex> lock(conns_mu_);
+
+  uint64_t total = 0;
+  for (const auto &iter : conns_) {
+    total += iter.second->GetMemoryUsage();
+  }
+  return total;
+}
+
 void Worker::KillClient(redis::Connection *self, uint64_t id, const std::string &addr, uint64_t type, bool skipme,
                         int64_t *killed) {
   std::lock_guard<std::mutex> guard(conns_mu_);
@@ -519,6 +660,9 @@ void Worker::KillClient(redis::Connection *self, uint64_t id, const std::string
       if (!conn->IsFlagEnabled(redis::Connection::kSlave)) {  // don't enable any event in slave connection
         auto bev = conn->GetBufferEvent();
         bufferevent_enable(bev, EV_WRITE);
+#ifdef ENABLE_IO_URING
+        if (io_uring_) io_uring_->Wakeup(bev);
+#endif
       }
       (*killed)++;
     }
@@ -37,8 +37,10 @@
 #include <vector>
 
 #include "event_util.h"
+#include "io_uring_driver.h"
 #include "redis_connection.h"
 #include "storage/storage.h"
+#include "tracking_table.h"
 
 class Server;
 
@@ -65,7 +67,28 @@ class Worker : EventCallbackBase<Worker>, EvconnlistenerBase<Worker> {
   void QuitMonitorConn(redis::Connection *conn);
   void FeedMonitorConns(redis::Connection *conn, const std::string &response);
 
+  // Client side caching of the connections in the worker
+  void TrackKeys(redis::Connection *conn, const std::vector<std::string> &keys);
+  void AddTrackingPrefixes(redis::Connection *conn, const std::vector<std::string> &prefixes);
+  void RemoveTrackingClient(redis::Connection *conn);
+  // Push the invalidation messages to the connections which cached the keys modified by the writer
+  void InvalidateTrackedKeys(const std::string &ns, const std::vector<std::string> &keys,
+                             const redis::Connection *writer);
+  void InvalidateAllTrackedKeys();
+  void SetTrackingTableMaxKeys(size_t max_keys) { tracking_table_.SetMaxKeys(max_keys); }
+  size_t GetTrackedKeyNum() { return tracking_table_.Size(); }
+
   std::string GetClientsStr();
+  // Bytes held by the buffers of all the connections in the worker
+  uint64_t GetClientsMemory();
+  // The jemalloc arena dedicated to the worker thread, 0 means the thread uses the automatic arenas
+  unsigned GetArena() const { return arena_; }
+  // Pin the worker thread to the CPU once it runs, it must be called before the thread starts
+  void SetCPU(int cpu) { cpu_ = cpu; }
+  // The CPU the worker thread is pinned to and its NUMA node, -1 means unknown
+  int GetCPU() const { return cpu_; }
+  int GetNumaNode() const { return numa_node_; }
+  bool IsNumaBound() const { return numa_bound_; }
   void KillClient(redis::Connection *self, uint64_t id, const std::string &addr, uint64_t type, bool skipme,
                   int64_t *killed);
   void KickoutIdleClients(int timeout);
@@ -83,6 +106,7 @@ class Worker : EventCallbackBase<Worker>, EvconnlistenerBase<Worker> {
   void newTCPConnection(evconnlistener *listener, evutil_socket_t fd, sockaddr *address, int socklen);
   void newUnixSocketConnection(evconnlistener *listener, evutil_socket_t fd, sockaddr *address, int socklen);
   redis::Connection *removeConnection(int fd);
+  void sendInvalidations(const TrackingTable::Invalidations &invalidations, const redis::Connection *writer);
 
   event_base *base_;
   UniqueEvent timer_;
@@ -92,11 +116,19 @@ class Worker : EventCallbackBase<Worker>, EvconnlistenerBase<Worker> {
   std::map<int, redis::Connection *> conns_;
   std::map<int, redis::Connection *> monitor_conns_;
   int last_iter_conn_fd_ = 0;  // fd of last processed connection in previous cron
+  TrackingTable tracking_table_;
 
+#ifdef ENABLE_IO_URING
+  std::unique_ptr<IOUringDriver> io_uring_;
+#endif
   struct bufferevent_rate_limit_group *rate_limit_group_ = nullptr;
   struct ev_token_bucket_cfg *rate_limit_group_cfg_ = nullptr;
   lua_State *lua_;
   std::atomic<bool> is_terminated_ = false;
+  std::atomic<unsigned> arena_ = 0;
+  std::atomic<int> cpu_ = -1;
+  std::atomic<int> numa_node_ = -1;
+  std::atomic<bool> numa_bound_ = false;
 };
 
 class WorkerThread {
@@ -0,0 +1,194 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "cpu_profiler.h"
+
+#include <execinfo.h>
+#include <fmt/format.h>
+#include <sys/time.h>
+
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+
+namespace google {
+bool Symbolize(void *pc, char *out, size_t out_size);
+}  // namespace google
+
+namespace {
+
+constexpr int kMaxStackDepth = 64;
+// the frames of the signal handler and the signal trampoline
+constexpr int kSkippedFrames = 2;
+constexpr size_t kMaxSamples = 1 << 15;
+
+struct Sample {
+  std::atomic<bool> ready = false;
+  char thread_name[16] = {};
+  int depth = 0;
+  void *frames[kMaxStackDepth + kSkippedFrames] = {};
+};
+
+std::mutex profiler_mu;
+bool handler_installed = false;
+// the samples are kept until the next start, since a signal handler may still be running after the stop
+std::unique_ptr<Sample[]> samples;
+
+std::atomic<bool> sampling = false;
+std::atomic<Sample *> sample_buffer = nullptr;
+std::atomic<size_t> next_sample = 0;
+std::atomic<uint64_t> dropped_samples = 0;
+std::atomic<int> running_handlers = 0;
+
+std::string SymbolizeFrame(void *pc, std::unordered_map<void *, std::string> *symbols) {
+  if (auto iter = symbols->find(pc); iter != symbols->end()) return iter->second;
+
+  char name[1024] = {};
+  std::string symbol;
+  if (google::Symbolize(pc, name, sizeof(name) - 1)) {
+    symbol = name;
+    // the separators of the collapsed-stack format can't appear in the frame names
+    for (auto &c : symbol) {
+      if (c == ';' || c == ' ') c = '_';
+    }
+  } else {
+    symbol = fmt::format("{}", pc);
+  }
+  return symbols->emplace(pc, std::move(symbol)).first->second;
+}
+
+}  // namespace
+
+void CpuProfiler::signalHandler(int, siginfo_t *, void *) {
+  int saved_errno = errno;
+  running_handlers++;
+
+  Sample *buffer = sample_buffer;
+  if (buffer) {
+    size_t index = next_sample.fetch_add(1, std::memory_order_relaxed);
+    if (index < kMaxSamples) {
+      Sample &sample = buffer[index];
+#ifdef __linux__
+      prctl(PR_GET_NAME, sample.thread_name);
+#endif
+      sample.depth = backtrace(sample.frames, kMaxStackDepth + kSkippedFrames);
+      sample.ready.store(true, std::memory_order_release);
+    } else {
+      dropped_samples.fetch_add(1, std::memory_order_relaxed);
+    }
+  }
+
+  running_handlers--;
+  errno = saved_errno;
+}
+
+Status CpuProfiler::Start(int frequency) {
+  if (frequency <= 0 || frequency > kMaxFrequency) {
+    return {Status::NotOK, fmt::format("the sampling frequency should be between 1 and {}", kMaxFrequency)};
+  }
+
+  std::lock_guard<std::mutex> guard(profiler_mu);
+  if (sampling) return {Status::NotOK, "the profiler is already running"};
+
+  // backtrace loads the unwinder lazily on the first call, which isn't async-signal-safe
+  void *warmup_frames[1];
+  backtrace(warmup_frames, 1);
+
+  if (!handler_installed) {
+    // the handler is never uninstalled, since the default action of a SIGPROF
+    // which is still pending after the stop is to terminate the process
+    struct sigaction act = {};
+    act.sa_sigaction = signalHandler;
+    act.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&act.sa_mask);
+    if (sigaction(SIGPROF, &act, nullptr) != 0) {
+      return {Status::NotOK, fmt::format("failed to install the signal handler: {}", strerror(errno))};
+    }
+    handler_installed = true;
+  }
+
+  samples = std::make_unique<Sample[]>(kMaxSamples);
+  next_sample = 0;
+  dropped_samples = 0;
+  sample_buffer = samples.get();
+  sampling = true;
+
+  itimerval timer = {};
+  timer.it_interval.tv_sec = 0;
+  timer.it_interval.tv_usec = 1000000 / frequency;
+  timer.it_value = timer.it_interval;
+  if (setitimer(ITIMER_PROF, &timer, nullptr) != 0) {
+    sample_buffer = nullptr;
+    sampling = false;
+    return {Status::NotOK, fmt::format("failed to start the profiling timer: {}", strerror(errno))};
+  }
+  return Status::OK();
+}
+
+StatusOr<std::string> CpuProfiler::Stop() {
+  std::lock_guard<std::mutex> guard(profiler_mu);
+  if (!sampling) return {Status::NotOK, "the profiler isn't running"};
+
+  itimerval timer = {};
+  setitimer(ITIMER_PROF, &timer, nullptr);
+  sample_buffer = nullptr;
+  sampling = false;
+  // wait for the handlers which may still be writing the samples
+  while (running_handlers > 0) {
+    std::this_thread::yield();
+  }
+
+  std::map<std::string, uint64_t> stacks;
+  std::unordered_map<void *, std::string> symbols;
+  size_t total = std::min(next_sample.load(), kMaxSamples);
+  for (size_t i = 0; i < total; i++) {
+    const Sample &sample = samples[i];
+    if (!sample.ready.load(std::memory_order_acquire)) continue;
+
+    std::string stack = sample.thread_name;
+    for (int j = sample.depth - 1; j >= kSkippedFrames; j--) {
+      // the frames except the interrupted one are return addresses, which may point to the next function
+      auto pc = static_cast<char *>(sample.frames[j]) - (j == kSkippedFrames ? 0 : 1);
+      stack.append(";").append(SymbolizeFrame(pc, &symbols));
+    }
+    stacks[stack]++;
+  }
+
+  std::string output;
+  for (const auto &[stack, count] : stacks) {
+    output.append(fmt::format("{} {}\n", stack, count));
+  }
+  if (auto dropped = dropped_samples.load(); dropped > 0) {
+    output.append(fmt::format("[dropped] {}\n", dropped));
+  }
+  return output;
+}
+
+bool CpuProfiler::IsRunning() { return sampling; }
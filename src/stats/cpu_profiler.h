@@ -0,0 +1,46 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#pragma once
+
+#include <csignal>
+#include <string>
+
+#include "status.h"
+
+// CpuProfiler samples the call stacks of all the threads in the process, including the workers
+// and the background threads of RocksDB, by the SIGPROF signal of the profiling timer,
+// which fires in the thread consuming the CPU time.
+//
+// The stacks are captured into a preallocated buffer in the signal handler,
+// and are symbolized and aggregated in the collapsed-stack format of the flame graph tools
+// (`thread;outermost_frame;...;innermost_frame count` per line) when the profiler is stopped.
+class CpuProfiler {
+ public:
+  static constexpr int kDefaultFrequency = 99;
+  static constexpr int kMaxFrequency = 10000;
+
+  static Status Start(int frequency);
+  static StatusOr<std::string> Stop();
+  static bool IsRunning();
+
+ private:
+  static void signalHandler(int sig, siginfo_t *info, void *ucontext);
+};
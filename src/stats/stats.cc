@@ -20,6 +20,7 @@
 
 #include "stats.h"
 
+#include <algorithm>
 #include <chrono>
 #include <mutex>
 
@@ -92,6 +93,34 @@ void Stats::IncrLatency(uint64_t latency, const std::string &command_name) {
   commands_stats[command_name].latency.fetch_add(latency, std::memory_order_relaxed);
 }
 
+void Stats::IncrLatencyHistogram(uint64_t latency) {
+  int bucket = latency == 0 ? 0 : std::min(64 - __builtin_clzll(latency), STATS_LATENCY_BUCKETS - 1);
+  latency_buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+std::vector<uint64_t> Stats::GetLatencyHistogram() const {
+  std::vector<uint64_t> histogram(STATS_LATENCY_BUCKETS);
+  for (int i = 0; i < STATS_LATENCY_BUCKETS; i++) {
+    histogram[i] = latency_buckets[i].load(std::memory_order_relaxed);
+  }
+  return histogram;
+}
+
+// Return the upper bound of the bucket which the percentile falls into, in microseconds
+uint64_t Stats::GetLatencyPercentile(const std::vector<uint64_t> &histogram, double percentile) {
+  uint64_t total = 0;
+  for (auto count : histogram) total += count;
+  if (total == 0) return 0;
+
+  auto rank = static_cast<uint64_t>(static_cast<double>(total) * percentile);
+  uint64_t seen = 0;
+  for (size_t i = 0; i < histogram.size(); i++) {
+    seen += histogram[i];
+    if (seen > rank) return uint64_t(1) << i;
+  }
+  return uint64_t(1) << (histogram.size() - 1);
+}
+
 void Stats::TrackInstantaneousMetric(int metric, uint64_t current_reading) {
   uint64_t curr_time_ms = util::GetTimeStampMS();
   std::unique_lock<std::shared_mutex> lock(inst_metrics_mutex);
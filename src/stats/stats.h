@@ -22,6 +22,7 @@
 
 #include <unistd.h>
 
+#include <array>
 #include <atomic>
 #include <map>
 #include <shared_mutex>
@@ -42,6 +43,9 @@ enum StatsMetricFlags {
 };
 
 const int STATS_METRIC_SAMPLES = 16;  // Number of samples per metric
+// Number of buckets of the command latency histogram, the bucket i counts the
+// latencies in [2^(i-1), 2^i) microseconds and the last bucket counts the rest.
+const int STATS_LATENCY_BUCKETS = 32;
 
 struct CommandStat {
   std::atomic<uint64_t> calls;
@@ -67,17 +71,26 @@ class Stats {
   std::atomic<uint64_t> fullsync_count = {0};
   std::atomic<uint64_t> psync_err_count = {0};
   std::atomic<uint64_t> psync_ok_count = {0};
+  // TLS sessions whose records are sent or received through the kernel (kTLS)
+  std::atomic<uint64_t> ktls_send_sessions = {0};
+  std::atomic<uint64_t> ktls_recv_sessions = {0};
   std::map<std::string, CommandStat> commands_stats;
+  std::array<std::atomic<uint64_t>, STATS_LATENCY_BUCKETS> latency_buckets{};
 
   Stats();
   void IncrCalls(const std::string &command_name);
   void IncrLatency(uint64_t latency, const std::string &command_name);
+  void IncrLatencyHistogram(uint64_t latency);
   void IncrInboundBytes(uint64_t bytes) { in_bytes.fetch_add(bytes, std::memory_order_relaxed); }
   void IncrOutboundBytes(uint64_t bytes) { out_bytes.fetch_add(bytes, std::memory_order_relaxed); }
   void IncrFullSyncCount() { fullsync_count.fetch_add(1, std::memory_order_relaxed); }
   void IncrPSyncErrCount() { psync_err_count.fetch_add(1, std::memory_order_relaxed); }
   void IncrPSyncOKCount() { psync_ok_count.fetch_add(1, std::memory_order_relaxed); }
+  void IncrKTLSSendSessions() { ktls_send_sessions.fetch_add(1, std::memory_order_relaxed); }
+  void IncrKTLSRecvSessions() { ktls_recv_sessions.fetch_add(1, std::memory_order_relaxed); }
   static int64_t GetMemoryRSS();
   void TrackInstantaneousMetric(int metric, uint64_t current_reading);
   uint64_t GetInstantaneousMetric(int metric) const;
+  std::vector<uint64_t> GetLatencyHistogram() const;
+  static uint64_t GetLatencyPercentile(const std::vector<uint64_t> &histogram, double percentile);
 };
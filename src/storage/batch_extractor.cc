@@ -26,6 +26,7 @@
 #include "parse_util.h"
 #include "server/redis_reply.h"
 #include "server/server.h"
+#include "string_util.h"
 #include "types/redis_bitmap.h"
 
 void WriteBatchExtractor::LogData(const rocksdb::Slice &blob) {
@@ -43,8 +44,23 @@ void WriteBatchExtractor::LogData(const rocksdb::Slice &blob) {
   }
 }
 
+bool WriteBatchExtractor::isFiltered(const std::string &ns, const std::string &user_key) const {
+  if (slot_id_ >= 0 && static_cast<uint16_t>(slot_id_) != GetSlotIdFromKey(user_key)) {
+    return true;
+  }
+  if (!namespace_.empty() && ns != namespace_) {
+    return true;
+  }
+  return !key_pattern_.empty() && !util::StringMatch(key_pattern_, user_key, 0);
+}
+
+bool WriteBatchExtractor::isTypeFiltered() const {
+  // updates which are not bound to a type(e.g. DEL and EXPIRE) are never filtered
+  return types_ && log_data_.GetRedisType() != kRedisNone && !types_->Contains(log_data_.GetRedisType());
+}
+
 rocksdb::Status WriteBatchExtractor::PutCF(uint32_t column_family_id, const Slice &key, const Slice &value) {
-  if (column_family_id == static_cast<uint32_t>(ColumnFamilyID::SecondarySubkey)) {
+  if (column_family_id == static_cast<uint32_t>(ColumnFamilyID::SecondarySubkey) || isTypeFiltered()) {
     return rocksdb::Status::OK();
   }
 
@@ -53,7 +69,7 @@ rocksdb::Status WriteBatchExtractor::PutCF(uint32_t column_family_id, const Slic
 
   if (column_family_id == static_cast<uint32_t>(ColumnFamilyID::Metadata)) {
     std::tie(ns, user_key) = ExtractNamespaceKey<std::string>(key, is_slot_id_encoded_);
-    if (slot_id_ >= 0 && static_cast<uint16_t>(slot_id_) != GetSlotIdFromKey(user_key)) {
+    if (isFiltered(ns, user_key)) {
       return rocksdb::Status::OK();
     }
 
@@ -112,17 +128,34 @@ rocksdb::Status WriteBatchExtractor::PutCF(uint32_t column_family_id, const Slic
   if (column_family_id == static_cast<uint32_t>(ColumnFamilyID::PrimarySubkey)) {
     InternalKey ikey(key, is_slot_id_encoded_);
     user_key = ikey.GetKey().ToString();
-    if (slot_id_ >= 0 && static_cast<uint16_t>(slot_id_) != GetSlotIdFromKey(user_key)) {
+    ns = ikey.GetNamespace().ToString();
+    if (isFiltered(ns, user_key)) {
       return rocksdb::Status::OK();
     }
 
     std::string sub_key = ikey.GetSubKey().ToString();
-    ns = ikey.GetNamespace().ToString();
 
     switch (log_data_.GetRedisType()) {
-      case kRedisHash:
-        command_args = {"HSET", user_key, sub_key, value.ToString()};
+      case kRedisHash: {
+        auto args = log_data_.GetArguments();
+        HashMetadata hash_metadata(false);
+        if (!args->empty() && (*args)[0] == std::to_string(kRedisCmdHExpire)) {
+          hash_metadata.field_encoding = HashSubkeyEncoding::VALUE_WITH_TTL;
+        }
+
+        Slice field_value;
+        uint64_t expire = 0;
+        if (!hash_metadata.DecodeFieldValue(value, &field_value, &expire)) {
+          LOG(ERROR) << "Failed to parse write_batch in PutCF. Type=Hash: the value of field is too short";
+          return rocksdb::Status::OK();
+        }
+        command_args = {"HSET", user_key, sub_key, field_value.ToString()};
+        if (expire > 0) {
+          resp_commands_[ns].emplace_back(redis::ArrayOfBulkStrings(command_args));
+          command_args = {"HPEXPIREAT", user_key, std::to_string(expire), "FIELDS", "1", sub_key};
+        }
         break;
+      }
       case kRedisList: {
         auto args = log_data_.GetArguments();
         if (args->empty()) {
@@ -253,6 +286,12 @@ rocksdb::Status WriteBatchExtractor::PutCF(uint32_t column_family_id, const Slic
         break;
     }
   } else if (column_family_id == static_cast<uint32_t>(ColumnFamilyID::Stream)) {
+    InternalKey ikey(key, is_slot_id_encoded_);
+    ns = ikey.GetNamespace().ToString();
+    if (isFiltered(ns, ikey.GetKey().ToString())) {
+      return rocksdb::Status::OK();
+    }
+
     auto s = ExtractStreamAddCommand(is_slot_id_encoded_, key, value, &command_args);
     if (!s.IsOK()) {
       LOG(ERROR) << "Failed to parse write_batch in PutCF. Type=Stream: " << s.Msg();
@@ -268,7 +307,7 @@ rocksdb::Status WriteBatchExtractor::PutCF(uint32_t column_family_id, const Slic
 }
 
 rocksdb::Status WriteBatchExtractor::DeleteCF(uint32_t column_family_id, const Slice &key) {
-  if (column_family_id == static_cast<uint32_t>(ColumnFamilyID::SecondarySubkey)) {
+  if (column_family_id == static_cast<uint32_t>(ColumnFamilyID::SecondarySubkey) || isTypeFiltered()) {
     return rocksdb::Status::OK();
   }
 
@@ -279,7 +318,7 @@ rocksdb::Status WriteBatchExtractor::DeleteCF(uint32_t column_family_id, const S
     std::string user_key;
     std::tie(ns, user_key) = ExtractNamespaceKey<std::string>(key, is_slot_id_encoded_);
 
-    if (slot_id_ >= 0 && static_cast<uint16_t>(slot_id_) != GetSlotIdFromKey(user_key)) {
+    if (isFiltered(ns, user_key)) {
       return rocksdb::Status::OK();
     }
 
@@ -287,12 +326,12 @@ rocksdb::Status WriteBatchExtractor::DeleteCF(uint32_t column_family_id, const S
   } else if (column_family_id == static_cast<uint32_t>(ColumnFamilyID::PrimarySubkey)) {
     InternalKey ikey(key, is_slot_id_encoded_);
     std::string user_key = ikey.GetKey().ToString();
-    if (slot_id_ >= 0 && static_cast<uint16_t>(slot_id_) != GetSlotIdFromKey(user_key)) {
+    ns = ikey.GetNamespace().ToString();
+    if (isFiltered(ns, user_key)) {
       return rocksdb::Status::OK();
     }
 
     std::string sub_key = ikey.GetSubKey().ToString();
-    ns = ikey.GetNamespace().ToString();
 
     switch (log_data_.GetRedisType()) {
       case kRedisHash:
@@ -378,6 +417,11 @@ rocksdb::Status WriteBatchExtractor::DeleteCF(uint32_t column_family_id, const S
     }
   } else if (column_family_id == static_cast<uint32_t>(ColumnFamilyID::Stream)) {
     InternalKey ikey(key, is_slot_id_encoded_);
+    ns = ikey.GetNamespace().ToString();
+    if (isFiltered(ns, ikey.GetKey().ToString())) {
+      return rocksdb::Status::OK();
+    }
+
     Slice encoded_id = ikey.GetSubKey();
     redis::StreamEntryID entry_id;
     GetFixed64(&encoded_id, &entry_id.ms);
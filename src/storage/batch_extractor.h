@@ -21,6 +21,7 @@
 #pragma once
 
 #include <map>
+#include <optional>
 #include <string>
 #include <vector>
 
@@ -41,14 +42,27 @@ class WriteBatchExtractor : public rocksdb::WriteBatch::Handler {
   rocksdb::Status DeleteRangeCF(uint32_t column_family_id, const Slice &begin_key, const Slice &end_key) override;
   std::map<std::string, std::vector<std::string>> *GetRESPCommands() { return &resp_commands_; }
 
+  // Only extract updates of keys in the namespace, empty means all namespaces
+  void SetNamespace(std::string ns) { namespace_ = std::move(ns); }
+  // Only extract updates of keys matching the glob-style pattern, empty means all keys
+  void SetKeyPattern(std::string pattern) { key_pattern_ = std::move(pattern); }
+  // Only extract updates of the specified types
+  void SetRedisTypes(RedisTypes types) { types_ = types; }
+
   static Status ExtractStreamAddCommand(bool is_slot_id_encoded, const Slice &subkey, const Slice &value,
                                         std::vector<std::string> *command_args);
 
  private:
+  bool isFiltered(const std::string &ns, const std::string &user_key) const;
+  bool isTypeFiltered() const;
+
   std::map<std::string, std::vector<std::string>> resp_commands_;
   redis::WriteBatchLogData log_data_;
   bool first_seen_ = true;
   bool is_slot_id_encoded_ = false;
   int slot_id_;
   bool to_redis_;
+  std::string namespace_;
+  std::string key_pattern_;
+  std::optional<RedisTypes> types_;
 };
@@ -22,12 +22,14 @@
 
 #include <glog/logging.h>
 
+#include <limits>
 #include <string>
 #include <utility>
 
 #include "db_util.h"
 #include "time_util.h"
 #include "types/redis_bitmap.h"
+#include "types/redis_hash.h"
 
 namespace engine {
 
@@ -95,25 +97,66 @@ bool SubKeyFilter::IsMetadataExpired(const InternalKey &ikey, const Metadata &me
          || metadata.ExpireAt(lazy_expired_ts) || ikey.GetVersion() != metadata.version;
 }
 
+rocksdb::CompactionFilter::Decision SubKeyFilter::removeDeadVersion(const InternalKey &ikey,
+                                                                    std::string *skip_until) const {
+  // The sub keys of a version are contiguous and the version is never reused, so once the version is dead,
+  // all its sub keys could be removed by skipping to the first sub key of the next version. The older values of
+  // the skipped keys in the lower levels may show up again, but they are in the dead version as well.
+  if (!skip_dead_versions_ || ikey.GetVersion() == std::numeric_limits<uint64_t>::max()) {
+    return rocksdb::CompactionFilter::Decision::kRemove;
+  }
+  // `cached_key_` is the namespace key of `ikey` after GetMetadata
+  *skip_until = InternalKey(cached_key_, "", ikey.GetVersion() + 1, stor_->IsSlotIdEncoded()).Encode();
+  return rocksdb::CompactionFilter::Decision::kRemoveAndSkipUntil;
+}
+
 rocksdb::CompactionFilter::Decision SubKeyFilter::FilterBlobByKey(int level, const Slice &key, std::string *new_value,
                                                                   std::string *skip_until) const {
   InternalKey ikey(key, stor_->IsSlotIdEncoded());
   Metadata metadata(kRedisNone, false);
   Status s = GetMetadata(ikey, &metadata);
   if (s.Is<Status::NotFound>()) {
-    return rocksdb::CompactionFilter::Decision::kRemove;
+    return removeDeadVersion(ikey, skip_until);
   }
   if (!s.IsOK()) {
     LOG(ERROR) << "[compact_filter/subkey] Failed to get metadata"
                << ", namespace: " << ikey.GetNamespace() << ", key: " << ikey.GetKey() << ", err: " << s.Msg();
     return rocksdb::CompactionFilter::Decision::kKeep;
   }
-  // bitmap will be checked in Filter
-  if (metadata.Type() == kRedisBitmap) {
+  if (IsMetadataExpired(ikey, metadata)) {
+    return removeDeadVersion(ikey, skip_until);
+  }
+  // bitmap and hash with field expiration will be checked in Filter
+  if (metadata.Type() == kRedisBitmap || metadata.Type() == kRedisHash) {
     return rocksdb::CompactionFilter::Decision::kUndetermined;
   }
+  return rocksdb::CompactionFilter::Decision::kKeep;
+}
 
-  bool result = IsMetadataExpired(ikey, metadata);
+rocksdb::CompactionFilter::Decision SubKeyFilter::FilterV2(int level, const Slice &key, ValueType value_type,
+                                                           const Slice &existing_value, std::string *new_value,
+                                                           std::string *skip_until) const {
+  if (value_type != ValueType::kValue) {
+    return rocksdb::CompactionFilter::FilterV2(level, key, value_type, existing_value, new_value, skip_until);
+  }
+
+  InternalKey ikey(key, stor_->IsSlotIdEncoded());
+  Metadata metadata(kRedisNone, false);
+  Status s = GetMetadata(ikey, &metadata);
+  if (s.Is<Status::NotFound>()) {
+    return removeDeadVersion(ikey, skip_until);
+  }
+  if (!s.IsOK()) {
+    LOG(ERROR) << "[compact_filter/subkey] Failed to get metadata"
+               << ", namespace: " << ikey.GetNamespace() << ", key: " << ikey.GetKey() << ", err: " << s.Msg();
+    return rocksdb::CompactionFilter::Decision::kKeep;
+  }
+  if (IsMetadataExpired(ikey, metadata)) {
+    return removeDeadVersion(ikey, skip_until);
+  }
+
+  bool result = (metadata.Type() == kRedisBitmap && redis::Bitmap::IsEmptySegment(existing_value)) ||
+                (metadata.Type() == kRedisHash && isHashFieldExpired(existing_value));
   return result ? rocksdb::CompactionFilter::Decision::kRemove : rocksdb::CompactionFilter::Decision::kKeep;
 }
 
@@ -131,7 +174,16 @@ bool SubKeyFilter::Filter(int level, const Slice &key, const Slice &value, std::
     return false;
   }
 
-  return IsMetadataExpired(ikey, metadata) || (metadata.Type() == kRedisBitmap && redis::Bitmap::IsEmptySegment(value));
+  return IsMetadataExpired(ikey, metadata) || (metadata.Type() == kRedisBitmap && redis::Bitmap::IsEmptySegment(value)) ||
+         (metadata.Type() == kRedisHash && isHashFieldExpired(value));
+}
+
+bool SubKeyFilter::isHashFieldExpired(const Slice &value) const {
+  HashMetadata metadata(false);
+  if (!metadata.Decode(cached_metadata_).ok() || !metadata.IsFieldExpirationEnabled()) {
+    return false;
+  }
+  return redis::Hash::DecodeFieldValue(metadata, value, nullptr).IsNotFound();
 }
 
 }  // namespace engine
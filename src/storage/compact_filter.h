@@ -57,19 +57,29 @@ class MetadataFilterFactory : public rocksdb::CompactionFilterFactory {
 
 class SubKeyFilter : public rocksdb::CompactionFilter {
  public:
-  explicit SubKeyFilter(Storage *storage) : stor_(storage) {}
+  // If `skip_dead_versions` is true, all the sub keys of a dead version are removed once the first of them is met,
+  // instead of checking them one by one.
+  explicit SubKeyFilter(Storage *storage, bool skip_dead_versions = false)
+      : stor_(storage), skip_dead_versions_(skip_dead_versions) {}
 
   const char *Name() const override { return "SubkeyFilter"; }
   Status GetMetadata(const InternalKey &ikey, Metadata *metadata) const;
   static bool IsMetadataExpired(const InternalKey &ikey, const Metadata &metadata);
   rocksdb::CompactionFilter::Decision FilterBlobByKey(int level, const Slice &key, std::string *new_value,
                                                       std::string *skip_until) const override;
+  rocksdb::CompactionFilter::Decision FilterV2(int level, const Slice &key, ValueType value_type,
+                                               const Slice &existing_value, std::string *new_value,
+                                               std::string *skip_until) const override;
   bool Filter(int level, const Slice &key, const Slice &value, std::string *new_value, bool *modified) const override;
 
  protected:
+  bool isHashFieldExpired(const Slice &value) const;
+  rocksdb::CompactionFilter::Decision removeDeadVersion(const InternalKey &ikey, std::string *skip_until) const;
+
   mutable std::string cached_key_;
   mutable std::string cached_metadata_;
   engine::Storage *stor_;
+  bool skip_dead_versions_;
 };
 
 class SubKeyFilterFactory : public rocksdb::CompactionFilterFactory {
@@ -79,7 +89,13 @@ class SubKeyFilterFactory : public rocksdb::CompactionFilterFactory {
   const char *Name() const override { return "SubKeyFilterFactory"; }
   std::unique_ptr<rocksdb::CompactionFilter> CreateCompactionFilter(
       const rocksdb::CompactionFilter::Context &context) override {
-    return std::unique_ptr<rocksdb::CompactionFilter>(new SubKeyFilter(stor_));
+    // The index keys of the search column family are encoded as InternalKey with the version of the index
+    // like the other sub keys, so the dead versions are skipped in all column families.
+    //
+    // The skipping isn't gated on the snapshots: the compaction filter ignores the snapshots anyway
+    // (IgnoreSnapshots() can't be false), so kRemove drops the sub keys of a dead version one by one even if
+    // they're visible to a snapshot, and kRemoveAndSkipUntil drops no key which wouldn't be removed that way.
+    return std::unique_ptr<rocksdb::CompactionFilter>(new SubKeyFilter(stor_, true));
   }
 
  private:
@@ -31,6 +31,8 @@ void CompactionChecker::CompactPropagateAndPubSubFiles() {
   compact_opts.change_level = true;
   for (const auto &cf :
        {engine::ColumnFamilyConfigs::PubSubColumnFamily(), engine::ColumnFamilyConfigs::PropagateColumnFamily()}) {
+    // the files of the FIFO compaction are dropped by the TTL
+    if (cf.Id() == ColumnFamilyID::PubSub && storage_->GetConfig()->rocks_db.pubsub_fifo_compaction) continue;
     LOG(INFO) << "[compaction checker] Start the compact the column family: " << cf.Name();
     auto cf_handle = storage_->GetCFHandle(cf.Id());
     auto s = storage_->GetDB()->CompactRange(compact_opts, cf_handle, nullptr, nullptr);
@@ -0,0 +1,116 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "compaction_rate_controller.h"
+
+#include <glog/logging.h>
+
+#include <algorithm>
+
+#include "stats/stats.h"
+
+void CompactionRateController::Adjust(const std::vector<uint64_t> &latency_histogram) {
+  std::vector<uint64_t> delta(latency_histogram.size());
+  for (size_t i = 0; i < latency_histogram.size(); i++) {
+    delta[i] = latency_histogram[i] - (i < last_latency_histogram_.size() ? last_latency_histogram_[i] : 0);
+  }
+  last_latency_histogram_ = latency_histogram;
+
+  std::lock_guard<std::mutex> guard(mu_);
+  int max_background_jobs = config_->rocks_db.max_background_jobs;
+  if (!config_->compaction_auto_tune) {
+    if (enabled_) {
+      // restore the static limits when the auto-tune was disabled
+      storage_->SetIORateLimit(config_->max_io_mb);
+      auto s = storage_->SetDBOption("max_background_jobs", std::to_string(max_background_jobs));
+      if (!s.IsOK()) LOG(WARNING) << "[compaction controller] Failed to restore the background jobs: " << s.Msg();
+      enabled_ = false;
+      last_decision_ = "none";
+    }
+    return;
+  }
+
+  int64_t min_io_rate_mb = config_->compaction_auto_tune_min_io_mb;
+  int64_t max_io_rate_mb = std::max<int64_t>(min_io_rate_mb, config_->compaction_auto_tune_max_io_mb);
+  int min_background_jobs = std::min(config_->compaction_auto_tune_min_background_jobs, max_background_jobs);
+  if (!enabled_) {
+    // start from the upper bounds, so it only throttles when the latency is hurt
+    enabled_ = true;
+    io_rate_mb_ = 0;
+    background_jobs_ = 0;
+    apply(max_io_rate_mb, max_background_jobs);
+  }
+
+  p99_latency_us_ = Stats::GetLatencyPercentile(delta, 0.99);
+  pending_compaction_bytes_ = 0;
+  storage_->GetDB()->GetAggregatedIntProperty("rocksdb.estimate-pending-compaction-bytes", &pending_compaction_bytes_);
+
+  // Compactions are considered to fall behind if the pending bytes exceed the half of soft limit,
+  // since rocksdb would start to slow down the writes when reaching the soft limit.
+  uint64_t pending_bytes_limit = storage_->GetDB()->GetOptions().soft_pending_compaction_bytes_limit / 2;
+  bool compaction_behind = pending_bytes_limit > 0 && pending_compaction_bytes_ >= pending_bytes_limit;
+  auto latency_target = static_cast<uint64_t>(config_->compaction_auto_tune_latency_target_us);
+
+  int64_t io_rate_mb = io_rate_mb_;
+  int background_jobs = background_jobs_;
+  if (p99_latency_us_ > latency_target && !compaction_behind) {
+    last_decision_ = "throttle";
+    io_rate_mb = io_rate_mb * 7 / 10;
+    background_jobs--;
+  } else if (compaction_behind || p99_latency_us_ <= latency_target / 2) {
+    last_decision_ = "boost";
+    io_rate_mb += std::max<int64_t>(1, (max_io_rate_mb - min_io_rate_mb) / 10);
+    background_jobs++;
+  } else {
+    last_decision_ = "hold";
+  }
+
+  apply(std::clamp(io_rate_mb, min_io_rate_mb, max_io_rate_mb),
+        std::clamp(background_jobs, min_background_jobs, max_background_jobs));
+}
+
+void CompactionRateController::apply(int64_t io_rate_mb, int background_jobs) {
+  if (io_rate_mb != io_rate_mb_) {
+    storage_->SetIORateLimit(io_rate_mb);
+    io_rate_mb_ = io_rate_mb;
+  }
+  if (background_jobs != background_jobs_) {
+    auto s = storage_->SetDBOption("max_background_jobs", std::to_string(background_jobs));
+    if (!s.IsOK()) {
+      LOG(WARNING) << "[compaction controller] Failed to set the background jobs: " << s.Msg();
+      return;
+    }
+    background_jobs_ = background_jobs;
+  }
+}
+
+std::string CompactionRateController::GetInfo() const {
+  std::lock_guard<std::mutex> guard(mu_);
+  std::string info;
+  info += "compaction_auto_tune:" + std::string(enabled_ ? "yes" : "no") + "\r\n";
+  if (enabled_) {
+    info += "compaction_auto_tune_io_rate_mb:" + std::to_string(io_rate_mb_) + "\r\n";
+    info += "compaction_auto_tune_background_jobs:" + std::to_string(background_jobs_) + "\r\n";
+    info += "compaction_auto_tune_p99_latency_us:" + std::to_string(p99_latency_us_) + "\r\n";
+    info += "compaction_auto_tune_pending_compaction_bytes:" + std::to_string(pending_compaction_bytes_) + "\r\n";
+    info += "compaction_auto_tune_last_decision:" + last_decision_ + "\r\n";
+  }
+  return info;
+}
@@ -0,0 +1,58 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#pragma once
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "config/config.h"
+#include "storage.h"
+
+// CompactionRateController auto-tunes the IO rate limit of flush and compaction, and the max
+// background jobs of rocksdb, by the p99 latency of commands and the pending compaction bytes.
+// It's an AIMD controller: the IO rate is multiplicatively reduced while the latency exceeds
+// the target unless the compaction falls behind, and additively increased while the latency is
+// well below the target or the compaction falls behind. The background jobs are adjusted by one.
+class CompactionRateController {
+ public:
+  explicit CompactionRateController(engine::Storage *storage, Config *config) : storage_(storage), config_(config) {}
+  ~CompactionRateController() = default;
+
+  // Adjust the IO rate limit and background jobs by the latency histogram since the last call
+  void Adjust(const std::vector<uint64_t> &latency_histogram);
+  std::string GetInfo() const;
+
+ private:
+  engine::Storage *storage_ = nullptr;
+  Config *config_ = nullptr;
+  std::vector<uint64_t> last_latency_histogram_;
+
+  mutable std::mutex mu_;
+  bool enabled_ = false;
+  int64_t io_rate_mb_ = 0;
+  int background_jobs_ = 0;
+  uint64_t p99_latency_us_ = 0;
+  uint64_t pending_compaction_bytes_ = 0;
+  std::string last_decision_ = "none";
+
+  void apply(int64_t io_rate_mb, int background_jobs);
+};
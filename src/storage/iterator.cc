@@ -23,8 +23,72 @@
 #include <cluster/redis_slot.h>
 
 #include "db_util.h"
+#include "time_util.h"
 
 namespace engine {
+
+AutoRefreshIterator::AutoRefreshIterator(rocksdb::Iterator *iter, const rocksdb::Snapshot *snapshot,
+                                         int64_t interval_ms)
+    : iter_(iter), snapshot_(snapshot), interval_ms_(interval_ms), last_refresh_ms_(util::GetTimeStampMS()) {
+  alive_num++;
+}
+
+AutoRefreshIterator::~AutoRefreshIterator() { alive_num--; }
+
+void AutoRefreshIterator::SeekToFirst() {
+  iter_->SeekToFirst();
+  steps_ = 0;
+}
+
+void AutoRefreshIterator::SeekToLast() {
+  iter_->SeekToLast();
+  steps_ = 0;
+}
+
+void AutoRefreshIterator::Seek(const Slice &target) {
+  iter_->Seek(target);
+  steps_ = 0;
+}
+
+void AutoRefreshIterator::SeekForPrev(const Slice &target) {
+  iter_->SeekForPrev(target);
+  steps_ = 0;
+}
+
+void AutoRefreshIterator::Next() {
+  iter_->Next();
+  maybeRefresh(true);
+}
+
+void AutoRefreshIterator::Prev() {
+  iter_->Prev();
+  maybeRefresh(false);
+}
+
+void AutoRefreshIterator::maybeRefresh(bool forward) {
+  if (interval_ms_ <= 0 || ++steps_ < kCheckSteps) return;
+  steps_ = 0;
+
+  if (!iter_->Valid()) return;
+  auto now = util::GetTimeStampMS();
+  if (now - last_refresh_ms_ < static_cast<uint64_t>(interval_ms_)) return;
+  last_refresh_ms_ = now;
+
+  std::string current_key = iter_->key().ToString();
+  auto s = iter_->Refresh(snapshot_);
+  if (s.ok()) {
+    refresh_num++;
+  } else {
+    // e.g. the iterator was created with a read callback, so don't try it again
+    interval_ms_ = 0;
+  }
+  // the position of the iterator is undefined after refreshing
+  if (forward) {
+    iter_->Seek(current_key);
+  } else {
+    iter_->SeekForPrev(current_key);
+  }
+}
 DBIterator::DBIterator(Storage *storage, rocksdb::ReadOptions read_options, int slot)
     : storage_(storage),
       read_options_(std::move(read_options)),
@@ -93,7 +157,7 @@ void DBIterator::Seek(const std::string &target) {
   std::string prefix = target;
   if (slot_ != -1) {
     // Use the slot id as the prefix if it's specified
-    prefix = ComposeSlotKeyPrefix(kDefaultNamespace, slot_) + target;
+    prefix = ComposeSlotKeyPrefix(storage_->EncodeNamespace(kDefaultNamespace), slot_) + target;
   }
 
   metadata_iter_->Seek(prefix);
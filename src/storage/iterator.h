@@ -22,10 +22,60 @@
 #include <rocksdb/iterator.h>
 #include <rocksdb/options.h>
 
+#include <atomic>
+
 #include "storage.h"
 
 namespace engine {
 
+// AutoRefreshIterator refreshes the wrapped iterator to the latest super version periodically and seeks
+// back to the current key, so a long-running scan won't pin the memtables and the SST files which were
+// flushed or compacted away since it started. The iterator still reads from the given snapshot after
+// refreshing, or from the latest data if the snapshot is nullptr.
+class AutoRefreshIterator : public rocksdb::Iterator {
+ public:
+  // check the elapsed time only every kCheckSteps moves to keep it cheap
+  static constexpr uint64_t kCheckSteps = 256;
+
+  explicit AutoRefreshIterator(rocksdb::Iterator *iter, const rocksdb::Snapshot *snapshot, int64_t interval_ms);
+  ~AutoRefreshIterator() override;
+
+  bool Valid() const override { return iter_->Valid(); }
+  void SeekToFirst() override;
+  void SeekToLast() override;
+  void Seek(const Slice &target) override;
+  void SeekForPrev(const Slice &target) override;
+  void Next() override;
+  void Prev() override;
+  Slice key() const override { return iter_->key(); }
+  Slice value() const override { return iter_->value(); }
+  rocksdb::Status status() const override { return iter_->status(); }
+  using rocksdb::Iterator::Refresh;
+  rocksdb::Status Refresh(const rocksdb::Snapshot *snapshot) override {
+    snapshot_ = snapshot;
+    return iter_->Refresh(snapshot);
+  }
+  rocksdb::Status GetProperty(std::string prop_name, std::string *prop) override {
+    return iter_->GetProperty(std::move(prop_name), prop);
+  }
+
+  // the number of the alive auto-refresh iterators and the total times they were refreshed
+  static int64_t GetAliveNum() { return alive_num; }
+  static uint64_t GetRefreshNum() { return refresh_num; }
+
+ private:
+  void maybeRefresh(bool forward);
+
+  std::unique_ptr<rocksdb::Iterator> iter_;
+  const rocksdb::Snapshot *snapshot_;
+  int64_t interval_ms_;
+  uint64_t last_refresh_ms_;
+  uint64_t steps_ = 0;
+
+  static inline std::atomic<int64_t> alive_num = 0;
+  static inline std::atomic<uint64_t> refresh_num = 0;
+};
+
 class SubKeyIterator {
  public:
   explicit SubKeyIterator(Storage *storage, rocksdb::ReadOptions read_options, RedisType type, std::string prefix);
@@ -20,8 +20,11 @@
 
 #include "redis_db.h"
 
+#include <algorithm>
 #include <ctime>
 #include <map>
+#include <random>
+#include <unordered_set>
 #include <utility>
 
 #include "cluster/redis_slot.h"
@@ -46,7 +49,8 @@ namespace redis {
 Database::Database(engine::Storage *storage, std::string ns)
     : storage_(storage),
       metadata_cf_handle_(storage->GetCFHandle(ColumnFamilyID::Metadata)),
-      namespace_(std::move(ns)) {}
+      namespace_(storage->EncodeNamespace(ns)),
+      write_options_(&storage->NamespaceWriteOptions(ns)) {}
 
 // Some data types may support reading multiple types of metadata.
 // For example, bitmap supports reading string metadata and bitmap metadata.
@@ -140,7 +144,7 @@ rocksdb::Status Database::Expire(const Slice &user_key, uint64_t timestamp) {
   WriteBatchLogData log_data(kRedisNone, {std::to_string(kRedisCmdExpire)});
   batch->PutLogData(log_data.Encode());
   batch->Put(metadata_cf_handle_, ns_key, value);
-  s = storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  s = storage_->Write(writeOptions(), batch->GetWriteBatch());
   return s;
 }
 
@@ -157,7 +161,7 @@ rocksdb::Status Database::Del(const Slice &user_key) {
   if (metadata.Expired()) {
     return rocksdb::Status::NotFound(kErrMsgKeyExpired);
   }
-  return storage_->Delete(storage_->DefaultWriteOptions(), metadata_cf_handle_, ns_key);
+  return storage_->Delete(writeOptions(), metadata_cf_handle_, ns_key);
 }
 
 rocksdb::Status Database::MDel(const std::vector<Slice> &keys, uint64_t *deleted_cnt) {
@@ -206,7 +210,7 @@ rocksdb::Status Database::MDel(const std::vector<Slice> &keys, uint64_t *deleted
 
   if (*deleted_cnt == 0) return rocksdb::Status::OK();
 
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Database::Exists(const std::vector<Slice> &keys, int *ret) {
@@ -254,7 +258,7 @@ rocksdb::Status Database::GetKeyNumStats(const std::string &prefix, KeyNumStats
 rocksdb::Status Database::Keys(const std::string &prefix, std::vector<std::string> *keys, KeyNumStats *stats) {
   uint16_t slot_id = 0;
   std::string ns_prefix;
-  if (namespace_ != kDefaultNamespace || keys != nullptr) {
+  if (namespace_ != storage_->EncodeNamespace(kDefaultNamespace) || keys != nullptr) {
     if (storage_->IsSlotIdEncoded()) {
       ns_prefix = ComposeNamespaceKey(namespace_, "", false);
       if (!prefix.empty()) {
@@ -432,33 +436,23 @@ rocksdb::Status Database::RandomKey(const std::string &cursor, std::string *key)
   return rocksdb::Status::OK();
 }
 
+void Database::GetNamespaceKeyRange(std::string *begin, std::string *end) const {
+  *begin = ComposeNamespaceKey(namespace_, "", false);
+  // it's ok to increase the last char in prefix as the boundary of the prefix
+  // while we limit the namespace last char shouldn't be larger than 128.
+  *end = *begin;
+  end->back()++;
+}
+
 rocksdb::Status Database::FlushDB() {
+  // Subkeys are deleted along with the metadata instead of being left to the compaction filter,
+  // so that the space could be reclaimed by compacting the range right after the flush.
   std::string begin_key, end_key;
-  std::string prefix = ComposeNamespaceKey(namespace_, "", false);
-  auto s = FindKeyRangeWithPrefix(prefix, std::string(), &begin_key, &end_key);
-  if (!s.ok()) {
-    return rocksdb::Status::OK();
-  }
-  return storage_->DeleteRange(begin_key, end_key);
+  GetNamespaceKeyRange(&begin_key, &end_key);
+  return storage_->DeleteRangeOfDataCFs(begin_key, end_key);
 }
 
-rocksdb::Status Database::FlushAll() {
-  LatestSnapShot ss(storage_);
-  rocksdb::ReadOptions read_options = storage_->DefaultScanOptions();
-  read_options.snapshot = ss.GetSnapShot();
-  auto iter = util::UniqueIterator(storage_, read_options, metadata_cf_handle_);
-  iter->SeekToFirst();
-  if (!iter->Valid()) {
-    return rocksdb::Status::OK();
-  }
-  auto first_key = iter->key().ToString();
-  iter->SeekToLast();
-  if (!iter->Valid()) {
-    return rocksdb::Status::OK();
-  }
-  auto last_key = iter->key().ToString();
-  return storage_->DeleteRange(first_key, last_key);
-}
+rocksdb::Status Database::FlushAll() { return storage_->DeleteRangeOfDataCFs("", ""); }
 
 rocksdb::Status Database::Dump(const Slice &user_key, std::vector<std::string> *infos) {
   infos->clear();
@@ -477,7 +471,7 @@ rocksdb::Status Database::Dump(const Slice &user_key, std::vector<std::string> *
   if (!s.ok()) return s;
 
   infos->emplace_back("namespace");
-  infos->emplace_back(namespace_);
+  infos->emplace_back(storage_->DecodeNamespace(namespace_));
   infos->emplace_back("type");
   infos->emplace_back(RedisTypeNames[metadata.Type()]);
   infos->emplace_back("version");
@@ -523,6 +517,10 @@ std::string Database::AppendNamespacePrefix(const Slice &user_key) {
   return ComposeNamespaceKey(namespace_, user_key, storage_->IsSlotIdEncoded());
 }
 
+void Database::AppendNamespacePrefix(const Slice &user_key, std::string *ns_key) {
+  ComposeNamespaceKey(namespace_, user_key, storage_->IsSlotIdEncoded(), ns_key);
+}
+
 rocksdb::Status Database::FindKeyRangeWithPrefix(const std::string &prefix, const std::string &prefix_end,
                                                  std::string *begin, std::string *end,
                                                  rocksdb::ColumnFamilyHandle *cf_handle) {
@@ -576,8 +574,9 @@ rocksdb::Status Database::ClearKeysOfSlot(const rocksdb::Slice &ns, int slot) {
     return rocksdb::Status::Aborted("It is not in cluster mode");
   }
 
-  std::string prefix = ComposeSlotKeyPrefix(ns, slot);
-  std::string prefix_end = ComposeSlotKeyPrefix(ns, slot + 1);
+  std::string encoded_ns = storage_->EncodeNamespace(ns.ToString());
+  std::string prefix = ComposeSlotKeyPrefix(encoded_ns, slot);
+  std::string prefix_end = ComposeSlotKeyPrefix(encoded_ns, slot + 1);
   auto s = storage_->DeleteRange(prefix, prefix_end);
   if (!s.ok()) {
     return s;
@@ -641,6 +640,83 @@ rocksdb::Status SubKeyScanner::Scan(RedisType type, const Slice &user_key, const
   return rocksdb::Status::OK();
 }
 
+rocksdb::Status SubKeyScanner::Sample(const Slice &ns_key, const Metadata &metadata, uint64_t count, bool unique,
+                                      const std::function<bool(const Slice &)> &filter,
+                                      std::vector<std::pair<std::string, std::string>> *samples) {
+  constexpr int kProbeTailBytes = 8;
+
+  samples->clear();
+  if (count == 0) return rocksdb::Status::OK();
+
+  std::string prefix = InternalKey(ns_key, "", metadata.version, storage_->IsSlotIdEncoded()).Encode();
+  std::string next_version_prefix =
+      InternalKey(ns_key, "", metadata.version + 1, storage_->IsSlotIdEncoded()).Encode();
+
+  LatestSnapShot ss(storage_);
+  rocksdb::ReadOptions read_options = storage_->DefaultScanOptions();
+  read_options.snapshot = ss.GetSnapShot();
+  rocksdb::Slice lower_bound(prefix);
+  rocksdb::Slice upper_bound(next_version_prefix);
+  read_options.iterate_lower_bound = &lower_bound;
+  read_options.iterate_upper_bound = &upper_bound;
+  auto iter = util::UniqueIterator(storage_, read_options);
+
+  iter->SeekToFirst();
+  if (!iter->Valid()) return iter->status();
+  std::string first = InternalKey(iter->key(), storage_->IsSlotIdEncoded()).GetSubKey().ToString();
+  iter->SeekToLast();
+  if (!iter->Valid()) return iter->status();
+  std::string last = InternalKey(iter->key(), storage_->IsSlotIdEncoded()).GetSubKey().ToString();
+
+  // Probes share the common prefix of the first and last sub key, the byte right after it is picked
+  // between theirs and the remaining bytes are drawn from the whole byte range, so the probes are
+  // uniform over the key space between the first and last sub key.
+  size_t common = 0;
+  while (common < first.size() && common < last.size() && first[common] == last[common]) common++;
+  int first_lo = common < first.size() ? static_cast<uint8_t>(first[common]) : 0;
+  int first_hi = common < last.size() ? static_cast<uint8_t>(last[common]) : 0;
+
+  std::mt19937_64 gen(std::random_device{}());
+  std::uniform_int_distribution<int> first_byte_dist(std::min(first_lo, first_hi), first_hi);
+  std::uniform_int_distribution<int> tail_byte_dist(0, UINT8_MAX);
+  std::uniform_int_distribution<uint64_t> first_key_dist(0, metadata.size > 0 ? metadata.size - 1 : 0);
+
+  std::unordered_set<std::string> seen;
+  uint64_t max_probes = count * 4 + 64;
+  std::string probe;
+  for (uint64_t i = 0; i < max_probes && samples->size() < count; i++) {
+    // no probe lands on the first sub key since they're all after it, so it's picked with the average chance
+    if (first_key_dist(gen) == 0) {
+      iter->SeekToFirst();
+    } else {
+      probe = prefix;
+      probe.append(first, 0, common);
+      probe.push_back(static_cast<char>(first_byte_dist(gen)));
+      for (int j = 0; j < kProbeTailBytes; j++) {
+        probe.push_back(static_cast<char>(tail_byte_dist(gen)));
+      }
+      iter->Seek(probe);
+    }
+    if (!iter->Valid()) {
+      if (!iter->status().ok()) return iter->status();
+      // the probe is beyond the last sub key, it's retried instead of wrapping around to the first sub key,
+      // which would give the first sub key the chances of those probes as well
+      continue;
+    }
+
+    if (filter && !filter(iter->value())) continue;
+
+    InternalKey ikey(iter->key(), storage_->IsSlotIdEncoded());
+    std::string sub_key = ikey.GetSubKey().ToString();
+    if (unique && !seen.emplace(sub_key).second) continue;
+    samples->emplace_back(std::move(sub_key), iter->value().ToString());
+  }
+  if (samples->size() < count) {
+    return rocksdb::Status::Incomplete("not enough sub keys were sampled");
+  }
+  return rocksdb::Status::OK();
+}
+
 RedisType WriteBatchLogData::GetRedisType() const { return type_; }
 
 std::vector<std::string> *WriteBatchLogData::GetArguments() { return &args_; }
@@ -666,6 +742,56 @@ Status WriteBatchLogData::Decode(const rocksdb::Slice &blob) {
   return Status::OK();
 }
 
+rocksdb::Status Database::getSubKeyValues(const Slice &ns_key, uint64_t version, std::vector<std::string_view> sub_keys,
+                                          std::unordered_map<std::string_view, std::string> *values) {
+  values->clear();
+  InternalKeyEncoder sub_key_encoder(ns_key, version, storage_->IsSlotIdEncoded());
+
+  if (sub_keys.size() <= kSubKeyMergeWalkThreshold) {
+    std::string value;
+    for (const auto &sub_key : sub_keys) {
+      auto s = storage_->Get(rocksdb::ReadOptions(), sub_key_encoder.Encode(sub_key), &value);
+      if (!s.ok() && !s.IsNotFound()) return s;
+      if (s.ok()) (*values)[sub_key] = std::move(value);
+    }
+    return rocksdb::Status::OK();
+  }
+
+  // the order of the sub keys is the same as the order of their internal keys, since they share the same prefix
+  std::sort(sub_keys.begin(), sub_keys.end());
+  sub_keys.erase(std::unique(sub_keys.begin(), sub_keys.end()), sub_keys.end());
+
+  std::string next_version_prefix = InternalKey(ns_key, "", version + 1, storage_->IsSlotIdEncoded()).Encode();
+  rocksdb::ReadOptions read_options = storage_->DefaultScanOptions();
+  rocksdb::Slice upper_bound(next_version_prefix);
+  read_options.iterate_upper_bound = &upper_bound;
+  auto iter = util::UniqueIterator(storage_, read_options);
+
+  // the next sub key is usually close to the current one in a dense range, so step forward
+  // a few times before seeking, which is much cheaper than a seek
+  constexpr int max_steps_before_seek = 8;
+  bool positioned = false;
+  for (const auto &sub_key : sub_keys) {
+    Slice target = sub_key_encoder.Encode(sub_key);
+    if (positioned) {
+      for (int i = 0; i < max_steps_before_seek && iter->Valid() && iter->key().compare(target) < 0; i++) {
+        iter->Next();
+      }
+    }
+    if (!positioned || (iter->Valid() && iter->key().compare(target) < 0)) {
+      iter->Seek(target);
+      positioned = true;
+    }
+    // the rest of the sub keys are all beyond the last sub key of the version
+    if (!iter->Valid()) break;
+
+    if (iter->key() == target) {
+      (*values)[sub_key] = iter->value().ToString();
+    }
+  }
+  return iter->status();
+}
+
 rocksdb::Status Database::existsInternal(const std::vector<std::string> &keys, int *ret) {
   *ret = 0;
   LatestSnapShot ss(storage_);
@@ -733,13 +859,19 @@ rocksdb::Status Database::Copy(const std::string &key, const std::string &new_ke
 
   if (key == new_key) return rocksdb::Status::OK();
 
+  engine::DBIterator iter(storage_, rocksdb::ReadOptions());
+  iter.Seek(key);
+
   auto batch = storage_->GetWriteBatchBase();
   WriteBatchLogData log_data(type);
+  if (type == kRedisHash) {
+    HashMetadata hash_metadata(false);
+    if (hash_metadata.Decode(iter.Value()).ok() && hash_metadata.IsFieldExpirationEnabled()) {
+      log_data = WriteBatchLogData(type, {std::to_string(kRedisCmdHExpire)});
+    }
+  }
   batch->PutLogData(log_data.Encode());
 
-  engine::DBIterator iter(storage_, rocksdb::ReadOptions());
-  iter.Seek(key);
-
   if (delete_old) {
     batch->Delete(metadata_cf_handle_, key);
   }
@@ -771,7 +903,7 @@ rocksdb::Status Database::Copy(const std::string &key, const std::string &new_ke
     }
   }
 
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 std::optional<std::string> Database::lookupKeyByPattern(const std::string &pattern, const std::string &subst) {
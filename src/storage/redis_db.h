@@ -20,9 +20,12 @@
 
 #pragma once
 
+#include <functional>
 #include <map>
 #include <optional>
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <utility>
 #include <variant>
 #include <vector>
@@ -126,6 +129,8 @@ class Database {
   [[nodiscard]] rocksdb::Status Dump(const Slice &user_key, std::vector<std::string> *infos);
   [[nodiscard]] rocksdb::Status FlushDB();
   [[nodiscard]] rocksdb::Status FlushAll();
+  // Get the key range [begin, end) of the namespace, which is shared by all column families of the user data
+  void GetNamespaceKeyRange(std::string *begin, std::string *end) const;
   [[nodiscard]] rocksdb::Status GetKeyNumStats(const std::string &prefix, KeyNumStats *stats);
   [[nodiscard]] rocksdb::Status Keys(const std::string &prefix, std::vector<std::string> *keys = nullptr,
                                      KeyNumStats *stats = nullptr);
@@ -134,6 +139,7 @@ class Database {
                                      RedisType type = kRedisNone);
   [[nodiscard]] rocksdb::Status RandomKey(const std::string &cursor, std::string *key);
   std::string AppendNamespacePrefix(const Slice &user_key);
+  void AppendNamespacePrefix(const Slice &user_key, std::string *ns_key);
   [[nodiscard]] rocksdb::Status FindKeyRangeWithPrefix(const std::string &prefix, const std::string &prefix_end,
                                                        std::string *begin, std::string *end,
                                                        rocksdb::ColumnFamilyHandle *cf_handle = nullptr);
@@ -157,9 +163,25 @@ class Database {
                                      std::vector<std::optional<std::string>> *elems, SortResult *res);
 
  protected:
+  // Inputs with more sub keys than this are merge-walked by one iterator instead of point lookups
+  static constexpr size_t kSubKeyMergeWalkThreshold = 256;
+
+  /// getSubKeyValues reads the raw values of the sub keys of a key in the version,
+  /// and the sub keys which don't exist are absent from `values`.
+  ///
+  /// A few sub keys are read by point lookups. Many sub keys are sorted and merge-walked against
+  /// the sub key range by one iterator, which turns the random reads into a sequential scan.
+  [[nodiscard]] rocksdb::Status getSubKeyValues(const Slice &ns_key, uint64_t version,
+                                                std::vector<std::string_view> sub_keys,
+                                                std::unordered_map<std::string_view, std::string> *values);
+
+  // The write options of the namespace, which don't write the WAL if it's in wal-disabled-namespaces
+  const rocksdb::WriteOptions &writeOptions() const { return *write_options_; }
+
   engine::Storage *storage_;
   rocksdb::ColumnFamilyHandle *metadata_cf_handle_;
   std::string namespace_;
+  const rocksdb::WriteOptions *write_options_;
 
   friend class LatestSnapShot;
 
@@ -203,6 +225,21 @@ class SubKeyScanner : public redis::Database {
   rocksdb::Status Scan(RedisType type, const Slice &user_key, const std::string &cursor, uint64_t limit,
                        const std::string &subkey_prefix, std::vector<std::string> *keys,
                        std::vector<std::string> *values = nullptr);
+
+  /// Sample picks `count` sub keys (with their raw values) of the structure by seeking to random probes
+  /// between its first and last sub key, so it costs O(count * log N) instead of reading every sub key.
+  ///
+  /// The picks are NOT uniform: the probes are uniform over the key space, so a sub key is picked with
+  /// the chance proportional to the key space gap between it and the previous sub key. The first sub key
+  /// has no gap before it and is picked with the average chance 1/N instead, so every sub key can be
+  /// picked. SPOP, SRANDMEMBER, HRANDFIELD and ZRANDMEMBER all pick large structures by this distribution.
+  ///
+  /// \param filter if set, sub keys whose raw value it rejects (e.g. expired hash fields) are skipped.
+  /// \return Incomplete if not enough (distinct, when `unique` is set) sub keys were hit within the probe
+  /// budget, the caller is expected to fall back to a full scan then.
+  rocksdb::Status Sample(const Slice &ns_key, const Metadata &metadata, uint64_t count, bool unique,
+                         const std::function<bool(const Slice &)> &filter,
+                         std::vector<std::pair<std::string, std::string>> *samples);
 };
 
 class WriteBatchLogData {
@@ -39,7 +39,8 @@ static std::atomic<uint64_t> version_counter_ = 0;
 
 constexpr const char *kErrMetadataTooShort = "metadata is too short";
 
-InternalKey::InternalKey(Slice input, bool slot_id_encoded) : slot_id_encoded_(slot_id_encoded) {
+InternalKey::InternalKey(Slice input, bool slot_id_encoded, uint8_t encoding_version)
+    : slot_id_encoded_(slot_id_encoded), encoding_version_(encoding_version) {
   uint32_t key_size = 0;
   uint8_t namespace_size = 0;
   GetFixed8(&input, &namespace_size);
@@ -48,15 +49,20 @@ InternalKey::InternalKey(Slice input, bool slot_id_encoded) : slot_id_encoded_(s
   if (slot_id_encoded_) {
     GetFixed16(&input, &slotid_);
   }
-  GetFixed32(&input, &key_size);
+  if (encoding_version_ == 0) {
+    GetFixed32(&input, &key_size);
+  } else {
+    GetVarint32(&input, &key_size);
+  }
   key_ = Slice(input.data(), key_size);
   input.remove_prefix(key_size);
   GetFixed64(&input, &version_);
   sub_key_ = Slice(input.data(), input.size());
 }
 
-InternalKey::InternalKey(Slice ns_key, Slice sub_key, uint64_t version, bool slot_id_encoded)
-    : sub_key_(sub_key), version_(version), slot_id_encoded_(slot_id_encoded) {
+InternalKey::InternalKey(Slice ns_key, Slice sub_key, uint64_t version, bool slot_id_encoded,
+                         uint8_t encoding_version)
+    : sub_key_(sub_key), version_(version), slot_id_encoded_(slot_id_encoded), encoding_version_(encoding_version) {
   uint8_t namespace_size = 0;
   GetFixed8(&ns_key, &namespace_size);
   namespace_ = Slice(ns_key.data(), namespace_size);
@@ -75,24 +81,72 @@ Slice InternalKey::GetSubKey() const { return sub_key_; }
 
 uint64_t InternalKey::GetVersion() const { return version_; }
 
-std::string InternalKey::Encode() const {
-  std::string out;
-  size_t total = 1 + namespace_.size() + 4 + key_.size() + 8 + sub_key_.size();
+size_t InternalKey::EncodedSize() const {
+  size_t key_size_length = 4;
+  if (encoding_version_ != 0) {
+    key_size_length = 1;
+    for (auto v = static_cast<uint32_t>(key_.size()); v >= 0x80; v >>= 7) key_size_length++;
+  }
+  size_t total = 1 + namespace_.size() + key_size_length + key_.size() + 8 + sub_key_.size();
   if (slot_id_encoded_) {
     total += 2;
   }
-  out.resize(total);
-  auto buf = out.data();
+  return total;
+}
+
+std::string InternalKey::Encode() const {
+  std::string out;
+  EncodeTo(&out);
+  return out;
+}
+
+void InternalKey::EncodeTo(std::string *out) const {
+  out->resize(EncodedSize());
+  auto buf = out->data();
   buf = EncodeFixed8(buf, static_cast<uint8_t>(namespace_.size()));
   buf = EncodeBuffer(buf, namespace_);
   if (slot_id_encoded_) {
     buf = EncodeFixed16(buf, slotid_);
   }
-  buf = EncodeFixed32(buf, static_cast<uint32_t>(key_.size()));
+  if (encoding_version_ == 0) {
+    buf = EncodeFixed32(buf, static_cast<uint32_t>(key_.size()));
+  } else {
+    buf = EncodeVarint32(buf, static_cast<uint32_t>(key_.size()));
+  }
   buf = EncodeBuffer(buf, key_);
   buf = EncodeFixed64(buf, version_);
   EncodeBuffer(buf, sub_key_);
-  return out;
+}
+
+InternalKeyEncoder::InternalKeyEncoder(Slice ns_key, uint64_t version, bool slot_id_encoded) {
+  InternalKey(ns_key, "", version, slot_id_encoded).EncodeTo(&buf_);
+  prefix_size_ = buf_.size();
+}
+
+Slice InternalKeyEncoder::Encode(Slice sub_key) {
+  buf_.resize(prefix_size_);
+  buf_.append(sub_key.data(), sub_key.size());
+  return buf_;
+}
+
+Slice InternalKeyEncoder::Prefix() { return Encode(""); }
+
+void InternalKeyEncoder::EncodeAll(const std::vector<Slice> &sub_keys, std::string *arena,
+                                   std::vector<Slice> *keys) const {
+  size_t total = prefix_size_ * sub_keys.size();
+  for (const auto &sub_key : sub_keys) total += sub_key.size();
+
+  // reserve first so that the slices won't be invalidated by reallocation
+  arena->clear();
+  arena->reserve(total);
+  keys->clear();
+  keys->reserve(sub_keys.size());
+  for (const auto &sub_key : sub_keys) {
+    size_t offset = arena->size();
+    arena->append(buf_.data(), prefix_size_);
+    arena->append(sub_key.data(), sub_key.size());
+    keys->emplace_back(arena->data() + offset, arena->size() - offset);
+  }
 }
 
 bool InternalKey::operator==(const InternalKey &that) const {
@@ -133,18 +187,22 @@ template std::tuple<std::string, std::string> ExtractNamespaceKey<std::string>(S
 
 std::string ComposeNamespaceKey(const Slice &ns, const Slice &key, bool slot_id_encoded) {
   std::string ns_key;
+  ComposeNamespaceKey(ns, key, slot_id_encoded, &ns_key);
+  return ns_key;
+}
 
-  PutFixed8(&ns_key, static_cast<uint8_t>(ns.size()));
-  ns_key.append(ns.data(), ns.size());
+void ComposeNamespaceKey(const Slice &ns, const Slice &key, bool slot_id_encoded, std::string *ns_key) {
+  ns_key->clear();
+
+  PutFixed8(ns_key, static_cast<uint8_t>(ns.size()));
+  ns_key->append(ns.data(), ns.size());
 
   if (slot_id_encoded) {
     auto slot_id = GetSlotIdFromKey(key.ToStringView());
-    PutFixed16(&ns_key, slot_id);
+    PutFixed16(ns_key, slot_id);
   }
 
-  ns_key.append(key.data(), key.size());
-
-  return ns_key;
+  ns_key->append(key.data(), key.size());
 }
 
 std::string ComposeSlotKeyPrefix(const Slice &ns, int slotid) {
@@ -333,6 +391,46 @@ bool Metadata::IsEmptyableType() const {
 
 bool Metadata::Expired() const { return ExpireAt(util::GetTimeStampMS()); }
 
+void HashMetadata::Encode(std::string *dst) const {
+  Metadata::Encode(dst);
+
+  // keep the encoding of hashes without field TTL unchanged
+  if (field_encoding != HashSubkeyEncoding::VALUE_ONLY) {
+    PutFixed8(dst, uint8_t(field_encoding));
+  }
+}
+
+rocksdb::Status HashMetadata::Decode(Slice *input) {
+  if (auto s = Metadata::Decode(input); !s.ok()) {
+    return s;
+  }
+
+  field_encoding = HashSubkeyEncoding::VALUE_ONLY;
+  if (input->size() >= 1) {
+    GetFixed8(input, reinterpret_cast<uint8_t *>(&field_encoding));
+  }
+
+  return rocksdb::Status::OK();
+}
+
+void HashMetadata::EncodeFieldValue(const Slice &value, uint64_t expire, std::string *dst) const {
+  dst->clear();
+  if (IsFieldExpirationEnabled()) {
+    dst->reserve(8 + value.size());
+    PutFixed64(dst, expire);
+  }
+  dst->append(value.data(), value.size());
+}
+
+bool HashMetadata::DecodeFieldValue(Slice raw, Slice *value, uint64_t *expire) const {
+  *expire = 0;
+  if (IsFieldExpirationEnabled() && !GetFixed64(&raw, expire)) {
+    return false;
+  }
+  *value = raw;
+  return true;
+}
+
 ListMetadata::ListMetadata(bool generate_version)
     : Metadata(kRedisList, generate_version), head(UINT64_MAX / 2), tail(head) {}
 
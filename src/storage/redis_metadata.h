@@ -33,6 +33,12 @@
 
 constexpr bool USE_64BIT_COMMON_FIELD_DEFAULT = METADATA_ENCODING_VERSION != 0;
 
+// The encoding of sub keys (see InternalKey), the data written by one version can't be read by another,
+// so it's recorded in the storage and converted on startup if required (see Storage::Open).
+//   0: [ns size(1)][ns][slot id(2)?][key size(fixed32)][key][version(8)][sub key]
+//   1: [ns size(1)][ns][slot id(2)?][key size(varint32)][key][version(8)][sub key]
+constexpr uint8_t SUBKEY_ENCODING_VERSION_DEFAULT = SUBKEY_ENCODING_VERSION;
+
 // We write enum integer value of every datatype
 // explicitly since it cannot be changed once confirmed
 // Note that if you want to add a new redis type in `RedisType`
@@ -66,6 +72,7 @@ struct RedisTypes {
   }
 
   bool Contains(RedisType type) const { return types_[type]; }
+  void Add(RedisType type) { types_.set(type); }
 
  private:
   using UnderlyingType = std::bitset<128>;
@@ -89,6 +96,7 @@ enum RedisCommand {
   kRedisCmdBitOp,
   kRedisCmdBitfield,
   kRedisCmdLMove,
+  kRedisCmdHExpire,
 };
 
 const std::vector<std::string> RedisTypeNames = {"none",   "string",    "hash",   "list",      "set",      "zset",
@@ -110,12 +118,20 @@ struct KeyNumStats {
 template <typename T = Slice>
 [[nodiscard]] std::tuple<T, T> ExtractNamespaceKey(Slice ns_key, bool slot_id_encoded);
 [[nodiscard]] std::string ComposeNamespaceKey(const Slice &ns, const Slice &key, bool slot_id_encoded);
+// Same as above, but reuses the buffer of `ns_key` so that composing keys in a loop doesn't allocate each time
+void ComposeNamespaceKey(const Slice &ns, const Slice &key, bool slot_id_encoded, std::string *ns_key);
 [[nodiscard]] std::string ComposeSlotKeyPrefix(const Slice &ns, int slotid);
 
+// The namespace in keys is replaced by this tag followed by a varint id when the namespace
+// id encoding is enabled, see `engine::Storage::EncodeNamespace`
+constexpr char kNamespaceIDTag = '\xff';
+inline bool IsNamespaceID(const Slice &ns) { return !ns.empty() && ns[0] == kNamespaceIDTag; }
+
 class InternalKey {
  public:
-  explicit InternalKey(Slice ns_key, Slice sub_key, uint64_t version, bool slot_id_encoded);
-  explicit InternalKey(Slice input, bool slot_id_encoded);
+  explicit InternalKey(Slice ns_key, Slice sub_key, uint64_t version, bool slot_id_encoded,
+                       uint8_t encoding_version = SUBKEY_ENCODING_VERSION_DEFAULT);
+  explicit InternalKey(Slice input, bool slot_id_encoded, uint8_t encoding_version = SUBKEY_ENCODING_VERSION_DEFAULT);
   ~InternalKey() = default;
 
   Slice GetNamespace() const;
@@ -123,6 +139,9 @@ class InternalKey {
   Slice GetSubKey() const;
   uint64_t GetVersion() const;
   [[nodiscard]] std::string Encode() const;
+  // Encode into `out` and reuse its buffer, the previous content of `out` is discarded
+  void EncodeTo(std::string *out) const;
+  size_t EncodedSize() const;
   bool operator==(const InternalKey &that) const;
 
  private:
@@ -132,6 +151,28 @@ class InternalKey {
   uint64_t version_;
   uint16_t slotid_;
   bool slot_id_encoded_;
+  uint8_t encoding_version_;
+};
+
+/// InternalKeyEncoder encodes the internal keys of the same ns_key and version into one reused buffer.
+/// The common prefix is encoded once and each sub key is appended to it, so encoding the sub keys of
+/// a multi-member command doesn't allocate once the buffer has grown large enough.
+///
+/// The slice returned by `Encode` is only valid until the next call of `Encode`.
+class InternalKeyEncoder {
+ public:
+  explicit InternalKeyEncoder(Slice ns_key, uint64_t version, bool slot_id_encoded);
+
+  Slice Encode(Slice sub_key);
+  // The encoded key with an empty sub key, i.e. the prefix of all the sub keys
+  Slice Prefix();
+  // Encode all the sub keys into one contiguous `arena`, e.g. for MultiGet. The slices in `keys`
+  // point into `arena` and are valid as long as it isn't modified.
+  void EncodeAll(const std::vector<Slice> &sub_keys, std::string *arena, std::vector<Slice> *keys) const;
+
+ private:
+  std::string buf_;
+  size_t prefix_size_;
 };
 
 constexpr uint8_t METADATA_64BIT_ENCODING_MASK = 0x80;
@@ -201,9 +242,26 @@ class Metadata {
   static uint64_t generateVersion();
 };
 
+enum class HashSubkeyEncoding : uint8_t {
+  VALUE_ONLY = 0,
+  VALUE_WITH_TTL = 1,
+};
+
 class HashMetadata : public Metadata {
  public:
+  // once any field of the hash gets a TTL, the values of all its subkeys
+  // are prefixed with an 8-byte expire timestamp in milliseconds (0 means no TTL)
+  HashSubkeyEncoding field_encoding = HashSubkeyEncoding::VALUE_ONLY;
+
   explicit HashMetadata(bool generate_version = true) : Metadata(kRedisHash, generate_version) {}
+
+  void Encode(std::string *dst) const override;
+  using Metadata::Decode;
+  rocksdb::Status Decode(Slice *input) override;
+
+  bool IsFieldExpirationEnabled() const { return field_encoding == HashSubkeyEncoding::VALUE_WITH_TTL; }
+  void EncodeFieldValue(const Slice &value, uint64_t expire, std::string *dst) const;
+  [[nodiscard]] bool DecodeFieldValue(Slice raw, Slice *value, uint64_t *expire) const;
 };
 
 class SetMetadata : public Metadata {
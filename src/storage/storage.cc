@@ -28,10 +28,12 @@
 #include <rocksdb/filter_policy.h>
 #include <rocksdb/rate_limiter.h>
 #include <rocksdb/sst_file_manager.h>
+#include <rocksdb/utilities/cache_dump_load.h>
 #include <rocksdb/utilities/checkpoint.h>
 #include <rocksdb/utilities/table_properties_collectors.h>
 
 #include <algorithm>
+#include <array>
 #include <iostream>
 #include <memory>
 #include <random>
@@ -40,18 +42,64 @@
 #include "db_util.h"
 #include "event_listener.h"
 #include "event_util.h"
+#include "iterator.h"
 #include "redis_db.h"
 #include "redis_metadata.h"
 #include "rocksdb/cache.h"
 #include "rocksdb_crc32c.h"
 #include "server/server.h"
 #include "table_properties_collector.h"
+#include "thread_util.h"
 #include "time_util.h"
 #include "unique_fd.h"
 
 namespace engine {
 
 constexpr const char *kReplicationIdKey = "replication_id_";
+constexpr const char *kSubkeyEncodingVersionKey = "subkey_encoding_version_";
+constexpr const char *kSubkeyEncodingConvertingKey = "subkey_encoding_converting_";
+// The converted sub keys are staged in this column family, it only exists while converting
+constexpr const char *kSubkeyConvertColumnFamilyName = "subkey_convert";
+constexpr const char *kNamespaceIDEncodingKey = "namespace_id_encoding_";
+// The default namespace always takes the first id, so it's never assigned at runtime
+constexpr uint32_t kDefaultNamespaceID = 1;
+
+// The progress of the sub key encoding conversion, it's written along with each converted batch
+// so that an interrupted conversion is resumed from where it stopped on the next start.
+struct SubkeyConvertProgress {
+  enum Phase : uint8_t {
+    // copying the sub keys of a column family into the staging column family in the new layout
+    kCopying = 0,
+    // replacing the sub keys of a column family with the staged ones
+    kReplacing = 1,
+  };
+
+  uint8_t from = 0;
+  uint8_t to = 0;
+  uint8_t cf_index = 0;
+  uint8_t phase = kCopying;
+  // the last copied key of the column family, the copying continues after it
+  std::string last_key;
+
+  std::string Encode() const {
+    std::string dst;
+    PutFixed8(&dst, from);
+    PutFixed8(&dst, to);
+    PutFixed8(&dst, cf_index);
+    PutFixed8(&dst, phase);
+    dst.append(last_key);
+    return dst;
+  }
+
+  bool Decode(rocksdb::Slice input) {
+    if (!GetFixed8(&input, &from) || !GetFixed8(&input, &to) || !GetFixed8(&input, &cf_index) ||
+        !GetFixed8(&input, &phase) || phase > kReplacing) {
+      return false;
+    }
+    last_key = input.ToString();
+    return true;
+  }
+};
 
 // used in creating rocksdb::LRUCache, set `num_shard_bits` to -1 means let rocksdb choose a good default shard count
 // based on the capacity and the implementation.
@@ -72,8 +120,53 @@ constexpr size_t kRockdbHCCAutoAdjustCharge = 0;
 
 const int64_t kIORateLimitMaxMb = 1024000;
 
+constexpr const char *kBlockCacheDumpFile = "block_cache.dump";
+
 using rocksdb::Slice;
 
+// ThrottledCacheDumpReader reads the dumped block cache at the limited rate, so that the prewarm doesn't
+// compete with the requests for the disk bandwidth, and counts the bytes read as the progress of the prewarm.
+class ThrottledCacheDumpReader : public rocksdb::CacheDumpReader {
+ public:
+  ThrottledCacheDumpReader(std::unique_ptr<rocksdb::CacheDumpReader> reader, int64_t rate_bytes_per_sec,
+                           std::atomic<uint64_t> *loaded_bytes, const std::atomic<bool> *stop)
+      : reader_(std::move(reader)), loaded_bytes_(loaded_bytes), stop_(stop) {
+    if (rate_bytes_per_sec > 0) rate_limiter_.reset(rocksdb::NewGenericRateLimiter(rate_bytes_per_sec));
+  }
+
+  rocksdb::IOStatus ReadMetadata(std::string *metadata) override {
+    auto s = reader_->ReadMetadata(metadata);
+    if (s.ok()) throttle(metadata->size());
+    return s;
+  }
+
+  rocksdb::IOStatus ReadPacket(std::string *data) override {
+    if (*stop_) return rocksdb::IOStatus::Aborted("the block cache prewarm is stopped");
+    auto s = reader_->ReadPacket(data);
+    if (s.ok()) throttle(data->size());
+    return s;
+  }
+
+ private:
+  void throttle(size_t bytes) {
+    *loaded_bytes_ += bytes;
+    if (!rate_limiter_) return;
+    // the rate limiter refuses the requests larger than a single burst
+    auto burst = static_cast<size_t>(rate_limiter_->GetSingleBurstBytes());
+    while (bytes > 0 && !*stop_) {
+      auto n = std::min(bytes, burst);
+      rate_limiter_->Request(static_cast<int64_t>(n), rocksdb::Env::IO_LOW, nullptr,
+                             rocksdb::RateLimiter::OpType::kRead);
+      bytes -= n;
+    }
+  }
+
+  std::unique_ptr<rocksdb::CacheDumpReader> reader_;
+  std::unique_ptr<rocksdb::RateLimiter> rate_limiter_;
+  std::atomic<uint64_t> *loaded_bytes_;
+  const std::atomic<bool> *stop_;
+};
+
 Storage::Storage(Config *config)
     : backup_creating_time_secs_(util::GetTimeStamp<std::chrono::seconds>()),
       env_(rocksdb::Env::Default()),
@@ -82,6 +175,7 @@ Storage::Storage(Config *config)
       db_stats_(std::make_unique<DBStats>()) {
   Metadata::InitVersionCounter();
   SetWriteOptions(config->rocks_db.write_options);
+  SetWALDisabledNamespaces(config->wal_disabled_namespaces);
 }
 
 Storage::~Storage() {
@@ -90,6 +184,7 @@ Storage::~Storage() {
 }
 
 void Storage::CloseDB() {
+  stopBlockCachePrewarm();
   auto guard = WriteLockGuard();
   if (!db_) return;
 
@@ -97,6 +192,8 @@ void Storage::CloseDB() {
   db_->SyncWAL();
   rocksdb::CancelAllBackgroundWork(db_.get(), true);
   for (auto handle : cf_handles_) db_->DestroyColumnFamilyHandle(handle);
+  if (subkey_convert_cf_) db_->DestroyColumnFamilyHandle(subkey_convert_cf_);
+  subkey_convert_cf_ = nullptr;
   db_ = nullptr;
 }
 
@@ -106,6 +203,50 @@ void Storage::SetWriteOptions(const Config::RocksDB::WriteOptions &config) {
   default_write_opts_.no_slowdown = config.no_slowdown;
   default_write_opts_.low_pri = config.low_pri;
   default_write_opts_.memtable_insert_hint_per_batch = config.memtable_insert_hint_per_batch;
+
+  wal_disabled_write_opts_ = default_write_opts_;
+  wal_disabled_write_opts_.disableWAL = true;
+  // RocksDB rejects the sync writes without WAL
+  wal_disabled_write_opts_.sync = false;
+}
+
+void Storage::SetWALDisabledNamespaces(const std::vector<std::string> &namespaces) {
+  std::unique_lock<std::shared_mutex> lock(wal_disabled_namespaces_mu_);
+  wal_disabled_namespaces_ = std::set<std::string>(namespaces.begin(), namespaces.end());
+  has_wal_disabled_namespaces_ = !wal_disabled_namespaces_.empty();
+}
+
+const rocksdb::WriteOptions &Storage::NamespaceWriteOptions(const std::string &ns) {
+  // most servers have no wal-disabled namespace, so don't take the lock on every write
+  if (!has_wal_disabled_namespaces_) return default_write_opts_;
+
+  // the nested databases are created with the encoded namespace, while the set is keyed by the names
+  std::string name = DecodeNamespace(ns);
+  std::shared_lock<std::shared_mutex> lock(wal_disabled_namespaces_mu_);
+  if (wal_disabled_namespaces_.count(name) == 0) return default_write_opts_;
+  return wal_disabled_write_opts_;
+}
+
+bool Storage::HasWALDisabledNamespaces() { return has_wal_disabled_namespaces_; }
+
+void Storage::RecordWALGap(rocksdb::SequenceNumber seq) {
+  auto prev = wal_gap_seq_.load();
+  while (prev < seq && !wal_gap_seq_.compare_exchange_weak(prev, seq)) {
+  }
+}
+
+Status Storage::FlushWALDisabledWrites() {
+  if (!has_wal_disabled_writes_.exchange(false)) return Status::OK();
+
+  rocksdb::FlushOptions flush_options;
+  flush_options.wait = false;
+  flush_options.allow_write_stall = true;
+  auto s = db_->Flush(flush_options, cf_handles_);
+  if (!s.ok()) {
+    has_wal_disabled_writes_ = true;
+    return {Status::NotOK, s.ToString()};
+  }
+  return Status::OK();
 }
 
 rocksdb::ReadOptions Storage::DefaultScanOptions() const {
@@ -166,6 +307,7 @@ rocksdb::Options Storage::InitRocksDBOptions() {
   options.write_buffer_size = config_->rocks_db.write_buffer_size * MiB;
   options.num_levels = 7;
   options.compression_opts.level = config_->rocks_db.compression_level;
+  options.compression_opts.parallel_threads = static_cast<uint32_t>(config_->rocks_db.compression_parallel_threads);
   options.compression_per_level.resize(options.num_levels);
   // only compress levels >= 2
   for (int i = 0; i < options.num_levels; ++i) {
@@ -284,15 +426,33 @@ Status Storage::Open(DBOpenMode mode) {
     }
   }
 
+  // RocksDB could only load the dumped blocks into the secondary cache, and they're moved into the block cache
+  // once they are read. So the compressed secondary cache is only used when there's a dump to load, and it's
+  // sized by the dump since the dumped blocks are uncompressed. It's released after the next dump in
+  // DumpBlockCache, since the blocks which are still unread by then are not hot anymore.
+  std::shared_ptr<rocksdb::SecondaryCache> prewarm_cache;
+  uint64_t dump_file_size = 0;
+  if (config_->rocks_db.block_cache_dump && env_->GetFileSize(blockCacheDumpPath(), &dump_file_size).ok() &&
+      dump_file_size > 0) {
+    rocksdb::CompressedSecondaryCacheOptions prewarm_cache_options;
+    prewarm_cache_options.capacity = std::min(block_cache_size, static_cast<size_t>(dump_file_size));
+    prewarm_cache = rocksdb::NewCompressedSecondaryCache(prewarm_cache_options);
+  }
+  prewarm_cache_ = prewarm_cache;
+
   std::shared_ptr<rocksdb::Cache> shared_block_cache;
 
   if (config_->rocks_db.block_cache_type == BlockCacheType::kCacheTypeLRU) {
-    shared_block_cache = rocksdb::NewLRUCache(block_cache_size, kRocksdbLRUAutoAdjustShardBits,
-                                              kRocksdbCacheStrictCapacityLimit, kRocksdbLRUBlockCacheHighPriPoolRatio);
+    rocksdb::LRUCacheOptions lru_cache_options(block_cache_size, kRocksdbLRUAutoAdjustShardBits,
+                                               kRocksdbCacheStrictCapacityLimit, kRocksdbLRUBlockCacheHighPriPoolRatio);
+    lru_cache_options.secondary_cache = prewarm_cache;
+    shared_block_cache = lru_cache_options.MakeSharedCache();
   } else {
     rocksdb::HyperClockCacheOptions hcc_cache_options(block_cache_size, kRockdbHCCAutoAdjustCharge);
+    hcc_cache_options.secondary_cache = prewarm_cache;
     shared_block_cache = hcc_cache_options.MakeSharedCache();
   }
+  block_cache_ = shared_block_cache;
 
   rocksdb::BlockBasedTableOptions metadata_table_opts = InitTableOptions();
   metadata_table_opts.block_cache = shared_block_cache;
@@ -330,6 +490,13 @@ Status Storage::Open(DBOpenMode mode) {
   pubsub_opts.compaction_filter_factory = std::make_shared<PubSubFilterFactory>();
   pubsub_opts.disable_auto_compactions = config_->rocks_db.disable_auto_compactions;
   SetBlobDB(&pubsub_opts);
+  // the messages are only replicated via the WAL and useless once written, so the SST files could be
+  // dropped as a whole after the TTL instead of being rewritten by the compaction
+  if (config_->rocks_db.pubsub_fifo_compaction) {
+    pubsub_opts.compaction_style = rocksdb::kCompactionStyleFIFO;
+    pubsub_opts.compaction_options_fifo.allow_compaction = false;
+    pubsub_opts.ttl = config_->rocks_db.pubsub_fifo_ttl;
+  }
 
   rocksdb::BlockBasedTableOptions propagate_table_opts = InitTableOptions();
   rocksdb::ColumnFamilyOptions propagate_opts(options);
@@ -347,10 +514,27 @@ Status Storage::Open(DBOpenMode mode) {
   column_families.emplace_back(std::string(kPropagateColumnFamilyName), propagate_opts);
   column_families.emplace_back(std::string(kStreamColumnFamilyName), subkey_opts);
   column_families.emplace_back(std::string(kSearchColumnFamilyName), subkey_opts);
+  // the small and similar values, e.g. hash fields and JSON documents, are compressed much better with a
+  // dictionary sampled from the SST file, which is only used by the compressed levels
+  if (config_->rocks_db.compression_max_dict_bytes > 0) {
+    const auto &dict_cfs = config_->rocks_db.compression_dict_column_families;
+    for (auto &cf : column_families) {
+      if (std::find(dict_cfs.begin(), dict_cfs.end(), cf.name) == dict_cfs.end()) continue;
+      cf.options.compression_opts.max_dict_bytes = config_->rocks_db.compression_max_dict_bytes;
+      cf.options.compression_opts.zstd_max_train_bytes = config_->rocks_db.compression_zstd_max_train_bytes;
+    }
+  }
 
   std::vector<std::string> old_column_families;
   auto s = rocksdb::DB::ListColumnFamilies(options, config_->db_dir, &old_column_families);
   if (!s.ok()) return {Status::NotOK, s.ToString()};
+  // the staging column family of an interrupted sub key encoding conversion must be opened to resume it
+  bool has_subkey_convert_cf = mode == DBOpenMode::kDBOpenModeDefault &&
+                               std::find(old_column_families.begin(), old_column_families.end(),
+                                         kSubkeyConvertColumnFamilyName) != old_column_families.end();
+  if (has_subkey_convert_cf) {
+    column_families.emplace_back(kSubkeyConvertColumnFamilyName, rocksdb::ColumnFamilyOptions());
+  }
 
   auto start = std::chrono::high_resolution_clock::now();
   switch (mode) {
@@ -377,11 +561,331 @@ Status Storage::Open(DBOpenMode mode) {
     LOG(INFO) << "[storage] Failed to load the data from disk: " << duration << " ms";
     return {Status::DBOpenErr};
   }
+  if (has_subkey_convert_cf) {
+    subkey_convert_cf_ = cf_handles_.back();
+    cf_handles_.pop_back();
+  }
   LOG(INFO) << "[storage] Success to load the data from disk: " << duration << " ms";
 
+  if (prewarm_cache) startBlockCachePrewarm(prewarm_cache, subkey_table_opts);
+
+  if (mode != DBOpenMode::kDBOpenModeAsSecondaryInstance) {
+    GET_OR_RET(checkSubkeyEncoding(mode == DBOpenMode::kDBOpenModeForReadOnly));
+    GET_OR_RET(checkNamespaceIDEncoding(mode == DBOpenMode::kDBOpenModeForReadOnly));
+  } else {
+    // The secondary instance follows the namespace id encoding recorded by the primary
+    std::string value;
+    auto s = db_->Get(rocksdb::ReadOptions(), GetCFHandle(ColumnFamilyID::Propagate), kNamespaceIDEncodingKey, &value);
+    if (!s.ok() && !s.IsNotFound()) return {Status::NotOK, s.ToString()};
+    config_->namespace_id_encoding = s.ok() && value == "yes";
+    GET_OR_RET(ReloadNamespaceIDs());
+  }
+  return Status::OK();
+}
+
+Status Storage::checkSubkeyEncoding(bool read_only) {
+  auto cf = GetCFHandle(ColumnFamilyID::Propagate);
+  std::string value;
+  auto s = db_->Get(rocksdb::ReadOptions(), cf, kSubkeyEncodingConvertingKey, &value);
+  if (!s.ok() && !s.IsNotFound()) return {Status::NotOK, s.ToString()};
+  if (s.ok()) {
+    // the sub key column families are partially converted, so they can only be used after resuming
+    SubkeyConvertProgress progress;
+    if (!progress.Decode(value)) return {Status::NotOK, "the progress of the sub key encoding conversion is corrupted"};
+    if (read_only || !config_->convert_subkey_encoding || progress.to != SUBKEY_ENCODING_VERSION_DEFAULT) {
+      return {Status::NotOK, fmt::format("the conversion of the sub keys from encoding version {} to {} was "
+                                         "interrupted, resume it with version {} and `convert-subkey-encoding` enabled",
+                                         progress.from, progress.to, progress.to)};
+    }
+    return convertSubkeyEncoding(progress.from, progress.to);
+  }
+
+  s = db_->Get(rocksdb::ReadOptions(), cf, kSubkeyEncodingVersionKey, &value);
+  if (!s.ok() && !s.IsNotFound()) return {Status::NotOK, s.ToString()};
+
+  uint8_t version = SUBKEY_ENCODING_VERSION_DEFAULT;
+  if (s.ok()) {
+    version = GET_OR_RET(ParseInt<uint8_t>(value, 10));
+  } else if (!isSubkeyCFsEmpty()) {
+    // the storage was created before the encoding version is recorded
+    version = 0;
+  }
+  bool recorded = s.ok() && version == SUBKEY_ENCODING_VERSION_DEFAULT;
+  if (recorded || read_only) {
+    if (version != SUBKEY_ENCODING_VERSION_DEFAULT) {
+      return {Status::NotOK, fmt::format("the sub keys are encoded in version {} while version {} is used", version,
+                                         SUBKEY_ENCODING_VERSION_DEFAULT)};
+    }
+    // the conversion was done but the staging column family wasn't dropped yet
+    if (!read_only) return dropSubkeyConvertCF();
+    return Status::OK();
+  }
+
+  if (version != SUBKEY_ENCODING_VERSION_DEFAULT) {
+    if (!config_->convert_subkey_encoding) {
+      return {Status::NotOK,
+              fmt::format("the sub keys are encoded in version {} while version {} is used, "
+                          "enable `convert-subkey-encoding` to convert them",
+                          version, SUBKEY_ENCODING_VERSION_DEFAULT)};
+    }
+    return convertSubkeyEncoding(version, SUBKEY_ENCODING_VERSION_DEFAULT);
+  }
+  // The version is recorded locally instead of being replicated, since the replicas
+  // are checked against their own storage on startup as well.
+  s = db_->Put(default_write_opts_, cf, kSubkeyEncodingVersionKey, std::to_string(SUBKEY_ENCODING_VERSION_DEFAULT));
+  if (!s.ok()) return {Status::NotOK, s.ToString()};
+  return Status::OK();
+}
+
+bool Storage::isSubkeyCFsEmpty() {
+  for (auto cf_id : {ColumnFamilyID::PrimarySubkey, ColumnFamilyID::SecondarySubkey, ColumnFamilyID::Stream,
+                     ColumnFamilyID::Search}) {
+    auto iter = util::UniqueIterator(this, rocksdb::ReadOptions(), GetCFHandle(cf_id));
+    iter->SeekToFirst();
+    if (iter->Valid()) return false;
+  }
+  return true;
+}
+
+// Delete all keys of the column family in the write batch
+Status Storage::clearColumnFamily(rocksdb::ColumnFamilyHandle *cf_handle, rocksdb::WriteBatch *batch) {
+  auto iter = util::UniqueIterator(this, DefaultScanOptions(), cf_handle);
+  iter->SeekToFirst();
+  if (!iter->Valid()) return Status::OK();
+  auto first_key = iter->key().ToString();
+  iter->SeekToLast();
+  if (!iter->Valid()) return Status::OK();
+  auto last_key = iter->key().ToString();
+
+  // the end key of DeleteRange is exclusive, so delete the last key explicitly
+  auto s = batch->DeleteRange(cf_handle, first_key, last_key);
+  if (s.ok()) s = batch->Delete(cf_handle, last_key);
+  if (!s.ok()) return {Status::NotOK, s.ToString()};
+  return Status::OK();
+}
+
+// The sub keys are converted column family by column family in two phases. They're copied into
+// the staging column family in the new layout first, then the column family is cleared and refilled
+// from the staged copy. The progress is written in the same batch as the keys, so the conversion
+// can be resumed after a crash, and a key is never parsed in the old layout once it's converted:
+// the column family holds only the old layout until the copy completes, and the staged copy holds
+// only the new layout.
+Status Storage::convertSubkeyEncoding(uint8_t from, uint8_t to) {
+  constexpr size_t kConvertBatchSize = 4096;
+  constexpr std::array<ColumnFamilyID, 4> kSubkeyCFs = {ColumnFamilyID::PrimarySubkey, ColumnFamilyID::SecondarySubkey,
+                                                        ColumnFamilyID::Stream, ColumnFamilyID::Search};
+
+  auto propagate_cf = GetCFHandle(ColumnFamilyID::Propagate);
+  SubkeyConvertProgress progress;
+  std::string value;
+  auto s = db_->Get(rocksdb::ReadOptions(), propagate_cf, kSubkeyEncodingConvertingKey, &value);
+  if (!s.ok() && !s.IsNotFound()) return {Status::NotOK, s.ToString()};
+  if (s.ok()) {
+    if (!progress.Decode(value) || progress.from != from || progress.to != to ||
+        progress.cf_index > kSubkeyCFs.size()) {
+      return {Status::NotOK, "the progress of the sub key encoding conversion is corrupted"};
+    }
+    LOG(INFO) << "[storage] Resume converting the sub keys from encoding version " << static_cast<int>(from) << " to "
+              << static_cast<int>(to) << " at column family " << static_cast<int>(progress.cf_index);
+  } else {
+    progress.from = from;
+    progress.to = to;
+    LOG(INFO) << "[storage] Start to convert the sub keys from encoding version " << static_cast<int>(from) << " to "
+              << static_cast<int>(to);
+  }
+  if (!subkey_convert_cf_) {
+    s = db_->CreateColumnFamily(rocksdb::ColumnFamilyOptions(), kSubkeyConvertColumnFamilyName, &subkey_convert_cf_);
+    if (!s.ok()) return {Status::NotOK, s.ToString()};
+  }
+
+  auto start = std::chrono::high_resolution_clock::now();
+  bool slot_id_encoded = IsSlotIdEncoded();
+  uint64_t converted = 0;
+  std::string ns_key, new_key;
+  auto write_batch = [this](rocksdb::WriteBatch *batch) -> Status {
+    auto s = db_->Write(default_write_opts_, batch);
+    if (!s.ok()) return {Status::NotOK, s.ToString()};
+    batch->Clear();
+    return Status::OK();
+  };
+  while (progress.cf_index < kSubkeyCFs.size()) {
+    auto cf = GetCFHandle(kSubkeyCFs[progress.cf_index]);
+    rocksdb::WriteBatch batch;
+    if (progress.phase == SubkeyConvertProgress::kCopying) {
+      // the staging column family is always empty before copying a column family
+      auto iter = util::UniqueIterator(this, DefaultScanOptions(), cf);
+      if (progress.last_key.empty()) {
+        iter->SeekToFirst();
+      } else {
+        iter->Seek(progress.last_key);
+        if (iter->Valid() && iter->key() == progress.last_key) iter->Next();
+      }
+      for (; iter->Valid(); iter->Next()) {
+        InternalKey ikey(iter->key(), slot_id_encoded, from);
+        ComposeNamespaceKey(ikey.GetNamespace(), ikey.GetKey(), slot_id_encoded, &ns_key);
+        InternalKey(ns_key, ikey.GetSubKey(), ikey.GetVersion(), slot_id_encoded, to).EncodeTo(&new_key);
+        batch.Put(subkey_convert_cf_, new_key, iter->value());
+        converted++;
+        if (batch.Count() >= kConvertBatchSize) {
+          progress.last_key = iter->key().ToString();
+          batch.Put(propagate_cf, kSubkeyEncodingConvertingKey, progress.Encode());
+          GET_OR_RET(write_batch(&batch));
+        }
+      }
+      if (!iter->status().ok()) return {Status::NotOK, iter->status().ToString()};
+      progress.phase = SubkeyConvertProgress::kReplacing;
+      progress.last_key.clear();
+      batch.Put(propagate_cf, kSubkeyEncodingConvertingKey, progress.Encode());
+      GET_OR_RET(write_batch(&batch));
+    }
+
+    // The staged copy is complete, so this phase is simply redone from the beginning if it's interrupted
+    GET_OR_RET(clearColumnFamily(cf, &batch));
+    auto iter = util::UniqueIterator(this, DefaultScanOptions(), subkey_convert_cf_);
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      batch.Put(cf, iter->key(), iter->value());
+      if (batch.Count() >= kConvertBatchSize) GET_OR_RET(write_batch(&batch));
+    }
+    if (!iter->status().ok()) return {Status::NotOK, iter->status().ToString()};
+    GET_OR_RET(clearColumnFamily(subkey_convert_cf_, &batch));
+    progress.cf_index++;
+    progress.phase = SubkeyConvertProgress::kCopying;
+    batch.Put(propagate_cf, kSubkeyEncodingConvertingKey, progress.Encode());
+    GET_OR_RET(write_batch(&batch));
+  }
+
+  // The version is recorded locally instead of being replicated, since the replicas
+  // are checked against their own storage on startup as well.
+  rocksdb::WriteBatch batch;
+  batch.Put(propagate_cf, kSubkeyEncodingVersionKey, std::to_string(to));
+  batch.Delete(propagate_cf, kSubkeyEncodingConvertingKey);
+  GET_OR_RET(write_batch(&batch));
+  GET_OR_RET(dropSubkeyConvertCF());
+
+  auto end = std::chrono::high_resolution_clock::now();
+  LOG(INFO) << "[storage] Converted " << converted << " sub keys in "
+            << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count() << " ms";
+  return Status::OK();
+}
+
+Status Storage::dropSubkeyConvertCF() {
+  if (!subkey_convert_cf_) return Status::OK();
+  auto s = db_->DropColumnFamily(subkey_convert_cf_);
+  if (!s.ok()) return {Status::NotOK, s.ToString()};
+  db_->DestroyColumnFamilyHandle(subkey_convert_cf_);
+  subkey_convert_cf_ = nullptr;
+  return Status::OK();
+}
+
+Status Storage::checkNamespaceIDEncoding(bool read_only) {
+  auto cf = GetCFHandle(ColumnFamilyID::Propagate);
+  std::string value;
+  auto s = db_->Get(rocksdb::ReadOptions(), cf, kNamespaceIDEncodingKey, &value);
+  if (!s.ok() && !s.IsNotFound()) return {Status::NotOK, s.ToString()};
+
+  bool enabled = config_->namespace_id_encoding;
+  // the storage was created before the namespace id encoding is recorded, so the names are used in keys
+  bool recorded = false;
+  if (s.ok()) {
+    recorded = value == "yes";
+  } else {
+    auto iter = util::UniqueIterator(this, rocksdb::ReadOptions(), GetCFHandle(ColumnFamilyID::Metadata));
+    iter->SeekToFirst();
+    if (!iter->Valid()) {
+      recorded = enabled;
+      if (!read_only) {
+        s = db_->Put(default_write_opts_, cf, kNamespaceIDEncodingKey, enabled ? "yes" : "no");
+        if (!s.ok()) return {Status::NotOK, s.ToString()};
+      }
+    }
+  }
+  if (recorded != enabled) {
+    return {Status::NotOK, fmt::format("the namespace id encoding is {} in the storage, "
+                                       "`namespace-id-encoding` can only be changed on an empty storage",
+                                       recorded ? "enabled" : "disabled")};
+  }
+
+  std::unique_lock<std::shared_mutex> lock(namespace_ids_mu_);
+  return loadNamespaceIDs();
+}
+
+// Should be called with the namespace_ids_mu_ held exclusively
+Status Storage::loadNamespaceIDs() {
+  namespace_ids_.clear();
+  namespace_names_.clear();
+  max_namespace_id_ = 0;
+  if (!config_->namespace_id_encoding) return Status::OK();
+
+  auto encode_id = [](uint32_t id) {
+    std::string encoded(1, kNamespaceIDTag);
+    PutVarint32(&encoded, id);
+    return encoded;
+  };
+  namespace_ids_[kDefaultNamespace] = encode_id(kDefaultNamespaceID);
+  namespace_names_[encode_id(kDefaultNamespaceID)] = kDefaultNamespace;
+  max_namespace_id_ = kDefaultNamespaceID;
+
+  rocksdb::Slice prefix(kNamespaceIDPrefix);
+  auto iter = util::UniqueIterator(this, rocksdb::ReadOptions(), GetCFHandle(ColumnFamilyID::Propagate));
+  for (iter->Seek(prefix); iter->Valid() && iter->key().starts_with(prefix); iter->Next()) {
+    auto id = GET_OR_RET(ParseInt<uint32_t>(iter->value().ToString(), 10));
+    std::string encoded = encode_id(id);
+    std::string name = iter->key().ToString().substr(prefix.size());
+    namespace_names_[encoded] = name;
+    namespace_ids_[std::move(name)] = std::move(encoded);
+    max_namespace_id_ = std::max(max_namespace_id_, id);
+  }
+  if (!iter->status().ok()) return {Status::NotOK, iter->status().ToString()};
   return Status::OK();
 }
 
+Status Storage::ReloadNamespaceIDs() {
+  std::unique_lock<std::shared_mutex> lock(namespace_ids_mu_);
+  return loadNamespaceIDs();
+}
+
+Status Storage::AssignNamespaceID(const std::string &ns) {
+  if (!config_->namespace_id_encoding) return Status::OK();
+  // Replicas wait for the id from the master, the name matches no keys before that
+  if (config_->IsSlave()) return Status::OK();
+
+  std::unique_lock<std::shared_mutex> lock(namespace_ids_mu_);
+  if (namespace_ids_.find(ns) != namespace_ids_.end()) return Status::OK();
+
+  uint32_t id = max_namespace_id_ + 1;
+  rocksdb::WriteBatch batch;
+  batch.Put(GetCFHandle(ColumnFamilyID::Propagate), kNamespaceIDPrefix + ns, std::to_string(id));
+  // Bypass the transaction batch since the id must be persisted before any key uses it
+  if (auto s = writeToDB(default_write_opts_, &batch); !s.ok()) {
+    return {Status::NotOK, fmt::format("failed to assign the id to namespace {}: {}", ns, s.ToString())};
+  }
+  std::string encoded(1, kNamespaceIDTag);
+  PutVarint32(&encoded, id);
+  max_namespace_id_ = id;
+  namespace_names_[encoded] = ns;
+  namespace_ids_[ns] = std::move(encoded);
+  return Status::OK();
+}
+
+std::string Storage::EncodeNamespace(std::string ns) {
+  if (!config_->namespace_id_encoding || IsNamespaceID(ns)) return ns;
+
+  std::shared_lock<std::shared_mutex> lock(namespace_ids_mu_);
+  if (auto iter = namespace_ids_.find(ns); iter != namespace_ids_.end()) return iter->second;
+  // The namespace has no id yet, e.g. it's unknown to the server or the id isn't replicated from the master.
+  // No key is stored under the name, so it's used as it is.
+  return ns;
+}
+
+std::string Storage::DecodeNamespace(const rocksdb::Slice &ns) {
+  if (!IsNamespaceID(ns)) return ns.ToString();
+
+  std::string encoded = ns.ToString();
+  std::shared_lock<std::shared_mutex> lock(namespace_ids_mu_);
+  if (auto iter = namespace_names_.find(encoded); iter != namespace_names_.end()) return iter->second;
+  return encoded;
+}
+
 Status Storage::CreateBackup(uint64_t *sequence_number) {
   LOG(INFO) << "[storage] Start to create new backup";
   std::lock_guard<std::mutex> lg(config_->backup_mu);
@@ -635,6 +1139,12 @@ rocksdb::Iterator *Storage::NewIterator(const rocksdb::ReadOptions &options,
   if (is_txn_mode_ && txn_write_batch_->GetWriteBatch()->Count() > 0) {
     return txn_write_batch_->NewIteratorWithBase(column_family, iter, &options);
   }
+  // only the iterators reading from an explicit snapshot are refreshed, since refreshing the others
+  // would make them see the writes after they were created
+  int64_t refresh_interval = config_->rocks_db.read_options.iterator_refresh_interval;
+  if (refresh_interval > 0 && options.snapshot && !options.tailing) {
+    return new AutoRefreshIterator(iter, options.snapshot, refresh_interval);
+  }
   return iter;
 }
 
@@ -667,6 +1177,12 @@ rocksdb::Status Storage::writeToDB(const rocksdb::WriteOptions &options, rocksdb
     updates->PutLogData(ServerLogData(kReplIdLog, replid_).Encode());
   }
 
+  if (options.disableWAL && !default_write_opts_.disableWAL) {
+    has_wal_disabled_writes_ = true;
+    auto s = db_->Write(options, updates);
+    if (s.ok()) RecordWALGap(db_->GetLatestSequenceNumber());
+    return s;
+  }
   return db_->Write(options, updates);
 }
 
@@ -693,6 +1209,42 @@ rocksdb::Status Storage::DeleteRange(const std::string &first_key, const std::st
   return Write(default_write_opts_, batch->GetWriteBatch());
 }
 
+std::vector<rocksdb::ColumnFamilyHandle *> Storage::GetDataCFHandles() {
+  // The index keys in the search column family are prefixed by the namespace as well, so the ranges of the keys
+  // cover them, and the index entries of the deleted keys would point to nothing if they were kept
+  return {GetCFHandle(ColumnFamilyID::Metadata), GetCFHandle(ColumnFamilyID::PrimarySubkey),
+          GetCFHandle(ColumnFamilyID::SecondarySubkey), GetCFHandle(ColumnFamilyID::Stream),
+          GetCFHandle(ColumnFamilyID::Search)};
+}
+
+rocksdb::Status Storage::DeleteRangeOfDataCFs(const std::string &begin_key, const std::string &end_key) {
+  auto batch = GetWriteBatchBase();
+  for (auto cf_handle : GetDataCFHandles()) {
+    if (!begin_key.empty() || !end_key.empty()) {
+      auto s = batch->DeleteRange(cf_handle, begin_key, end_key);
+      if (!s.ok()) return s;
+      continue;
+    }
+
+    rocksdb::ReadOptions read_options = DefaultScanOptions();
+    auto iter = util::UniqueIterator(this, read_options, cf_handle);
+    iter->SeekToFirst();
+    if (!iter->Valid()) continue;
+    auto first_key = iter->key().ToString();
+    iter->SeekToLast();
+    if (!iter->Valid()) continue;
+    auto last_key = iter->key().ToString();
+
+    // the end key of DeleteRange is exclusive, so delete the last key explicitly
+    auto s = batch->DeleteRange(cf_handle, first_key, last_key);
+    if (!s.ok()) return s;
+    s = batch->Delete(cf_handle, last_key);
+    if (!s.ok()) return s;
+  }
+
+  return Write(default_write_opts_, batch->GetWriteBatch());
+}
+
 rocksdb::Status Storage::FlushScripts(const rocksdb::WriteOptions &options, rocksdb::ColumnFamilyHandle *cf_handle) {
   std::string begin_key = kLuaFuncSHAPrefix, end_key = begin_key;
   // we need to increase one here since the DeleteRange api
@@ -763,7 +1315,7 @@ uint64_t Storage::GetTotalSize(const std::string &ns) {
   }
 
   std::string begin_key, end_key;
-  std::string prefix = ComposeNamespaceKey(ns, "", false);
+  std::string prefix = ComposeNamespaceKey(EncodeNamespace(ns), "", false);
 
   redis::Database db(this, ns);
   uint64_t size = 0, total_size = 0;
@@ -812,6 +1364,115 @@ void Storage::SetIORateLimit(int64_t max_io_mb) {
   rate_limiter_->SetBytesPerSecond(max_io_mb * static_cast<int64_t>(MiB));
 }
 
+std::string Storage::blockCacheDumpPath() const { return config_->dir + "/" + kBlockCacheDumpFile; }
+
+Status Storage::DumpBlockCache() {
+  std::lock_guard<std::mutex> lg(block_cache_dump_mu_);
+  auto guard = ReadLockGuard();
+  if (!db_ || db_closing_) return {Status::NotOK, "the db is closed"};
+
+  auto start = std::chrono::high_resolution_clock::now();
+  // dump into the temporary file first, so that the previous dump is still intact if it's interrupted
+  auto dump_path = blockCacheDumpPath();
+  auto tmp_path = dump_path + ".tmp";
+  std::unique_ptr<rocksdb::CacheDumpWriter> writer;
+  auto io_s = rocksdb::NewToFileCacheDumpWriter(env_->GetFileSystem(), rocksdb::FileOptions(), tmp_path, &writer);
+  if (!io_s.ok()) return {Status::NotOK, io_s.ToString()};
+
+  rocksdb::CacheDumpOptions dump_options;
+  dump_options.clock = env_->GetSystemClock().get();
+  std::unique_ptr<rocksdb::CacheDumper> dumper;
+  auto s = rocksdb::NewDefaultCacheDumper(dump_options, block_cache_, std::move(writer), &dumper);
+  if (!s.ok()) return {Status::NotOK, s.ToString()};
+  // only dump the blocks of this DB, the cache may be shared by others
+  s = dumper->SetDumpFilter({db_.get()});
+  if (!s.ok()) return {Status::NotOK, s.ToString()};
+  io_s = dumper->DumpCacheEntriesToWriter();
+  if (!io_s.ok()) {
+    env_->DeleteFile(tmp_path);
+    return {Status::NotOK, io_s.ToString()};
+  }
+  s = env_->RenameFile(tmp_path, dump_path);
+  if (!s.ok()) return {Status::NotOK, s.ToString()};
+
+  uint64_t dump_bytes = 0;
+  env_->GetFileSize(dump_path, &dump_bytes);
+  // the hot blocks of the prewarm have been moved into the block cache and dumped again by now
+  if (prewarm_cache_ && block_cache_dump_info_.prewarm_state != BlockCacheDumpInfo::kLoading) {
+    // the secondary cache can't be detached from the block cache, so drop its entries and admit nothing anymore
+    if (auto cache_s = prewarm_cache_->SetCapacity(0); !cache_s.ok()) {
+      LOG(WARNING) << "[storage] Failed to release the block cache prewarm cache: " << cache_s.ToString();
+    }
+    prewarm_cache_.reset();
+  }
+  block_cache_dump_info_.last_dump_bytes = dump_bytes;
+  block_cache_dump_info_.last_dump_time_secs = util::GetTimeStamp<std::chrono::seconds>();
+  auto end = std::chrono::high_resolution_clock::now();
+  auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end - start);
+  LOG(INFO) << "[storage] Dumped the block cache, " << dump_bytes << " bytes in " << duration.count() << " ms";
+  return Status::OK();
+}
+
+void Storage::startBlockCachePrewarm(const std::shared_ptr<rocksdb::SecondaryCache> &secondary_cache,
+                                     const rocksdb::BlockBasedTableOptions &table_options) {
+  auto dump_path = blockCacheDumpPath();
+  uint64_t total_bytes = 0;
+  env_->GetFileSize(dump_path, &total_bytes);
+  block_cache_dump_info_.prewarm_state = BlockCacheDumpInfo::kLoading;
+  block_cache_dump_info_.prewarm_loaded_bytes = 0;
+  block_cache_dump_info_.prewarm_total_bytes = total_bytes;
+  block_cache_dump_info_.prewarm_duration_ms = 0;
+  block_cache_prewarm_stop_ = false;
+
+  auto prewarm = [this, secondary_cache, table_options, dump_path] {
+    auto start = std::chrono::high_resolution_clock::now();
+    std::unique_ptr<rocksdb::CacheDumpReader> file_reader;
+    rocksdb::Status s =
+        rocksdb::NewFromFileCacheDumpReader(env_->GetFileSystem(), rocksdb::FileOptions(), dump_path, &file_reader);
+    if (s.ok()) {
+      auto reader = std::make_unique<ThrottledCacheDumpReader>(
+          std::move(file_reader), static_cast<int64_t>(config_->rocks_db.block_cache_prewarm_rate) * MiB,
+          &block_cache_dump_info_.prewarm_loaded_bytes, &block_cache_prewarm_stop_);
+      rocksdb::CacheDumpOptions dump_options;
+      dump_options.clock = env_->GetSystemClock().get();
+      std::unique_ptr<rocksdb::CacheDumpedLoader> loader;
+      s = rocksdb::NewDefaultCacheDumpedLoader(dump_options, table_options, secondary_cache, std::move(reader),
+                                               &loader);
+      if (s.ok()) s = loader->RestoreCacheEntriesToSecondaryCache();
+    }
+
+    auto duration =
+        std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start);
+    block_cache_dump_info_.prewarm_duration_ms = duration.count();
+    if (!s.ok()) {
+      block_cache_dump_info_.prewarm_state = BlockCacheDumpInfo::kFailed;
+      LOG(WARNING) << "[storage] Failed to prewarm the block cache: " << s.ToString();
+      secondary_cache->SetCapacity(0);
+      return;
+    }
+    block_cache_dump_info_.prewarm_state = BlockCacheDumpInfo::kDone;
+    LOG(INFO) << "[storage] Prewarmed the block cache, " << block_cache_dump_info_.prewarm_loaded_bytes
+              << " bytes in " << duration.count() << " ms";
+  };
+
+  auto t = util::CreateThread("cache-prewarm", prewarm);
+  if (!t) {
+    block_cache_dump_info_.prewarm_state = BlockCacheDumpInfo::kFailed;
+    LOG(WARNING) << "[storage] Failed to start the block cache prewarm: " << t.Msg();
+    return;
+  }
+  block_cache_prewarm_thread_ = std::move(*t);
+}
+
+void Storage::stopBlockCachePrewarm() {
+  if (!block_cache_prewarm_thread_.joinable()) return;
+
+  block_cache_prewarm_stop_ = true;
+  if (auto s = util::ThreadJoin(block_cache_prewarm_thread_); !s) {
+    LOG(WARNING) << "[storage] Failed to join the block cache prewarm thread: " << s.Msg();
+  }
+}
+
 rocksdb::DB *Storage::GetDB() { return db_.get(); }
 
 Status Storage::BeginTxn() {
@@ -23,6 +23,7 @@
 #include <event2/bufferevent.h>
 #include <rocksdb/db.h>
 #include <rocksdb/options.h>
+#include <rocksdb/secondary_cache.h>
 #include <rocksdb/table.h>
 #include <rocksdb/utilities/backup_engine.h>
 #include <rocksdb/utilities/write_batch_with_index.h>
@@ -31,8 +32,11 @@
 #include <cinttypes>
 #include <cstddef>
 #include <memory>
+#include <set>
 #include <shared_mutex>
 #include <string>
+#include <thread>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -77,6 +81,8 @@ constexpr const char *kLuaFuncSHAPrefix = "lua_f_";
 constexpr const char *kLuaFuncLibPrefix = "lua_func_lib_";
 constexpr const char *kLuaLibCodePrefix = "lua_lib_code_";
 
+constexpr const char *kNamespaceIDPrefix = "namespace_id_of_";
+
 struct CompressionOption {
   rocksdb::CompressionType type;
   const std::string name;
@@ -116,6 +122,31 @@ struct DBStats {
   alignas(CACHE_LINE_SIZE) std::atomic<uint_fast64_t> keyspace_misses = 0;
 };
 
+struct BlockCacheDumpInfo {
+  enum PrewarmState : int { kNone = 0, kLoading, kDone, kFailed };
+
+  // System clock time when the block cache was dumped last time, and the size of the dump file
+  std::atomic<int64_t> last_dump_time_secs = 0;
+  std::atomic<uint64_t> last_dump_bytes = 0;
+  std::atomic<int> prewarm_state = kNone;
+  std::atomic<uint64_t> prewarm_loaded_bytes = 0;
+  std::atomic<uint64_t> prewarm_total_bytes = 0;
+  std::atomic<int64_t> prewarm_duration_ms = 0;
+
+  static const char *PrewarmStateName(int state) {
+    switch (state) {
+      case kLoading:
+        return "loading";
+      case kDone:
+        return "done";
+      case kFailed:
+        return "failed";
+      default:
+        return "none";
+    }
+  }
+};
+
 class ColumnFamilyConfig {
  public:
   ColumnFamilyConfig(ColumnFamilyID id, std::string_view name, bool is_minor)
@@ -200,6 +231,7 @@ class Storage {
   ~Storage();
 
   void SetWriteOptions(const Config::RocksDB::WriteOptions &config);
+  void SetWALDisabledNamespaces(const std::vector<std::string> &namespaces);
   Status Open(DBOpenMode mode = kDBOpenModeDefault);
   void CloseDB();
   bool IsEmptyDB();
@@ -236,11 +268,25 @@ class Storage {
 
   [[nodiscard]] rocksdb::Status Write(const rocksdb::WriteOptions &options, rocksdb::WriteBatch *updates);
   const rocksdb::WriteOptions &DefaultWriteOptions() { return default_write_opts_; }
+  // The write options of the namespace, which don't write the WAL if the namespace is in wal-disabled-namespaces.
+  // The namespace is either the name or its encoded id.
+  const rocksdb::WriteOptions &NamespaceWriteOptions(const std::string &ns);
+  // Flush the memtables if anything was written without the WAL since the last flush,
+  // which bounds the writes lost on crash
+  Status FlushWALDisabledWrites();
+  bool HasWALDisabledNamespaces();
+  // The writes without the WAL still take sequence numbers, so they leave gaps in the WAL.
+  // The WAL before the last gap can't feed the replicas or CDC consumers continuously.
+  void RecordWALGap(rocksdb::SequenceNumber seq);
+  rocksdb::SequenceNumber GetWALGapSeq() const { return wal_gap_seq_; }
   rocksdb::ReadOptions DefaultScanOptions() const;
   rocksdb::ReadOptions DefaultMultiGetOptions() const;
   [[nodiscard]] rocksdb::Status Delete(const rocksdb::WriteOptions &options, rocksdb::ColumnFamilyHandle *cf_handle,
                                        const rocksdb::Slice &key);
   [[nodiscard]] rocksdb::Status DeleteRange(const std::string &first_key, const std::string &last_key);
+  // Delete the keys in [begin_key, end_key) from all column families which store the user data,
+  // or all keys of them if the range is empty.
+  [[nodiscard]] rocksdb::Status DeleteRangeOfDataCFs(const std::string &begin_key, const std::string &end_key);
   [[nodiscard]] rocksdb::Status FlushScripts(const rocksdb::WriteOptions &options,
                                              rocksdb::ColumnFamilyHandle *cf_handle);
   bool WALHasNewData(rocksdb::SequenceNumber seq) { return seq <= LatestSeqNumber(); }
@@ -255,6 +301,8 @@ class Storage {
   /// Get the column family handle by the column family id.
   rocksdb::ColumnFamilyHandle *GetCFHandle(ColumnFamilyID id);
   std::vector<rocksdb::ColumnFamilyHandle *> *GetCFHandles() { return &cf_handles_; }
+  /// Get the handles of the column families which store the user data, including the search indexes of the keys.
+  std::vector<rocksdb::ColumnFamilyHandle *> GetDataCFHandles();
   LockManager *GetLockManager() { return &lock_mgr_; }
   void PurgeOldBackups(uint32_t num_backups_to_keep, uint32_t backup_max_keep_hours);
   uint64_t GetTotalSize(const std::string &ns = kDefaultNamespace);
@@ -262,11 +310,25 @@ class Storage {
   bool ReachedDBSizeLimit() { return db_size_limit_reached_; }
   void SetDBSizeLimit(bool limit) { db_size_limit_reached_ = limit; }
   void SetIORateLimit(int64_t max_io_mb);
+  // Dump the blocks of this DB in the block cache to the file, which would be loaded on the next start
+  Status DumpBlockCache();
+  const BlockCacheDumpInfo &GetBlockCacheDumpInfo() const { return block_cache_dump_info_; }
 
   std::shared_lock<std::shared_mutex> ReadLockGuard();
   std::unique_lock<std::shared_mutex> WriteLockGuard();
 
   bool IsSlotIdEncoded() const { return config_->slot_id_encoded; }
+  // Translate the namespace name into the compact id which is stored in keys instead of the name
+  // if `namespace-id-encoding` is enabled. The lookup never assigns ids, a namespace without the id
+  // is returned as it is, so is an encoded namespace.
+  std::string EncodeNamespace(std::string ns);
+  // Translate the namespace in keys back to its name
+  std::string DecodeNamespace(const rocksdb::Slice &ns);
+  // Assign the id to the namespace if it has none. The ids are only assigned on the master when namespaces
+  // are added, and replicated to replicas which never assign ids by themselves.
+  Status AssignNamespaceID(const std::string &ns);
+  // Reload the ids after the id records are changed by the replication
+  Status ReloadNamespaceIDs();
   Config *GetConfig() const { return config_; }
 
   const DBStats *GetDBStats() const { return db_stats_.get(); }
@@ -335,6 +397,8 @@ class Storage {
   std::mutex checkpoint_mu_;
   Config *config_ = nullptr;
   std::vector<rocksdb::ColumnFamilyHandle *> cf_handles_;
+  // the staging column family of the sub key encoding conversion, see convertSubkeyEncoding
+  rocksdb::ColumnFamilyHandle *subkey_convert_cf_ = nullptr;
   LockManager lock_mgr_;
   std::atomic<bool> db_size_limit_reached_{false};
 
@@ -345,6 +409,13 @@ class Storage {
 
   std::atomic<bool> db_in_retryable_io_error_{false};
 
+  std::shared_ptr<rocksdb::Cache> block_cache_;
+  std::mutex block_cache_dump_mu_;
+  BlockCacheDumpInfo block_cache_dump_info_;
+  std::shared_ptr<rocksdb::SecondaryCache> prewarm_cache_;
+  std::thread block_cache_prewarm_thread_;
+  std::atomic<bool> block_cache_prewarm_stop_ = false;
+
   std::atomic<bool> is_txn_mode_ = false;
   // txn_write_batch_ is used as the global write batch for the transaction mode,
   // all writes will be grouped in this write batch when entering the transaction mode,
@@ -355,8 +426,31 @@ class Storage {
   std::unique_ptr<rocksdb::WriteBatchWithIndex> txn_write_batch_;
 
   rocksdb::WriteOptions default_write_opts_ = rocksdb::WriteOptions();
-
+  rocksdb::WriteOptions wal_disabled_write_opts_ = rocksdb::WriteOptions();
+  std::shared_mutex wal_disabled_namespaces_mu_;
+  std::set<std::string> wal_disabled_namespaces_;
+  std::atomic<bool> has_wal_disabled_namespaces_ = false;
+  std::atomic<bool> has_wal_disabled_writes_ = false;
+  std::atomic<rocksdb::SequenceNumber> wal_gap_seq_ = 0;
+
+  std::shared_mutex namespace_ids_mu_;
+  // namespace name -> encoded id, and the reverse
+  std::unordered_map<std::string, std::string> namespace_ids_;
+  std::unordered_map<std::string, std::string> namespace_names_;
+  uint32_t max_namespace_id_ = 0;
+
+  std::string blockCacheDumpPath() const;
+  void startBlockCachePrewarm(const std::shared_ptr<rocksdb::SecondaryCache> &secondary_cache,
+                              const rocksdb::BlockBasedTableOptions &table_options);
+  void stopBlockCachePrewarm();
   rocksdb::Status writeToDB(const rocksdb::WriteOptions &options, rocksdb::WriteBatch *updates);
+  Status checkSubkeyEncoding(bool read_only);
+  bool isSubkeyCFsEmpty();
+  Status clearColumnFamily(rocksdb::ColumnFamilyHandle *cf_handle, rocksdb::WriteBatch *batch);
+  Status convertSubkeyEncoding(uint8_t from, uint8_t to);
+  Status dropSubkeyConvertCF();
+  Status checkNamespaceIDEncoding(bool read_only);
+  Status loadNamespaceIDs();
   void recordKeyspaceStat(const rocksdb::ColumnFamilyHandle *column_family, const rocksdb::Status &s);
 };
 
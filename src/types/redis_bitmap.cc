@@ -224,7 +224,7 @@ rocksdb::Status Bitmap::SetBit(const Slice &user_key, uint32_t bit_offset, bool
     metadata.Encode(&bytes);
     batch->Put(metadata_cf_handle_, ns_key, bytes);
   }
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Bitmap::BitCount(const Slice &user_key, int64_t start, int64_t stop, bool is_bit_index, uint32_t *cnt) {
@@ -495,7 +495,7 @@ rocksdb::Status Bitmap::BitOp(BitOpFlags op_flag, const std::string &op_name, co
   if (max_bitmap_size == 0) {
     /* Compute the bit operation, if all bitmap is empty. cleanup the dest bitmap. */
     batch->Delete(metadata_cf_handle_, ns_key);
-    return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+    return storage_->Write(writeOptions(), batch->GetWriteBatch());
   }
   std::vector<std::string> log_args = {std::to_string(kRedisCmdBitOp), op_name};
   for (const auto &op_key : op_keys) {
@@ -653,7 +653,7 @@ rocksdb::Status Bitmap::BitOp(BitOpFlags op_flag, const std::string &op_name, co
   res_metadata.Encode(&bytes);
   batch->Put(metadata_cf_handle_, ns_key, bytes);
   *len = static_cast<int64_t>(max_bitmap_size);
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 // SegmentCacheStore is used to read segments from storage.
@@ -856,7 +856,7 @@ rocksdb::Status Bitmap::bitfield(const Slice &user_key, const std::vector<Bitfie
     auto batch = storage_->GetWriteBatchBase();
     if (bitfieldWriteAheadLog(batch, ops)) {
       cache.BatchForFlush(batch);
-      return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+      return storage_->Write(writeOptions(), batch->GetWriteBatch());
     }
   }
   return rocksdb::Status::OK();
@@ -61,7 +61,7 @@ rocksdb::Status BitmapString::SetBit(const Slice &ns_key, std::string *raw_value
   WriteBatchLogData log_data(kRedisString);
   batch->PutLogData(log_data.Encode());
   batch->Put(metadata_cf_handle_, ns_key, *raw_value);
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status BitmapString::BitCount(const std::string &raw_value, int64_t start, int64_t stop, bool is_bit_index,
@@ -260,7 +260,7 @@ rocksdb::Status BitmapString::Bitfield(const Slice &ns_key, std::string *raw_val
   batch->PutLogData(log_data.Encode());
   batch->Put(metadata_cf_handle_, ns_key, *raw_value);
 
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status BitmapString::BitfieldReadOnly(const Slice &ns_key, const std::string &raw_value,
@@ -91,7 +91,7 @@ rocksdb::Status BloomChain::createBloomChain(const Slice &ns_key, double error_r
   std::string bf_key = getBFKey(ns_key, *metadata, metadata->n_filters - 1);
   batch->Put(bf_key, block_split_bloom_filter.GetData());
 
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 void BloomChain::createBloomFilterInBatch(const Slice &ns_key, BloomChainMetadata *metadata,
@@ -221,7 +221,7 @@ rocksdb::Status BloomChain::InsertCommon(const Slice &user_key, const std::vecto
     batch->Put(metadata_cf_handle_, ns_key, bloom_chain_metadata_bytes);
     batch->Put(bf_key_list.back(), bf_data_list.back().ToStringView());
   }
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status BloomChain::Exists(const Slice &user_key, const std::string &item, bool *exist) {
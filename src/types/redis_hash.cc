@@ -26,6 +26,7 @@
 #include <cctype>
 #include <cmath>
 #include <random>
+#include <unordered_map>
 #include <utility>
 
 #include "db_util.h"
@@ -38,6 +39,52 @@ rocksdb::Status Hash::GetMetadata(Database::GetOptions get_options, const Slice
   return Database::GetMetadata(get_options, {kRedisHash}, ns_key, metadata);
 }
 
+rocksdb::Status Hash::DecodeFieldValue(const HashMetadata &metadata, const Slice &raw_value, std::string *value,
+                                       uint64_t *expire) {
+  Slice field_value;
+  uint64_t field_expire = 0;
+  if (!metadata.DecodeFieldValue(raw_value, &field_value, &field_expire)) {
+    return rocksdb::Status::Corruption("the value of hash field is too short");
+  }
+  if (IsFieldExpired(field_expire)) {
+    return rocksdb::Status::NotFound("the hash field was expired");
+  }
+  if (value) *value = field_value.ToString();
+  if (expire) *expire = field_expire;
+  return rocksdb::Status::OK();
+}
+
+WriteBatchLogData Hash::logData(const HashMetadata &metadata) {
+  // mark the batch so that the extractor knows values of subkeys are prefixed with the expire timestamp
+  if (metadata.IsFieldExpirationEnabled()) {
+    return WriteBatchLogData(kRedisHash, {std::to_string(kRedisCmdHExpire)});
+  }
+  return WriteBatchLogData(kRedisHash);
+}
+
+rocksdb::Status Hash::enableFieldExpiration(rocksdb::WriteBatchBase *batch, const Slice &ns_key,
+                                            HashMetadata *metadata,
+                                            const std::unordered_set<std::string_view> &skip_fields) {
+  std::string prefix_key = InternalKey(ns_key, "", metadata->version, storage_->IsSlotIdEncoded()).Encode();
+  std::string next_version_prefix_key =
+      InternalKey(ns_key, "", metadata->version + 1, storage_->IsSlotIdEncoded()).Encode();
+
+  rocksdb::ReadOptions read_options = storage_->DefaultScanOptions();
+  rocksdb::Slice upper_bound(next_version_prefix_key);
+  read_options.iterate_upper_bound = &upper_bound;
+
+  metadata->field_encoding = HashSubkeyEncoding::VALUE_WITH_TTL;
+  std::string encoded_value;
+  auto iter = util::UniqueIterator(storage_, read_options);
+  for (iter->Seek(prefix_key); iter->Valid() && iter->key().starts_with(prefix_key); iter->Next()) {
+    InternalKey ikey(iter->key(), storage_->IsSlotIdEncoded());
+    if (skip_fields.count(ikey.GetSubKey().ToStringView()) > 0) continue;
+    metadata->EncodeFieldValue(iter->value(), 0, &encoded_value);
+    batch->Put(iter->key(), encoded_value);
+  }
+  return iter->status();
+}
+
 rocksdb::Status Hash::Size(const Slice &user_key, uint64_t *size) {
   *size = 0;
 
@@ -45,6 +92,8 @@ rocksdb::Status Hash::Size(const Slice &user_key, uint64_t *size) {
   HashMetadata metadata(false);
   rocksdb::Status s = GetMetadata(Database::GetOptions{}, ns_key, &metadata);
   if (!s.ok()) return s;
+  // the size also counts the expired fields which are not overwritten or deleted yet, which is an upper bound
+  // of the alive fields. The expired fields are filtered on read and dropped by the compaction instead.
   *size = metadata.size;
   return rocksdb::Status::OK();
 }
@@ -58,7 +107,14 @@ rocksdb::Status Hash::Get(const Slice &user_key, const Slice &field, std::string
   rocksdb::ReadOptions read_options;
   read_options.snapshot = ss.GetSnapShot();
   std::string sub_key = InternalKey(ns_key, field, metadata.version, storage_->IsSlotIdEncoded()).Encode();
-  return storage_->Get(read_options, sub_key, value);
+  if (!metadata.IsFieldExpirationEnabled()) {
+    return storage_->Get(read_options, sub_key, value);
+  }
+
+  std::string raw_value;
+  s = storage_->Get(read_options, sub_key, &raw_value);
+  if (!s.ok()) return s;
+  return DecodeFieldValue(metadata, raw_value, value);
 }
 
 rocksdb::Status Hash::IncrBy(const Slice &user_key, const Slice &field, int64_t increment, int64_t *new_value) {
@@ -72,11 +128,18 @@ rocksdb::Status Hash::IncrBy(const Slice &user_key, const Slice &field, int64_t
   rocksdb::Status s = GetMetadata(GetOptions{}, ns_key, &metadata);
   if (!s.ok() && !s.IsNotFound()) return s;
 
+  uint64_t expire = 0;
   std::string sub_key = InternalKey(ns_key, field, metadata.version, storage_->IsSlotIdEncoded()).Encode();
   if (s.ok()) {
-    std::string value_bytes;
-    s = storage_->Get(rocksdb::ReadOptions(), sub_key, &value_bytes);
+    std::string raw_value, value_bytes;
+    s = storage_->Get(rocksdb::ReadOptions(), sub_key, &raw_value);
     if (!s.ok() && !s.IsNotFound()) return s;
+    if (s.ok()) {
+      // an expired field still occupies the size until it's overwritten
+      exists = true;
+      s = DecodeFieldValue(metadata, raw_value, &value_bytes, &expire);
+      if (!s.ok() && !s.IsNotFound()) return s;
+    }
     if (s.ok()) {
       auto parse_result = ParseInt<int64_t>(value_bytes, 10);
       if (!parse_result) {
@@ -86,7 +149,6 @@ rocksdb::Status Hash::IncrBy(const Slice &user_key, const Slice &field, int64_t
         return rocksdb::Status::InvalidArgument("value is not an integer");
       }
       old_value = *parse_result;
-      exists = true;
     }
   }
   if ((increment < 0 && old_value < 0 && increment < (LLONG_MIN - old_value)) ||
@@ -96,16 +158,18 @@ rocksdb::Status Hash::IncrBy(const Slice &user_key, const Slice &field, int64_t
 
   *new_value = old_value + increment;
   auto batch = storage_->GetWriteBatchBase();
-  WriteBatchLogData log_data(kRedisHash);
+  WriteBatchLogData log_data = logData(metadata);
   batch->PutLogData(log_data.Encode());
-  batch->Put(sub_key, std::to_string(*new_value));
+  std::string encoded_value;
+  metadata.EncodeFieldValue(std::to_string(*new_value), expire, &encoded_value);
+  batch->Put(sub_key, encoded_value);
   if (!exists) {
     metadata.size += 1;
     std::string bytes;
     metadata.Encode(&bytes);
     batch->Put(metadata_cf_handle_, ns_key, bytes);
   }
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Hash::IncrByFloat(const Slice &user_key, const Slice &field, double increment, double *new_value) {
@@ -119,18 +183,24 @@ rocksdb::Status Hash::IncrByFloat(const Slice &user_key, const Slice &field, dou
   rocksdb::Status s = GetMetadata(GetOptions{}, ns_key, &metadata);
   if (!s.ok() && !s.IsNotFound()) return s;
 
+  uint64_t expire = 0;
   std::string sub_key = InternalKey(ns_key, field, metadata.version, storage_->IsSlotIdEncoded()).Encode();
   if (s.ok()) {
-    std::string value_bytes;
-    s = storage_->Get(rocksdb::ReadOptions(), sub_key, &value_bytes);
+    std::string raw_value, value_bytes;
+    s = storage_->Get(rocksdb::ReadOptions(), sub_key, &raw_value);
     if (!s.ok() && !s.IsNotFound()) return s;
+    if (s.ok()) {
+      // an expired field still occupies the size until it's overwritten
+      exists = true;
+      s = DecodeFieldValue(metadata, raw_value, &value_bytes, &expire);
+      if (!s.ok() && !s.IsNotFound()) return s;
+    }
     if (s.ok()) {
       auto value_stat = ParseFloat(value_bytes);
       if (!value_stat || isspace(value_bytes[0])) {
         return rocksdb::Status::InvalidArgument("value is not a number");
       }
       old_value = *value_stat;
-      exists = true;
     }
   }
   double n = old_value + increment;
@@ -140,16 +210,18 @@ rocksdb::Status Hash::IncrByFloat(const Slice &user_key, const Slice &field, dou
 
   *new_value = n;
   auto batch = storage_->GetWriteBatchBase();
-  WriteBatchLogData log_data(kRedisHash);
+  WriteBatchLogData log_data = logData(metadata);
   batch->PutLogData(log_data.Encode());
-  batch->Put(sub_key, std::to_string(*new_value));
+  std::string encoded_value;
+  metadata.EncodeFieldValue(std::to_string(*new_value), expire, &encoded_value);
+  batch->Put(sub_key, encoded_value);
   if (!exists) {
     metadata.size += 1;
     std::string bytes;
     metadata.Encode(&bytes);
     batch->Put(metadata_cf_handle_, ns_key, bytes);
   }
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Hash::MGet(const Slice &user_key, const std::vector<Slice> &fields, std::vector<std::string> *values,
@@ -168,15 +240,8 @@ rocksdb::Status Hash::MGet(const Slice &user_key, const std::vector<Slice> &fiel
   rocksdb::ReadOptions read_options = storage_->DefaultMultiGetOptions();
   read_options.snapshot = ss.GetSnapShot();
   std::vector<rocksdb::Slice> keys;
-
-  keys.reserve(fields.size());
-  std::vector<std::string> sub_keys;
-  sub_keys.resize(fields.size());
-  for (size_t i = 0; i < fields.size(); i++) {
-    auto &field = fields[i];
-    sub_keys[i] = InternalKey(ns_key, field, metadata.version, storage_->IsSlotIdEncoded()).Encode();
-    keys.emplace_back(sub_keys[i]);
-  }
+  std::string keys_arena;
+  InternalKeyEncoder(ns_key, metadata.version, storage_->IsSlotIdEncoded()).EncodeAll(fields, &keys_arena, &keys);
 
   std::vector<rocksdb::PinnableSlice> values_vector;
   values_vector.resize(keys.size());
@@ -186,6 +251,14 @@ rocksdb::Status Hash::MGet(const Slice &user_key, const std::vector<Slice> &fiel
                      values_vector.data(), statuses_vector.data());
   for (size_t i = 0; i < keys.size(); i++) {
     if (!statuses_vector[i].ok() && !statuses_vector[i].IsNotFound()) return statuses_vector[i];
+    if (statuses_vector[i].ok() && metadata.IsFieldExpirationEnabled()) {
+      std::string value;
+      s = DecodeFieldValue(metadata, values_vector[i], &value);
+      if (!s.ok() && !s.IsNotFound()) return s;
+      values->emplace_back(std::move(value));
+      statuses->emplace_back(s);
+      continue;
+    }
     values->emplace_back(values_vector[i].ToString());
     statuses->emplace_back(statuses_vector[i]);
   }
@@ -201,34 +274,39 @@ rocksdb::Status Hash::Delete(const Slice &user_key, const std::vector<Slice> &fi
   std::string ns_key = AppendNamespacePrefix(user_key);
 
   HashMetadata metadata(false);
-  auto batch = storage_->GetWriteBatchBase();
-  WriteBatchLogData log_data(kRedisHash);
-  batch->PutLogData(log_data.Encode());
   LockGuard guard(storage_->GetLockManager(), ns_key);
   rocksdb::Status s = GetMetadata(GetOptions{}, ns_key, &metadata);
   if (!s.ok()) return s.IsNotFound() ? rocksdb::Status::OK() : s;
 
+  auto batch = storage_->GetWriteBatchBase();
+  WriteBatchLogData log_data = logData(metadata);
+  batch->PutLogData(log_data.Encode());
+
+  uint64_t removed_cnt = 0;
   std::string value;
   std::unordered_set<std::string_view> field_set;
+  InternalKeyEncoder sub_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
   for (const auto &field : fields) {
     if (!field_set.emplace(field.ToStringView()).second) {
       continue;
     }
-    std::string sub_key = InternalKey(ns_key, field, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice sub_key = sub_key_encoder.Encode(field);
     s = storage_->Get(rocksdb::ReadOptions(), sub_key, &value);
     if (s.ok()) {
-      *deleted_cnt += 1;
+      // expired fields are removed as well, but they are not counted in the reply
+      removed_cnt += 1;
+      if (DecodeFieldValue(metadata, value, nullptr).ok()) *deleted_cnt += 1;
       batch->Delete(sub_key);
     }
   }
-  if (*deleted_cnt == 0) {
+  if (removed_cnt == 0) {
     return rocksdb::Status::OK();
   }
-  metadata.size -= *deleted_cnt;
+  metadata.size -= removed_cnt;
   std::string bytes;
   metadata.Encode(&bytes);
   batch->Put(metadata_cf_handle_, ns_key, bytes);
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Hash::MSet(const Slice &user_key, const std::vector<FieldValue> &field_values, bool nx,
@@ -241,45 +319,68 @@ rocksdb::Status Hash::MSet(const Slice &user_key, const std::vector<FieldValue>
   rocksdb::Status s = GetMetadata(GetOptions{}, ns_key, &metadata);
   if (!s.ok() && !s.IsNotFound()) return s;
 
+  std::unordered_map<std::string_view, std::string> existing_fields;
+  if (metadata.size > 0) {
+    std::vector<std::string_view> fields;
+    fields.reserve(field_values.size());
+    for (const auto &fv : field_values) fields.emplace_back(fv.field);
+    s = getSubKeyValues(ns_key, metadata.version, std::move(fields), &existing_fields);
+    if (!s.ok()) return s;
+  }
+
   int added = 0;
+  int size_delta = 0;
   auto batch = storage_->GetWriteBatchBase();
-  WriteBatchLogData log_data(kRedisHash);
+  WriteBatchLogData log_data = logData(metadata);
   batch->PutLogData(log_data.Encode());
   std::unordered_set<std::string_view> field_set;
+  std::string encoded_value;
+  InternalKeyEncoder sub_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
   for (auto it = field_values.rbegin(); it != field_values.rend(); it++) {
     if (!field_set.insert(it->field).second) {
       continue;
     }
 
     bool exists = false;
-    std::string sub_key = InternalKey(ns_key, it->field, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice sub_key = sub_key_encoder.Encode(it->field);
 
-    if (metadata.size > 0) {
+    if (auto iter = existing_fields.find(it->field); iter != existing_fields.end()) {
+      const std::string &raw_value = iter->second;
       std::string field_value;
-      s = storage_->Get(rocksdb::ReadOptions(), sub_key, &field_value);
+      uint64_t expire = 0;
+      s = DecodeFieldValue(metadata, raw_value, &field_value, &expire);
       if (!s.ok() && !s.IsNotFound()) return s;
 
+      // an expired field is regarded as a new field, but it still occupies the size
       if (s.ok()) {
-        if (nx || field_value == it->value) continue;
+        // setting the field will also clear its TTL
+        if (nx || (field_value == it->value && expire == 0)) continue;
 
+        exists = true;
+      } else {
+        added++;
         exists = true;
       }
     }
 
-    if (!exists) added++;
+    if (!exists) {
+      added++;
+      size_delta++;
+    }
 
-    batch->Put(sub_key, it->value);
+    metadata.EncodeFieldValue(it->value, 0, &encoded_value);
+    batch->Put(sub_key, encoded_value);
   }
 
-  if (added > 0) {
-    *added_cnt = added;
-    metadata.size += added;
+  *added_cnt = added;
+  if (size_delta > 0) {
+    metadata.size += size_delta;
     std::string bytes;
     metadata.Encode(&bytes);
     batch->Put(metadata_cf_handle_, ns_key, bytes);
   }
 
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Hash::RangeByLex(const Slice &user_key, const RangeLexSpec &spec,
@@ -333,9 +434,13 @@ rocksdb::Status Hash::RangeByLex(const Slice &user_key, const RangeLexSpec &spec
           (!spec.max_infinite && ikey.GetSubKey().ToString() > spec.max))
         break;
     }
+    std::string value;
+    s = DecodeFieldValue(metadata, iter->value(), &value);
+    if (s.IsNotFound()) continue;
+    if (!s.ok()) return s;
     if (spec.offset >= 0 && pos++ < spec.offset) continue;
 
-    field_values->emplace_back(ikey.GetSubKey().ToString(), iter->value().ToString());
+    field_values->emplace_back(ikey.GetSubKey().ToString(), std::move(value));
     if (spec.count > 0 && field_values->size() >= static_cast<unsigned>(spec.count)) break;
   }
   return rocksdb::Status::OK();
@@ -360,15 +465,20 @@ rocksdb::Status Hash::GetAll(const Slice &user_key, std::vector<FieldValue> *fie
   read_options.iterate_upper_bound = &upper_bound;
 
   auto iter = util::UniqueIterator(storage_, read_options);
+  std::string value;
   for (iter->Seek(prefix_key); iter->Valid() && iter->key().starts_with(prefix_key); iter->Next()) {
+    s = DecodeFieldValue(metadata, iter->value(), type == HashFetchType::kOnlyKey ? nullptr : &value);
+    if (s.IsNotFound()) continue;
+    if (!s.ok()) return s;
+
     if (type == HashFetchType::kOnlyKey) {
       InternalKey ikey(iter->key(), storage_->IsSlotIdEncoded());
       field_values->emplace_back(ikey.GetSubKey().ToString(), "");
     } else if (type == HashFetchType::kOnlyValue) {
-      field_values->emplace_back("", iter->value().ToString());
+      field_values->emplace_back("", std::move(value));
     } else {
       InternalKey ikey(iter->key(), storage_->IsSlotIdEncoded());
-      field_values->emplace_back(ikey.GetSubKey().ToString(), iter->value().ToString());
+      field_values->emplace_back(ikey.GetSubKey().ToString(), std::move(value));
     }
   }
   return rocksdb::Status::OK();
@@ -377,7 +487,204 @@ rocksdb::Status Hash::GetAll(const Slice &user_key, std::vector<FieldValue> *fie
 rocksdb::Status Hash::Scan(const Slice &user_key, const std::string &cursor, uint64_t limit,
                            const std::string &field_prefix, std::vector<std::string> *fields,
                            std::vector<std::string> *values) {
-  return SubKeyScanner::Scan(kRedisHash, user_key, cursor, limit, field_prefix, fields, values);
+  std::string ns_key = AppendNamespacePrefix(user_key);
+  HashMetadata metadata(false);
+  LatestSnapShot ss(storage_);
+  rocksdb::Status s = GetMetadata(GetOptions{ss.GetSnapShot()}, ns_key, &metadata);
+  if (!s.ok()) return s;
+  if (!metadata.IsFieldExpirationEnabled()) {
+    return SubKeyScanner::Scan(kRedisHash, user_key, cursor, limit, field_prefix, fields, values);
+  }
+
+  // skip the expired fields, so the limit only counts alive fields
+  uint64_t cnt = 0;
+  std::string match_prefix_key =
+      InternalKey(ns_key, field_prefix, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+  std::string start_key = cursor.empty()
+                              ? match_prefix_key
+                              : InternalKey(ns_key, cursor, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+
+  rocksdb::ReadOptions read_options = storage_->DefaultScanOptions();
+  read_options.snapshot = ss.GetSnapShot();
+  auto iter = util::UniqueIterator(storage_, read_options);
+  std::string value;
+  for (iter->Seek(start_key); iter->Valid(); iter->Next()) {
+    if (!cursor.empty() && iter->key() == start_key) continue;
+    if (!iter->key().starts_with(match_prefix_key)) break;
+
+    s = DecodeFieldValue(metadata, iter->value(), &value);
+    if (s.IsNotFound()) continue;
+    if (!s.ok()) return s;
+
+    InternalKey ikey(iter->key(), storage_->IsSlotIdEncoded());
+    fields->emplace_back(ikey.GetSubKey().ToString());
+    if (values != nullptr) {
+      values->emplace_back(std::move(value));
+    }
+    cnt++;
+    if (limit > 0 && cnt >= limit) break;
+  }
+  return iter->status();
+}
+
+rocksdb::Status Hash::ExpireFields(const Slice &user_key, uint64_t expire, const std::vector<Slice> &fields,
+                                   HashFieldExpireFlag flag, std::vector<int64_t> *results) {
+  results->clear();
+  std::string ns_key = AppendNamespacePrefix(user_key);
+
+  LockGuard guard(storage_->GetLockManager(), ns_key);
+  HashMetadata metadata(false);
+  rocksdb::Status s = GetMetadata(GetOptions{}, ns_key, &metadata);
+  if (!s.ok()) return s;
+
+  struct FieldUpdate {
+    std::string sub_key;
+    std::string value;
+  };
+  std::vector<FieldUpdate> updates;
+  std::vector<std::string> deleted_sub_keys;
+  std::unordered_map<std::string_view, int64_t> processed;
+  std::unordered_set<std::string_view> touched_fields;
+  uint64_t now = util::GetTimeStampMS();
+  for (const auto &field : fields) {
+    if (auto iter = processed.find(field.ToStringView()); iter != processed.end()) {
+      results->emplace_back(iter->second);
+      continue;
+    }
+
+    std::string sub_key = InternalKey(ns_key, field, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    std::string raw_value, value;
+    uint64_t field_expire = 0;
+    s = storage_->Get(rocksdb::ReadOptions(), sub_key, &raw_value);
+    if (s.ok()) s = DecodeFieldValue(metadata, raw_value, &value, &field_expire);
+    if (!s.ok() && !s.IsNotFound()) return s;
+
+    int64_t result = kHashFieldUpdated;
+    if (s.IsNotFound()) {
+      result = kHashFieldNotExist;
+    } else if ((flag == HashFieldExpireFlag::kNX && field_expire != 0) ||
+               (flag == HashFieldExpireFlag::kXX && field_expire == 0) ||
+               (flag == HashFieldExpireFlag::kGT && (field_expire == 0 || expire <= field_expire)) ||
+               (flag == HashFieldExpireFlag::kLT && field_expire != 0 && expire >= field_expire)) {
+      result = kHashFieldConditionNotMet;
+    } else if (expire <= now) {
+      result = kHashFieldDeleted;
+      deleted_sub_keys.emplace_back(std::move(sub_key));
+      touched_fields.emplace(field.ToStringView());
+    } else {
+      updates.push_back({std::move(sub_key), std::move(value)});
+      touched_fields.emplace(field.ToStringView());
+    }
+    processed.emplace(field.ToStringView(), result);
+    results->emplace_back(result);
+  }
+  if (updates.empty() && deleted_sub_keys.empty()) {
+    return rocksdb::Status::OK();
+  }
+
+  auto batch = storage_->GetWriteBatchBase();
+  bool metadata_changed = !deleted_sub_keys.empty();
+  if (!updates.empty() && !metadata.IsFieldExpirationEnabled()) {
+    // the first TTL on this hash, all existing values need to be rewritten with the new encoding
+    WriteBatchLogData log_data(kRedisHash, {std::to_string(kRedisCmdHExpire)});
+    batch->PutLogData(log_data.Encode());
+    s = enableFieldExpiration(batch.Get(), ns_key, &metadata, touched_fields);
+    if (!s.ok()) return s;
+    metadata_changed = true;
+  } else {
+    WriteBatchLogData log_data = logData(metadata);
+    batch->PutLogData(log_data.Encode());
+  }
+
+  std::string encoded_value;
+  for (const auto &update : updates) {
+    metadata.EncodeFieldValue(update.value, expire, &encoded_value);
+    batch->Put(update.sub_key, encoded_value);
+  }
+  for (const auto &sub_key : deleted_sub_keys) {
+    batch->Delete(sub_key);
+  }
+  if (metadata_changed) {
+    metadata.size -= deleted_sub_keys.size();
+    std::string bytes;
+    metadata.Encode(&bytes);
+    batch->Put(metadata_cf_handle_, ns_key, bytes);
+  }
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
+}
+
+rocksdb::Status Hash::PersistFields(const Slice &user_key, const std::vector<Slice> &fields,
+                                    std::vector<int64_t> *results) {
+  results->clear();
+  std::string ns_key = AppendNamespacePrefix(user_key);
+
+  LockGuard guard(storage_->GetLockManager(), ns_key);
+  HashMetadata metadata(false);
+  rocksdb::Status s = GetMetadata(GetOptions{}, ns_key, &metadata);
+  if (!s.ok()) return s;
+
+  auto batch = storage_->GetWriteBatchBase();
+  WriteBatchLogData log_data = logData(metadata);
+  batch->PutLogData(log_data.Encode());
+
+  bool persisted = false;
+  std::string encoded_value;
+  std::unordered_set<std::string_view> field_set;
+  InternalKeyEncoder sub_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
+  for (const auto &field : fields) {
+    Slice sub_key = sub_key_encoder.Encode(field);
+    std::string raw_value, value;
+    uint64_t field_expire = 0;
+    s = storage_->Get(rocksdb::ReadOptions(), sub_key, &raw_value);
+    if (s.ok()) s = DecodeFieldValue(metadata, raw_value, &value, &field_expire);
+    if (!s.ok() && !s.IsNotFound()) return s;
+
+    if (s.IsNotFound()) {
+      results->emplace_back(kHashFieldNotExist);
+    } else if (field_expire == 0 || !field_set.emplace(field.ToStringView()).second) {
+      results->emplace_back(kHashFieldNoTTL);
+    } else {
+      metadata.EncodeFieldValue(value, 0, &encoded_value);
+      batch->Put(sub_key, encoded_value);
+      persisted = true;
+      results->emplace_back(kHashFieldUpdated);
+    }
+  }
+  if (!persisted) {
+    return rocksdb::Status::OK();
+  }
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
+}
+
+rocksdb::Status Hash::GetFieldsExpireTime(const Slice &user_key, const std::vector<Slice> &fields,
+                                          std::vector<int64_t> *expire_times) {
+  expire_times->clear();
+  std::string ns_key = AppendNamespacePrefix(user_key);
+  HashMetadata metadata(false);
+  LatestSnapShot ss(storage_);
+  rocksdb::Status s = GetMetadata(GetOptions{ss.GetSnapShot()}, ns_key, &metadata);
+  if (!s.ok()) return s;
+
+  rocksdb::ReadOptions read_options;
+  read_options.snapshot = ss.GetSnapShot();
+  InternalKeyEncoder sub_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
+  for (const auto &field : fields) {
+    Slice sub_key = sub_key_encoder.Encode(field);
+    std::string raw_value;
+    uint64_t field_expire = 0;
+    s = storage_->Get(read_options, sub_key, &raw_value);
+    if (s.ok()) s = DecodeFieldValue(metadata, raw_value, nullptr, &field_expire);
+    if (!s.ok() && !s.IsNotFound()) return s;
+
+    if (s.IsNotFound()) {
+      expire_times->emplace_back(kHashFieldNotExist);
+    } else if (field_expire == 0) {
+      expire_times->emplace_back(kHashFieldNoTTL);
+    } else {
+      expire_times->emplace_back(static_cast<int64_t>(field_expire));
+    }
+  }
+  return rocksdb::Status::OK();
 }
 
 rocksdb::Status Hash::RandField(const Slice &user_key, int64_t command_count, std::vector<FieldValue> *field_values,
@@ -393,8 +700,25 @@ rocksdb::Status Hash::RandField(const Slice &user_key, int64_t command_count, st
   std::vector<FieldValue> samples;
   // TODO: Getting all values in Hash might be heavy, consider lazy-loading these values later
   if (count == 0) return rocksdb::Status::OK();
-  s = ExtractRandMemberFromSet<FieldValue>(
-      unique, count,
+  s = ExtractRandMember<FieldValue>(
+      unique, count, metadata.size,
+      [this, &ns_key, &metadata, count, unique, type](std::vector<FieldValue> *elements) {
+        std::vector<std::pair<std::string, std::string>> sub_keys;
+        auto s = this->Sample(
+            ns_key, metadata, count, unique,
+            [&metadata](const Slice &raw_value) { return DecodeFieldValue(metadata, raw_value, nullptr).ok(); },
+            &sub_keys);
+        for (auto &[field, raw_value] : sub_keys) {
+          std::string value;
+          if (type != HashFetchType::kOnlyKey) {
+            auto decode_status = DecodeFieldValue(metadata, raw_value, &value);
+            if (!decode_status.ok()) return decode_status;
+          }
+          if (type == HashFetchType::kOnlyValue) field.clear();
+          elements->emplace_back(std::move(field), std::move(value));
+        }
+        return s;
+      },
       [this, user_key, type](std::vector<FieldValue> *elements) { return this->GetAll(user_key, elements, type); },
       field_values);
   if (!s.ok()) {
@@ -23,10 +23,13 @@
 #include <rocksdb/status.h>
 
 #include <string>
+#include <string_view>
+#include <unordered_set>
 #include <vector>
 
 #include "common/range_spec.h"
 #include "encoding.h"
+#include "time_util.h"
 #include "storage/redis_db.h"
 #include "storage/redis_metadata.h"
 
@@ -39,6 +42,15 @@ struct FieldValue {
 
 enum class HashFetchType { kAll = 0, kOnlyKey = 1, kOnlyValue = 2 };
 
+enum class HashFieldExpireFlag { kNone = 0, kNX, kXX, kGT, kLT };
+
+// the results of HEXPIRE-like commands for every field, which are the same as Redis
+constexpr int64_t kHashFieldNotExist = -2;
+constexpr int64_t kHashFieldNoTTL = -1;
+constexpr int64_t kHashFieldConditionNotMet = 0;
+constexpr int64_t kHashFieldUpdated = 1;
+constexpr int64_t kHashFieldDeleted = 2;
+
 namespace redis {
 
 class Hash : public SubKeyScanner {
@@ -63,9 +75,21 @@ class Hash : public SubKeyScanner {
                        std::vector<std::string> *values = nullptr);
   rocksdb::Status RandField(const Slice &user_key, int64_t command_count, std::vector<FieldValue> *field_values,
                             HashFetchType type = HashFetchType::kOnlyKey);
+  rocksdb::Status ExpireFields(const Slice &user_key, uint64_t expire, const std::vector<Slice> &fields,
+                               HashFieldExpireFlag flag, std::vector<int64_t> *results);
+  rocksdb::Status PersistFields(const Slice &user_key, const std::vector<Slice> &fields, std::vector<int64_t> *results);
+  rocksdb::Status GetFieldsExpireTime(const Slice &user_key, const std::vector<Slice> &fields,
+                                      std::vector<int64_t> *expire_times);
+
+  static bool IsFieldExpired(uint64_t expire) { return expire != 0 && expire <= util::GetTimeStampMS(); }
+  static rocksdb::Status DecodeFieldValue(const HashMetadata &metadata, const Slice &raw_value, std::string *value,
+                                          uint64_t *expire = nullptr);
 
  private:
   rocksdb::Status GetMetadata(Database::GetOptions get_options, const Slice &ns_key, HashMetadata *metadata);
+  rocksdb::Status enableFieldExpiration(rocksdb::WriteBatchBase *batch, const Slice &ns_key, HashMetadata *metadata,
+                                        const std::unordered_set<std::string_view> &skip_fields);
+  static WriteBatchLogData logData(const HashMetadata &metadata);
 
   friend struct FieldValueRetriever;
 };
@@ -51,7 +51,7 @@ rocksdb::Status Json::write(Slice ns_key, JsonMetadata *metadata, const JsonValu
 
   batch->Put(metadata_cf_handle_, ns_key, val);
 
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Json::parse(const JsonMetadata &metadata, const Slice &json_bytes, JsonValue *value) {
@@ -95,7 +95,7 @@ rocksdb::Status Json::del(const Slice &ns_key) {
 
   batch->Delete(metadata_cf_handle_, ns_key);
 
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Json::Info(const std::string &user_key, JsonStorageFormat *storage_format) {
@@ -602,7 +602,7 @@ rocksdb::Status Json::MSet(const std::vector<std::string> &user_keys, const std:
     batch->Put(metadata_cf_handle_, ns_keys[i], val);
   }
 
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 std::vector<rocksdb::Status> Json::readMulti(const std::vector<Slice> &ns_keys, std::vector<JsonValue> &values) {
@@ -66,10 +66,11 @@ rocksdb::Status List::push(const Slice &user_key, const std::vector<Slice> &elem
     return s.IsNotFound() ? rocksdb::Status::OK() : s;
   }
   uint64_t index = left ? metadata.head - 1 : metadata.tail;
+  InternalKeyEncoder sub_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
   for (const auto &elem : elems) {
     std::string index_buf;
     PutFixed64(&index_buf, index);
-    std::string sub_key = InternalKey(ns_key, index_buf, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice sub_key = sub_key_encoder.Encode(index_buf);
     batch->Put(sub_key, elem);
     left ? --index : ++index;
   }
@@ -83,7 +84,7 @@ rocksdb::Status List::push(const Slice &user_key, const std::vector<Slice> &elem
   metadata.Encode(&bytes);
   batch->Put(metadata_cf_handle_, ns_key, bytes);
   *new_size = metadata.size;
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status List::Pop(const Slice &user_key, bool left, std::string *elem) {
@@ -113,11 +114,12 @@ rocksdb::Status List::PopMulti(const rocksdb::Slice &user_key, bool left, uint32
   WriteBatchLogData log_data(kRedisList, {std::to_string(cmd)});
   batch->PutLogData(log_data.Encode());
 
+  InternalKeyEncoder sub_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
   while (metadata.size > 0 && count > 0) {
     uint64_t index = left ? metadata.head : metadata.tail - 1;
     std::string buf;
     PutFixed64(&buf, index);
-    std::string sub_key = InternalKey(ns_key, buf, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice sub_key = sub_key_encoder.Encode(buf);
     std::string elem;
     s = storage_->Get(rocksdb::ReadOptions(), sub_key, &elem);
     if (!s.ok()) {
@@ -140,7 +142,7 @@ rocksdb::Status List::PopMulti(const rocksdb::Slice &user_key, bool left, uint32
     batch->Put(metadata_cf_handle_, ns_key, bytes);
   }
 
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 /*
@@ -250,7 +252,7 @@ rocksdb::Status List::Rem(const Slice &user_key, int count, const Slice &elem, u
   }
 
   *removed_cnt = to_delete_indexes.size();
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status List::Insert(const Slice &user_key, const Slice &pivot, const Slice &elem, bool before, int *new_size) {
@@ -326,7 +328,7 @@ rocksdb::Status List::Insert(const Slice &user_key, const Slice &pivot, const Sl
   batch->Put(metadata_cf_handle_, ns_key, bytes);
 
   *new_size = static_cast<int>(metadata.size);
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status List::Index(const Slice &user_key, int index, std::string *elem) {
@@ -474,7 +476,7 @@ rocksdb::Status List::Set(const Slice &user_key, int index, Slice elem) {
   WriteBatchLogData log_data(kRedisList, {std::to_string(kRedisCmdLSet), std::to_string(index)});
   batch->PutLogData(log_data.Encode());
   batch->Put(sub_key, elem);
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status List::LMove(const rocksdb::Slice &src, const rocksdb::Slice &dst, bool src_left, bool dst_left,
@@ -542,7 +544,7 @@ rocksdb::Status List::lmoveOnSingleList(const rocksdb::Slice &src, bool src_left
   metadata.Encode(&bytes);
   batch->Put(metadata_cf_handle_, ns_key, bytes);
 
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status List::lmoveOnTwoLists(const rocksdb::Slice &src, const rocksdb::Slice &dst, bool src_left,
@@ -605,7 +607,7 @@ rocksdb::Status List::lmoveOnTwoLists(const rocksdb::Slice &src, const rocksdb::
   dst_metadata.Encode(&bytes);
   batch->Put(metadata_cf_handle_, dst_ns_key, bytes);
 
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 // Caution: trim the big list may block the server
@@ -623,7 +625,7 @@ rocksdb::Status List::Trim(const Slice &user_key, int start, int stop) {
   // the result will be empty list when start > stop,
   // or start is larger than the end of list
   if (start > stop) {
-    return storage_->Delete(storage_->DefaultWriteOptions(), metadata_cf_handle_, ns_key);
+    return storage_->Delete(writeOptions(), metadata_cf_handle_, ns_key);
   }
   if (start < 0) start = 0;
 
@@ -633,10 +635,11 @@ rocksdb::Status List::Trim(const Slice &user_key, int start, int stop) {
   batch->PutLogData(log_data.Encode());
   uint64_t left_index = metadata.head + start;
   uint64_t right_index = metadata.head + stop + 1;
+  InternalKeyEncoder sub_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
   for (uint64_t i = metadata.head; i < left_index; i++) {
     std::string buf;
     PutFixed64(&buf, i);
-    std::string sub_key = InternalKey(ns_key, buf, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice sub_key = sub_key_encoder.Encode(buf);
     batch->Delete(sub_key);
     metadata.head++;
     trim_cnt++;
@@ -645,7 +648,7 @@ rocksdb::Status List::Trim(const Slice &user_key, int start, int stop) {
   for (uint64_t i = right_index; i < tail; i++) {
     std::string buf;
     PutFixed64(&buf, i);
-    std::string sub_key = InternalKey(ns_key, buf, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice sub_key = sub_key_encoder.Encode(buf);
     batch->Delete(sub_key);
     metadata.tail--;
     trim_cnt++;
@@ -658,6 +661,6 @@ rocksdb::Status List::Trim(const Slice &user_key, int start, int stop) {
   std::string bytes;
   metadata.Encode(&bytes);
   batch->Put(metadata_cf_handle_, ns_key, bytes);
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 }  // namespace redis
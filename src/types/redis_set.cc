@@ -42,15 +42,16 @@ rocksdb::Status Set::Overwrite(Slice user_key, const std::vector<std::string> &m
   auto batch = storage_->GetWriteBatchBase();
   WriteBatchLogData log_data(kRedisSet);
   batch->PutLogData(log_data.Encode());
+  InternalKeyEncoder sub_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
   for (const auto &member : members) {
-    std::string sub_key = InternalKey(ns_key, member, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice sub_key = sub_key_encoder.Encode(member);
     batch->Put(sub_key, Slice());
   }
   metadata.size = static_cast<uint32_t>(members.size());
   std::string bytes;
   metadata.Encode(&bytes);
   batch->Put(metadata_cf_handle_, ns_key, bytes);
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Set::Add(const Slice &user_key, const std::vector<Slice> &members, uint64_t *added_cnt) {
@@ -63,19 +64,26 @@ rocksdb::Status Set::Add(const Slice &user_key, const std::vector<Slice> &member
   rocksdb::Status s = GetMetadata(Database::GetOptions{}, ns_key, &metadata);
   if (!s.ok() && !s.IsNotFound()) return s;
 
-  std::string value;
+  // no member exists in a new set
+  std::unordered_map<std::string_view, std::string> existing_members;
+  if (metadata.size > 0) {
+    std::vector<std::string_view> member_views;
+    member_views.reserve(members.size());
+    for (const auto &member : members) member_views.emplace_back(member.ToStringView());
+    s = getSubKeyValues(ns_key, metadata.version, std::move(member_views), &existing_members);
+    if (!s.ok()) return s;
+  }
+
   auto batch = storage_->GetWriteBatchBase();
   WriteBatchLogData log_data(kRedisSet);
   batch->PutLogData(log_data.Encode());
   std::unordered_set<std::string_view> mset;
+  InternalKeyEncoder sub_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
   for (const auto &member : members) {
-    if (!mset.insert(member.ToStringView()).second) {
+    if (!mset.insert(member.ToStringView()).second || existing_members.count(member.ToStringView())) {
       continue;
     }
-    std::string sub_key = InternalKey(ns_key, member, metadata.version, storage_->IsSlotIdEncoded()).Encode();
-    s = storage_->Get(rocksdb::ReadOptions(), sub_key, &value);
-    if (s.ok()) continue;
-    batch->Put(sub_key, Slice());
+    batch->Put(sub_key_encoder.Encode(member), Slice());
     *added_cnt += 1;
   }
   if (*added_cnt > 0) {
@@ -84,7 +92,7 @@ rocksdb::Status Set::Add(const Slice &user_key, const std::vector<Slice> &member
     metadata.Encode(&bytes);
     batch->Put(metadata_cf_handle_, ns_key, bytes);
   }
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Set::Remove(const Slice &user_key, const std::vector<Slice> &members, uint64_t *removed_cnt) {
@@ -102,11 +110,12 @@ rocksdb::Status Set::Remove(const Slice &user_key, const std::vector<Slice> &mem
   WriteBatchLogData log_data(kRedisSet);
   batch->PutLogData(log_data.Encode());
   std::unordered_set<std::string_view> mset;
+  InternalKeyEncoder sub_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
   for (const auto &member : members) {
     if (!mset.insert(member.ToStringView()).second) {
       continue;
     }
-    std::string sub_key = InternalKey(ns_key, member, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice sub_key = sub_key_encoder.Encode(member);
     s = storage_->Get(rocksdb::ReadOptions(), sub_key, &value);
     if (!s.ok()) continue;
     batch->Delete(sub_key);
@@ -122,7 +131,7 @@ rocksdb::Status Set::Remove(const Slice &user_key, const std::vector<Slice> &mem
       batch->Delete(metadata_cf_handle_, ns_key);
     }
   }
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Set::Card(const Slice &user_key, uint64_t *size) {
@@ -185,8 +194,9 @@ rocksdb::Status Set::MIsMember(const Slice &user_key, const std::vector<Slice> &
 
   read_options.snapshot = ss.GetSnapShot();
   std::string value;
+  InternalKeyEncoder sub_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
   for (const auto &member : members) {
-    std::string sub_key = InternalKey(ns_key, member, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice sub_key = sub_key_encoder.Encode(member);
     s = storage_->Get(read_options, sub_key, &value);
     if (!s.ok() && !s.IsNotFound()) return s;
     if (s.IsNotFound()) {
@@ -223,9 +233,15 @@ rocksdb::Status Set::Take(const Slice &user_key, std::vector<std::string> *membe
     batch->PutLogData(log_data.Encode());
   }
   members->clear();
-  s = ExtractRandMemberFromSet<std::string>(
-      unique, count, [this, user_key](std::vector<std::string> *samples) { return this->Members(user_key, samples); },
-      members);
+  s = ExtractRandMember<std::string>(
+      unique, count, metadata.size,
+      [this, &ns_key, &metadata, count, unique](std::vector<std::string> *samples) {
+        std::vector<std::pair<std::string, std::string>> sub_keys;
+        auto s = this->Sample(ns_key, metadata, count, unique, nullptr, &sub_keys);
+        for (auto &[member, _] : sub_keys) samples->emplace_back(std::move(member));
+        return s;
+      },
+      [this, user_key](std::vector<std::string> *samples) { return this->Members(user_key, samples); }, members);
   if (!s.ok()) {
     return s;
   }
@@ -233,15 +249,16 @@ rocksdb::Status Set::Take(const Slice &user_key, std::vector<std::string> *membe
   if (!pop) return rocksdb::Status::OK();
   // Avoid to write an empty op-log if the set is empty.
   if (members->empty()) return rocksdb::Status::OK();
+  InternalKeyEncoder sub_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
   for (std::string &user_sub_key : *members) {
-    std::string sub_key = InternalKey(ns_key, user_sub_key, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice sub_key = sub_key_encoder.Encode(user_sub_key);
     batch->Delete(sub_key);
   }
   metadata.size -= members->size();
   std::string bytes;
   metadata.Encode(&bytes);
   batch->Put(metadata_cf_handle_, ns_key, bytes);
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Set::Move(const Slice &src, const Slice &dst, const Slice &member, bool *flag) {
@@ -47,10 +47,11 @@ rocksdb::Status Sortedint::Add(const Slice &user_key, const std::vector<uint64_t
   auto batch = storage_->GetWriteBatchBase();
   WriteBatchLogData log_data(kRedisSortedint);
   batch->PutLogData(log_data.Encode());
+  InternalKeyEncoder sub_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
   for (const auto id : ids) {
     std::string id_buf;
     PutFixed64(&id_buf, id);
-    std::string sub_key = InternalKey(ns_key, id_buf, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice sub_key = sub_key_encoder.Encode(id_buf);
     s = storage_->Get(rocksdb::ReadOptions(), sub_key, &value);
     if (s.ok()) continue;
     batch->Put(sub_key, Slice());
@@ -63,7 +64,7 @@ rocksdb::Status Sortedint::Add(const Slice &user_key, const std::vector<uint64_t
   std::string bytes;
   metadata.Encode(&bytes);
   batch->Put(metadata_cf_handle_, ns_key, bytes);
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Sortedint::Remove(const Slice &user_key, const std::vector<uint64_t> &ids, uint64_t *removed_cnt) {
@@ -80,10 +81,11 @@ rocksdb::Status Sortedint::Remove(const Slice &user_key, const std::vector<uint6
   auto batch = storage_->GetWriteBatchBase();
   WriteBatchLogData log_data(kRedisSortedint);
   batch->PutLogData(log_data.Encode());
+  InternalKeyEncoder sub_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
   for (const auto id : ids) {
     std::string id_buf;
     PutFixed64(&id_buf, id);
-    std::string sub_key = InternalKey(ns_key, id_buf, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice sub_key = sub_key_encoder.Encode(id_buf);
     s = storage_->Get(rocksdb::ReadOptions(), sub_key, &value);
     if (!s.ok()) continue;
     batch->Delete(sub_key);
@@ -94,7 +96,7 @@ rocksdb::Status Sortedint::Remove(const Slice &user_key, const std::vector<uint6
   std::string bytes;
   metadata.Encode(&bytes);
   batch->Put(metadata_cf_handle_, ns_key, bytes);
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Sortedint::Card(const Slice &user_key, uint64_t *size) {
@@ -215,10 +217,11 @@ rocksdb::Status Sortedint::MExist(const Slice &user_key, const std::vector<uint6
   rocksdb::ReadOptions read_options;
   read_options.snapshot = ss.GetSnapShot();
   std::string value;
+  InternalKeyEncoder sub_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
   for (const auto id : ids) {
     std::string id_buf;
     PutFixed64(&id_buf, id);
-    std::string sub_key = InternalKey(ns_key, id_buf, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice sub_key = sub_key_encoder.Encode(id_buf);
     s = storage_->Get(read_options, sub_key, &value);
     if (!s.ok() && !s.IsNotFound()) return s;
     if (s.IsNotFound()) {
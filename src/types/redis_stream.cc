@@ -163,7 +163,7 @@ rocksdb::Status Stream::Add(const Slice &stream_name, const StreamAddOptions &op
 
   *id = next_entry_id;
 
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 std::string Stream::internalKeyFromGroupName(const std::string &ns_key, const StreamMetadata &metadata,
@@ -354,7 +354,7 @@ rocksdb::Status Stream::DeletePelEntries(const Slice &stream_name, const std::st
     std::string group_value = encodeStreamConsumerGroupMetadataValue(group_metadata);
     batch->Put(stream_cf_handle_, group_key, group_value);
   }
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Stream::ClaimPelEntries(const Slice &stream_name, const std::string &group_name,
@@ -486,7 +486,7 @@ rocksdb::Status Stream::ClaimPelEntries(const Slice &stream_name, const std::str
 
   batch->Put(stream_cf_handle_, consumer_key, encodeStreamConsumerMetadataValue(consumer_metadata));
   batch->Put(stream_cf_handle_, group_key, encodeStreamConsumerGroupMetadataValue(group_metadata));
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Stream::CreateGroup(const Slice &stream_name, const StreamXGroupCreateOptions &options,
@@ -538,7 +538,7 @@ rocksdb::Status Stream::CreateGroup(const Slice &stream_name, const StreamXGroup
   std::string metadata_bytes;
   metadata.Encode(&metadata_bytes);
   batch->Put(metadata_cf_handle_, ns_key, metadata_bytes);
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Stream::DestroyGroup(const Slice &stream_name, const std::string &group_name, uint64_t *delete_cnt) {
@@ -588,7 +588,7 @@ rocksdb::Status Stream::DestroyGroup(const Slice &stream_name, const std::string
     batch->Put(metadata_cf_handle_, ns_key, metadata_bytes);
   }
 
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Stream::createConsumerWithoutLock(const Slice &stream_name, const std::string &group_name,
@@ -638,7 +638,7 @@ rocksdb::Status Stream::createConsumerWithoutLock(const Slice &stream_name, cons
   consumer_group_metadata.consumer_number += 1;
   std::string consumer_group_metadata_bytes = encodeStreamConsumerGroupMetadataValue(consumer_group_metadata);
   batch->Put(stream_cf_handle_, entry_key, consumer_group_metadata_bytes);
-  s = storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  s = storage_->Write(writeOptions(), batch->GetWriteBatch());
   if (s.ok()) *created_number = 1;
   return s;
 }
@@ -718,7 +718,7 @@ rocksdb::Status Stream::DestroyConsumer(const Slice &stream_name, const std::str
   group_metadata.consumer_number -= 1;
   group_metadata.pending_number -= deleted_pel;
   batch->Put(stream_cf_handle_, group_key, encodeStreamConsumerGroupMetadataValue(group_metadata));
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Stream::GroupSetId(const Slice &stream_name, const std::string &group_name,
@@ -761,7 +761,7 @@ rocksdb::Status Stream::GroupSetId(const Slice &stream_name, const std::string &
   WriteBatchLogData log_data(kRedisStream);
   batch->PutLogData(log_data.Encode());
   batch->Put(stream_cf_handle_, entry_key, entry_value);
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Stream::DeleteEntries(const Slice &stream_name, const std::vector<StreamEntryID> &ids,
@@ -846,7 +846,7 @@ rocksdb::Status Stream::DeleteEntries(const Slice &stream_name, const std::vecto
     batch->Put(metadata_cf_handle_, ns_key, bytes);
   }
 
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 // If `options` is StreamLenOptions{} the function just returns the number of entries in the stream.
@@ -1360,7 +1360,7 @@ rocksdb::Status Stream::RangeWithPending(const Slice &stream_name, StreamRangeOp
   }
   batch->Put(stream_cf_handle_, group_key, encodeStreamConsumerGroupMetadataValue(consumergroup_metadata));
   batch->Put(stream_cf_handle_, consumer_key, encodeStreamConsumerMetadataValue(consumer_metadata));
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status Stream::Trim(const Slice &stream_name, const StreamTrimOptions &options, uint64_t *delete_cnt) {
@@ -1391,7 +1391,7 @@ rocksdb::Status Stream::Trim(const Slice &stream_name, const StreamTrimOptions &
     metadata.Encode(&bytes);
     batch->Put(metadata_cf_handle_, ns_key, bytes);
 
-    return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+    return storage_->Write(writeOptions(), batch->GetWriteBatch());
   }
 
   return rocksdb::Status::OK();
@@ -1522,7 +1522,7 @@ rocksdb::Status Stream::SetId(const Slice &stream_name, const StreamEntryID &las
   metadata.Encode(&bytes);
   batch->Put(metadata_cf_handle_, ns_key, bytes);
 
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 }  // namespace redis
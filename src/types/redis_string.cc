@@ -108,7 +108,7 @@ rocksdb::Status String::updateRawValue(const std::string &ns_key, const std::str
   WriteBatchLogData log_data(kRedisString);
   batch->PutLogData(log_data.Encode());
   batch->Put(metadata_cf_handle_, ns_key, raw_value);
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status String::Append(const std::string &user_key, const std::string &value, uint64_t *new_size) {
@@ -129,16 +129,21 @@ rocksdb::Status String::Append(const std::string &user_key, const std::string &v
 }
 
 std::vector<rocksdb::Status> String::MGet(const std::vector<Slice> &keys, std::vector<std::string> *values) {
-  std::vector<std::string> ns_keys;
-  ns_keys.reserve(keys.size());
+  // compose all the keys into one arena instead of allocating a string for each of them
+  std::string ns_key, keys_arena;
+  std::vector<size_t> key_ends;
+  key_ends.reserve(keys.size());
   for (const auto &key : keys) {
-    std::string ns_key = AppendNamespacePrefix(key);
-    ns_keys.emplace_back(ns_key);
+    AppendNamespacePrefix(key, &ns_key);
+    keys_arena.append(ns_key);
+    key_ends.emplace_back(keys_arena.size());
   }
   std::vector<Slice> slice_keys;
-  slice_keys.reserve(ns_keys.size());
-  for (const auto &ns_key : ns_keys) {
-    slice_keys.emplace_back(ns_key);
+  slice_keys.reserve(keys.size());
+  size_t key_begin = 0;
+  for (size_t key_end : key_ends) {
+    slice_keys.emplace_back(keys_arena.data() + key_begin, key_end - key_begin);
+    key_begin = key_end;
   }
   return getValues(slice_keys, values);
 }
@@ -169,7 +174,7 @@ rocksdb::Status String::GetEx(const std::string &user_key, std::string *value, s
   WriteBatchLogData log_data(kRedisString);
   batch->PutLogData(log_data.Encode());
   batch->Put(metadata_cf_handle_, ns_key, raw_data);
-  s = storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  s = storage_->Write(writeOptions(), batch->GetWriteBatch());
   if (!s.ok()) return s;
   return rocksdb::Status::OK();
 }
@@ -186,7 +191,7 @@ rocksdb::Status String::GetDel(const std::string &user_key, std::string *value)
   rocksdb::Status s = getValue(ns_key, value);
   if (!s.ok()) return s;
 
-  return storage_->Delete(storage_->DefaultWriteOptions(), metadata_cf_handle_, ns_key);
+  return storage_->Delete(writeOptions(), metadata_cf_handle_, ns_key);
 }
 
 rocksdb::Status String::Set(const std::string &user_key, const std::string &value) {
@@ -401,16 +406,17 @@ rocksdb::Status String::MSet(const std::vector<StringPair> &pairs, uint64_t expi
   auto batch = storage_->GetWriteBatchBase();
   WriteBatchLogData log_data(kRedisString);
   batch->PutLogData(log_data.Encode());
+  std::string bytes, ns_key;
   for (const auto &pair : pairs) {
-    std::string bytes;
+    bytes.clear();
     Metadata metadata(kRedisString, false);
     metadata.expire = expire_ms;
     metadata.Encode(&bytes);
     bytes.append(pair.value.data(), pair.value.size());
-    std::string ns_key = AppendNamespacePrefix(pair.key);
+    AppendNamespacePrefix(pair.key, &ns_key);
     batch->Put(metadata_cf_handle_, ns_key, bytes);
   }
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status String::MSetNX(const std::vector<StringPair> &pairs, uint64_t expire_ms, bool *flag) {
@@ -504,7 +510,7 @@ rocksdb::Status String::CAD(const std::string &user_key, const std::string &valu
 
   if (value == current_value) {
     auto delete_status =
-        storage_->Delete(storage_->DefaultWriteOptions(), storage_->GetCFHandle(ColumnFamilyID::Metadata), ns_key);
+        storage_->Delete(writeOptions(), storage_->GetCFHandle(ColumnFamilyID::Metadata), ns_key);
     if (!delete_status.ok()) {
       return delete_status;
     }
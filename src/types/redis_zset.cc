@@ -46,54 +46,59 @@ rocksdb::Status ZSet::Add(const Slice &user_key, ZAddFlags flags, MemberScores *
   rocksdb::Status s = GetMetadata(Database::GetOptions{}, ns_key, &metadata);
   if (!s.ok() && !s.IsNotFound()) return s;
 
+  std::unordered_map<std::string_view, std::string> old_scores;
+  if (metadata.size > 0) {
+    std::vector<std::string_view> members;
+    members.reserve(mscores->size());
+    for (const auto &ms : *mscores) members.emplace_back(ms.member);
+    s = getSubKeyValues(ns_key, metadata.version, std::move(members), &old_scores);
+    if (!s.ok()) return s;
+  }
+
   int added = 0;
   int changed = 0;
   auto batch = storage_->GetWriteBatchBase();
   WriteBatchLogData log_data(kRedisZSet);
   batch->PutLogData(log_data.Encode());
   std::unordered_set<std::string_view> added_member_keys;
+  InternalKeyEncoder member_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
+  InternalKeyEncoder score_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
   for (auto it = mscores->rbegin(); it != mscores->rend(); ++it) {
     if (!added_member_keys.insert(it->member).second) {
       continue;
     }
-    std::string member_key = InternalKey(ns_key, it->member, metadata.version, storage_->IsSlotIdEncoded()).Encode();
-    if (metadata.size > 0) {
-      std::string old_score_bytes;
-      s = storage_->Get(rocksdb::ReadOptions(), member_key, &old_score_bytes);
-      if (!s.ok() && !s.IsNotFound()) return s;
-      if (s.ok()) {
-        if (!s.IsNotFound() && flags.HasNX()) {
+    Slice member_key = member_key_encoder.Encode(it->member);
+    if (auto old_score_iter = old_scores.find(it->member); old_score_iter != old_scores.end()) {
+      std::string &old_score_bytes = old_score_iter->second;
+      if (flags.HasNX()) {
+        continue;
+      }
+      double old_score = DecodeDouble(old_score_bytes.data());
+      if (flags.HasIncr()) {
+        if ((flags.HasLT() && it->score >= 0) || (flags.HasGT() && it->score <= 0)) {
           continue;
         }
-        double old_score = DecodeDouble(old_score_bytes.data());
-        if (flags.HasIncr()) {
-          if ((flags.HasLT() && it->score >= 0) || (flags.HasGT() && it->score <= 0)) {
-            continue;
-          }
-          it->score += old_score;
-          if (std::isnan(it->score)) {
-            return rocksdb::Status::InvalidArgument("resulting score is not a number (NaN)");
-          }
+        it->score += old_score;
+        if (std::isnan(it->score)) {
+          return rocksdb::Status::InvalidArgument("resulting score is not a number (NaN)");
         }
-        if (it->score != old_score) {
-          if ((flags.HasLT() && it->score >= old_score) || (flags.HasGT() && it->score <= old_score)) {
-            continue;
-          }
-          old_score_bytes.append(it->member);
-          std::string old_score_key =
-              InternalKey(ns_key, old_score_bytes, metadata.version, storage_->IsSlotIdEncoded()).Encode();
-          batch->Delete(score_cf_handle_, old_score_key);
-          std::string new_score_bytes;
-          PutDouble(&new_score_bytes, it->score);
-          batch->Put(member_key, new_score_bytes);
-          new_score_bytes.append(it->member);
-          std::string new_score_key =
-              InternalKey(ns_key, new_score_bytes, metadata.version, storage_->IsSlotIdEncoded()).Encode();
-          batch->Put(score_cf_handle_, new_score_key, Slice());
-          changed++;
+      }
+      if (it->score != old_score) {
+        if ((flags.HasLT() && it->score >= old_score) || (flags.HasGT() && it->score <= old_score)) {
+          continue;
         }
-        continue;
+        old_score_bytes.append(it->member);
+        Slice old_score_key = score_key_encoder.Encode(old_score_bytes);
+        batch->Delete(score_cf_handle_, old_score_key);
+        std::string new_score_bytes;
+        PutDouble(&new_score_bytes, it->score);
+        batch->Put(member_key, new_score_bytes);
+        new_score_bytes.append(it->member);
+        Slice new_score_key = score_key_encoder.Encode(new_score_bytes);
+        batch->Put(score_cf_handle_, new_score_key, Slice());
+        changed++;
       }
+      continue;
     }
     if (flags.HasXX()) {
       continue;
@@ -102,7 +107,7 @@ rocksdb::Status ZSet::Add(const Slice &user_key, ZAddFlags flags, MemberScores *
     PutDouble(&score_bytes, it->score);
     batch->Put(member_key, score_bytes);
     score_bytes.append(it->member);
-    std::string score_key = InternalKey(ns_key, score_bytes, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice score_key = score_key_encoder.Encode(score_bytes);
     batch->Put(score_cf_handle_, score_key, Slice());
     added++;
   }
@@ -116,7 +121,7 @@ rocksdb::Status ZSet::Add(const Slice &user_key, ZAddFlags flags, MemberScores *
   if (flags.HasCH()) {
     *added_cnt += changed;
   }
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status ZSet::Card(const Slice &user_key, uint64_t *size) {
@@ -200,7 +205,7 @@ rocksdb::Status ZSet::Pop(const Slice &user_key, int count, bool min, MemberScor
     metadata.Encode(&bytes);
     batch->Put(metadata_cf_handle_, ns_key, bytes);
   }
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status ZSet::RangeByRank(const Slice &user_key, const RangeRankSpec &spec, MemberScores *mscores,
@@ -278,7 +283,7 @@ rocksdb::Status ZSet::RangeByRank(const Slice &user_key, const RangeRankSpec &sp
     std::string bytes;
     metadata.Encode(&bytes);
     batch->Put(metadata_cf_handle_, ns_key, bytes);
-    return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+    return storage_->Write(writeOptions(), batch->GetWriteBatch());
   }
   return rocksdb::Status::OK();
 }
@@ -395,7 +400,7 @@ rocksdb::Status ZSet::RangeByScore(const Slice &user_key, const RangeScoreSpec &
     std::string bytes;
     metadata.Encode(&bytes);
     batch->Put(metadata_cf_handle_, ns_key, bytes);
-    return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+    return storage_->Write(writeOptions(), batch->GetWriteBatch());
   }
   return rocksdb::Status::OK();
 }
@@ -485,7 +490,7 @@ rocksdb::Status ZSet::RangeByLex(const Slice &user_key, const RangeLexSpec &spec
     std::string bytes;
     metadata.Encode(&bytes);
     batch->Put(metadata_cf_handle_, ns_key, bytes);
-    return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+    return storage_->Write(writeOptions(), batch->GetWriteBatch());
   }
   return rocksdb::Status::OK();
 }
@@ -522,16 +527,18 @@ rocksdb::Status ZSet::Remove(const Slice &user_key, const std::vector<Slice> &me
   batch->PutLogData(log_data.Encode());
   int removed = 0;
   std::unordered_set<std::string_view> mset;
+  InternalKeyEncoder member_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
+  InternalKeyEncoder score_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
   for (const auto &member : members) {
     if (!mset.insert(member.ToStringView()).second) {
       continue;
     }
-    std::string member_key = InternalKey(ns_key, member, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice member_key = member_key_encoder.Encode(member);
     std::string score_bytes;
     s = storage_->Get(rocksdb::ReadOptions(), member_key, &score_bytes);
     if (s.ok()) {
       score_bytes.append(member.data(), member.size());
-      std::string score_key = InternalKey(ns_key, score_bytes, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+      Slice score_key = score_key_encoder.Encode(score_bytes);
       batch->Delete(member_key);
       batch->Delete(score_cf_handle_, score_key);
       removed++;
@@ -544,7 +551,7 @@ rocksdb::Status ZSet::Remove(const Slice &user_key, const std::vector<Slice> &me
     metadata.Encode(&bytes);
     batch->Put(metadata_cf_handle_, ns_key, bytes);
   }
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status ZSet::Rank(const Slice &user_key, const Slice &member, bool reversed, int *member_rank,
@@ -609,20 +616,22 @@ rocksdb::Status ZSet::Overwrite(const Slice &user_key, const MemberScores &mscor
   auto batch = storage_->GetWriteBatchBase();
   WriteBatchLogData log_data(kRedisZSet);
   batch->PutLogData(log_data.Encode());
+  InternalKeyEncoder member_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
+  InternalKeyEncoder score_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
   for (const auto &ms : mscores) {
     std::string score_bytes;
-    std::string member_key = InternalKey(ns_key, ms.member, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice member_key = member_key_encoder.Encode(ms.member);
     PutDouble(&score_bytes, ms.score);
     batch->Put(member_key, score_bytes);
     score_bytes.append(ms.member);
-    std::string score_key = InternalKey(ns_key, score_bytes, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice score_key = score_key_encoder.Encode(score_bytes);
     batch->Put(score_cf_handle_, score_key, Slice());
   }
   metadata.size = static_cast<uint32_t>(mscores.size());
   std::string bytes;
   metadata.Encode(&bytes);
   batch->Put(metadata_cf_handle_, ns_key, bytes);
-  return storage_->Write(storage_->DefaultWriteOptions(), batch->GetWriteBatch());
+  return storage_->Write(writeOptions(), batch->GetWriteBatch());
 }
 
 rocksdb::Status ZSet::InterStore(const Slice &dst, const std::vector<KeyWeight> &keys_weights,
@@ -838,8 +847,9 @@ rocksdb::Status ZSet::MGet(const Slice &user_key, const std::vector<Slice> &memb
   rocksdb::ReadOptions read_options;
   read_options.snapshot = ss.GetSnapShot();
   std::string score_bytes;
+  InternalKeyEncoder member_key_encoder(ns_key, metadata.version, storage_->IsSlotIdEncoded());
   for (const auto &member : members) {
-    std::string member_key = InternalKey(ns_key, member, metadata.version, storage_->IsSlotIdEncoded()).Encode();
+    Slice member_key = member_key_encoder.Encode(member);
     score_bytes.clear();
     s = storage_->Get(read_options, member_key, &score_bytes);
     if (!s.ok() && !s.IsNotFound()) return s;
@@ -900,8 +910,17 @@ rocksdb::Status ZSet::RandMember(const Slice &user_key, int64_t command_count,
   if (!s.ok()) return s.IsNotFound() ? rocksdb::Status::OK() : s;
   if (metadata.size == 0) return rocksdb::Status::OK();
 
-  return ExtractRandMemberFromSet<MemberScore>(
-      unique, count,
+  return ExtractRandMember<MemberScore>(
+      unique, count, metadata.size,
+      [this, &ns_key, &metadata, count, unique](std::vector<MemberScore> *scores) {
+        // members are sampled from the member -> score sub keys rather than the score index
+        std::vector<std::pair<std::string, std::string>> sub_keys;
+        auto s = this->Sample(ns_key, metadata, count, unique, nullptr, &sub_keys);
+        for (auto &[member, score_bytes] : sub_keys) {
+          scores->emplace_back(MemberScore{std::move(member), DecodeDouble(score_bytes.data())});
+        }
+        return s;
+      },
       [this, user_key](std::vector<MemberScore> *scores) -> rocksdb::Status {
         return this->GetAllMemberScores(user_key, scores);
       },
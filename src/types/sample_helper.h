@@ -27,7 +27,8 @@
 
 /// ExtractRandMemberFromSet is a helper function to extract random elements from a kvrocks structure.
 ///
-/// The complexity of the function is O(N) where N is the number of elements inside the structure.
+/// The complexity of the function is O(N) where N is the number of elements inside the structure,
+/// see ExtractRandMember for the sublinear path used on large structures.
 template <typename ElementType, typename GetAllMemberFnType>
 rocksdb::Status ExtractRandMemberFromSet(bool unique, size_t count, const GetAllMemberFnType &get_all_member_fn,
                                          std::vector<ElementType> *elements) {
@@ -65,3 +66,24 @@ rocksdb::Status ExtractRandMemberFromSet(bool unique, size_t count, const GetAll
   }
   return rocksdb::Status::OK();
 }
+
+/// Sampling by random seeks only pays off when a small part of a large structure is requested,
+/// otherwise a sequential scan of the whole structure is cheaper than `count` seeks.
+constexpr uint64_t kSampleBySeekMinSize = 512;
+constexpr uint64_t kSampleBySeekMinRatio = 8;
+
+/// ExtractRandMember is like ExtractRandMemberFromSet, but picks the elements with `sample_fn` when only
+/// a small part of a large structure is requested, which costs O(count * log N) instead of O(N).
+/// `sample_fn` returning Incomplete means it could not pick enough elements, and the whole structure
+/// would be loaded by `get_all_member_fn` then. The elements are picked by the distribution of
+/// SubKeyScanner::Sample, which isn't uniform, unlike ExtractRandMemberFromSet.
+template <typename ElementType, typename SampleFnType, typename GetAllMemberFnType>
+rocksdb::Status ExtractRandMember(bool unique, size_t count, uint64_t size, const SampleFnType &sample_fn,
+                                  const GetAllMemberFnType &get_all_member_fn, std::vector<ElementType> *elements) {
+  if (size >= kSampleBySeekMinSize && count <= size / kSampleBySeekMinRatio) {
+    elements->clear();
+    rocksdb::Status s = sample_fn(elements);
+    if (!s.IsIncomplete()) return s;
+  }
+  return ExtractRandMemberFromSet<ElementType>(unique, count, get_all_member_fn, elements);
+}
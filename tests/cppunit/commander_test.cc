@@ -0,0 +1,128 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "commands/commander.h"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <cctype>
+#include <string>
+#include <thread>
+
+#include "server/server.h"
+
+TEST(CommandLookupIndex, MixedCase) {
+  redis::CommandTable::Reset();
+
+  for (const auto &[name, attributes] : *redis::CommandTable::GetOriginal()) {
+    std::string upper = name, mixed = name;
+    std::transform(upper.begin(), upper.end(), upper.begin(), ::toupper);
+    for (size_t i = 0; i < mixed.size(); i += 2) mixed[i] = static_cast<char>(::toupper(mixed[i]));
+
+    ASSERT_EQ(redis::CommandTable::Lookup(name), attributes) << name;
+    ASSERT_EQ(redis::CommandTable::Lookup(upper), attributes) << upper;
+    ASSERT_EQ(redis::CommandTable::Lookup(mixed), attributes) << mixed;
+  }
+}
+
+TEST(CommandLookupIndex, UnknownCommands) {
+  redis::CommandTable::Reset();
+
+  ASSERT_EQ(redis::CommandTable::Lookup(""), nullptr);
+  ASSERT_EQ(redis::CommandTable::Lookup("foobaredcommand"), nullptr);
+  // neither the prefix nor the extension of a command name is a command
+  ASSERT_EQ(redis::CommandTable::Lookup("ge"), nullptr);
+  ASSERT_EQ(redis::CommandTable::Lookup("gets"), nullptr);
+  ASSERT_EQ(redis::CommandTable::Lookup(std::string("get\0", 4)), nullptr);
+  ASSERT_EQ(redis::CommandTable::Lookup("g e t"), nullptr);
+
+  redis::CommandLookupIndex empty_index;
+  ASSERT_EQ(empty_index.Find("get"), nullptr);
+  empty_index.Build({});
+  ASSERT_EQ(empty_index.Find("get"), nullptr);
+}
+
+TEST(CommandLookupIndex, Rebuild) {
+  redis::CommandTable::Reset();
+
+  auto commands = redis::CommandTable::Get();
+  auto get = commands->at("get");
+  commands->erase("get");
+  (*commands)["get_new"] = get;
+  redis::CommandTable::UpdateLookupIndex();
+  ASSERT_EQ(redis::CommandTable::Lookup("GET"), nullptr);
+  ASSERT_EQ(redis::CommandTable::Lookup("Get_New"), get);
+
+  redis::CommandTable::Reset();
+  ASSERT_EQ(redis::CommandTable::Lookup("GET"), get);
+  ASSERT_EQ(redis::CommandTable::Lookup("get_new"), nullptr);
+}
+
+TEST(CommandLookupIndex, ReusePooledCommanders) {
+  redis::CommandTable::Reset();
+
+  auto get = *Server::LookupAndCreateCommand("GET");
+  auto *get_ptr = get.get();
+  ASSERT_EQ(get->GetAttributes()->name, "get");
+  Server::RecycleCommand(std::move(get));
+
+  // the recycled commander is only reused by the same command
+  auto set = *Server::LookupAndCreateCommand("set");
+  ASSERT_NE(set.get(), get_ptr);
+  ASSERT_EQ(set->GetAttributes()->name, "set");
+  get = *Server::LookupAndCreateCommand("get");
+  ASSERT_EQ(get.get(), get_ptr);
+  ASSERT_EQ(get->GetAttributes()->name, "get");
+
+  // the pool is thread local, so the other threads never take it
+  Server::RecycleCommand(std::move(get));
+  std::thread([get_ptr] {
+    auto other = *Server::LookupAndCreateCommand("get");
+    ASSERT_NE(other.get(), get_ptr);
+  }).join();
+  get = *Server::LookupAndCreateCommand("get");
+  ASSERT_EQ(get.get(), get_ptr);
+
+  ASSERT_FALSE(Server::LookupAndCreateCommand("foobaredcommand").IsOK());
+}
+
+TEST(CommandLookupIndex, ReuseBlockingCommanders) {
+  redis::CommandTable::Reset();
+
+  // a suspended blocking command holds its commander in saved_current_command_ instead of recycling it,
+  // so it's never handed out to another command until it's released
+  auto saved = *Server::LookupAndCreateCommand("blpop");
+  auto next = *Server::LookupAndCreateCommand("BLPOP");
+  ASSERT_NE(next.get(), saved.get());
+
+  auto *next_ptr = next.get();
+  Server::RecycleCommand(std::move(next));
+  next = *Server::LookupAndCreateCommand("blpop");
+  ASSERT_EQ(next.get(), next_ptr);
+  ASSERT_NE(next.get(), saved.get());
+
+  for (int i = 0; i < 3; i++) {
+    Server::RecycleCommand(std::move(next));
+    next = *Server::LookupAndCreateCommand("bLpOp");
+    ASSERT_EQ(next.get(), next_ptr);
+  }
+  ASSERT_EQ(saved->GetAttributes()->name, "blpop");
+}
@@ -21,7 +21,9 @@
 #include <gtest/gtest.h>
 
 #include <filesystem>
+#include <map>
 
+#include "storage/compact_filter.h"
 #include "storage/redis_metadata.h"
 #include "storage/storage.h"
 #include "types/redis_hash.h"
@@ -130,3 +132,130 @@ TEST(Compact, Filter) {
     std::cout << "Encounter filesystem error: " << ec << std::endl;
   }
 }
+
+TEST(Compact, SkipDeadVersions) {
+  Config config;
+  config.db_dir = "compactdb_skip";
+  config.slot_id_encoded = false;
+
+  auto storage = std::make_unique<engine::Storage>(&config);
+  Status s = storage->Open();
+  ASSERT_TRUE(s.IsOK());
+
+  uint64_t ret = 0;
+  std::string ns = "test_compact";
+  auto hash = std::make_unique<redis::Hash>(storage.get(), ns);
+  std::string dead_hash_key = "dead_hash_key";
+  std::string live_hash_key = "live_hash_key";
+  hash->Set(dead_hash_key, "f1", "v1", &ret);
+  hash->Set(dead_hash_key, "f2", "v2", &ret);
+  hash->Set(live_hash_key, "f1", "v1", &ret);
+
+  std::map<std::string, std::string> subkeys;
+  std::unique_ptr<rocksdb::Iterator> iter(
+      storage->GetDB()->NewIterator(rocksdb::ReadOptions(), storage->GetCFHandle(ColumnFamilyID::PrimarySubkey)));
+  for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+    InternalKey ikey(iter->key(), storage->IsSlotIdEncoded());
+    subkeys[ikey.GetKey().ToString() + ":" + ikey.GetSubKey().ToString()] = iter->key().ToString();
+  }
+  ASSERT_EQ(subkeys.size(), 3);
+  ASSERT_TRUE(hash->Del(dead_hash_key).ok());
+
+  engine::SubKeyFilter filter(storage.get(), true);
+  std::string new_value, skip_until;
+  auto decision = filter.FilterV2(0, subkeys["live_hash_key:f1"], rocksdb::CompactionFilter::ValueType::kValue, "v1",
+                                  &new_value, &skip_until);
+  EXPECT_EQ(decision, rocksdb::CompactionFilter::Decision::kKeep);
+
+  // all the fields of the deleted hash are skipped at once
+  decision = filter.FilterV2(0, subkeys["dead_hash_key:f1"], rocksdb::CompactionFilter::ValueType::kValue, "v1",
+                             &new_value, &skip_until);
+  EXPECT_EQ(decision, rocksdb::CompactionFilter::Decision::kRemoveAndSkipUntil);
+  EXPECT_GT(skip_until, subkeys["dead_hash_key:f2"]);
+  EXPECT_LT(skip_until, subkeys["live_hash_key:f1"]);
+  InternalKey skip_ikey(skip_until, storage->IsSlotIdEncoded());
+  EXPECT_EQ(skip_ikey.GetKey().ToString(), dead_hash_key);
+  EXPECT_EQ(skip_ikey.GetSubKey().ToString(), "");
+
+  // only the dead key itself is removed if skipping isn't enabled
+  engine::SubKeyFilter no_skip_filter(storage.get());
+  decision = no_skip_filter.FilterV2(0, subkeys["dead_hash_key:f1"], rocksdb::CompactionFilter::ValueType::kValue, "v1",
+                                     &new_value, &skip_until);
+  EXPECT_EQ(decision, rocksdb::CompactionFilter::Decision::kRemove);
+
+  // the skipping is enabled even if a snapshot is alive, kRemove would drop the keys regardless of snapshots as well
+  engine::SubKeyFilterFactory factory(storage.get());
+  rocksdb::CompactionFilter::Context context;
+  context.column_family_id = static_cast<uint32_t>(ColumnFamilyID::Search);
+  const rocksdb::Snapshot *snapshot = storage->GetDB()->GetSnapshot();
+  decision = factory.CreateCompactionFilter(context)->FilterV2(
+      0, subkeys["dead_hash_key:f1"], rocksdb::CompactionFilter::ValueType::kValue, "v1", &new_value, &skip_until);
+  EXPECT_EQ(decision, rocksdb::CompactionFilter::Decision::kRemoveAndSkipUntil);
+  storage->GetDB()->ReleaseSnapshot(snapshot);
+
+  iter.reset();
+  storage.reset();
+  std::error_code ec;
+  std::filesystem::remove_all(config.db_dir, ec);
+}
+
+TEST(Compact, SkipDeadVersionsInCompaction) {
+  Config config;
+  config.db_dir = "compactdb_skip_range";
+  config.slot_id_encoded = false;
+
+  auto storage = std::make_unique<engine::Storage>(&config);
+  Status s = storage->Open();
+  ASSERT_TRUE(s.IsOK());
+
+  uint64_t ret = 0;
+  std::string ns = "test_compact";
+  auto hash = std::make_unique<redis::Hash>(storage.get(), ns);
+  std::string recreated_hash_key = "recreated_hash_key";
+  std::string live_hash_key = "live_hash_key";
+  for (int i = 0; i < 100; i++) {
+    hash->Set(recreated_hash_key, "f" + std::to_string(i), "v", &ret);
+  }
+  hash->Set(live_hash_key, "f1", "v1", &ret);
+
+  auto versions = [&storage](const std::string &key) {
+    std::map<uint64_t, int> versions;
+    std::unique_ptr<rocksdb::Iterator> iter(
+        storage->GetDB()->NewIterator(rocksdb::ReadOptions(), storage->GetCFHandle(ColumnFamilyID::PrimarySubkey)));
+    for (iter->SeekToFirst(); iter->Valid(); iter->Next()) {
+      InternalKey ikey(iter->key(), storage->IsSlotIdEncoded());
+      if (ikey.GetKey() == key) versions[ikey.GetVersion()]++;
+    }
+    return versions;
+  };
+  auto dead_versions = versions(recreated_hash_key);
+  ASSERT_EQ(dead_versions.size(), 1);
+  uint64_t dead_version = dead_versions.begin()->first;
+
+  // the hash is deleted and created again with a new version, while a snapshot is alive
+  ASSERT_TRUE(hash->Del(recreated_hash_key).ok());
+  hash->Set(recreated_hash_key, "f0", "v0", &ret);
+  const rocksdb::Snapshot *snapshot = storage->GetDB()->GetSnapshot();
+
+  // Compact twice, see the Filter test
+  auto status = storage->Compact(storage->GetCFHandle(ColumnFamilyID::PrimarySubkey), nullptr, nullptr);
+  ASSERT_TRUE(status.ok());
+  status = storage->Compact(storage->GetCFHandle(ColumnFamilyID::PrimarySubkey), nullptr, nullptr);
+  ASSERT_TRUE(status.ok());
+
+  // the whole dead version is gone, while the live versions survive
+  auto live_versions = versions(recreated_hash_key);
+  ASSERT_EQ(live_versions.size(), 1);
+  EXPECT_NE(live_versions.begin()->first, dead_version);
+  EXPECT_EQ(live_versions.begin()->second, 1);
+  EXPECT_EQ(versions(live_hash_key).size(), 1);
+  std::string value;
+  EXPECT_TRUE(hash->Get(recreated_hash_key, "f0", &value).ok() && value == "v0");
+  EXPECT_TRUE(hash->Get(recreated_hash_key, "f1", &value).IsNotFound());
+  EXPECT_TRUE(hash->Get(live_hash_key, "f1", &value).ok() && value == "v1");
+
+  storage->GetDB()->ReleaseSnapshot(snapshot);
+  storage.reset();
+  std::error_code ec;
+  std::filesystem::remove_all(config.db_dir, ec);
+}
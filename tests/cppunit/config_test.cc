@@ -48,10 +48,13 @@ TEST(Config, GetAndSet) {
       {"bgsave-cron", "5 4 3 2 1"},
       {"dbsize-scan-cron", "1 2 3 2 1"},
       {"max-io-mb", "5000"},
+      {"compaction-auto-tune", "yes"},
+      {"compaction-auto-tune-max-io-mb", "256"},
       {"max-db-size", "6000"},
       {"max-replication-mb", "7000"},
       {"slave-serve-stale-data", "no"},
       {"slave-read-only", "no"},
+      {"repl-pubsub-side-channel", "yes"},
       {"slave-priority", "101"},
       {"slowlog-log-slower-than", "1234"},
       {"slowlog-max-len", "123"},
@@ -63,6 +66,7 @@ TEST(Config, GetAndSet) {
 
       {"rocksdb.compression", "no"},
       {"rocksdb.max_open_files", "1234"},
+      {"rocksdb.block_cache_dump_interval", "10"},
       {"rocksdb.write_buffer_size", "1234"},
       {"rocksdb.max_write_buffer_number", "1"},
       {"rocksdb.target_file_size_base", "100"},
@@ -126,8 +130,16 @@ TEST(Config, GetAndSet) {
       {"rocksdb.metadata_block_cache_size", "100"},
       {"rocksdb.subkey_block_cache_size", "100"},
       {"rocksdb.row_cache_size", "100"},
+      {"rocksdb.block_cache_dump", "yes"},
+      {"rocksdb.pubsub_fifo_compaction", "yes"},
+      {"rocksdb.pubsub_fifo_ttl", "600"},
+      {"rocksdb.block_cache_prewarm_rate", "32"},
       {"rocksdb.rate_limiter_auto_tuned", "yes"},
       {"rocksdb.compression_level", "32767"},
+      {"rocksdb.compression_max_dict_bytes", "16384"},
+      {"rocksdb.compression_zstd_max_train_bytes", "1638400"},
+      {"rocksdb.compression_parallel_threads", "2"},
+      {"rocksdb.compression_dict_column_families", "default"},
   };
   for (const auto &iter : immutable_cases) {
     s = config.Set(nullptr, iter.first, iter.second);
@@ -135,6 +147,69 @@ TEST(Config, GetAndSet) {
   }
 }
 
+TEST(Config, CompressionDictionary) {
+  const char *path = "test.conf";
+  unlink(path);
+
+  std::ofstream output_file(path, std::ios::out);
+  output_file << "rocksdb.compression zstd\n";
+  output_file << "rocksdb.compression_max_dict_bytes 16384\n";
+  output_file << "rocksdb.compression_dict_column_families default  metadata stream\n";
+  output_file.close();
+  Config config;
+  ASSERT_TRUE(config.Load(CLIOptions(path)).IsOK());
+  ASSERT_EQ(config.rocks_db.compression_max_dict_bytes, 16384);
+  ASSERT_EQ(config.rocks_db.compression_dict_column_families,
+            (std::vector<std::string>{"default", "metadata", "stream"}));
+
+  output_file.open(path, std::ios::out | std::ios::trunc);
+  output_file << "rocksdb.compression_dict_column_families default unknown\n";
+  output_file.close();
+  ASSERT_FALSE(Config().Load(CLIOptions(path)).IsOK());
+
+  output_file.open(path, std::ios::out | std::ios::trunc);
+  output_file << "rocksdb.compression zstd\n";
+  output_file << "rocksdb.compression_zstd_max_train_bytes 1638400\n";
+  output_file.close();
+  ASSERT_FALSE(Config().Load(CLIOptions(path)).IsOK());
+
+  // the dictionary is ignored by the other compression types
+  for (const char *compression : {"no", "snappy", "zlib"}) {
+    output_file.open(path, std::ios::out | std::ios::trunc);
+    output_file << "rocksdb.compression " << compression << "\n";
+    output_file << "rocksdb.compression_max_dict_bytes 16384\n";
+    output_file.close();
+    ASSERT_FALSE(Config().Load(CLIOptions(path)).IsOK()) << compression;
+  }
+  // lz4 supports the dictionary, but only zstd trains it
+  output_file.open(path, std::ios::out | std::ios::trunc);
+  output_file << "rocksdb.compression lz4\n";
+  output_file << "rocksdb.compression_max_dict_bytes 16384\n";
+  output_file.close();
+  ASSERT_TRUE(Config().Load(CLIOptions(path)).IsOK());
+  output_file.open(path, std::ios::out | std::ios::trunc);
+  output_file << "rocksdb.compression lz4\n";
+  output_file << "rocksdb.compression_max_dict_bytes 16384\n";
+  output_file << "rocksdb.compression_zstd_max_train_bytes 1638400\n";
+  output_file.close();
+  ASSERT_FALSE(Config().Load(CLIOptions(path)).IsOK());
+
+  // the compression can't be changed to a type ignoring the dictionary at runtime
+  output_file.open(path, std::ios::out | std::ios::trunc);
+  output_file << "rocksdb.compression zstd\n";
+  output_file << "rocksdb.compression_max_dict_bytes 16384\n";
+  output_file << "rocksdb.compression_zstd_max_train_bytes 1638400\n";
+  output_file.close();
+  Config config_with_training;
+  ASSERT_TRUE(config_with_training.Load(CLIOptions(path)).IsOK());
+  ASSERT_FALSE(config_with_training.Set(nullptr, "rocksdb.compression", "snappy").IsOK());
+  ASSERT_FALSE(config_with_training.Set(nullptr, "rocksdb.compression", "lz4").IsOK());
+  ASSERT_TRUE(config_with_training.Set(nullptr, "rocksdb.compression", "zstd").IsOK());
+  ASSERT_FALSE(config.Set(nullptr, "rocksdb.compression", "snappy").IsOK());
+  ASSERT_TRUE(config.Set(nullptr, "rocksdb.compression", "lz4").IsOK());
+  unlink(path);
+}
+
 TEST(Config, GetRenameCommand) {
   const char *path = "test.conf";
   unlink(path);
@@ -158,6 +233,11 @@ TEST(Config, GetRenameCommand) {
   ASSERT_EQ(values[0], "rename-command");
   ASSERT_EQ(values[2], "rename-command");
   ASSERT_EQ(values[4], "rename-command");
+
+  ASSERT_EQ(redis::CommandTable::Lookup("KEYS"), nullptr);
+  ASSERT_NE(redis::CommandTable::Lookup("keys_new"), nullptr);
+  ASSERT_EQ(redis::CommandTable::Lookup("Get_New")->name, "get");
+  ASSERT_EQ(redis::CommandTable::Lookup("hGeTaLl")->name, "hgetall");
 }
 
 TEST(Config, Rewrite) {
@@ -30,6 +30,10 @@
 #include <types/redis_stream.h>
 #include <types/redis_zset.h>
 
+#include <chrono>
+#include <thread>
+
+#include "db_util.h"
 #include "test_base.h"
 #include "types/redis_string.h"
 
@@ -857,3 +861,91 @@ TEST_F(WALIteratorTest, NextSequence) {
   ASSERT_EQ(expected_next_sequences.size(), next_sequences.size());
   ASSERT_TRUE(std::equal(expected_next_sequences.begin(), expected_next_sequences.end(), next_sequences.begin()));
 }
+
+class AutoRefreshIteratorTest : public TestBase {
+ protected:
+  explicit AutoRefreshIteratorTest() = default;
+  ~AutoRefreshIteratorTest() override = default;
+
+  void SetUp() override {
+    for (int i = 0; i < kKeyNum; i++) {
+      auto s = storage_->GetDB()->Put(rocksdb::WriteOptions(), cf(), key(i), "value");
+      ASSERT_TRUE(s.ok());
+    }
+  }
+
+  // modify all the keys and flush them, which makes the iterators created before pin the old memtable
+  void modifyAndFlush() {
+    for (int i = 0; i < kKeyNum; i += 2) {
+      auto s = storage_->GetDB()->Delete(rocksdb::WriteOptions(), cf(), key(i));
+      ASSERT_TRUE(s.ok());
+      s = storage_->GetDB()->Put(rocksdb::WriteOptions(), cf(), key(i) + "-new", "value");
+      ASSERT_TRUE(s.ok());
+    }
+    auto s = storage_->GetDB()->Flush(rocksdb::FlushOptions(), cf());
+    ASSERT_TRUE(s.ok());
+    // make sure the refresh interval is elapsed
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+  }
+
+  rocksdb::ColumnFamilyHandle *cf() { return storage_->GetCFHandle(ColumnFamilyID::PrimarySubkey); }
+  static std::string key(int i) { return fmt::format("key-{:04}", i); }
+
+  static constexpr int kKeyNum = 1000;
+};
+
+TEST_F(AutoRefreshIteratorTest, ForwardWithSnapshot) {
+  auto db = storage_->GetDB();
+  auto snapshot = db->GetSnapshot();
+  auto refresh_num = engine::AutoRefreshIterator::GetRefreshNum();
+  rocksdb::ReadOptions read_options;
+  read_options.snapshot = snapshot;
+
+  {
+    engine::AutoRefreshIterator iter(db->NewIterator(read_options, cf()), snapshot, 1);
+    int i = 0;
+    for (iter.SeekToFirst(); iter.Valid(); iter.Next(), i++) {
+      ASSERT_EQ(iter.key().ToString(), key(i));
+      if (i == 0) modifyAndFlush();
+    }
+    ASSERT_TRUE(iter.status().ok());
+    ASSERT_EQ(i, kKeyNum);
+    ASSERT_GT(engine::AutoRefreshIterator::GetRefreshNum(), refresh_num);
+  }
+  db->ReleaseSnapshot(snapshot);
+}
+
+TEST_F(AutoRefreshIteratorTest, BackwardWithSnapshot) {
+  auto db = storage_->GetDB();
+  auto snapshot = db->GetSnapshot();
+  auto refresh_num = engine::AutoRefreshIterator::GetRefreshNum();
+  rocksdb::ReadOptions read_options;
+  read_options.snapshot = snapshot;
+
+  {
+    engine::AutoRefreshIterator iter(db->NewIterator(read_options, cf()), snapshot, 1);
+    int i = kKeyNum - 1;
+    for (iter.SeekToLast(); iter.Valid(); iter.Prev(), i--) {
+      ASSERT_EQ(iter.key().ToString(), key(i));
+      if (i == kKeyNum - 1) modifyAndFlush();
+    }
+    ASSERT_TRUE(iter.status().ok());
+    ASSERT_EQ(i, -1);
+    ASSERT_GT(engine::AutoRefreshIterator::GetRefreshNum(), refresh_num);
+  }
+  db->ReleaseSnapshot(snapshot);
+}
+
+TEST_F(AutoRefreshIteratorTest, AliveNum) {
+  auto alive_num = engine::AutoRefreshIterator::GetAliveNum();
+  {
+    auto snapshot = storage_->GetDB()->GetSnapshot();
+    rocksdb::ReadOptions read_options;
+    read_options.snapshot = snapshot;
+    auto iter = util::UniqueIterator(storage_.get(), read_options, cf());
+    ASSERT_EQ(engine::AutoRefreshIterator::GetAliveNum(), alive_num + 1);
+    iter.reset();
+    storage_->GetDB()->ReleaseSnapshot(snapshot);
+  }
+  ASSERT_EQ(engine::AutoRefreshIterator::GetAliveNum(), alive_num);
+}
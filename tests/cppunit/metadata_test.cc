@@ -44,6 +44,60 @@ TEST(InternalKey, EncodeAndDecode) {
   EXPECT_EQ(ikey, ikey1);
 }
 
+TEST(InternalKey, EncodingVersions) {
+  Slice ns = "namespace";
+  Slice sub_key = "test-metadata-sub-key";
+  uint64_t version = 12;
+  std::string short_key = "test-metadata-key", long_key(300, 'k');
+  for (bool slot_id_encoded : {false, true}) {
+    for (const auto &key : {short_key, long_key}) {
+      std::string ns_key = ComposeNamespaceKey(ns, key, slot_id_encoded);
+      InternalKey v0_key(ns_key, sub_key, version, slot_id_encoded, 0);
+      InternalKey v1_key(ns_key, sub_key, version, slot_id_encoded, 1);
+      std::string v0_bytes = v0_key.Encode(), v1_bytes = v1_key.Encode();
+      ASSERT_EQ(v0_bytes.size(), v0_key.EncodedSize());
+      ASSERT_EQ(v1_bytes.size(), v1_key.EncodedSize());
+      // the key size takes 1 byte for short keys and 2 bytes for the long one instead of 4 bytes
+      ASSERT_EQ(v0_bytes.size() - v1_bytes.size(), key.size() < 128 ? 3 : 2);
+
+      InternalKey decoded(v1_bytes, slot_id_encoded, 1);
+      ASSERT_EQ(decoded.GetNamespace(), ns);
+      ASSERT_EQ(decoded.GetKey(), key);
+      ASSERT_EQ(decoded.GetSubKey(), sub_key);
+      ASSERT_EQ(decoded.GetVersion(), version);
+
+      // sub keys are still prefixed by the encoded key with an empty sub key
+      std::string prefix = InternalKey(ns_key, "", version, slot_id_encoded, 1).Encode();
+      ASSERT_TRUE(Slice(v1_bytes).starts_with(prefix));
+    }
+  }
+}
+
+TEST(InternalKey, EncodeIntoBuffer) {
+  Slice ns = "namespace";
+  uint64_t version = 12;
+  std::string ns_key, long_sub_key(100, 'x');
+  for (bool slot_id_encoded : {false, true}) {
+    ComposeNamespaceKey(ns, "test-metadata-key", slot_id_encoded, &ns_key);
+    ASSERT_EQ(ns_key, ComposeNamespaceKey(ns, "test-metadata-key", slot_id_encoded));
+
+    std::vector<Slice> sub_keys = {"a", "", "test-metadata-sub-key", long_sub_key};
+    InternalKeyEncoder encoder(ns_key, version, slot_id_encoded);
+    ASSERT_EQ(encoder.Prefix(), InternalKey(ns_key, "", version, slot_id_encoded).Encode());
+    for (const auto &sub_key : sub_keys) {
+      ASSERT_EQ(encoder.Encode(sub_key), InternalKey(ns_key, sub_key, version, slot_id_encoded).Encode());
+    }
+
+    std::string arena;
+    std::vector<Slice> keys;
+    encoder.EncodeAll(sub_keys, &arena, &keys);
+    ASSERT_EQ(keys.size(), sub_keys.size());
+    for (size_t i = 0; i < sub_keys.size(); i++) {
+      ASSERT_EQ(keys[i], InternalKey(ns_key, sub_keys[i], version, slot_id_encoded).Encode());
+    }
+  }
+}
+
 TEST(Metadata, EncodeAndDecode) {
   std::string string_bytes;
   Metadata string_md(kRedisString);
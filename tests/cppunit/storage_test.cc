@@ -21,7 +21,9 @@
 #include <config/config.h>
 #include <gtest/gtest.h>
 #include <status.h>
+#include <storage/redis_metadata.h>
 #include <storage/storage.h>
+#include <types/redis_string.h>
 
 #include <filesystem>
 
@@ -56,3 +58,218 @@ TEST(Storage, CreateBackup) {
   std::filesystem::remove_all(config.db_dir, ec);
   ASSERT_TRUE(!ec);
 }
+
+TEST(Storage, DeleteRangeOfDataCFs) {
+  std::error_code ec;
+
+  Config config;
+  config.db_dir = "test_delete_range_dir";
+  config.slot_id_encoded = false;
+
+  std::filesystem::remove_all(config.db_dir, ec);
+  ASSERT_TRUE(!ec);
+
+  auto storage = std::make_unique<engine::Storage>(&config);
+  auto s = storage->Open();
+  ASSERT_TRUE(s.IsOK());
+
+  auto metadata_cf = storage->GetCFHandle(ColumnFamilyID::Metadata);
+  auto subkey_cf = storage->GetCFHandle(ColumnFamilyID::PrimarySubkey);
+  for (const auto &key : {"a1", "a2", "b1", "b2"}) {
+    rocksdb::WriteBatch batch;
+    batch.Put(metadata_cf, key, "v");
+    batch.Put(subkey_cf, key, "v");
+    ASSERT_TRUE(storage->Write(rocksdb::WriteOptions(), &batch).ok());
+  }
+
+  auto exists = [&](rocksdb::ColumnFamilyHandle *cf, const std::string &key) {
+    std::string value;
+    return storage->Get(rocksdb::ReadOptions(), cf, key, &value).ok();
+  };
+
+  ASSERT_TRUE(storage->DeleteRangeOfDataCFs("a", "b").ok());
+  for (auto cf : {metadata_cf, subkey_cf}) {
+    ASSERT_FALSE(exists(cf, "a1"));
+    ASSERT_FALSE(exists(cf, "a2"));
+    ASSERT_TRUE(exists(cf, "b1"));
+    ASSERT_TRUE(exists(cf, "b2"));
+  }
+
+  // the last key should be deleted as well if the range is empty
+  ASSERT_TRUE(storage->DeleteRangeOfDataCFs("", "").ok());
+  for (auto cf : {metadata_cf, subkey_cf}) {
+    ASSERT_FALSE(exists(cf, "b1"));
+    ASSERT_FALSE(exists(cf, "b2"));
+  }
+
+  storage.reset();
+  std::filesystem::remove_all(config.db_dir, ec);
+  ASSERT_TRUE(!ec);
+}
+
+TEST(Storage, NamespaceIDEncoding) {
+  std::error_code ec;
+
+  Config config;
+  config.db_dir = "test_namespace_id_dir";
+  config.slot_id_encoded = false;
+  config.namespace_id_encoding = true;
+
+  std::filesystem::remove_all(config.db_dir, ec);
+  ASSERT_TRUE(!ec);
+
+  auto storage = std::make_unique<engine::Storage>(&config);
+  auto s = storage->Open();
+  ASSERT_TRUE(s.IsOK());
+
+  auto default_ns = storage->EncodeNamespace(kDefaultNamespace);
+  ASSERT_TRUE(IsNamespaceID(default_ns));
+  ASSERT_EQ(kDefaultNamespace, storage->DecodeNamespace(default_ns));
+  // the lookup never assigns ids
+  ASSERT_EQ("ns1", storage->EncodeNamespace("ns1"));
+  ASSERT_TRUE(storage->AssignNamespaceID("ns1").IsOK());
+  ASSERT_TRUE(storage->AssignNamespaceID("ns2").IsOK());
+  auto ns1 = storage->EncodeNamespace("ns1");
+  auto ns2 = storage->EncodeNamespace("ns2");
+  ASSERT_TRUE(IsNamespaceID(ns1));
+  ASSERT_LT(ns1.size(), std::string("ns1").size());
+  ASSERT_NE(ns1, ns2);
+  ASSERT_NE(ns1, default_ns);
+  // the encoded namespace is kept as it is
+  ASSERT_EQ(ns1, storage->EncodeNamespace(ns1));
+  ASSERT_EQ("ns1", storage->DecodeNamespace(ns1));
+  ASSERT_EQ("ns2", storage->DecodeNamespace(ns2));
+  // the assigned id is kept
+  ASSERT_TRUE(storage->AssignNamespaceID("ns1").IsOK());
+  ASSERT_EQ(ns1, storage->EncodeNamespace("ns1"));
+
+  // the ids are persisted
+  storage.reset();
+  storage = std::make_unique<engine::Storage>(&config);
+  s = storage->Open();
+  ASSERT_TRUE(s.IsOK());
+  ASSERT_EQ(ns2, storage->EncodeNamespace("ns2"));
+  ASSERT_EQ("ns1", storage->DecodeNamespace(ns1));
+
+  // the encoding can't be changed on an existing storage
+  storage.reset();
+  config.namespace_id_encoding = false;
+  storage = std::make_unique<engine::Storage>(&config);
+  s = storage->Open();
+  ASSERT_FALSE(s.IsOK());
+
+  storage.reset();
+  std::filesystem::remove_all(config.db_dir, ec);
+  ASSERT_TRUE(!ec);
+}
+
+TEST(Storage, WALDisabledNamespaces) {
+  std::error_code ec;
+
+  Config config;
+  config.db_dir = "test_wal_disabled_dir";
+  config.slot_id_encoded = false;
+  config.wal_disabled_namespaces = {"cache"};
+
+  std::filesystem::remove_all(config.db_dir, ec);
+  ASSERT_TRUE(!ec);
+
+  auto storage = std::make_unique<engine::Storage>(&config);
+  auto s = storage->Open();
+  ASSERT_TRUE(s.IsOK());
+
+  ASSERT_TRUE(storage->NamespaceWriteOptions("cache").disableWAL);
+  ASSERT_FALSE(storage->NamespaceWriteOptions("ns1").disableWAL);
+  ASSERT_FALSE(storage->NamespaceWriteOptions(kDefaultNamespace).disableWAL);
+
+  redis::String cache(storage.get(), "cache");
+  redis::String ns1(storage.get(), "ns1");
+  ASSERT_EQ(0, storage->GetWALGapSeq());
+  ASSERT_TRUE(cache.Set("key", "cached").ok());
+  // the write without WAL leaves a gap in the WAL
+  auto gap_seq = storage->LatestSeqNumber();
+  ASSERT_EQ(gap_seq, storage->GetWALGapSeq());
+  ASSERT_TRUE(ns1.Set("key", "value").ok());
+  ASSERT_EQ(gap_seq, storage->GetWALGapSeq());
+  // the writes without WAL are persisted by flushing the memtables
+  ASSERT_TRUE(storage->FlushWALDisabledWrites().IsOK());
+  ASSERT_TRUE(storage->FlushWALDisabledWrites().IsOK());
+
+  storage->SetWALDisabledNamespaces({});
+  ASSERT_FALSE(storage->NamespaceWriteOptions("cache").disableWAL);
+
+  storage.reset();
+  storage = std::make_unique<engine::Storage>(&config);
+  s = storage->Open();
+  ASSERT_TRUE(s.IsOK());
+
+  std::string value;
+  ASSERT_TRUE(redis::String(storage.get(), "cache").Get("key", &value).ok());
+  ASSERT_EQ("cached", value);
+  ASSERT_TRUE(redis::String(storage.get(), "ns1").Get("key", &value).ok());
+  ASSERT_EQ("value", value);
+
+  storage.reset();
+  std::filesystem::remove_all(config.db_dir, ec);
+  ASSERT_TRUE(!ec);
+}
+
+TEST(Storage, WALDisabledEncodedNamespaces) {
+  std::error_code ec;
+
+  Config config;
+  config.db_dir = "test_wal_disabled_encoded_dir";
+  config.slot_id_encoded = false;
+  config.namespace_id_encoding = true;
+  config.wal_disabled_namespaces = {"cache"};
+
+  std::filesystem::remove_all(config.db_dir, ec);
+  ASSERT_TRUE(!ec);
+
+  auto storage = std::make_unique<engine::Storage>(&config);
+  auto s = storage->Open();
+  ASSERT_TRUE(s.IsOK());
+  ASSERT_TRUE(storage->AssignNamespaceID("cache").IsOK());
+  ASSERT_TRUE(storage->AssignNamespaceID("ns1").IsOK());
+
+  // the nested databases, e.g. of SORT ... STORE, are created with the encoded namespace
+  auto cache = storage->EncodeNamespace("cache");
+  ASSERT_TRUE(IsNamespaceID(cache));
+  ASSERT_TRUE(storage->NamespaceWriteOptions(cache).disableWAL);
+  ASSERT_FALSE(storage->NamespaceWriteOptions(storage->EncodeNamespace("ns1")).disableWAL);
+
+  redis::String nested(storage.get(), cache);
+  ASSERT_TRUE(nested.Set("key", "cached").ok());
+  ASSERT_EQ(storage->LatestSeqNumber(), storage->GetWALGapSeq());
+
+  storage.reset();
+  std::filesystem::remove_all(config.db_dir, ec);
+  ASSERT_TRUE(!ec);
+}
+
+TEST(Storage, PubSubFIFOCompaction) {
+  std::error_code ec;
+
+  Config config;
+  config.db_dir = "test_pubsub_fifo_dir";
+  config.slot_id_encoded = false;
+  config.rocks_db.pubsub_fifo_compaction = true;
+  config.rocks_db.pubsub_fifo_ttl = 600;
+
+  std::filesystem::remove_all(config.db_dir, ec);
+  ASSERT_TRUE(!ec);
+
+  auto storage = std::make_unique<engine::Storage>(&config);
+  auto s = storage->Open();
+  ASSERT_TRUE(s.IsOK());
+
+  auto pubsub_opts = storage->GetDB()->GetOptions(storage->GetCFHandle(ColumnFamilyID::PubSub));
+  ASSERT_EQ(pubsub_opts.compaction_style, rocksdb::kCompactionStyleFIFO);
+  ASSERT_EQ(pubsub_opts.ttl, 600U);
+  // the other column families still use the level compaction
+  auto propagate_opts = storage->GetDB()->GetOptions(storage->GetCFHandle(ColumnFamilyID::Propagate));
+  ASSERT_EQ(propagate_opts.compaction_style, rocksdb::kCompactionStyleLevel);
+
+  storage.reset();
+  std::filesystem::remove_all(config.db_dir, ec);
+}
@@ -0,0 +1,41 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ *
+ */
+
+#include "thread_util.h"
+
+#include <gtest/gtest.h>
+
+TEST(ThreadUtil, ParseCPUList) {
+  ASSERT_EQ(*util::ParseCPUList(""), std::vector<int>{});
+  ASSERT_EQ(*util::ParseCPUList("3"), std::vector<int>{3});
+  ASSERT_EQ(*util::ParseCPUList("8,0-3, 2,10-11"), (std::vector<int>{0, 1, 2, 3, 8, 10, 11}));
+
+  ASSERT_FALSE(util::ParseCPUList("3-1"));
+  ASSERT_FALSE(util::ParseCPUList("a-b"));
+  ASSERT_FALSE(util::ParseCPUList("-1"));
+  ASSERT_FALSE(util::ParseCPUList("1-"));
+}
+
+TEST(ThreadUtil, FormatCPUList) {
+  ASSERT_EQ(util::FormatCPUList({}), "");
+  ASSERT_EQ(util::FormatCPUList({5}), "5");
+  ASSERT_EQ(util::FormatCPUList({0, 1, 2, 3, 8, 10, 11}), "0-3,8,10-11");
+  ASSERT_EQ(util::FormatCPUList(*util::ParseCPUList("1-4,6")), "1-4,6");
+}
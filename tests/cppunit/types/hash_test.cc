@@ -21,10 +21,12 @@
 #include <gtest/gtest.h>
 
 #include <algorithm>
+#include <chrono>
 #include <climits>
 #include <memory>
 #include <random>
 #include <string>
+#include <thread>
 
 #include "parse_util.h"
 #include "test_base.h"
@@ -391,3 +393,138 @@ TEST_F(RedisHashTest, HRandField) {
 
   s = hash_->Del(key_);
 }
+
+TEST_F(RedisHashTest, HRandFieldFromLargeHash) {
+  // large enough to pick the fields by random seeks instead of loading the whole hash
+  std::vector<FieldValue> fvs;
+  std::vector<Slice> expired_fields;
+  for (int i = 0; i < 1000; i++) {
+    fvs.emplace_back("field-" + std::to_string(i), "value-" + std::to_string(i));
+  }
+  for (size_t i = 0; i < fvs.size(); i += 2) expired_fields.emplace_back(fvs[i].field);
+  uint64_t ret = 0;
+  auto s = hash_->MSet(key_, fvs, false, &ret);
+  EXPECT_TRUE(s.ok() && ret == fvs.size());
+  std::vector<int64_t> results;
+  s = hash_->ExpireFields(key_, util::GetTimeStampMS() + 100, expired_fields, HashFieldExpireFlag::kNone, &results);
+  EXPECT_TRUE(s.ok());
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  // the expired fields are never picked
+  for (int64_t count : {10, -10}) {
+    std::vector<FieldValue> picked;
+    s = hash_->RandField(key_, count, &picked, HashFetchType::kAll);
+    EXPECT_TRUE(s.ok());
+    EXPECT_EQ(picked.size(), 10);
+    for (const auto &fv : picked) {
+      auto i = *ParseInt<int>(fv.field.substr(6), 10);
+      EXPECT_EQ(i % 2, 1) << fv.field;
+      EXPECT_EQ(fv.value, "value-" + std::to_string(i));
+    }
+  }
+
+  s = hash_->Del(key_);
+}
+
+TEST_F(RedisHashTest, FieldExpiration) {
+  uint64_t ret = 0;
+  for (size_t i = 0; i < fields_.size(); i++) {
+    auto s = hash_->Set(key_, fields_[i], values_[i], &ret);
+    EXPECT_TRUE(s.ok() && ret == 1);
+  }
+
+  std::vector<int64_t> results;
+  uint64_t now = util::GetTimeStampMS();
+  auto s = hash_->ExpireFields(key_, now + 100000, {fields_[0], "no-exist-field"}, HashFieldExpireFlag::kNone,
+                               &results);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(results, std::vector<int64_t>({kHashFieldUpdated, kHashFieldNotExist}));
+
+  // the values should be kept after the encoding of the hash was changed
+  for (size_t i = 0; i < fields_.size(); i++) {
+    std::string got;
+    s = hash_->Get(key_, fields_[i], &got);
+    EXPECT_TRUE(s.ok());
+    EXPECT_EQ(values_[i], got);
+  }
+
+  std::vector<int64_t> expire_times;
+  s = hash_->GetFieldsExpireTime(key_, {fields_[0], fields_[1]}, &expire_times);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(expire_times, std::vector<int64_t>({static_cast<int64_t>(now + 100000), kHashFieldNoTTL}));
+
+  s = hash_->ExpireFields(key_, now + 200000, {fields_[0], fields_[1]}, HashFieldExpireFlag::kNX, &results);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(results, std::vector<int64_t>({kHashFieldConditionNotMet, kHashFieldUpdated}));
+
+  s = hash_->ExpireFields(key_, now + 150000, {fields_[0], fields_[1]}, HashFieldExpireFlag::kGT, &results);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(results, std::vector<int64_t>({kHashFieldUpdated, kHashFieldConditionNotMet}));
+
+  s = hash_->PersistFields(key_, {fields_[0], fields_[2]}, &results);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(results, std::vector<int64_t>({kHashFieldUpdated, kHashFieldNoTTL}));
+
+  // setting a field will clear its TTL
+  s = hash_->Set(key_, fields_[1], values_[1], &ret);
+  EXPECT_TRUE(s.ok() && ret == 0);
+  s = hash_->GetFieldsExpireTime(key_, {fields_[1]}, &expire_times);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(expire_times, std::vector<int64_t>({kHashFieldNoTTL}));
+
+  // expire time in the past will delete the field
+  s = hash_->ExpireFields(key_, now - 1, {fields_[2]}, HashFieldExpireFlag::kNone, &results);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(results, std::vector<int64_t>({kHashFieldDeleted}));
+
+  uint64_t size = 0;
+  s = hash_->Size(key_, &size);
+  EXPECT_TRUE(s.ok() && size == fields_.size() - 1);
+
+  s = hash_->Del(key_);
+}
+
+TEST_F(RedisHashTest, ExpiredFieldsAreInvisible) {
+  uint64_t ret = 0;
+  for (size_t i = 0; i < fields_.size(); i++) {
+    auto s = hash_->Set(key_, fields_[i], values_[i], &ret);
+    EXPECT_TRUE(s.ok() && ret == 1);
+  }
+
+  std::vector<int64_t> results;
+  auto s = hash_->ExpireFields(key_, util::GetTimeStampMS() + 100, {fields_[0]}, HashFieldExpireFlag::kNone, &results);
+  EXPECT_TRUE(s.ok());
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+
+  std::string got;
+  s = hash_->Get(key_, fields_[0], &got);
+  EXPECT_TRUE(s.IsNotFound());
+
+  std::vector<FieldValue> fvs;
+  s = hash_->GetAll(key_, &fvs);
+  EXPECT_TRUE(s.ok() && fvs.size() == fields_.size() - 1);
+
+  // the size is an upper bound, which still counts the expired field until it's touched
+  uint64_t size = 0;
+  s = hash_->Size(key_, &size);
+  EXPECT_TRUE(s.ok() && size == fields_.size());
+
+  // the expired field is regarded as a new field, but it's counted in the size already
+  s = hash_->Set(key_, fields_[0], values_[0], &ret);
+  EXPECT_TRUE(s.ok() && ret == 1);
+  s = hash_->Get(key_, fields_[0], &got);
+  EXPECT_TRUE(s.ok() && got == values_[0].ToString());
+  s = hash_->Size(key_, &size);
+  EXPECT_TRUE(s.ok() && size == fields_.size());
+
+  // deleting an expired field isn't counted in the reply, but it's no longer counted in the size
+  s = hash_->ExpireFields(key_, util::GetTimeStampMS() + 100, {fields_[1]}, HashFieldExpireFlag::kNone, &results);
+  EXPECT_TRUE(s.ok());
+  std::this_thread::sleep_for(std::chrono::milliseconds(200));
+  s = hash_->Delete(key_, {fields_[1]}, &ret);
+  EXPECT_TRUE(s.ok() && ret == 0);
+  s = hash_->Size(key_, &size);
+  EXPECT_TRUE(s.ok() && size == fields_.size() - 1);
+
+  s = hash_->Del(key_);
+}
@@ -20,7 +20,9 @@
 
 #include <gtest/gtest.h>
 
+#include <map>
 #include <memory>
+#include <set>
 
 #include "test_base.h"
 #include "types/redis_set.h"
@@ -68,6 +70,24 @@ TEST_F(RedisSetTest, AddAndRemoveRepeated) {
   EXPECT_EQ(card, allmembers.size() - 1 - ret);
 }
 
+TEST_F(RedisSetTest, AddManyMembers) {
+  // enough members to be merge-walked instead of point lookups
+  std::vector<std::string> existing, incoming;
+  for (int i = 0; i < 1000; i += 2) existing.emplace_back("m" + std::to_string(i));
+  for (int i = 999; i >= 0; i--) incoming.emplace_back("m" + std::to_string(i));
+  incoming.emplace_back("m1");
+
+  uint64_t ret = 0;
+  rocksdb::Status s = set_->Add(key_, std::vector<rocksdb::Slice>(existing.begin(), existing.end()), &ret);
+  EXPECT_TRUE(s.ok() && existing.size() == ret);
+  s = set_->Add(key_, std::vector<rocksdb::Slice>(incoming.begin(), incoming.end()), &ret);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(ret, 500);
+  s = set_->Card(key_, &ret);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(ret, 1000);
+}
+
 TEST_F(RedisSetTest, Members) {
   uint64_t ret = 0;
   rocksdb::Status s = set_->Add(key_, fields_, &ret);
@@ -274,3 +294,93 @@ TEST_F(RedisSetTest, TakeWithoutPop) {
   s = set_->Remove(key_, fields_, &ret);
   EXPECT_TRUE(s.ok() && fields_.size() == ret);
 }
+
+TEST_F(RedisSetTest, TakeFromLargeSet) {
+  // large enough for SPOP to pick members by random seeks instead of loading the whole set
+  std::vector<std::string> members;
+  for (int i = 0; i < 2000; i++) {
+    members.emplace_back("member-" + std::to_string(i));
+  }
+  uint64_t ret = 0;
+  rocksdb::Status s = set_->Add(key_, std::vector<Slice>(members.begin(), members.end()), &ret);
+  EXPECT_TRUE(s.ok() && ret == members.size());
+  std::set<std::string> all_members(members.begin(), members.end());
+
+  std::vector<std::string> taken;
+  s = set_->Take(key_, &taken, 10, false);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(taken.size(), 10);
+  EXPECT_EQ(std::set<std::string>(taken.begin(), taken.end()).size(), 10);
+  for (const auto &member : taken) {
+    EXPECT_TRUE(all_members.count(member));
+  }
+
+  s = set_->Take(key_, &taken, -20, false);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(taken.size(), 20);
+
+  s = set_->Take(key_, &taken, 100, true);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(taken.size(), 100);
+  uint64_t card = 0;
+  s = set_->Card(key_, &card);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(card, members.size() - 100);
+  for (const auto &member : taken) {
+    bool flag = true;
+    s = set_->IsMember(key_, member, &flag);
+    EXPECT_TRUE(s.ok() && !flag);
+  }
+}
+
+TEST_F(RedisSetTest, RandMemberFromLargeSet) {
+  // SRANDMEMBER picks the members of a large set by random seeks as well
+  std::vector<std::string> members;
+  for (int i = 0; i < 1000; i++) {
+    members.emplace_back("member-" + std::to_string(i));
+  }
+  uint64_t ret = 0;
+  rocksdb::Status s = set_->Add(key_, std::vector<Slice>(members.begin(), members.end()), &ret);
+  EXPECT_TRUE(s.ok() && ret == members.size());
+  std::set<std::string> all_members(members.begin(), members.end());
+
+  std::map<std::string, int> hits;
+  std::vector<std::string> taken;
+  for (int i = 0; i < 200; i++) {
+    s = set_->Take(key_, &taken, 100, false);
+    EXPECT_TRUE(s.ok());
+    EXPECT_EQ(taken.size(), 100);
+    EXPECT_EQ(std::set<std::string>(taken.begin(), taken.end()).size(), 100);
+    for (const auto &member : taken) hits[member]++;
+  }
+  for (const auto &[member, n] : hits) {
+    EXPECT_TRUE(all_members.count(member)) << member;
+  }
+  // no probe lands on the first member, which is picked with the average chance instead,
+  // so it's expected to be picked 20 times
+  EXPECT_GT(hits["member-0"], 0);
+  EXPECT_LE(hits["member-0"], 60);
+}
+
+TEST_F(RedisSetTest, PopAllFromLargeSet) {
+  std::vector<std::string> members;
+  for (int i = 0; i < 2000; i++) {
+    members.emplace_back("member-" + std::to_string(i));
+  }
+  uint64_t ret = 0;
+  rocksdb::Status s = set_->Add(key_, std::vector<Slice>(members.begin(), members.end()), &ret);
+  EXPECT_TRUE(s.ok() && ret == members.size());
+
+  // every member is popped once, though SPOP doesn't pick them uniformly
+  std::set<std::string> popped;
+  std::vector<std::string> taken;
+  for (size_t i = 0; i < members.size(); i++) {
+    s = set_->Take(key_, &taken, 16, true);
+    EXPECT_TRUE(s.ok());
+    if (taken.empty()) break;
+    for (const auto &member : taken) {
+      EXPECT_TRUE(popped.insert(member).second) << member;
+    }
+  }
+  EXPECT_EQ(popped, std::set<std::string>(members.begin(), members.end()));
+}
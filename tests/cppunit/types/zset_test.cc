@@ -21,6 +21,7 @@
 #include <gtest/gtest.h>
 
 #include <memory>
+#include <unordered_set>
 
 #include "test_base.h"
 #include "types/redis_zset.h"
@@ -59,6 +60,43 @@ TEST_F(RedisZSetTest, Add) {
   auto s = zset_->Del(key_);
 }
 
+TEST_F(RedisZSetTest, AddManyMembers) {
+  // enough members to be merge-walked instead of point lookups
+  uint64_t ret = 0;
+  std::vector<MemberScore> mscores;
+  for (int i = 0; i < 1000; i += 2) {
+    mscores.emplace_back(MemberScore{"m" + std::to_string(i), static_cast<double>(i)});
+  }
+  auto s = zset_->Add(key_, ZAddFlags::Default(), &mscores, &ret);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(ret, 500);
+
+  mscores.clear();
+  for (int i = 999; i >= 0; i--) {
+    mscores.emplace_back(MemberScore{"m" + std::to_string(i), static_cast<double>(-i)});
+  }
+  s = zset_->Add(key_, ZAddFlags::Default(), &mscores, &ret);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(ret, 500);
+
+  s = zset_->Card(key_, &ret);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(ret, 1000);
+  for (int i = 0; i < 1000; i += 111) {
+    double got = 0.0;
+    s = zset_->Score(key_, "m" + std::to_string(i), &got);
+    EXPECT_TRUE(s.ok());
+    EXPECT_EQ(got, -i);
+  }
+
+  std::vector<MemberScore> min_members;
+  s = zset_->Pop(key_, 1, true, &min_members);
+  EXPECT_TRUE(s.ok());
+  ASSERT_EQ(min_members.size(), 1);
+  EXPECT_EQ(min_members[0].member, "m999");
+  s = zset_->Del(key_);
+}
+
 TEST_F(RedisZSetTest, IncrBy) {
   uint64_t ret = 0;
   std::vector<MemberScore> mscores;
@@ -536,6 +574,34 @@ TEST_F(RedisZSetTest, RandMember) {
   EXPECT_TRUE(s.ok());
 }
 
+TEST_F(RedisZSetTest, RandMemberFromLargeZSet) {
+  // large enough to pick members by random seeks instead of loading the whole zset
+  std::vector<MemberScore> in_mscores;
+  for (int i = 0; i < 2000; i++) {
+    in_mscores.emplace_back(MemberScore{"member-" + std::to_string(i), static_cast<double>(i)});
+  }
+  uint64_t ret = 0;
+  auto s = zset_->Add(key_, ZAddFlags::Default(), &in_mscores, &ret);
+  EXPECT_TRUE(s.ok());
+  EXPECT_EQ(in_mscores.size(), ret);
+
+  for (int64_t count : {10, -10}) {
+    std::vector<MemberScore> mscores;
+    s = zset_->RandMember(key_, count, &mscores);
+    EXPECT_TRUE(s.ok());
+    EXPECT_EQ(10, mscores.size());
+    std::unordered_set<std::string> members;
+    for (const auto &ms : mscores) {
+      members.insert(ms.member);
+      EXPECT_EQ("member-" + std::to_string(static_cast<int>(ms.score)), ms.member);
+    }
+    if (count > 0) EXPECT_EQ(10, members.size());
+  }
+
+  s = zset_->Del(key_);
+  EXPECT_TRUE(s.ok());
+}
+
 TEST_F(RedisZSetTest, Diff) {
   uint64_t ret = 0;
 
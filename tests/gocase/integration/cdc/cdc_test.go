@@ -0,0 +1,122 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+package cdc
+
+import (
+	"context"
+	"strconv"
+	"testing"
+
+	"github.com/apache/kvrocks/tests/gocase/util"
+	"github.com/stretchr/testify/require"
+)
+
+func readArrayLen(t *testing.T, c *util.TCPClient) int {
+	r, err := c.ReadLine()
+	require.NoError(t, err)
+	require.EqualValues(t, '*', r[0])
+	n, err := strconv.Atoi(r[1:])
+	require.NoError(t, err)
+	return n
+}
+
+func readBulkString(t *testing.T, c *util.TCPClient) string {
+	_, err := c.ReadLine()
+	require.NoError(t, err)
+	r, err := c.ReadLine()
+	require.NoError(t, err)
+	return r
+}
+
+// readEvents reads the CDC frames until n events are received, heartbeat frames are skipped
+func readEvents(t *testing.T, c *util.TCPClient, n int) [][]string {
+	var events [][]string
+	for len(events) < n {
+		require.Equal(t, 3, readArrayLen(t, c))
+		require.Equal(t, "cdc", readBulkString(t, c))
+		c.MustMatch(t, `^:\d+$`)
+		count := readArrayLen(t, c)
+		for i := 0; i < count; i++ {
+			require.Equal(t, 2, readArrayLen(t, c))
+			event := []string{readBulkString(t, c)}
+			args := readArrayLen(t, c)
+			for j := 0; j < args; j++ {
+				event = append(event, readBulkString(t, c))
+			}
+			events = append(events, event)
+		}
+	}
+	return events
+}
+
+func TestCDCSync(t *testing.T) {
+	srv := util.StartServer(t, map[string]string{})
+	defer srv.Close()
+
+	ctx := context.Background()
+	rdb := srv.NewClient()
+	defer func() { require.NoError(t, rdb.Close()) }()
+
+	offset, err := strconv.ParseInt(util.FindInfoEntry(rdb, "master_repl_offset"), 10, 64)
+	require.NoError(t, err)
+	seq := strconv.FormatInt(offset+1, 10)
+
+	require.NoError(t, rdb.Set(ctx, "a", "1", 0).Err())
+	require.NoError(t, rdb.HSet(ctx, "h", "f", "v").Err())
+	require.NoError(t, rdb.Del(ctx, "a").Err())
+
+	t.Run("CDCSYNC streams all updates since the sequence", func(t *testing.T) {
+		c := srv.NewTCPClient()
+		defer func() { require.NoError(t, c.Close()) }()
+		require.NoError(t, c.WriteArgs("CDCSYNC", seq))
+		c.MustRead(t, "+OK")
+		require.Equal(t, [][]string{
+			{"__namespace", "SET", "a", "1"},
+			{"__namespace", "HSET", "h", "f", "v"},
+			{"__namespace", "DEL", "a"},
+		}, readEvents(t, c, 3))
+
+		require.EqualValues(t, "1", util.FindInfoEntry(rdb, "connected_cdc_consumers"))
+
+		require.NoError(t, rdb.SAdd(ctx, "s", "m").Err())
+		require.Equal(t, [][]string{{"__namespace", "SADD", "s", "m"}}, readEvents(t, c, 1))
+	})
+
+	t.Run("CDCSYNC filters the updates by key pattern and type", func(t *testing.T) {
+		c := srv.NewTCPClient()
+		defer func() { require.NoError(t, c.Close()) }()
+		require.NoError(t, c.WriteArgs("CDCSYNC", seq, "MATCH", "h*", "TYPE", "hash"))
+		c.MustRead(t, "+OK")
+		require.Equal(t, [][]string{{"__namespace", "HSET", "h", "f", "v"}}, readEvents(t, c, 1))
+
+		// updates of other types or keys are skipped
+		require.NoError(t, rdb.SAdd(ctx, "h1", "m").Err())
+		require.NoError(t, rdb.HSet(ctx, "x", "f", "v").Err())
+		require.NoError(t, rdb.HSet(ctx, "h2", "f", "v").Err())
+		require.Equal(t, [][]string{{"__namespace", "HSET", "h2", "f", "v"}}, readEvents(t, c, 1))
+	})
+
+	t.Run("CDCSYNC with invalid arguments", func(t *testing.T) {
+		require.ErrorContains(t, rdb.Do(ctx, "CDCSYNC", "a").Err(), "not started as an integer")
+		require.ErrorContains(t, rdb.Do(ctx, "CDCSYNC", seq, "TYPE", "none").Err(), "Invalid type")
+		require.ErrorContains(t, rdb.Do(ctx, "CDCSYNC", seq, "BATCH", "0").Err(), "out of numeric range")
+		require.ErrorContains(t, rdb.Do(ctx, "CDCSYNC", "100000000").Err(), "sequence out of range")
+	})
+}
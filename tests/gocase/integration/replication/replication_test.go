@@ -509,3 +509,188 @@ func TestShouldNotReplicate(t *testing.T) {
 		require.Equal(t, "master", util.FindInfoEntry(masterClient, "role"))
 	})
 }
+
+func TestReplicationPubSubSideChannel(t *testing.T) {
+	ctx := context.Background()
+
+	master := util.StartServer(t, map[string]string{"repl-pubsub-side-channel": "yes"})
+	defer master.Close()
+	masterClient := master.NewClient()
+	defer func() { require.NoError(t, masterClient.Close()) }()
+
+	slave := util.StartServer(t, map[string]string{})
+	defer slave.Close()
+	slaveClient := slave.NewClient()
+	defer func() { require.NoError(t, slaveClient.Close()) }()
+
+	util.SlaveOf(t, slaveClient, master)
+	util.WaitForSync(t, slaveClient)
+
+	sub := slaveClient.Subscribe(ctx, "chan")
+	defer func() { require.NoError(t, sub.Close()) }()
+	_, err := sub.Receive(ctx)
+	require.NoError(t, err)
+
+	receiveMessage := func() string {
+		ctx, cancel := context.WithTimeout(ctx, 5*time.Second)
+		defer cancel()
+		msg, err := sub.ReceiveMessage(ctx)
+		require.NoError(t, err)
+		require.Equal(t, "chan", msg.Channel)
+		return msg.Payload
+	}
+
+	t.Run("The published messages are replicated without writing the WAL", func(t *testing.T) {
+		offset := util.FindInfoEntry(masterClient, "master_repl_offset")
+		require.NoError(t, masterClient.Publish(ctx, "chan", "hello").Err())
+		require.NoError(t, masterClient.Publish(ctx, "chan", "world").Err())
+		require.Equal(t, "hello", receiveMessage())
+		require.Equal(t, "world", receiveMessage())
+		require.Equal(t, offset, util.FindInfoEntry(masterClient, "master_repl_offset"))
+	})
+
+	t.Run("The published empty messages are replicated without reconnecting", func(t *testing.T) {
+		syncs := util.FindInfoEntry(masterClient, "sync_partial_ok")
+		require.NoError(t, masterClient.Publish(ctx, "chan", "").Err())
+		require.NoError(t, masterClient.Publish(ctx, "chan", "after empty").Err())
+		require.Equal(t, "", receiveMessage())
+		require.Equal(t, "after empty", receiveMessage())
+		require.Equal(t, "up", util.FindInfoEntry(slaveClient, "master_link_status"))
+		require.Equal(t, syncs, util.FindInfoEntry(masterClient, "sync_partial_ok"))
+	})
+
+	t.Run("The published messages are replicated via the WAL if the side channel is disabled", func(t *testing.T) {
+		require.NoError(t, masterClient.ConfigSet(ctx, "repl-pubsub-side-channel", "no").Err())
+		offset := util.FindInfoEntry(masterClient, "master_repl_offset")
+		require.NoError(t, masterClient.Publish(ctx, "chan", "via wal").Err())
+		require.Equal(t, "via wal", receiveMessage())
+		require.NotEqual(t, offset, util.FindInfoEntry(masterClient, "master_repl_offset"))
+	})
+
+	t.Run("The published messages are replicated via the WAL once the replica has its own replica", func(t *testing.T) {
+		require.NoError(t, masterClient.ConfigSet(ctx, "repl-pubsub-side-channel", "yes").Err())
+
+		subSlave := util.StartServer(t, map[string]string{})
+		defer subSlave.Close()
+		subSlaveClient := subSlave.NewClient()
+		defer func() { require.NoError(t, subSlaveClient.Close()) }()
+		util.SlaveOf(t, subSlaveClient, slave)
+		util.WaitForSync(t, subSlaveClient)
+
+		subSlaveSub := subSlaveClient.Subscribe(ctx, "chan")
+		defer func() { require.NoError(t, subSlaveSub.Close()) }()
+		_, err := subSlaveSub.Receive(ctx)
+		require.NoError(t, err)
+
+		// the replica reconnects to its master without the side channel
+		require.Eventually(t, func() bool {
+			offset := util.FindInfoEntry(masterClient, "master_repl_offset")
+			require.NoError(t, masterClient.Publish(ctx, "chan", "chained").Err())
+			return offset != util.FindInfoEntry(masterClient, "master_repl_offset")
+		}, 10*time.Second, 100*time.Millisecond)
+		require.NoError(t, masterClient.Publish(ctx, "chan", "to sub-replica").Err())
+		ctx, cancel := context.WithTimeout(ctx, 10*time.Second)
+		defer cancel()
+		for {
+			msg, err := subSlaveSub.ReceiveMessage(ctx)
+			require.NoError(t, err)
+			if msg.Payload == "to sub-replica" {
+				break
+			}
+		}
+	})
+}
+
+func TestReplicationPubSubSideChannelWithFullSync(t *testing.T) {
+	ctx := context.Background()
+
+	master := util.StartServer(t, map[string]string{"repl-pubsub-side-channel": "yes"})
+	defer master.Close()
+	masterClient := master.NewClient()
+	defer func() { require.NoError(t, masterClient.Close()) }()
+
+	offset := util.FindInfoEntry(masterClient, "master_repl_offset")
+	require.NoError(t, masterClient.Publish(ctx, "chan", "no replica").Err())
+	require.Equal(t, offset, util.FindInfoEntry(masterClient, "master_repl_offset"))
+
+	t.Run("The published messages are replicated via the WAL while a replica is in the full sync", func(t *testing.T) {
+		c := master.NewTCPClient()
+		defer func() { require.NoError(t, c.Close()) }()
+		require.NoError(t, c.WriteArgs("replconf", "listening-port", "1234", "capa", "pubsub"))
+		c.MustRead(t, "+OK")
+		require.NoError(t, c.WriteArgs("_fetch_meta"))
+		// the replica isn't fed by the WAL until it PSYNC from the checkpoint
+		require.Eventually(t, func() bool {
+			offset := util.FindInfoEntry(masterClient, "master_repl_offset")
+			require.NoError(t, masterClient.Publish(ctx, "chan", "in full sync").Err())
+			return offset != util.FindInfoEntry(masterClient, "master_repl_offset")
+		}, 5*time.Second, 100*time.Millisecond)
+	})
+}
+
+func TestReplicationSubkeyEncodingMismatch(t *testing.T) {
+	master := util.StartServer(t, map[string]string{})
+	defer master.Close()
+
+	c := master.NewTCPClient()
+	defer func() { require.NoError(t, c.Close()) }()
+
+	// no valid build uses this version, so it never matches the master
+	require.NoError(t, c.WriteArgs("replconf", "subkey-encoding-version", "255"))
+	c.MustRead(t, "+OK")
+
+	t.Run("PSYNC is rejected with a mismatched sub key encoding version", func(t *testing.T) {
+		require.NoError(t, c.WriteArgs("psync", "1"))
+		c.MustMatch(t, "mismatched sub key encoding version, the replica uses 255")
+	})
+
+	t.Run("Full sync is rejected with a mismatched sub key encoding version", func(t *testing.T) {
+		require.NoError(t, c.WriteArgs("_fetch_meta"))
+		c.MustMatch(t, "mismatched sub key encoding version, the replica uses 255")
+	})
+}
+
+func TestReplicationWALDisabledNamespaces(t *testing.T) {
+	ctx := context.Background()
+
+	master := util.StartServer(t, map[string]string{})
+	defer master.Close()
+	masterClient := master.NewClient()
+	defer func() { require.NoError(t, masterClient.Close()) }()
+
+	t.Run("Mix the writes with and without the WAL before a replica is attached", func(t *testing.T) {
+		require.NoError(t, masterClient.Set(ctx, "wal-key1", "v1", 0).Err())
+		require.NoError(t, masterClient.ConfigSet(ctx, "wal-disabled-namespaces", "__namespace").Err())
+		require.NoError(t, masterClient.Set(ctx, "no-wal-key", "v2", 0).Err())
+		require.NoError(t, masterClient.ConfigSet(ctx, "wal-disabled-namespaces", "").Err())
+		require.NoError(t, masterClient.Set(ctx, "wal-key2", "v3", 0).Err())
+	})
+
+	replica := util.StartServer(t, map[string]string{})
+	defer replica.Close()
+	replicaClient := replica.NewClient()
+	defer func() { require.NoError(t, replicaClient.Close()) }()
+
+	t.Run("Replica can't resume from before the gap in the WAL, so it falls back to full sync", func(t *testing.T) {
+		util.SlaveOf(t, replicaClient, master)
+		require.Eventually(t, func() bool {
+			return util.FindInfoEntry(replicaClient, "master_link_status") == "up"
+		}, 10*time.Second, 100*time.Millisecond)
+		require.Eventually(t, func() bool {
+			return replicaClient.Get(ctx, "wal-key2").Val() == "v3"
+		}, 5*time.Second, 100*time.Millisecond)
+		require.Equal(t, "v1", replicaClient.Get(ctx, "wal-key1").Val())
+
+		// the replication goes on with the later writes
+		require.NoError(t, masterClient.Set(ctx, "wal-key3", "v4", 0).Err())
+		util.WaitForOffsetSync(t, masterClient, replicaClient)
+		require.Equal(t, "v4", replicaClient.Get(ctx, "wal-key3").Val())
+	})
+
+	t.Run("wal-disabled-namespaces can't be set while replicas are attached", func(t *testing.T) {
+		err := masterClient.ConfigSet(ctx, "wal-disabled-namespaces", "__namespace").Err()
+		require.ErrorContains(t, err, "replicas or CDC consumers are attached")
+		require.Equal(t, map[string]string{"wal-disabled-namespaces": ""},
+			masterClient.ConfigGet(ctx, "wal-disabled-namespaces").Val())
+	})
+}
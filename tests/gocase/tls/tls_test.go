@@ -23,6 +23,8 @@ import (
 	"context"
 	"crypto/tls"
 	"fmt"
+	"os"
+	"strings"
 	"testing"
 	"time"
 
@@ -137,6 +139,65 @@ func TestTLS(t *testing.T) {
 		require.NoError(t, rdb.ConfigSet(ctx, "tls-protocols", "").Err())
 		require.NoError(t, rdb.ConfigSet(ctx, "tls-ciphers", "DEFAULT").Err())
 	})
+
+	t.Run("TLS: Verify tls-ktls can be set and get", func(t *testing.T) {
+		require.Equal(t, map[string]string{"tls-ktls": "no"}, rdb.ConfigGet(ctx, "tls-ktls").Val())
+
+		require.NoError(t, rdb.ConfigSet(ctx, "tls-ktls", "yes").Err())
+		require.Equal(t, map[string]string{"tls-ktls": "yes"}, rdb.ConfigGet(ctx, "tls-ktls").Val())
+		doWithTLSClient(defaultTLSConfig, func(c *redis.Client) { require.Equal(t, "PONG", c.Ping(ctx).Val()) })
+
+		require.NoError(t, rdb.ConfigSet(ctx, "tls-ktls", "no").Err())
+		require.Equal(t, map[string]string{"tls-ktls": "no"}, rdb.ConfigGet(ctx, "tls-ktls").Val())
+		require.Error(t, rdb.ConfigSet(ctx, "tls-ktls", "maybe").Err())
+	})
+
+	t.Run("TLS: Verify the sessions are handed to the kernel with tls-ktls", func(t *testing.T) {
+		if _, err := os.Stat("/sys/module/tls"); err != nil {
+			t.Skip("kTLS isn't supported by the kernel")
+		}
+
+		require.NoError(t, rdb.ConfigSet(ctx, "tls-ktls", "yes").Err())
+		defer func() { require.NoError(t, rdb.ConfigSet(ctx, "tls-ktls", "no").Err()) }()
+
+		sendSessions := util.FindInfoEntry(rdb, "ktls_send_sessions")
+		// the kernel only offloads AES-GCM and ChaCha20-Poly1305
+		tlsConfig, err := util.DefaultTLSConfig()
+		require.NoError(t, err)
+		tlsConfig.MaxVersion = tls.VersionTLS12
+		tlsConfig.CipherSuites = []uint16{tls.TLS_RSA_WITH_AES_128_GCM_SHA256}
+		doWithTLSClient(tlsConfig, func(c *redis.Client) {
+			// the value spans many records in both directions
+			value := strings.Repeat("x", 1024*1024)
+			require.NoError(t, c.Set(ctx, "ktls", value, 0).Err())
+			require.Equal(t, value, c.Get(ctx, "ktls").Val())
+		})
+
+		if srv.LogFileMatches(t, "kTLS isn't supported by the linked OpenSSL") {
+			t.Skip("kTLS isn't supported by the linked OpenSSL")
+		}
+		if util.FindInfoEntry(rdb, "ktls_send_sessions") == sendSessions {
+			t.Skip("the linked OpenSSL isn't built with kTLS")
+		}
+	})
+}
+
+func TestTLSKTLSWithoutTLS(t *testing.T) {
+	if !util.TLSEnable() {
+		t.Skip("TLS tests run only if tls enabled.")
+	}
+
+	ctx := context.Background()
+
+	srv := util.StartServer(t, map[string]string{})
+	defer srv.Close()
+
+	rdb := srv.NewClient()
+	defer func() { require.NoError(t, rdb.Close()) }()
+
+	require.ErrorContains(t, rdb.ConfigSet(ctx, "tls-ktls", "yes").Err(), "tls-port")
+	require.Equal(t, map[string]string{"tls-ktls": "no"}, rdb.ConfigGet(ctx, "tls-ktls").Val())
+	require.NoError(t, rdb.ConfigSet(ctx, "tls-ktls", "no").Err())
 }
 
 func TestTLSReplica(t *testing.T) {
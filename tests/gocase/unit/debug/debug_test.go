@@ -143,3 +143,31 @@ func TestDebugDBSizeLimit(t *testing.T) {
 		require.NoError(t, r.Err())
 	})
 }
+
+func TestDebugProfile(t *testing.T) {
+	srv := util.StartServer(t, map[string]string{})
+	defer srv.Close()
+
+	ctx := context.Background()
+	rdb := srv.NewClient()
+	defer func() { require.NoError(t, rdb.Close()) }()
+
+	t.Run("debug profile with invalid arguments", func(t *testing.T) {
+		require.Error(t, rdb.Do(ctx, "DEBUG", "PROFILE", "START", "0").Err())
+		require.Error(t, rdb.Do(ctx, "DEBUG", "PROFILE", "UNKNOWN").Err())
+		util.ErrorRegexp(t, rdb.Do(ctx, "DEBUG", "PROFILE", "STOP").Err(), ".*isn't running.*")
+	})
+
+	t.Run("debug profile collects stacks", func(t *testing.T) {
+		require.NoError(t, rdb.Do(ctx, "DEBUG", "PROFILE", "START", "1000").Err())
+		util.ErrorRegexp(t, rdb.Do(ctx, "DEBUG", "PROFILE", "START").Err(), ".*already running.*")
+
+		for i := 0; i < 10000; i++ {
+			require.NoError(t, rdb.Set(ctx, "profile-key", i, 0).Err())
+		}
+
+		stacks, err := rdb.Do(ctx, "DEBUG", "PROFILE", "STOP").Text()
+		require.NoError(t, err)
+		require.Regexp(t, `(?m)^\S+ [0-9]+$`, stacks)
+	})
+}
@@ -23,6 +23,7 @@ import (
 	"context"
 	"fmt"
 	"strconv"
+	"strings"
 	"testing"
 	"time"
 
@@ -72,6 +73,28 @@ func TestInfo(t *testing.T) {
 		require.Greater(t, MustAtoi(t, r), 0)
 	})
 
+	t.Run("get compaction auto-tune decisions by INFO", func(t *testing.T) {
+		require.Equal(t, "no", util.FindInfoEntry(rdb, "compaction_auto_tune", "rocksdb"))
+
+		require.NoError(t, rdb.ConfigSet(ctx, "compaction-auto-tune-min-io-mb", "16").Err())
+		require.NoError(t, rdb.ConfigSet(ctx, "compaction-auto-tune-max-io-mb", "64").Err())
+		require.NoError(t, rdb.ConfigSet(ctx, "compaction-auto-tune", "yes").Err())
+		require.Eventually(t, func() bool {
+			return util.FindInfoEntry(rdb, "compaction_auto_tune", "rocksdb") == "yes"
+		}, 5*time.Second, 100*time.Millisecond)
+
+		rate := MustAtoi(t, util.FindInfoEntry(rdb, "compaction_auto_tune_io_rate_mb", "rocksdb"))
+		require.GreaterOrEqual(t, rate, 16)
+		require.LessOrEqual(t, rate, 64)
+		require.Contains(t, []string{"throttle", "boost", "hold"},
+			util.FindInfoEntry(rdb, "compaction_auto_tune_last_decision", "rocksdb"))
+
+		require.NoError(t, rdb.ConfigSet(ctx, "compaction-auto-tune", "no").Err())
+		require.Eventually(t, func() bool {
+			return util.FindInfoEntry(rdb, "compaction_auto_tune", "rocksdb") == "no"
+		}, 5*time.Second, 100*time.Millisecond)
+	})
+
 	t.Run("get bgsave information by INFO", func(t *testing.T) {
 		require.Equal(t, "0", util.FindInfoEntry(rdb, "bgsave_in_progress", "persistence"))
 		require.Equal(t, "ok", util.FindInfoEntry(rdb, "last_bgsave_status", "persistence"))
@@ -95,6 +118,46 @@ func TestInfo(t *testing.T) {
 		require.Less(t, lastBgsaveTimeSec, 3)
 	})
 
+	t.Run("get clients memory by INFO", func(t *testing.T) {
+		usedMemoryClients := func() int {
+			return MustAtoi(t, util.FindInfoEntry(rdb, "used_memory_clients", "memory"))
+		}
+		before := usedMemoryClients()
+
+		// the partial commands are kept in the query buffers until they're completed
+		const bulkLen = 1024 * 1024
+		var clients []*util.TCPClient
+		for i := 0; i < 4; i++ {
+			c := srv.NewTCPClient()
+			clients = append(clients, c)
+			require.NoError(t, c.Write(fmt.Sprintf("*3\r\n$3\r\nSET\r\n$3\r\nkey\r\n$%d\r\n", bulkLen)))
+			require.NoError(t, c.Write(strings.Repeat("x", bulkLen/2)))
+		}
+		require.Eventually(t, func() bool {
+			return usedMemoryClients() >= before+4*bulkLen/2
+		}, 5*time.Second, 100*time.Millisecond)
+
+		for _, c := range clients {
+			require.NoError(t, c.Close())
+		}
+		require.Eventually(t, func() bool {
+			return usedMemoryClients() < before+bulkLen/2
+		}, 5*time.Second, 100*time.Millisecond)
+
+		v := rdb.ClientList(ctx).Val()
+		require.Regexp(t, "qbuf=[0-9]+ argv-mem=[0-9]+ obuf=[0-9]+ tot-mem=[0-9]+ ", v)
+	})
+
+	t.Run("get memory breakdown by INFO", func(t *testing.T) {
+		require.NoError(t, rdb.Set(ctx, "memory-breakdown", "value", 0).Err())
+		require.Greater(t, MustAtoi(t, util.FindInfoEntry(rdb, "used_memory_rocksdb_memtables", "memory")), 0)
+		require.GreaterOrEqual(t, MustAtoi(t, util.FindInfoEntry(rdb, "used_memory_rocksdb_caches", "memory")), 0)
+		require.GreaterOrEqual(t, MustAtoi(t, util.FindInfoEntry(rdb, "used_memory_pubsub", "memory")), 0)
+		require.Equal(t, "0", util.FindInfoEntry(rdb, "used_memory_search_executors", "memory"))
+		require.Regexp(t, "memtables=[0-9]+,table_readers=[0-9]+,block_cache=[0-9]+",
+			util.FindInfoEntry(rdb, `used_memory_rocksdb\[default\]`, "memory"))
+	})
+
 	t.Run("get cluster information by INFO - cluster not enabled", func(t *testing.T) {
 		require.Equal(t, "0", util.FindInfoEntry(rdb, "cluster_enabled", "cluster"))
 	})
@@ -104,6 +167,62 @@ func TestInfo(t *testing.T) {
 	})
 }
 
+func TestInfoCPUAffinity(t *testing.T) {
+	srv := util.StartServer(t, map[string]string{
+		"workers":             "2",
+		"worker-cpulist":      "0",
+		"task-runner-cpulist": "0",
+	})
+	defer srv.Close()
+
+	rdb := srv.NewClient()
+	defer func() { require.NoError(t, rdb.Close()) }()
+
+	require.Equal(t, "0", util.FindInfoEntry(rdb, "worker_cpulist", "cpu"))
+	require.Equal(t, "0", util.FindInfoEntry(rdb, "task_runner_cpulist", "cpu"))
+	require.Equal(t, "", util.FindInfoEntry(rdb, "rocksdb_cpulist", "cpu"))
+	require.Equal(t, "no", util.FindInfoEntry(rdb, "worker_numa_bind", "cpu"))
+	// the list is reused if there are more workers than CPUs
+	for _, worker := range []string{"worker0_affinity", "worker1_affinity"} {
+		require.Regexp(t, "^cpu=0,numa_node=-?[0-9]+,numa_bound=0$", util.FindInfoEntry(rdb, worker, "cpu"))
+	}
+}
+
+func TestInfoBlockCacheDump(t *testing.T) {
+	srv := util.StartServer(t, map[string]string{
+		"rocksdb.block_cache_dump": "yes",
+	})
+	defer srv.Close()
+
+	ctx := context.Background()
+	rdb := srv.NewClient()
+	defer func() { require.NoError(t, rdb.Close()) }()
+
+	require.Equal(t, "none", util.FindInfoEntry(rdb, "block_cache_prewarm_status", "rocksdb"))
+	require.Equal(t, "0", util.FindInfoEntry(rdb, "block_cache_last_dump_time", "rocksdb"))
+
+	util.Populate(t, rdb, "key:", 1024, 1024)
+	require.NoError(t, rdb.Do(ctx, "COMPACT").Err())
+	require.Eventually(t, func() bool {
+		return util.FindInfoEntry(rdb, "is_compacting", "rocksdb") == "no"
+	}, 10*time.Second, 100*time.Millisecond)
+	// read the keys from the SST files to fill the block cache
+	for i := 0; i < 1024; i++ {
+		require.NoError(t, rdb.Get(ctx, fmt.Sprintf("key:%d", i)).Err())
+	}
+
+	srv.Restart()
+	require.Eventually(t, func() bool {
+		return util.FindInfoEntry(rdb, "block_cache_prewarm_status", "rocksdb") == "done"
+	}, 10*time.Second, 100*time.Millisecond)
+	loaded, err := strconv.Atoi(util.FindInfoEntry(rdb, "block_cache_prewarm_loaded_bytes", "rocksdb"))
+	require.NoError(t, err)
+	require.Greater(t, loaded, 0)
+	total, err := strconv.Atoi(util.FindInfoEntry(rdb, "block_cache_prewarm_total_bytes", "rocksdb"))
+	require.NoError(t, err)
+	require.LessOrEqual(t, loaded, total)
+}
+
 func TestKeyspaceHitMiss(t *testing.T) {
 	srv0 := util.StartServer(t, map[string]string{})
 	defer func() { srv0.Close() }()
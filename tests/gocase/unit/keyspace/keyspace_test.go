@@ -117,6 +117,40 @@ func TestKeyspace(t *testing.T) {
 		util.ErrorRegexp(t, rdb.Do(ctx, "foobaredcommand").Err(), "ERR.*")
 	})
 
+	t.Run("FLUSHDB and FLUSHALL with SYNC and ASYNC flags", func(t *testing.T) {
+		for _, args := range [][]interface{}{
+			{"FLUSHDB"}, {"FLUSHDB", "SYNC"}, {"FLUSHDB", "async"},
+			{"FLUSHALL"}, {"FLUSHALL", "SYNC"}, {"FLUSHALL", "async"},
+		} {
+			require.NoError(t, rdb.Set(ctx, "foo", "bar", 0).Err())
+			require.NoError(t, rdb.HSet(ctx, "hash", "f1", "v1", "f2", "v2").Err())
+			require.NoError(t, rdb.Do(ctx, args...).Err())
+			require.EqualValues(t, 0, rdb.DBSize(ctx).Val())
+			// fields of the flushed hash should not be resurrected
+			require.NoError(t, rdb.HSet(ctx, "hash", "f3", "v3").Err())
+			require.Equal(t, map[string]string{"f3": "v3"}, rdb.HGetAll(ctx, "hash").Val())
+			require.NoError(t, rdb.Del(ctx, "hash").Err())
+		}
+
+		util.ErrorRegexp(t, rdb.Do(ctx, "FLUSHDB", "foo").Err(), ".*syntax error.*")
+		util.ErrorRegexp(t, rdb.Do(ctx, "FLUSHALL", "SYNC", "ASYNC").Err(), ".*syntax error.*")
+	})
+
+	t.Run("FLUSHDB while a compaction is running", func(t *testing.T) {
+		require.NoError(t, rdb.Set(ctx, "foo", "bar", 0).Err())
+		require.NoError(t, rdb.Do(ctx, "COMPACT").Err())
+		// the flushed range is compacted after the running compaction
+		require.NoError(t, rdb.Do(ctx, "FLUSHDB").Err())
+		require.NoError(t, rdb.Do(ctx, "FLUSHDB", "ASYNC").Err())
+		// SYNC waits for its range to be compacted after the queued ones
+		require.NoError(t, rdb.Set(ctx, "foo", "bar", 0).Err())
+		require.NoError(t, rdb.Do(ctx, "FLUSHDB", "SYNC").Err())
+		require.EqualValues(t, 0, rdb.DBSize(ctx).Val())
+		require.Eventually(t, func() bool {
+			return util.FindInfoEntry(rdb, "is_compacting", "rocksdb") == "no"
+		}, 10*time.Second, 100*time.Millisecond)
+	})
+
 	t.Run("RANDOMKEY", func(t *testing.T) {
 		rdb.FlushDB(ctx)
 		require.NoError(t, rdb.Set(ctx, "foo", "x", 0).Err())
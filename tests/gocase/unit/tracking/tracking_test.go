@@ -0,0 +1,171 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+package tracking
+
+import (
+	"context"
+	"testing"
+
+	"github.com/apache/kvrocks/tests/gocase/util"
+	"github.com/stretchr/testify/require"
+)
+
+func newRESP3Client(t *testing.T, srv *util.KvrocksServer) *util.TCPClient {
+	c := srv.NewTCPClient()
+	require.NoError(t, c.WriteArgs("HELLO", "3"))
+	require.NoError(t, c.WriteArgs("PING"))
+	// skip the reply of HELLO
+	for {
+		r, err := c.ReadLine()
+		require.NoError(t, err)
+		if r == "+PONG" {
+			break
+		}
+	}
+	return c
+}
+
+func mustReadInvalidation(t *testing.T, c *util.TCPClient, keys ...string) {
+	c.MustRead(t, ">2")
+	c.MustRead(t, "$10")
+	c.MustRead(t, "invalidate")
+	c.MustReadStrings(t, keys)
+}
+
+func TestClientTracking(t *testing.T) {
+	srv := util.StartServer(t, map[string]string{"resp3-enabled": "yes"})
+	defer srv.Close()
+
+	ctx := context.Background()
+	rdb := srv.NewClient()
+	defer func() { require.NoError(t, rdb.Close()) }()
+
+	t.Run("tracking requires RESP3", func(t *testing.T) {
+		c := srv.NewTCPClient()
+		defer func() { require.NoError(t, c.Close()) }()
+		require.NoError(t, c.WriteArgs("CLIENT", "TRACKING", "ON"))
+		c.MustMatch(t, ".*requires RESP3.*")
+	})
+
+	t.Run("tracking with invalid options", func(t *testing.T) {
+		require.ErrorContains(t, rdb.Do(ctx, "CLIENT", "TRACKING", "ON", "PREFIX", "a").Err(), "BCAST")
+		require.ErrorContains(t, rdb.Do(ctx, "CLIENT", "TRACKING", "ON", "REDIRECT", "1").Err(), "isn't supported")
+		require.Error(t, rdb.Do(ctx, "CLIENT", "TRACKING", "MAYBE").Err())
+	})
+
+	t.Run("read keys are invalidated once they're modified", func(t *testing.T) {
+		c := newRESP3Client(t, srv)
+		defer func() { require.NoError(t, c.Close()) }()
+
+		require.NoError(t, rdb.Set(ctx, "tracked", "v1", 0).Err())
+		require.NoError(t, c.WriteArgs("CLIENT", "TRACKING", "ON"))
+		c.MustRead(t, "+OK")
+		require.Regexp(t, "flags=t", rdb.ClientList(ctx).Val())
+		require.Equal(t, "1", util.FindInfoEntry(rdb, "tracking_clients", "clients"))
+
+		require.NoError(t, c.WriteArgs("GET", "tracked"))
+		c.MustRead(t, "$2")
+		c.MustRead(t, "v1")
+
+		require.NoError(t, rdb.Set(ctx, "tracked", "v2", 0).Err())
+		mustReadInvalidation(t, c, "tracked")
+
+		// the key isn't tracked any more until it's read again
+		require.NoError(t, rdb.Set(ctx, "tracked", "v3", 0).Err())
+		require.NoError(t, c.WriteArgs("PING"))
+		c.MustRead(t, "+PONG")
+
+		require.NoError(t, c.WriteArgs("CLIENT", "TRACKING", "OFF"))
+		c.MustRead(t, "+OK")
+		require.Equal(t, "0", util.FindInfoEntry(rdb, "tracking_clients", "clients"))
+	})
+
+	t.Run("keys matching the prefixes are broadcast", func(t *testing.T) {
+		c := newRESP3Client(t, srv)
+		defer func() { require.NoError(t, c.Close()) }()
+
+		require.NoError(t, c.WriteArgs("CLIENT", "TRACKING", "ON", "BCAST", "PREFIX", "user:"))
+		c.MustRead(t, "+OK")
+
+		require.NoError(t, rdb.Set(ctx, "other", "v", 0).Err())
+		require.NoError(t, rdb.Set(ctx, "user:1", "v", 0).Err())
+		mustReadInvalidation(t, c, "user:1")
+	})
+
+	t.Run("flushing the database invalidates all the keys", func(t *testing.T) {
+		c := newRESP3Client(t, srv)
+		defer func() { require.NoError(t, c.Close()) }()
+
+		require.NoError(t, c.WriteArgs("CLIENT", "TRACKING", "ON"))
+		c.MustRead(t, "+OK")
+		require.NoError(t, rdb.FlushDB(ctx).Err())
+		c.MustRead(t, ">2")
+		c.MustRead(t, "$10")
+		c.MustRead(t, "invalidate")
+		c.MustRead(t, "_")
+	})
+
+	t.Run("the writes of the connection itself are skipped with NOLOOP", func(t *testing.T) {
+		c := newRESP3Client(t, srv)
+		defer func() { require.NoError(t, c.Close()) }()
+
+		require.NoError(t, c.WriteArgs("CLIENT", "TRACKING", "ON", "NOLOOP"))
+		c.MustRead(t, "+OK")
+		require.NoError(t, c.WriteArgs("GET", "noloop"))
+		c.MustRead(t, "_")
+		require.NoError(t, c.WriteArgs("SET", "noloop", "v"))
+		c.MustRead(t, "+OK")
+		require.NoError(t, c.WriteArgs("PING"))
+		c.MustRead(t, "+PONG")
+	})
+}
+
+func TestClientTrackingOnReplica(t *testing.T) {
+	master := util.StartServer(t, map[string]string{"resp3-enabled": "yes"})
+	defer master.Close()
+	masterClient := master.NewClient()
+	defer func() { require.NoError(t, masterClient.Close()) }()
+
+	replica := util.StartServer(t, map[string]string{"resp3-enabled": "yes"})
+	defer replica.Close()
+	replicaClient := replica.NewClient()
+	defer func() { require.NoError(t, replicaClient.Close()) }()
+
+	ctx := context.Background()
+	require.NoError(t, masterClient.HSet(ctx, "replicated", "field", "v1").Err())
+	util.SlaveOf(t, replicaClient, master)
+	util.WaitForSync(t, replicaClient)
+	util.WaitForOffsetSync(t, masterClient, replicaClient)
+
+	t.Run("replicated writes invalidate the keys read from the replica", func(t *testing.T) {
+		c := newRESP3Client(t, replica)
+		defer func() { require.NoError(t, c.Close()) }()
+
+		require.NoError(t, c.WriteArgs("CLIENT", "TRACKING", "ON"))
+		c.MustRead(t, "+OK")
+		require.NoError(t, c.WriteArgs("HGET", "replicated", "field"))
+		c.MustRead(t, "$2")
+		c.MustRead(t, "v1")
+
+		// overwriting the field only writes the sub key
+		require.NoError(t, masterClient.HSet(ctx, "replicated", "field", "v2").Err())
+		mustReadInvalidation(t, c, "replicated")
+	})
+}
@@ -894,4 +894,54 @@ func TestHashWithAsyncIOEnabled(t *testing.T) {
 		require.Len(t, rdb.HKeys(ctx, testKey).Val(), 50)
 		require.Len(t, rdb.HVals(ctx, testKey).Val(), 50)
 	})
+
+	t.Run("HEXPIRE/HTTL/HPERSIST basic", func(t *testing.T) {
+		testKey := "test-hash-field-ttl"
+		require.NoError(t, rdb.Del(ctx, testKey).Err())
+		require.NoError(t, rdb.HSet(ctx, testKey, "f1", "v1", "f2", "v2", "f3", "v3").Err())
+
+		require.EqualValues(t, []interface{}{int64(1), int64(-2)},
+			rdb.Do(ctx, "HEXPIRE", testKey, 100, "FIELDS", 2, "f1", "f4").Val())
+		ttls := rdb.Do(ctx, "HTTL", testKey, "FIELDS", 2, "f1", "f2").Val().([]interface{})
+		require.Len(t, ttls, 2)
+		require.LessOrEqual(t, ttls[0].(int64), int64(100))
+		require.Greater(t, ttls[0].(int64), int64(90))
+		require.EqualValues(t, -1, ttls[1])
+
+		require.EqualValues(t, []interface{}{int64(0), int64(1)},
+			rdb.Do(ctx, "HEXPIRE", testKey, 200, "NX", "FIELDS", 2, "f1", "f2").Val())
+		require.EqualValues(t, []interface{}{int64(1), int64(-1), int64(-2)},
+			rdb.Do(ctx, "HPERSIST", testKey, "FIELDS", 3, "f1", "f3", "f4").Val())
+
+		require.EqualValues(t, []interface{}{int64(2)},
+			rdb.Do(ctx, "HPEXPIREAT", testKey, 1, "FIELDS", 1, "f3").Val())
+		require.EqualValues(t, 2, rdb.HLen(ctx, testKey).Val())
+		require.Equal(t, map[string]string{"f1": "v1", "f2": "v2"}, rdb.HGetAll(ctx, testKey).Val())
+
+		require.ErrorContains(t, rdb.Do(ctx, "HEXPIRE", testKey, 100, "FIELDS", 2, "f1").Err(), "numfields")
+		require.ErrorContains(t, rdb.Do(ctx, "HTTL", testKey, "f1", "FIELDS", 1, "f1").Err(), "FIELDS")
+		require.EqualValues(t, []interface{}{int64(-2)}, rdb.Do(ctx, "HTTL", "no-exist-key", "FIELDS", 1, "f1").Val())
+	})
+
+	t.Run("Expired hash fields are invisible and reclaimed by compaction", func(t *testing.T) {
+		testKey := "test-hash-field-ttl-compaction"
+		require.NoError(t, rdb.Del(ctx, testKey).Err())
+		require.NoError(t, rdb.HSet(ctx, testKey, "f1", "v1", "f2", "v2", "f3", "v3").Err())
+		require.NoError(t, rdb.Do(ctx, "HPEXPIRE", testKey, 100, "FIELDS", 2, "f1", "f2").Err())
+
+		time.Sleep(200 * time.Millisecond)
+		require.Equal(t, "", rdb.HGet(ctx, testKey, "f1").Val())
+		require.EqualValues(t, []interface{}{nil, "v3"}, rdb.HMGet(ctx, testKey, "f1", "f3").Val())
+		// HLEN is an upper bound, which counts the expired fields until they're overwritten or deleted
+		require.EqualValues(t, 3, rdb.HLen(ctx, testKey).Val())
+		require.EqualValues(t, 0, rdb.HDel(ctx, testKey, "f1").Val())
+		require.EqualValues(t, 2, rdb.HLen(ctx, testKey).Val())
+		require.Equal(t, []string{"f3"}, rdb.HKeys(ctx, testKey).Val())
+		keys, _ := rdb.HScan(ctx, testKey, 0, "*", 10).Val()
+		require.Equal(t, []string{"f3", "v3"}, keys)
+
+		require.NoError(t, rdb.Do(ctx, "COMPACT").Err())
+		time.Sleep(2 * time.Second)
+		require.Equal(t, map[string]string{"f3": "v3"}, rdb.HGetAll(ctx, testKey).Val())
+	})
 }
@@ -92,6 +92,10 @@ Status Config::parseConfigFromString(const std::string &input) {
     cluster_enabled = GET_OR_RET(yesnotoi(args[0]).Prefixed("key 'cluster-enable'"));
   } else if (size == 1 && key == "cluster-enabled") {
     cluster_enabled = GET_OR_RET(yesnotoi(args[0]).Prefixed("key 'cluster-enabled'"));
+  } else if (size == 1 && key == "writer-threads") {
+    writer_threads = GET_OR_RET(ParseInt<int>(args[0], {1, 256}, 10).Prefixed("key 'writer-threads'"));
+  } else if (size == 1 && key == "pipeline-depth") {
+    pipeline_depth = GET_OR_RET(ParseInt<int>(args[0], {1, 65536}, 10).Prefixed("key 'pipeline-depth'"));
   } else if (size >= 2 && strncasecmp(key.data(), "namespace.", 10) == 0) {
     std::string ns = original_key.substr(10);
     if (ns.size() > INT8_MAX) {
@@ -50,6 +50,8 @@ struct Config {
 
   std::map<std::string, RedisServer> tokens;
   bool cluster_enabled = false;
+  int writer_threads = 4;
+  int pipeline_depth = 128;
 
   Status Load(std::string path);
   Config() = default;
@@ -29,6 +29,7 @@
 #include "db_util.h"
 #include "server/redis_reply.h"
 #include "storage/redis_metadata.h"
+#include "time_util.h"
 #include "types/redis_string.h"
 
 Status Parser::ParseFullDB() {
@@ -54,6 +55,12 @@ Status Parser::ParseFullDB() {
     Status s;
     if (metadata.Type() == kRedisString) {
       s = parseSimpleKV(iter->key(), iter->value(), metadata.expire);
+    } else if (metadata.Type() == kRedisHash) {
+      HashMetadata hash_metadata(false);
+      if (!hash_metadata.Decode(iter->value()).ok()) {
+        continue;
+      }
+      s = parseComplexKV(iter->key(), hash_metadata);
     } else {
       s = parseComplexKV(iter->key(), metadata);
     }
@@ -63,8 +70,21 @@ Status Parser::ParseFullDB() {
   return Status::OK();
 }
 
+// The namespace id in keys is translated back to the name which the namespaces are configured with
+std::string Parser::decodeNamespace(const std::string &ns) {
+  auto name = storage_->DecodeNamespace(ns);
+  if (!IsNamespaceID(name)) return name;
+  // the id may be assigned after the ids are loaded, reload them since the storage has caught up with the primary
+  if (auto s = storage_->ReloadNamespaceIDs(); !s.IsOK()) {
+    LOG(ERROR) << "[kvrocks2redis] Failed to reload the namespace ids: " << s.Msg();
+    return name;
+  }
+  return storage_->DecodeNamespace(ns);
+}
+
 Status Parser::parseSimpleKV(const Slice &ns_key, const Slice &value, uint64_t expire) {
-  auto [ns, user_key] = ExtractNamespaceKey<std::string>(ns_key, slot_id_encoded_);
+  auto [encoded_ns, user_key] = ExtractNamespaceKey<std::string>(ns_key, slot_id_encoded_);
+  auto ns = decodeNamespace(encoded_ns);
 
   auto command =
       redis::ArrayOfBulkStrings({"SET", user_key, value.ToString().substr(Metadata::GetOffsetAfterExpire(value[0]))});
@@ -85,7 +105,8 @@ Status Parser::parseComplexKV(const Slice &ns_key, const Metadata &metadata) {
     return {Status::NotOK, "unknown metadata type: " + std::to_string(type)};
   }
 
-  auto [ns, user_key] = ExtractNamespaceKey<std::string>(ns_key, slot_id_encoded_);
+  auto [encoded_ns, user_key] = ExtractNamespaceKey<std::string>(ns_key, slot_id_encoded_);
+  auto ns = decodeNamespace(encoded_ns);
   std::string prefix_key = InternalKey(ns_key, "", metadata.version, slot_id_encoded_).Encode();
   std::string next_version_prefix_key = InternalKey(ns_key, "", metadata.version + 1, slot_id_encoded_).Encode();
 
@@ -104,9 +125,23 @@ Status Parser::parseComplexKV(const Slice &ns_key, const Metadata &metadata) {
     std::string sub_key = ikey.GetSubKey().ToString();
     std::string value = iter->value().ToString();
     switch (type) {
-      case kRedisHash:
-        output = redis::ArrayOfBulkStrings({"HSET", user_key, sub_key, value});
+      case kRedisHash: {
+        // the metadata of hashes is always decoded as HashMetadata in ParseFullDB
+        const auto &hash_metadata = static_cast<const HashMetadata &>(metadata);
+        Slice field_value;
+        uint64_t expire = 0;
+        if (!hash_metadata.DecodeFieldValue(iter->value(), &field_value, &expire)) {
+          return {Status::NotOK, "the value of hash field is too short"};
+        }
+        if (expire > 0 && expire <= util::GetTimeStampMS()) {
+          continue;  // ignore the expired field
+        }
+        output = redis::ArrayOfBulkStrings({"HSET", user_key, sub_key, field_value.ToString()});
+        if (expire > 0) {
+          output += redis::ArrayOfBulkStrings({"HPEXPIREAT", user_key, std::to_string(expire), "FIELDS", "1", sub_key});
+        }
         break;
+      }
       case kRedisSet:
         output = redis::ArrayOfBulkStrings({"SADD", user_key, sub_key});
         break;
@@ -175,7 +210,7 @@ Status Parser::ParseWriteBatch(const std::string &batch_string) {
 
   auto resp_commands = write_batch_extractor.GetRESPCommands();
   for (const auto &iter : *resp_commands) {
-    auto s = writer_->Write(iter.first, iter.second);
+    auto s = writer_->Write(decodeNamespace(iter.first), iter.second);
     if (!s.IsOK()) {
       LOG(ERROR) << "[kvrocks2redis] Failed to write to AOF from the write batch. Error: " << s.Msg();
     }
@@ -47,6 +47,7 @@ class Parser {
   Writer *writer_ = nullptr;
   bool slot_id_encoded_ = false;
 
+  std::string decodeNamespace(const std::string &ns);
   Status parseSimpleKV(const Slice &ns_key, const Slice &value, uint64_t expire);
   Status parseComplexKV(const Slice &ns_key, const Metadata &metadata);
   Status parseBitmapSegment(const Slice &ns, const Slice &user_key, int index, const Slice &bitmap);
@@ -22,16 +22,80 @@
 
 #include <assert.h>
 #include <fcntl.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <functional>
 #include <system_error>
 
 #include "io_util.h"
+#include "parse_util.h"
 #include "server/redis_reply.h"
 #include "thread_util.h"
+#include "time_util.h"
+
+namespace {
+
+// Return the length of the complete RESP value at the beginning of the buffer, or 0 if it's incomplete
+StatusOr<size_t> RESPValueLength(std::string_view buf) {
+  auto pos = buf.find(CRLF);
+  if (pos == std::string_view::npos) return size_t{0};
+  size_t line_len = pos + 2;
+
+  switch (buf[0]) {
+    case '+':
+    case '-':
+    case ':':
+      return line_len;
+    case '$': {
+      auto len = GET_OR_RET(ParseInt<int64_t>(std::string(buf.substr(1, pos - 1)), 10));
+      if (len < 0) return line_len;
+      size_t total = line_len + len + 2;
+      return buf.size() < total ? 0 : total;
+    }
+    case '*': {
+      auto num = GET_OR_RET(ParseInt<int64_t>(std::string(buf.substr(1, pos - 1)), 10));
+      size_t total = line_len;
+      for (int64_t i = 0; i < num; i++) {
+        auto len = GET_OR_RET(RESPValueLength(buf.substr(total)));
+        if (len == 0) return size_t{0};
+        total += len;
+      }
+      return total;
+    }
+    default:
+      return {Status::NotOK, "invalid RESP value: " + std::string(buf.substr(0, pos))};
+  }
+}
+
+// Return the key of a complete command, which is the second element of the RESP array,
+// or empty if the command has no key(e.g. FLUSHDB).
+std::string_view CommandKey(std::string_view command) {
+  // skip the array header and the command name
+  auto pos = command.find(CRLF);
+  if (pos == std::string_view::npos || command.substr(1, pos - 1) == "1") return {};
+  pos = command.find(CRLF, pos + 2);
+  pos = command.find(CRLF, pos + 2);
+  // now we are at the end of the command name, parse the bulk string of the key
+  auto len_end = command.find(CRLF, pos + 2);
+  auto len = ParseInt<size_t>(std::string(command.substr(pos + 3, len_end - pos - 3)), 10);
+  if (!len) return {};
+  return command.substr(len_end + 2, *len);
+}
+
+}  // namespace
 
 RedisWriter::RedisWriter(kvrocks2redis::Config *config) : Writer(config) {
   try {
+    for (int i = 0; i < config_->writer_threads; i++) {
+      auto shard = std::make_unique<Shard>();
+      shard->t = std::thread([this, shard = shard.get()]() {
+        util::ThreadSetName("redis-shard");
+        this->shardLoop(shard);
+      });
+      shards_.emplace_back(std::move(shard));
+    }
     t_ = std::thread([this]() {
       util::ThreadSetName("redis-writer");
       this->sync();
@@ -44,11 +108,16 @@ RedisWriter::RedisWriter(kvrocks2redis::Config *config) : Writer(config) {
 }
 
 RedisWriter::~RedisWriter() {
+  Stop();
+  if (t_.joinable()) t_.join();
+
   for (const auto &iter : next_offset_fds_) {
     close(iter.second);
   }
-  for (const auto &iter : redis_fds_) {
-    close(iter.second);
+  for (const auto &shard : shards_) {
+    for (const auto &iter : shard->redis_fds) {
+      close(iter.second);
+    }
   }
 }
 
@@ -58,6 +127,11 @@ Status RedisWriter::Write(const std::string &ns, const std::vector<std::string>
     return s;
   }
 
+  {
+    std::lock_guard<std::mutex> guard(aof_mu_);
+    has_new_aof_ = true;
+  }
+  aof_cv_.notify_one();
   return Status::OK();
 }
 
@@ -82,8 +156,16 @@ void RedisWriter::Stop() {
   if (stop_flag_) return;
 
   stop_flag_ = true;  // Stopping procedure is asynchronous,
+  aof_cv_.notify_all();
+  {
+    std::lock_guard<std::mutex> guard(shards_mu_);
+    round_cv_.notify_all();
+  }
 
-  if (t_.joinable()) t_.join();
+  if (t_.joinable() && t_.get_id() != std::this_thread::get_id()) t_.join();
+  for (const auto &shard : shards_) {
+    if (shard->t.joinable()) shard->t.join();
+  }
   // handled by sync func
   LOG(INFO) << "[kvrocks2redis] redis_writer Stopped";
 }
@@ -98,8 +180,9 @@ void RedisWriter::sync() {
   }
 
   size_t chunk_size = 4 * 1024 * 1024;
-  char *buffer = new char[chunk_size];
+  std::string buffer(chunk_size, '\0');
   while (!stop_flag_) {
+    bool has_progress = false;
     for (const auto &iter : config_->tokens) {
       Status s = GetAofFd(iter.first);
       if (!s.IsOK()) {
@@ -107,14 +190,8 @@ void RedisWriter::sync() {
         continue;
       }
 
-      s = getRedisConn(iter.first, iter.second.host, iter.second.port, iter.second.auth, iter.second.db_number);
-      if (!s.IsOK()) {
-        LOG(ERROR) << s.Msg();
-        continue;
-      }
-
-      while (true) {
-        auto getted_line_leng = pread(aof_fds_[iter.first], buffer, chunk_size, next_offsets_[iter.first]);
+      while (!stop_flag_) {
+        auto getted_line_leng = pread(aof_fds_[iter.first], buffer.data(), buffer.size(), next_offsets_[iter.first]);
         if (getted_line_leng <= 0) {
           if (getted_line_leng < 0) {
             LOG(ERROR) << "ERR read aof file : " << strerror(errno);
@@ -122,78 +199,234 @@ void RedisWriter::sync() {
           break;
         }
 
-        std::string con = std::string(buffer, getted_line_leng);
-        s = util::SockSend(redis_fds_[iter.first], std::string(buffer, getted_line_leng));
-        if (!s.IsOK()) {
-          LOG(ERROR) << "ERR send data to redis err: " << s.Msg();
-          break;
+        // Only the complete commands would be sent, the rest would be read again in the next round
+        std::string_view chunk(buffer.data(), getted_line_leng);
+        std::vector<std::string_view> commands;
+        size_t consumed = 0;
+        while (consumed < chunk.size()) {
+          auto len = RESPValueLength(chunk.substr(consumed));
+          if (!len) {
+            LOG(ERROR) << "[kvrocks2redis] CRITICAL - failed to parse the aof file: " << len.Msg();
+            Stop();
+            return;
+          }
+          if (*len == 0) break;
+          commands.emplace_back(chunk.substr(consumed, *len));
+          consumed += *len;
         }
-
-        auto line_state = util::SockReadLine(redis_fds_[iter.first]);
-        if (!line_state) {
-          LOG(ERROR) << "read redis response err: " << s.Msg();
+        if (commands.empty()) {
+          // The command is larger than the buffer, enlarge it and read again
+          if (static_cast<size_t>(getted_line_leng) == buffer.size()) {
+            buffer.resize(buffer.size() * 2);
+            continue;
+          }
           break;
         }
 
-        std::string line = *line_state;
-        if (line.compare(0, 1, "-") == 0) {
-          // Ooops, something went wrong , sync process has been terminated, administrator should be notified
-          // when full sync is needed, please remove last_next_seq config file, and restart kvrocks2redis
-          LOG(ERROR) << "[kvrocks2redis] CRITICAL - redis sync return error , administrator confirm needed : " << line;
-          delete[] buffer;
-          Stop();
-          return;
+        s = dispatch(iter.first, commands);
+        if (!s.IsOK()) {
+          if (s.Is<Status::RedisExecErr>()) {
+            // Ooops, something went wrong , sync process has been terminated, administrator should be notified
+            // when full sync is needed, please remove last_next_seq config file, and restart kvrocks2redis
+            LOG(ERROR) << "[kvrocks2redis] CRITICAL - redis sync return error , administrator confirm needed : "
+                       << s.Msg();
+            Stop();
+            return;
+          }
+          LOG(ERROR) << "ERR send data to redis err: " << s.Msg();
+          break;
         }
 
-        s = updateNextOffset(iter.first, next_offsets_[iter.first] + getted_line_leng);
+        written_commands_[iter.first] += commands.size();
+        has_progress = true;
+        s = updateNextOffset(iter.first, next_offsets_[iter.first] + static_cast<std::istream::off_type>(consumed));
         if (!s.IsOK()) {
           LOG(ERROR) << "ERR updating next offset: " << s.Msg();
           break;
         }
       }
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
+
+    reportLag();
+    if (!has_progress) waitForNewAof();
   }
+}
 
-  delete[] buffer;
+void RedisWriter::waitForNewAof() {
+  std::unique_lock<std::mutex> lock(aof_mu_);
+  aof_cv_.wait_for(lock, std::chrono::milliseconds(kMaxAofWaitMs), [this] { return has_new_aof_ || stop_flag_; });
+  has_new_aof_ = false;
 }
 
-Status RedisWriter::getRedisConn(const std::string &ns, const std::string &host, uint32_t port, const std::string &auth,
-                                 int db_index) {
-  auto iter = redis_fds_.find(ns);
-  if (iter == redis_fds_.end()) {
-    redis_fds_[ns] = GET_OR_RET(util::SockConnect(host, port).Prefixed("Failed to connect to redis"));
+void RedisWriter::reportLag() {
+  auto now_ms = util::GetTimeStampMS();
+  if (now_ms - last_report_ms_ < kReportIntervalMs) return;
 
-    if (!auth.empty()) {
-      auto s = authRedis(ns, auth);
-      if (!s.IsOK()) {
-        close(redis_fds_[ns]);
-        redis_fds_.erase(ns);
-        return s;
-      }
+  for (const auto &iter : config_->tokens) {
+    struct stat st;
+    if (aof_fds_.count(iter.first) == 0 || fstat(aof_fds_[iter.first], &st) != 0) continue;
+    LOG(INFO) << "[kvrocks2redis] namespace: " << iter.first
+              << ", pending bytes in aof: " << st.st_size - next_offsets_[iter.first]
+              << ", written commands: " << written_commands_[iter.first];
+  }
+  last_report_ms_ = now_ms;
+}
+
+Status RedisWriter::dispatch(const std::string &ns, const std::vector<std::string_view> &commands) {
+  for (const auto &command : commands) {
+    auto key = CommandKey(command);
+    if (key.empty()) {
+      // Commands without key(e.g. FLUSHDB) act as barriers, all commands before it must be
+      // written before sending it, so that commands of different shards won't be reordered
+      GET_OR_RET(runRound(ns));
+      shards_[0]->commands.emplace_back(command);
+      GET_OR_RET(runRound(ns));
+      continue;
+    }
+    shards_[std::hash<std::string_view>{}(key) % shards_.size()]->commands.emplace_back(command);
+  }
+  return runRound(ns);
+}
+
+Status RedisWriter::runRound(const std::string &ns) {
+  std::unique_lock<std::mutex> lock(shards_mu_);
+  if (stop_flag_) {
+    for (const auto &shard : shards_) shard->commands.clear();
+    return {Status::NotOK, "redis writer was stopped"};
+  }
+
+  for (const auto &shard : shards_) {
+    shard->ns = &ns;
+    shard->status = Status::OK();
+  }
+  pending_shards_ = shards_.size();
+  round_++;
+  round_cv_.notify_all();
+  // commands refer to the buffer of the caller, so always wait for all shards to finish
+  done_cv_.wait(lock, [this] { return pending_shards_ == 0; });
+
+  Status result;
+  for (const auto &shard : shards_) {
+    shard->commands.clear();
+    if (!shard->status.IsOK()) {
+      // the redis error reply always takes precedence over the network error
+      if (result.IsOK() || shard->status.Is<Status::RedisExecErr>()) result = std::move(shard->status);
+    }
+  }
+  return result;
+}
+
+void RedisWriter::shardLoop(Shard *shard) {
+  uint64_t round = 0;
+  std::unique_lock<std::mutex> lock(shards_mu_);
+  while (true) {
+    round_cv_.wait(lock, [&] { return round_ != round || stop_flag_; });
+    if (round_ == round) return;  // stopped
+    round = round_;
+    lock.unlock();
+
+    Status s;
+    if (!shard->commands.empty()) s = sendCommands(shard, *shard->ns);
+
+    lock.lock();
+    shard->status = std::move(s);
+    if (--pending_shards_ == 0) done_cv_.notify_one();
+  }
+}
+
+Status RedisWriter::sendCommands(Shard *shard, const std::string &ns) {
+  GET_OR_RET(getRedisConn(shard, ns));
+  int fd = shard->redis_fds[ns];
+
+  auto close_conn = [shard, &ns, fd] {
+    close(fd);
+    shard->redis_fds.erase(ns);
+    shard->read_buffer.clear();
+  };
+
+  size_t depth = config_->pipeline_depth;
+  std::string pipeline;
+  for (size_t i = 0; i < shard->commands.size(); i += depth) {
+    size_t n = std::min(depth, shard->commands.size() - i);
+    pipeline.clear();
+    for (size_t j = i; j < i + n; j++) {
+      pipeline.append(shard->commands[j]);
+    }
+
+    auto s = util::SockSend(fd, pipeline);
+    if (!s.IsOK()) {
+      close_conn();
+      return s;
     }
 
-    if (db_index != 0) {
-      auto s = selectDB(ns, db_index);
+    std::string reply;
+    for (size_t j = 0; j < n; j++) {
+      s = readReply(shard, fd, &reply);
       if (!s.IsOK()) {
-        close(redis_fds_[ns]);
-        redis_fds_.erase(ns);
-        return s;
+        close_conn();
+        return s.Prefixed("read redis response err");
       }
+      if (reply.compare(0, 1, "-") == 0) {
+        return {Status::RedisExecErr, reply};
+      }
+    }
+  }
+
+  return Status::OK();
+}
+
+Status RedisWriter::readReply(Shard *shard, int fd, std::string *reply) {
+  auto &buffer = shard->read_buffer;
+  while (true) {
+    auto len = GET_OR_RET(RESPValueLength(buffer));
+    if (len > 0) {
+      reply->assign(buffer, 0, len);
+      buffer.erase(0, len);
+      return Status::OK();
+    }
+
+    char buf[16 * 1024];
+    auto nread = read(fd, buf, sizeof(buf));
+    if (nread <= 0) {
+      return nread == 0 ? Status{Status::NotOK, "connection was closed"} : Status::FromErrno();
+    }
+    buffer.append(buf, nread);
+  }
+}
+
+Status RedisWriter::getRedisConn(Shard *shard, const std::string &ns) {
+  if (shard->redis_fds.count(ns) > 0) return Status::OK();
+
+  const auto &server = config_->tokens.at(ns);
+  int fd = GET_OR_RET(util::SockConnect(server.host, server.port).Prefixed("Failed to connect to redis"));
+  if (!server.auth.empty()) {
+    auto s = authRedis(fd, server.auth);
+    if (!s.IsOK()) {
+      close(fd);
+      return s;
+    }
+  }
+
+  if (server.db_number != 0) {
+    auto s = selectDB(fd, server.db_number);
+    if (!s.IsOK()) {
+      close(fd);
+      return s;
     }
   }
 
+  shard->redis_fds[ns] = fd;
   return Status::OK();
 }
 
-Status RedisWriter::authRedis(const std::string &ns, const std::string &auth) {
+Status RedisWriter::authRedis(int fd, const std::string &auth) {
   const auto auth_len_str = std::to_string(auth.length());
-  auto s = util::SockSend(redis_fds_[ns], "*2" CRLF "$4" CRLF "auth" CRLF "$" + auth_len_str + CRLF + auth + CRLF);
+  auto s = util::SockSend(fd, "*2" CRLF "$4" CRLF "auth" CRLF "$" + auth_len_str + CRLF + auth + CRLF);
   if (!s.IsOK()) {
     return s.Prefixed("[kvrocks2redis] failed to send AUTH command");
   }
 
-  std::string line = GET_OR_RET(util::SockReadLine(redis_fds_[ns]).Prefixed("read redis auth response err"));
+  std::string line = GET_OR_RET(util::SockReadLine(fd).Prefixed("read redis auth response err"));
   if (line.compare(0, 3, "+OK") != 0) {
     return {Status::NotOK, "[kvrocks2redis] redis Auth failed: " + line};
   }
@@ -201,17 +434,16 @@ Status RedisWriter::authRedis(const std::string &ns, const std::string &auth) {
   return Status::OK();
 }
 
-Status RedisWriter::selectDB(const std::string &ns, int db_number) {
+Status RedisWriter::selectDB(int fd, int db_number) {
   const auto db_number_str = std::to_string(db_number);
   const auto db_number_str_len = std::to_string(db_number_str.length());
-  auto s = util::SockSend(redis_fds_[ns],
-                          "*2" CRLF "$6" CRLF "select" CRLF "$" + db_number_str_len + CRLF + db_number_str + CRLF);
+  auto s = util::SockSend(fd, "*2" CRLF "$6" CRLF "select" CRLF "$" + db_number_str_len + CRLF + db_number_str + CRLF);
   if (!s.IsOK()) {
     return s.Prefixed("failed to send SELECT command to socket");
   }
 
   LOG(INFO) << "[kvrocks2redis] select db request was sent, waiting for response";
-  std::string line = GET_OR_RET(util::SockReadLine(redis_fds_[ns]).Prefixed("read select db response err"));
+  std::string line = GET_OR_RET(util::SockReadLine(fd).Prefixed("read select db response err"));
   if (line.compare(0, 3, "+OK") != 0) {
     return {Status::NotOK, "[kvrocks2redis] redis select db failed: " + line};
   }
@@ -22,13 +22,22 @@
 
 #include <glog/logging.h>
 
+#include <atomic>
+#include <condition_variable>
 #include <map>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <string_view>
 #include <thread>
 #include <vector>
 
 #include "writer.h"
 
+// RedisWriter tails the AOF files and replays the commands to the target redis.
+// Commands are sharded by the hash of key to `writer-threads` connections, so commands of
+// the same key are always sent in order by the same connection, and each connection pipelines
+// up to `pipeline-depth` commands before waiting for the replies.
 class RedisWriter : public Writer {
  public:
   explicit RedisWriter(kvrocks2redis::Config *config);
@@ -43,17 +52,52 @@ class RedisWriter : public Writer {
   void Stop() override;
 
  private:
+  struct Shard {
+    std::thread t;
+    std::map<std::string, int> redis_fds;
+    std::string read_buffer;
+
+    // The commands to be sent in the current round
+    const std::string *ns = nullptr;
+    std::vector<std::string_view> commands;
+    Status status;
+  };
+
   std::thread t_;
-  bool stop_flag_ = false;
+  std::atomic<bool> stop_flag_ = false;
   std::map<std::string, int> next_offset_fds_;
   std::map<std::string, std::istream::off_type> next_offsets_;
-  std::map<std::string, int> redis_fds_;
+
+  std::vector<std::unique_ptr<Shard>> shards_;
+  std::mutex shards_mu_;
+  std::condition_variable round_cv_;
+  std::condition_variable done_cv_;
+  uint64_t round_ = 0;
+  size_t pending_shards_ = 0;
+
+  std::mutex aof_mu_;
+  std::condition_variable aof_cv_;
+  bool has_new_aof_ = false;
+
+  // Lag metrics, reported periodically
+  std::map<std::string, uint64_t> written_commands_;
+  uint64_t last_report_ms_ = 0;
+
+  static const uint64_t kReportIntervalMs = 10 * 1000;
+  static const uint64_t kMaxAofWaitMs = 100;
 
   void sync();
-  Status getRedisConn(const std::string &ns, const std::string &host, uint32_t port, const std::string &auth,
-                      int db_index);
-  Status authRedis(const std::string &ns, const std::string &auth);
-  Status selectDB(const std::string &ns, int db_number);
+  void shardLoop(Shard *shard);
+  Status dispatch(const std::string &ns, const std::vector<std::string_view> &commands);
+  Status runRound(const std::string &ns);
+  Status sendCommands(Shard *shard, const std::string &ns);
+  Status readReply(Shard *shard, int fd, std::string *reply);
+  void waitForNewAof();
+  void reportLag();
+
+  Status getRedisConn(Shard *shard, const std::string &ns);
+  static Status authRedis(int fd, const std::string &auth);
+  static Status selectDB(int fd, int db_number);
 
   Status updateNextOffset(const std::string &ns, std::istream::off_type offset);
   Status readNextOffsetFromFile(const std::string &ns, std::istream::off_type *offset);
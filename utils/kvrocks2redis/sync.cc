@@ -24,15 +24,21 @@
 #include <event2/bufferevent.h>
 #include <fcntl.h>
 #include <glog/logging.h>
+#include <poll.h>
 #include <rocksdb/write_batch.h>
 #include <unistd.h>
 
+#ifdef __linux__
+#include <sys/inotify.h>
+#endif
+
 #include <fstream>
 #include <string>
 
 #include "event_util.h"
 #include "io_util.h"
 #include "server/redis_reply.h"
+#include "time_util.h"
 
 void SendStringToEvent(bufferevent *bev, const std::string &data) {
   auto output = bufferevent_get_output(bev);
@@ -44,6 +50,7 @@ Sync::Sync(engine::Storage *storage, Writer *writer, Parser *parser, kvrocks2red
 
 Sync::~Sync() {
   if (next_seq_fd_) close(next_seq_fd_);
+  if (wal_watch_fd_ >= 0) close(wal_watch_fd_);
   writer_->Stop();
 }
 
@@ -58,6 +65,7 @@ void Sync::Start() {
     LOG(ERROR) << s.Msg();
     return;
   }
+  watchWAL();
   LOG(INFO) << "[kvrocks2redis] Start sync the data from kvrocks to redis";
   while (!IsStopped()) {
     s = checkWalBoundary();
@@ -83,6 +91,47 @@ Status Sync::tryCatchUpWithPrimary() {
   return s.ok() ? Status() : Status::NotOK;
 }
 
+// Watch the db directory to be notified once the primary instance appends the WAL,
+// fall back to polling if the file notification is unavailable.
+void Sync::watchWAL() {
+#ifdef __linux__
+  wal_watch_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (wal_watch_fd_ < 0) {
+    LOG(WARNING) << "[kvrocks2redis] Failed to init inotify, would poll the WAL: " << strerror(errno);
+    return;
+  }
+  if (inotify_add_watch(wal_watch_fd_, config_->db_dir.c_str(), IN_MODIFY | IN_CREATE | IN_MOVED_TO) < 0) {
+    LOG(WARNING) << "[kvrocks2redis] Failed to watch the db directory, would poll the WAL: " << strerror(errno);
+    close(wal_watch_fd_);
+    wal_watch_fd_ = -1;
+  }
+#endif
+}
+
+void Sync::waitForWALUpdates() {
+  if (wal_watch_fd_ < 0) {
+    usleep(10000);
+    return;
+  }
+
+  // The timeout is only a safety net in case of missing events
+  pollfd pfd = {wal_watch_fd_, POLLIN, 0};
+  if (poll(&pfd, 1, kMaxWALWaitMs) > 0) {
+    char buf[4096];
+    while (read(wal_watch_fd_, buf, sizeof(buf)) > 0) {
+    }
+  }
+}
+
+void Sync::reportLag() {
+  auto now_ms = util::GetTimeStampMS();
+  if (now_ms - last_report_ms_ < kReportIntervalMs) return;
+
+  LOG(INFO) << "[kvrocks2redis] next sequence: " << next_seq_ << ", latest sequence: " << storage_->LatestSeqNumber()
+            << ", lag: " << storage_->LatestSeqNumber() + 1 - next_seq_;
+  last_report_ms_ = now_ms;
+}
+
 Status Sync::checkWalBoundary() {
   if (next_seq_ == storage_->LatestSeqNumber() + 1) {
     return Status::OK();
@@ -117,6 +166,7 @@ Status Sync::incrementBatchLoop() {
     if (!tryCatchUpWithPrimary().IsOK()) {
       return {Status::NotOK};
     }
+    reportLag();
     if (next_seq_ <= storage_->LatestSeqNumber()) {
       storage_->GetDB()->GetUpdatesSince(next_seq_, &iter);
       for (; iter->Valid(); iter->Next()) {
@@ -139,7 +189,7 @@ Status Sync::incrementBatchLoop() {
         }
       }
     } else {
-      usleep(10000);
+      waitForWALUpdates();
     }
   }
   return Status::OK();
@@ -52,7 +52,12 @@ class Sync {
   Parser *parser_ = nullptr;
   kvrocks2redis::Config *config_ = nullptr;
   int next_seq_fd_;
+  int wal_watch_fd_ = -1;
   rocksdb::SequenceNumber next_seq_ = static_cast<rocksdb::SequenceNumber>(0);
+  uint64_t last_report_ms_ = 0;
+
+  static const uint64_t kReportIntervalMs = 10 * 1000;
+  static const int kMaxWALWaitMs = 100;
 
   // Internal states managed by IncrementBatchLoop procedure
   enum IncrementBatchLoopState {
@@ -64,6 +69,9 @@ class Sync {
 
   Status tryCatchUpWithPrimary();
   Status checkWalBoundary();
+  void watchWAL();
+  void waitForWALUpdates();
+  void reportLag();
 
   void parseKVFromLocalStorage();
 